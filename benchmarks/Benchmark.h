@@ -0,0 +1,72 @@
+#pragma once
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// Just enough of a benchmark framework for the engine code that runs without a device.
+/// BENCHMARK(Suite, Name) defines a benchmark; it times its own work with Measure and prints it with Report
+/// </summary>
+namespace Benchmark
+{
+
+struct Case
+{
+    const char *Suite;
+    const char *Name;
+    void (*Function)();
+};
+
+std::vector<Case> &GetCases();
+
+struct Registrar
+{
+    Registrar(const char *suite, const char *name, void (*function)())
+    {
+        GetCases().push_back({ suite, name, function });
+    }
+};
+
+/// <summary>
+/// Runs function once to warm up, then repetitions times, and returns the median run in seconds
+/// </summary>
+template <typename Function>
+double Measure(uint32_t repetitions, Function &&function)
+{
+    function();
+
+    std::vector<double> seconds;
+    for (uint32_t i = 0; i < std::max(repetitions, 1u); ++i)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        function();
+        auto end = std::chrono::high_resolution_clock::now();
+        seconds.push_back(std::chrono::duration<double>(end - start).count());
+    }
+    std::sort(seconds.begin(), seconds.end());
+    return seconds[seconds.size() / 2];
+}
+
+/// <summary>
+/// Prints the time of one run and, if items is not 0, the throughput in millions of unit per second
+/// </summary>
+void Report(const char *name, double seconds, double items = 0.0, const char *unit = nullptr);
+
+/// <summary>
+/// Restarts the job system with workerCount workers; the calling thread works too
+/// </summary>
+void RestartJobSystem(uint32_t workerCount);
+/// <summary>
+/// Worker counts worth measuring scaling with: powers of two up to one worker per extra hardware thread
+/// </summary>
+std::vector<uint32_t> GetWorkerCounts();
+
+} // namespace Benchmark
+
+#define BENCHMARK(suite, name)                                                                                         \
+    static void Benchmark_##suite##_##name();                                                                          \
+    static Benchmark::Registrar gRegistrar_##suite##_##name(#suite, #name, &Benchmark_##suite##_##name);               \
+    static void Benchmark_##suite##_##name()
@@ -0,0 +1,85 @@
+#include "Benchmark.h"
+#include "DDSFixture.h"
+#include "JobSystem.h"
+
+#include "Utils/DDSTextureData.h"
+
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+static constexpr uint32_t kFileCount = 500;
+
+// Reads one byte per page of every subresource, as recording the upload would
+static uint64_t Touch(const DirectX::DDSTextureData &textureData)
+{
+    uint64_t checksum = 0;
+    for (const auto &subresource : textureData.subresources)
+    {
+        auto data = (const uint8_t *)subresource.pData;
+        for (LONG_PTR offset = 0; offset < subresource.SlicePitch; offset += 4096)
+        {
+            checksum += data[offset];
+        }
+    }
+    return checksum;
+}
+
+// Only the decode side, which InitTextures runs on the job system: file reads, header parsing and subresource layout
+BENCHMARK(DDSLoader, Load500Files)
+{
+    auto directory = std::filesystem::temp_directory_path() / "OblivionDDSBenchmark";
+    std::filesystem::create_directories(directory);
+
+    std::vector<std::filesystem::path> paths;
+    uint64_t totalBytes = 0;
+    for (uint32_t i = 0; i < kFileCount; ++i)
+    {
+        DDSFixture::Description description;
+        description.Width = description.Height = 256;
+        description.MipCount = 9;
+        description.DX10Header = (i % 2) == 1;
+        paths.push_back(directory / ("Texture" + std::to_string(i) + ".dds"));
+        if (!DDSFixture::Write(paths.back(), description))
+        {
+            std::printf("    Unable to write %s\n", paths.back().string().c_str());
+            return;
+        }
+        totalBytes += std::filesystem::file_size(paths.back());
+    }
+
+    std::atomic<uint64_t> checksum = 0;
+    double serialSeconds = Benchmark::Measure(3, [&]()
+                                              {
+                                                  for (const auto &path : paths)
+                                                  {
+                                                      DirectX::DDSTextureData textureData;
+                                                      if (SUCCEEDED(DirectX::LoadDDSTextureData(path.wstring().c_str(), textureData)))
+                                                      {
+                                                          checksum += Touch(textureData);
+                                                      }
+                                                  }
+                                              });
+    Benchmark::Report("Serial", serialSeconds, (double)totalBytes, "B");
+
+    double parallelSeconds = Benchmark::Measure(3, [&]()
+                                                {
+                                                    JobSystem::Get()->ParallelFor(kFileCount, 1, [&](uint32_t begin, uint32_t end)
+                                                                                  {
+                                                                                      for (uint32_t i = begin; i < end; ++i)
+                                                                                      {
+                                                                                          DirectX::DDSTextureData textureData;
+                                                                                          if (SUCCEEDED(DirectX::LoadDDSTextureData(paths[i].wstring().c_str(), textureData)))
+                                                                                          {
+                                                                                              checksum += Touch(textureData);
+                                                                                          }
+                                                                                      }
+                                                                                  });
+                                                });
+    Benchmark::Report("Job system", parallelSeconds, (double)totalBytes, "B");
+    std::printf("    %-52s %12.0f files/s\n", "Job system", kFileCount / parallelSeconds);
+
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+}
@@ -0,0 +1,123 @@
+#include "Benchmark.h"
+#include "JobSystem.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <thread>
+
+static constexpr uint32_t kEmptyJobs = 100000;
+static constexpr uint32_t kScalingItems = 1 << 20;
+
+// Enough arithmetic per item that scaling measures the workers, not memory bandwidth
+static float Work(uint32_t index)
+{
+    float value = (float)index;
+    for (uint32_t i = 0; i < 32; ++i)
+    {
+        value = std::sqrt(value * 1.0001f + 1.0f);
+    }
+    return value;
+}
+
+BENCHMARK(JobSystem, SpawnOverhead)
+{
+    double seconds = Benchmark::Measure(5, []()
+                                        {
+                                            JobCounter counter;
+                                            for (uint32_t i = 0; i < kEmptyJobs; ++i)
+                                            {
+                                                JobSystem::Get()->Schedule(counter, []() {});
+                                            }
+                                            JobSystem::Get()->Wait(counter);
+                                        });
+    Benchmark::Report("Schedule + Wait, empty jobs", seconds, kEmptyJobs, "jobs");
+    std::printf("    %-52s %12.1f ns\n", "Per job", seconds / kEmptyJobs * 1e9);
+
+    seconds = Benchmark::Measure(5, []()
+                                 {
+                                     JobSystem::Get()->ParallelFor(kEmptyJobs, 1, [](uint32_t, uint32_t) {});
+                                 });
+    Benchmark::Report("ParallelFor, batches of 1, empty", seconds, kEmptyJobs, "jobs");
+}
+
+BENCHMARK(JobSystem, ParallelForScaling)
+{
+    std::vector<float> results(kScalingItems);
+    auto run = [&results](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            results[i] = Work(i);
+        }
+    };
+
+    double serialSeconds = Benchmark::Measure(3, [&]()
+                                              {
+                                                  run(0, kScalingItems);
+                                              });
+    Benchmark::Report("Serial, calling thread only", serialSeconds, kScalingItems, "items");
+
+    for (uint32_t workers : Benchmark::GetWorkerCounts())
+    {
+        Benchmark::RestartJobSystem(workers);
+        double seconds = Benchmark::Measure(3, [&]()
+                                            {
+                                                JobSystem::Get()->ParallelFor(kScalingItems, 4096, run);
+                                            });
+        auto name = std::to_string(workers + 1) + " threads";
+        Benchmark::Report(name.c_str(), seconds, kScalingItems, "items");
+        std::printf("    %-52s %12.2fx\n", "Speedup over serial", serialSeconds / seconds);
+    }
+    Benchmark::RestartJobSystem(0);
+}
+
+BENCHMARK(JobSystem, Contention)
+{
+    // Single item batches: every thread keeps popping and stealing from the same deques
+    std::vector<float> results(kEmptyJobs);
+    double seconds = Benchmark::Measure(5, [&]()
+                                        {
+                                            JobSystem::Get()->ParallelFor(kEmptyJobs, 1, [&](uint32_t begin, uint32_t)
+                                                                          {
+                                                                              results[begin] = Work(begin);
+                                                                          });
+                                        });
+    Benchmark::Report("Stealing, batches of 1", seconds, kEmptyJobs, "jobs");
+
+    // Every job touches the same cache line
+    std::atomic<uint64_t> shared = 0;
+    seconds = Benchmark::Measure(5, [&]()
+                                 {
+                                     JobSystem::Get()->ParallelFor(kEmptyJobs, 1, [&](uint32_t begin, uint32_t)
+                                                                   {
+                                                                       shared.fetch_add(begin, std::memory_order_relaxed);
+                                                                   });
+                                 });
+    Benchmark::Report("Shared atomic, batches of 1", seconds, kEmptyJobs, "jobs");
+
+    // Threads outside the system all go through the injected queue's lock
+    static constexpr uint32_t kSchedulingThreads = 4;
+    seconds = Benchmark::Measure(5, []()
+                                 {
+                                     JobCounter counter;
+                                     std::vector<std::thread> threads;
+                                     for (uint32_t i = 0; i < kSchedulingThreads; ++i)
+                                     {
+                                         threads.emplace_back([&counter]()
+                                                              {
+                                                                  for (uint32_t job = 0; job < kEmptyJobs / kSchedulingThreads; ++job)
+                                                                  {
+                                                                      JobSystem::Get()->Schedule(counter, []() {});
+                                                                  }
+                                                              });
+                                     }
+                                     for (auto &thread : threads)
+                                     {
+                                         thread.join();
+                                     }
+                                     JobSystem::Get()->Wait(counter);
+                                 });
+    Benchmark::Report("4 foreign threads scheduling, empty jobs", seconds, kEmptyJobs, "jobs");
+}
@@ -0,0 +1,56 @@
+#include "Benchmark.h"
+#include "Utils/LightClusterBuilder.h"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+using Sphere = LightClusterBuilder::Sphere;
+
+// 60 degrees vertical field of view, 16:9
+static constexpr float kYScale = 1.7320508f;
+static constexpr float kXScale = kYScale * 9.0f / 16.0f;
+static constexpr float kNearZ = 0.1f;
+static constexpr float kFarZ = 100.0f;
+
+// Point lights spread through the frustum, the way a scene would place them: more of them far away
+static std::vector<Sphere> MakeLights(uint32_t count)
+{
+    std::vector<Sphere> lights;
+    uint32_t state = 0x2545f491;
+    auto random = [&state]()
+    {
+        state = state * 1664525u + 1013904223u;
+        return (float)(state >> 8) / (float)(1 << 24);
+    };
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        float z = kNearZ + (kFarZ - kNearZ) * std::sqrt(random());
+        float ndcX = random() * 2.2f - 1.1f;
+        float ndcY = random() * 2.2f - 1.1f;
+        lights.push_back({ ndcX * z / kXScale, ndcY * z / kYScale, z, 0.5f + random() * 2.5f });
+    }
+    return lights;
+}
+
+BENCHMARK(LightClusterBuilder, Binning)
+{
+    LightClusterBuilder builder;
+    builder.Init();
+    builder.SetProjection(kXScale, kYScale, kNearZ, kFarZ);
+
+    for (uint32_t lightCount : { 256u, 1024u, 4096u })
+    {
+        auto lights = MakeLights(lightCount);
+        double seconds = Benchmark::Measure(20, [&]()
+                                            {
+                                                builder.Build(lights.data(), lightCount);
+                                            });
+        auto name = std::to_string(lightCount) + " lights, 16x9x24 clusters";
+        Benchmark::Report(name.c_str(), seconds, lightCount, "lights");
+
+        const auto &statistics = builder.GetStatistics();
+        std::printf("    %-52s %u visible, %u indices, %u at most per cluster\n", "Binned", statistics.VisibleLights,
+                    statistics.LightIndices, statistics.MaxLightsPerCluster);
+    }
+}
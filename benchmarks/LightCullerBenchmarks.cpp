@@ -0,0 +1,86 @@
+#include "Benchmark.h"
+#include "Utils/LightCuller.h"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+using namespace LightCuller;
+
+// 60 degrees vertical field of view, 16:9, looking down +z from the origin
+static constexpr float kYScale = 1.7320508f;
+static constexpr float kXScale = kYScale * 9.0f / 16.0f;
+static constexpr float kNearZ = 0.1f;
+static constexpr float kFarZ = 100.0f;
+static constexpr uint32_t kMaxLights = 256;
+
+static Frustum MakeFrustum()
+{
+    // The side planes go through the eye, with normals (±scale, 0, 1) normalized
+    float xLength = std::sqrt(kXScale * kXScale + 1.0f);
+    float yLength = std::sqrt(kYScale * kYScale + 1.0f);
+
+    Frustum frustum;
+    frustum.Planes[0] = { kXScale / xLength, 0.0f, 1.0f / xLength, 0.0f };
+    frustum.Planes[1] = { -kXScale / xLength, 0.0f, 1.0f / xLength, 0.0f };
+    frustum.Planes[2] = { 0.0f, kYScale / yLength, 1.0f / yLength, 0.0f };
+    frustum.Planes[3] = { 0.0f, -kYScale / yLength, 1.0f / yLength, 0.0f };
+    frustum.Planes[4] = { 0.0f, 0.0f, 1.0f, -kNearZ };
+    frustum.Planes[5] = { 0.0f, 0.0f, -1.0f, kFarZ };
+    frustum.EyeX = 0.0f;
+    frustum.EyeY = 0.0f;
+    frustum.EyeZ = 0.0f;
+    frustum.YScale = kYScale;
+    return frustum;
+}
+
+// Half point lights and half spotlights, all around the eye the way a level would place them, so about a fifth
+// of them are in the frustum
+static Lights MakeLights(uint32_t count)
+{
+    uint32_t state = 0x2545f491;
+    auto random = [&state]()
+    {
+        state = state * 1664525u + 1013904223u;
+        return (float)(state >> 8) / (float)(1 << 24);
+    };
+
+    Lights lights;
+    lights.Resize(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        float x = random() * 200.0f - 100.0f;
+        float y = random() * 20.0f - 5.0f;
+        float z = random() * 200.0f - 100.0f;
+        float range = 1.0f + random() * 9.0f;
+        float intensity = 0.5f + random() * 4.5f;
+        if (i % 2 == 0)
+        {
+            lights.SetPointLight(i, x, y, z, range, intensity);
+        }
+        else
+        {
+            lights.SetSpotlight(i, x, y, z, random() - 0.5f, -1.0f, random() - 0.5f, range, 8.0f + random() * 56.0f,
+                                intensity);
+        }
+    }
+    return lights;
+}
+
+BENCHMARK(LightCuller, CullAndRank)
+{
+    auto frustum = MakeFrustum();
+    std::vector<uint32_t> selected;
+    for (uint32_t lightCount : { 1000u, 10000u })
+    {
+        auto lights = MakeLights(lightCount);
+        uint32_t visibleCount = 0;
+        double seconds = Benchmark::Measure(20, [&]()
+                                            {
+                                                visibleCount = CullAndRank(frustum, lights, kMaxLights, selected);
+                                            });
+        auto name = std::to_string(lightCount) + " lights, " + std::to_string(kMaxLights) + " at most";
+        Benchmark::Report(name.c_str(), seconds, lightCount, "lights");
+        std::printf("    %-52s %u visible, %zu selected\n", "Culled", visibleCount, selected.size());
+    }
+}
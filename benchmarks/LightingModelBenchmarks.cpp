@@ -0,0 +1,100 @@
+#include "Benchmark.h"
+#include "Utils/LightingModel.h"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+using namespace LightingModel;
+
+static constexpr uint32_t kSampleCount = 64 * 1024;
+
+static const Material kMaterial = { { 0.5f, 0.4f, 0.3f, 1.0f }, { 0.04f, 0.05f, 0.06f }, 0.25f };
+
+static void Normalize(float vector[3])
+{
+    float length = std::sqrt(vector[0] * vector[0] + vector[1] * vector[1] + vector[2] * vector[2]);
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        vector[i] /= length;
+    }
+}
+
+static float Random(uint32_t &state, float min, float max)
+{
+    state = state * 1664525u + 1013904223u;
+    return min + (max - min) * (float)(state >> 8) / (float)(1 << 24);
+}
+
+// A quarter of each kind is directional and spot, the rest point lights
+static std::vector<Light> MakeLights(uint32_t count, uint32_t &state)
+{
+    std::vector<Light> lights(count);
+    for (auto &light : lights)
+    {
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            light.Strength[c] = Random(state, 0.1f, 2.0f);
+            light.Direction[c] = Random(state, -1.0f, 1.0f);
+            light.Position[c] = Random(state, -16.0f, 16.0f);
+        }
+        light.Direction[1] = -1.0f;
+        Normalize(light.Direction);
+        light.FalloffStart = 1.0f;
+        light.FalloffEnd = 12.0f;
+        light.SpotPower = 16.0f;
+    }
+    return lights;
+}
+
+BENCHMARK(LightingModel, Shading)
+{
+    uint32_t state = 0x6b43a9b5;
+    Samples samples;
+    samples.Resize(kSampleCount);
+    for (uint32_t i = 0; i < kSampleCount; ++i)
+    {
+        float position[3] = { Random(state, -16.0f, 16.0f), 0.0f, Random(state, -16.0f, 16.0f) };
+        float normal[3] = { Random(state, -0.3f, 0.3f), 1.0f, Random(state, -0.3f, 0.3f) };
+        float toEye[3] = { Random(state, -1.0f, 1.0f), 1.0f, Random(state, -1.0f, 1.0f) };
+        Normalize(normal);
+        Normalize(toEye);
+        samples.Set(i, position, normal, toEye);
+    }
+    std::printf("    %-52s %s\n", "Batched path", UsesAVX() ? "AVX" : "scalar");
+
+    Colors colors;
+    colors.R.resize(kSampleCount);
+    colors.G.resize(kSampleCount);
+    colors.B.resize(kSampleCount);
+    for (uint32_t lightCount : { 4u, 16u, 64u })
+    {
+        auto lights = MakeLights(lightCount, state);
+        LightList lightList = { lights.data(), lightCount / 4, lightCount / 2, lightCount / 4 };
+
+        double scalarSeconds = Benchmark::Measure(3, [&]()
+                                                  {
+                                                      for (uint32_t i = 0; i < kSampleCount; ++i)
+                                                      {
+                                                          float position[3] = { samples.PositionX[i], samples.PositionY[i], samples.PositionZ[i] };
+                                                          float normal[3] = { samples.NormalX[i], samples.NormalY[i], samples.NormalZ[i] };
+                                                          float toEye[3] = { samples.ToEyeX[i], samples.ToEyeY[i], samples.ToEyeZ[i] };
+                                                          float result[3];
+                                                          ComputeLighting(lightList, kMaterial, position, normal, toEye, result);
+                                                          colors.R[i] = result[0];
+                                                          colors.G[i] = result[1];
+                                                          colors.B[i] = result[2];
+                                                      }
+                                                  });
+        auto name = std::to_string(lightCount) + " lights, scalar reference";
+        Benchmark::Report(name.c_str(), scalarSeconds, kSampleCount, "samples");
+
+        double batchedSeconds = Benchmark::Measure(3, [&]()
+                                                   {
+                                                       ComputeLighting(lightList, kMaterial, samples, colors);
+                                                   });
+        name = std::to_string(lightCount) + " lights, batched";
+        Benchmark::Report(name.c_str(), batchedSeconds, kSampleCount, "samples");
+        std::printf("    %-52s %12.2fx\n", "Speedup over scalar", scalarSeconds / batchedSeconds);
+    }
+}
@@ -0,0 +1,99 @@
+#include "Benchmark.h"
+#include "JobSystem.h"
+#include "Utils/LightmapBaker.h"
+
+#include <cstdio>
+#include <string>
+
+using Vertex = LightmapBaker::Vertex;
+
+static constexpr float kGroundSize = 20.0f;
+static constexpr uint32_t kGroundQuads = 16;
+
+// The baked mesh: a ground grid whose lightmap UVs cover the whole map
+static void AddGround(LightmapBaker &baker)
+{
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    for (uint32_t z = 0; z <= kGroundQuads; ++z)
+    {
+        for (uint32_t x = 0; x <= kGroundQuads; ++x)
+        {
+            float u = (float)x / kGroundQuads;
+            float v = (float)z / kGroundQuads;
+            vertices.push_back({ { (u - 0.5f) * kGroundSize, 0.0f, (v - 0.5f) * kGroundSize }, { 0.0f, 1.0f, 0.0f }, { u, v } });
+        }
+    }
+    for (uint32_t z = 0; z < kGroundQuads; ++z)
+    {
+        for (uint32_t x = 0; x < kGroundQuads; ++x)
+        {
+            uint32_t first = z * (kGroundQuads + 1) + x;
+            uint32_t next = first + kGroundQuads + 1;
+            indices.insert(indices.end(), { first, next, first + 1, first + 1, next, next + 1 });
+        }
+    }
+    baker.AddMesh(std::move(vertices), std::move(indices));
+}
+
+// Occluders standing on the ground, so shadow and AO rays have something to hit
+static void AddBox(LightmapBaker &baker, float x, float z, float size, float height)
+{
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    float corners[8][3];
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        corners[i][0] = x + (i & 1 ? size : -size);
+        corners[i][1] = i & 2 ? height : 0.0f;
+        corners[i][2] = z + (i & 4 ? size : -size);
+    }
+    for (const auto &corner : corners)
+    {
+        vertices.push_back({ { corner[0], corner[1], corner[2] }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f } });
+    }
+    static const uint32_t kBoxIndices[] = { 0, 1, 3, 0, 3, 2, 4, 6, 7, 4, 7, 5, 0, 2, 6, 0, 6, 4,
+                                            1, 5, 7, 1, 7, 3, 2, 3, 7, 2, 7, 6, 0, 4, 5, 0, 5, 1 };
+    indices.assign(std::begin(kBoxIndices), std::end(kBoxIndices));
+    baker.AddMesh(std::move(vertices), std::move(indices));
+}
+
+BENCHMARK(LightmapBaker, BakeScaling)
+{
+    LightmapBaker baker;
+    AddGround(baker);
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        AddBox(baker, -7.5f + (i % 4) * 5.0f, -7.5f + (i / 4) * 5.0f, 0.5f + (i % 3) * 0.4f, 1.0f + (i % 5) * 0.8f);
+    }
+    baker.BuildAccelerationStructure();
+
+    LightingModel::Light lights[3] = {
+        { { 1.0f, 0.95f, 0.9f }, 0.0f, { -0.4f, -0.8f, -0.45f }, 0.0f, {}, 0.0f },
+        { { 4.0f, 3.0f, 2.0f }, 1.0f, {}, 12.0f, { 3.0f, 3.0f, 2.0f }, 0.0f },
+        { { 2.0f, 3.0f, 4.0f }, 1.0f, {}, 12.0f, { -4.0f, 2.5f, -3.0f }, 0.0f },
+    };
+    LightingModel::LightList lightList = { lights, 1, 2, 0 };
+
+    LightmapBaker::Settings settings;
+    settings.Width = 256;
+    settings.Height = 256;
+    settings.AORayCount = 32;
+
+    LightmapBaker::Lightmap lightmap;
+    double firstSeconds = 0.0;
+    for (uint32_t workers : Benchmark::GetWorkerCounts())
+    {
+        Benchmark::RestartJobSystem(workers);
+        double seconds = Benchmark::Measure(3, [&]()
+                                            {
+                                                baker.Bake(0, lightList, settings, lightmap);
+                                            });
+        auto name = "256x256, 32 AO rays, " + std::to_string(workers + 1) + " threads";
+        Benchmark::Report(name.c_str(), seconds, lightmap.CoveredTexels, "texels");
+
+        firstSeconds = firstSeconds == 0.0 ? seconds : firstSeconds;
+        std::printf("    %-52s %12.2fx\n", "Speedup over 2 threads", firstSeconds / seconds);
+    }
+    Benchmark::RestartJobSystem(0);
+}
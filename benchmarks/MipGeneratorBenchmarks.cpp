@@ -0,0 +1,60 @@
+#include "Benchmark.h"
+#include "JobSystem.h"
+#include "Utils/MipGenerator.h"
+
+#include <string>
+
+static constexpr uint32_t kSize = 2048;
+static constexpr uint32_t kChannels = 4;
+
+// Noise, so neither filter gets to skip work on flat areas
+static std::vector<uint8_t> MakeImage()
+{
+    std::vector<uint8_t> image((size_t)kSize * kSize * kChannels);
+    uint32_t state = 0x12345678;
+    for (auto &value : image)
+    {
+        state = state * 1664525u + 1013904223u;
+        value = (uint8_t)(state >> 24);
+    }
+    return image;
+}
+
+static void Measure(const std::vector<uint8_t> &image, bool srgb, MipGenerator::Filter filter, const char *name)
+{
+    double seconds = Benchmark::Measure(5, [&]()
+                                        {
+                                            MipGenerator::Generate(image.data(), kSize, kSize, kSize * kChannels, srgb, filter);
+                                        });
+    // Throughput of the source image; the whole chain is a third larger
+    Benchmark::Report(name, seconds, (double)kSize * kSize, "pixels");
+}
+
+BENCHMARK(MipGenerator, Throughput)
+{
+    auto image = MakeImage();
+    Measure(image, false, MipGenerator::Filter::Box, "2048x2048 linear, box");
+    Measure(image, true, MipGenerator::Filter::Box, "2048x2048 sRGB, box");
+    Measure(image, false, MipGenerator::Filter::Kaiser, "2048x2048 linear, Kaiser");
+    Measure(image, true, MipGenerator::Filter::Kaiser, "2048x2048 sRGB, Kaiser");
+
+    if (MipGenerator::UsesAVX())
+    {
+        MipGenerator::SetAVXEnabled(false);
+        Measure(image, false, MipGenerator::Filter::Box, "2048x2048 linear, box, SSE");
+        Measure(image, true, MipGenerator::Filter::Kaiser, "2048x2048 sRGB, Kaiser, SSE");
+        MipGenerator::SetAVXEnabled(true);
+    }
+}
+
+BENCHMARK(MipGenerator, Scaling)
+{
+    auto image = MakeImage();
+    for (uint32_t workers : Benchmark::GetWorkerCounts())
+    {
+        Benchmark::RestartJobSystem(workers);
+        auto name = "2048x2048 sRGB, Kaiser, " + std::to_string(workers + 1) + " threads";
+        Measure(image, true, MipGenerator::Filter::Kaiser, name.c_str());
+    }
+    Benchmark::RestartJobSystem(0);
+}
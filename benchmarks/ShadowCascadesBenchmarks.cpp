@@ -0,0 +1,57 @@
+#include "Benchmark.h"
+#include "Utils/ShadowCascades.h"
+
+#include <cmath>
+#include <string>
+
+static constexpr uint32_t kCasterCount = 100000;
+
+BENCHMARK(ShadowCascades, UpdateAndCull)
+{
+    ShadowCascades::CameraInfo camera = {};
+    camera.Position[1] = 2.0f;
+    camera.Forward[2] = 1.0f;
+    camera.Right[0] = 1.0f;
+    camera.Up[1] = 1.0f;
+    camera.TanHalfFovY = 0.57735027f;
+    camera.TanHalfFovX = camera.TanHalfFovY * 16.0f / 9.0f;
+    camera.NearZ = 0.1f;
+    camera.FarZ = 200.0f;
+    float lightDirection[3] = { 0.3f, -1.0f, 0.2f };
+    ShadowCascades::Settings settings;
+
+    ShadowCascades cascades;
+    double seconds = Benchmark::Measure(1000, [&]()
+                                        {
+                                            cascades.Update(camera, lightDirection, settings);
+                                        });
+    Benchmark::Report("Update, 4 cascades", seconds);
+
+    // Casters scattered over the area the camera sees and around it
+    uint32_t state = 0x51ed270b;
+    auto random = [&state](float min, float max)
+    {
+        state = state * 1664525u + 1013904223u;
+        return min + (max - min) * (float)(state >> 8) / (float)(1 << 24);
+    };
+    std::vector<float> x(kCasterCount), y(kCasterCount), z(kCasterCount), radius(kCasterCount);
+    for (uint32_t i = 0; i < kCasterCount; ++i)
+    {
+        x[i] = random(-300.0f, 300.0f);
+        y[i] = random(0.0f, 30.0f);
+        z[i] = random(-100.0f, 300.0f);
+        radius[i] = random(0.5f, 5.0f);
+    }
+
+    std::vector<uint32_t> visible;
+    visible.reserve(kCasterCount);
+    for (uint32_t i = 0; i < cascades.GetCascadeCount(); ++i)
+    {
+        seconds = Benchmark::Measure(20, [&]()
+                                     {
+                                         cascades.CullCasters(i, x.data(), y.data(), z.data(), radius.data(), kCasterCount, visible);
+                                     });
+        auto name = "CullCasters, cascade " + std::to_string(i) + ", " + std::to_string(visible.size()) + " of 100000 visible";
+        Benchmark::Report(name.c_str(), seconds, kCasterCount, "spheres");
+    }
+}
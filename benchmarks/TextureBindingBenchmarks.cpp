@@ -0,0 +1,123 @@
+#include "Benchmark.h"
+#include "Result.h"
+#include "Utils/TextureTable.h"
+
+#include <cstdio>
+#include <tuple>
+#include <unordered_map>
+
+// TextureManager needs a device, so its old binding path is rebuilt here on plain types and compared with
+// the TextureTable it binds through now. The descriptor heap is a stand in with a virtual call, as
+// ID3D12DescriptorHeap's heap start is
+
+static constexpr uint32_t kTextureCount = 4096;
+static constexpr uint32_t kLookups = 1 << 20;
+static constexpr uint64_t kDescriptorSize = 32;
+
+struct GPUHandle
+{
+    uint64_t ptr;
+};
+
+struct DescriptorHeap
+{
+    virtual ~DescriptorHeap() = default;
+    virtual GPUHandle GetGPUDescriptorHandleForHeapStart() const = 0;
+};
+
+struct ShaderVisibleHeap : DescriptorHeap
+{
+    GPUHandle GetGPUDescriptorHandleForHeapStart() const override
+    {
+        return { 0x100000 };
+    }
+};
+
+// Before: texture index -> (SRV, UAV, RTV, DSV) heap indices; every bind looked the index up and
+// computed the handle from the heap start
+class MapBinding
+{
+public:
+    MapBinding(const DescriptorHeap *heap): mHeap(heap)
+    {
+        for (uint32_t i = 0; i < kTextureCount; ++i)
+        {
+            mTextureIndexToHeapIndex[i] = { (int32_t)i, -1, -1, -1 };
+        }
+    }
+
+    Result<GPUHandle> GetGPUDescriptorSrvHandleForTextureIndex(uint32_t textureIndex)
+    {
+        if (textureIndex >= kTextureCount || mTextureIndexToHeapIndex.find(textureIndex) == mTextureIndexToHeapIndex.end())
+        {
+            return std::nullopt;
+        }
+        auto heapIndex = std::get<0>(mTextureIndexToHeapIndex[textureIndex]);
+        if (heapIndex == -1)
+        {
+            return std::nullopt;
+        }
+        return GPUHandle{ mHeap->GetGPUDescriptorHandleForHeapStart().ptr + heapIndex * kDescriptorSize };
+    }
+
+private:
+    const DescriptorHeap *mHeap;
+    std::unordered_map<uint32_t, std::tuple<int32_t, int32_t, int32_t, int32_t>> mTextureIndexToHeapIndex;
+};
+
+// Draws come sorted by material, not by texture, so the indices are scattered
+static std::vector<uint32_t> MakeBindOrder()
+{
+    std::vector<uint32_t> order(kLookups);
+    uint32_t state = 0x9e3779b9;
+    for (auto &index : order)
+    {
+        state = state * 1664525u + 1013904223u;
+        index = (state >> 8) % kTextureCount;
+    }
+    return order;
+}
+
+BENCHMARK(TextureBinding, MapVersusTable)
+{
+    ShaderVisibleHeap heap;
+    auto order = MakeBindOrder();
+    // Summed so the lookups can't be optimized away
+    volatile uint64_t sink = 0;
+
+    MapBinding mapBinding(&heap);
+    double mapSeconds = Benchmark::Measure(5, [&]()
+                                           {
+                                               uint64_t sum = 0;
+                                               for (auto index : order)
+                                               {
+                                                   auto handle = mapBinding.GetGPUDescriptorSrvHandleForTextureIndex(index);
+                                                   sum += handle.Valid() ? handle.Get().ptr : 0;
+                                               }
+                                               sink = sink + sum;
+                                           });
+    Benchmark::Report("unordered_map + heap start, 4096 textures", mapSeconds, kLookups, "binds");
+
+    // Filled as TextureManager fills it, with the handles computed once from the heap start
+    TextureTable textureTable;
+    std::vector<TextureTable::Handle> handles(kTextureCount);
+    for (uint32_t i = 0; i < kTextureCount; ++i)
+    {
+        textureTable.Add();
+        auto &entry = textureTable.GetEntry(i);
+        entry.HeapIndices[TextureTable::kSrv] = (int32_t)i;
+        entry.SrvGPU = heap.GetGPUDescriptorHandleForHeapStart().ptr + i * kDescriptorSize;
+        handles[i] = textureTable.GetHandle(i);
+    }
+    double tableSeconds = Benchmark::Measure(5, [&]()
+                                             {
+                                                 uint64_t sum = 0;
+                                                 for (auto index : order)
+                                                 {
+                                                     sum += textureTable.GetSrvGPU(handles[index]);
+                                                 }
+                                                 sink = sink + sum;
+                                             });
+    Benchmark::Report("Texture table, 4096 textures", tableSeconds, kLookups, "binds");
+    std::printf("    %-52s %12.2fx\n", "Speedup over the map", mapSeconds / tableSeconds);
+}
@@ -0,0 +1,71 @@
+#include "Benchmark.h"
+#include "JobSystem.h"
+
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+namespace Benchmark
+{
+
+std::vector<Case> &GetCases()
+{
+    static std::vector<Case> cases;
+    return cases;
+}
+
+void Report(const char *name, double seconds, double items, const char *unit)
+{
+    if (items > 0.0 && unit)
+    {
+        std::printf("    %-52s %12.3f ms %12.2f M%s/s\n", name, seconds * 1e3, items / seconds / 1e6, unit);
+    }
+    else
+    {
+        std::printf("    %-52s %12.3f ms\n", name, seconds * 1e3);
+    }
+}
+
+void RestartJobSystem(uint32_t workerCount)
+{
+    JobSystem::Get()->Shutdown();
+    JobSystem::Get()->Init(workerCount);
+}
+
+std::vector<uint32_t> GetWorkerCounts()
+{
+    uint32_t maxWorkers = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    std::vector<uint32_t> workerCounts;
+    for (uint32_t workers = 1; workers < maxWorkers; workers *= 2)
+    {
+        workerCounts.push_back(workers);
+    }
+    workerCounts.push_back(maxWorkers);
+    return workerCounts;
+}
+
+} // namespace Benchmark
+
+// Usage: Benchmarks [suite]. Without a suite every benchmark runs
+int main(int argc, char **argv)
+{
+    const char *suite = argc > 1 ? argv[1] : nullptr;
+    JobSystem::Get()->Init();
+    std::printf("%u hardware threads, %u workers\n", std::thread::hardware_concurrency(), JobSystem::Get()->GetWorkerCount());
+
+    uint32_t ran = 0;
+    for (const auto &benchmark : Benchmark::GetCases())
+    {
+        if (suite && std::strcmp(suite, benchmark.Suite) != 0)
+        {
+            continue;
+        }
+
+        std::printf("%s.%s\n", benchmark.Suite, benchmark.Name);
+        benchmark.Function();
+        ++ran;
+    }
+
+    JobSystem::Get()->Shutdown();
+    return ran == 0 ? 1 : 0;
+}
@@ -0,0 +1,119 @@
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+static std::atomic<uint64_t> gAllocations = 0;
+static std::atomic<uint64_t> gAllocatedBytes = 0;
+
+static AllocationCounter::Statistics gFrameStart = {};
+static AllocationCounter::Statistics gLastFrame = {};
+
+AllocationCounter::Statistics AllocationCounter::GetTotal()
+{
+    return { gAllocations.load(std::memory_order_relaxed), gAllocatedBytes.load(std::memory_order_relaxed) };
+}
+
+AllocationCounter::Statistics AllocationCounter::EndFrame()
+{
+    auto total = GetTotal();
+    gLastFrame = { total.Allocations - gFrameStart.Allocations, total.Bytes - gFrameStart.Bytes };
+    gFrameStart = total;
+    return gLastFrame;
+}
+
+AllocationCounter::Statistics AllocationCounter::GetLastFrame()
+{
+    return gLastFrame;
+}
+
+#if OBLIVION_COUNT_ALLOCATIONS
+
+static void *CountedAllocate(size_t size)
+{
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    gAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+    void *memory = std::malloc(size ? size : 1);
+    if (!memory)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+static void *CountedAllocate(size_t size, std::align_val_t alignment)
+{
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    gAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+    void *memory = _aligned_malloc(size ? size : 1, (size_t)alignment);
+    if (!memory)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void *operator new(size_t size)
+{
+    return CountedAllocate(size);
+}
+
+void *operator new[](size_t size)
+{
+    return CountedAllocate(size);
+}
+
+void *operator new(size_t size, std::align_val_t alignment)
+{
+    return CountedAllocate(size, alignment);
+}
+
+void *operator new[](size_t size, std::align_val_t alignment)
+{
+    return CountedAllocate(size, alignment);
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::align_val_t) noexcept
+{
+    _aligned_free(memory);
+}
+
+void operator delete[](void *memory, std::align_val_t) noexcept
+{
+    _aligned_free(memory);
+}
+
+void operator delete(void *memory, size_t, std::align_val_t) noexcept
+{
+    _aligned_free(memory);
+}
+
+void operator delete[](void *memory, size_t, std::align_val_t) noexcept
+{
+    _aligned_free(memory);
+}
+
+#endif
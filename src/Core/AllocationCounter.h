@@ -0,0 +1,37 @@
+#pragma once
+
+
+#include <atomic>
+#include <cstdint>
+
+// Set OBLIVION_COUNT_ALLOCATIONS to 0 to use the default global operator new / delete
+#ifndef OBLIVION_COUNT_ALLOCATIONS
+#define OBLIVION_COUNT_ALLOCATIONS 1
+#endif
+
+namespace AllocationCounter
+{
+
+struct Statistics
+{
+    uint64_t Allocations;
+    uint64_t Bytes;
+};
+
+/// <summary>
+/// Number of heap allocations done through the global operator new since the application started.
+/// Always returns zero when OBLIVION_COUNT_ALLOCATIONS is 0
+/// </summary>
+Statistics GetTotal();
+
+/// <summary>
+/// Call this once per frame. Returns how many allocations happened since the previous call
+/// </summary>
+Statistics EndFrame();
+
+/// <summary>
+/// Allocations counted by the last EndFrame() call
+/// </summary>
+Statistics GetLastFrame();
+
+} // namespace AllocationCounter
@@ -0,0 +1,25 @@
+#include "CpuFeatures.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static bool DetectAVX()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    // The OS must save the upper halves of the ymm registers too
+    return osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+#else
+    return __builtin_cpu_supports("avx");
+#endif
+}
+
+bool CpuFeatures::HasAVX()
+{
+    static const bool hasAVX = DetectAVX();
+    return hasAVX;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+
+// Marks a function that uses AVX intrinsics. Only call it after checking CpuFeatures::HasAVX()
+#if defined(_MSC_VER)
+// MSVC accepts AVX intrinsics in any function
+#define TARGET_AVX
+#else
+#define TARGET_AVX __attribute__((target("avx")))
+#endif
+
+namespace CpuFeatures
+{
+
+/// <summary>
+/// Whether both the CPU and the OS support AVX. Checked once, the first time it's called
+/// </summary>
+bool HasAVX();
+
+} // namespace CpuFeatures
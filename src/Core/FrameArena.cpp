@@ -0,0 +1,72 @@
+#include "FrameArena.h"
+
+bool FrameArena::Init()
+{
+    mMainThreadId = std::this_thread::get_id();
+    for (uint32_t i = 0; i < mArenas.size(); ++i)
+    {
+        CHECK(mArenas[i].Init(kMainArenaSize), false, "Unable to initialize frame arena {}", i);
+    }
+    return true;
+}
+
+void FrameArena::BeginFrame(uint32_t frameIndex)
+{
+    mArenas[frameIndex].Reset();
+    mGenerations[frameIndex]++;
+    mFrameIndex = frameIndex;
+}
+
+LinearArena *FrameArena::GetArena()
+{
+    if (std::this_thread::get_id() == mMainThreadId)
+    {
+        return &mArenas[mFrameIndex];
+    }
+    return GetThreadArena();
+}
+
+size_t FrameArena::GetUsed() const
+{
+    return mArenas[mFrameIndex].GetUsed();
+}
+
+size_t FrameArena::GetPeak() const
+{
+    size_t peak = 0;
+    for (const auto &arena : mArenas)
+    {
+        peak = std::max(peak, arena.GetPeak());
+    }
+    return peak;
+}
+
+size_t FrameArena::GetCapacity() const
+{
+    return mArenas[mFrameIndex].GetCapacity();
+}
+
+LinearArena *FrameArena::GetThreadArena()
+{
+    struct ThreadArenas
+    {
+        std::array<LinearArena, Direct3D::kBufferCount> Arenas;
+        std::array<uint64_t, Direct3D::kBufferCount> Generations = {};
+    };
+    thread_local ThreadArenas threadArenas;
+
+    uint32_t frameIndex = mFrameIndex;
+    auto &arena = threadArenas.Arenas[frameIndex];
+    if (arena.GetCapacity() == 0)
+    {
+        CHECKSHOW(arena.Init(kWorkerArenaSize), "Unable to initialize worker arena for frame {}", frameIndex);
+    }
+
+    uint64_t generation = mGenerations[frameIndex];
+    if (threadArenas.Generations[frameIndex] != generation)
+    {
+        arena.Reset();
+        threadArenas.Generations[frameIndex] = generation;
+    }
+    return &arena;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+
+#include <Oblivion.h>
+#include <ISingletone.h>
+#include "Direct3D.h"
+#include "LinearArena.h"
+
+#include <atomic>
+
+/// <summary>
+/// Transient per-frame memory. There is one arena for every frame in flight and each one is
+/// reset once the fence for its frame has completed, so anything allocated from it is valid
+/// until the same frame resource is reused. Worker threads get their own thread-local arenas,
+/// reset lazily the first time they are used in a new frame
+/// </summary>
+class FrameArena : public ISingletone<FrameArena>
+{
+    MAKE_SINGLETONE_CAPABLE(FrameArena);
+
+public:
+    static constexpr const size_t kMainArenaSize = _4MiB;
+    static constexpr const size_t kWorkerArenaSize = _1MiB;
+
+private:
+    FrameArena() = default;
+    ~FrameArena() = default;
+
+public:
+    bool Init();
+
+    /// <summary>
+    /// Must be called after waiting for the fence of the frame resource at frameIndex
+    /// </summary>
+    void BeginFrame(uint32_t frameIndex);
+
+    /// <summary>
+    /// Returns the main arena when called from the thread that owns the frame loop
+    /// and the calling thread's own arena otherwise
+    /// </summary>
+    LinearArena *GetArena();
+
+    template <typename T>
+    ArenaAllocator<T> GetAllocator()
+    {
+        return ArenaAllocator<T>(GetArena());
+    }
+
+    template <typename T>
+    ArenaVector<T> MakeVector()
+    {
+        return ArenaVector<T>(GetAllocator<T>());
+    }
+
+public:
+    size_t GetUsed() const;
+    size_t GetPeak() const;
+    size_t GetCapacity() const;
+
+private:
+    LinearArena *GetThreadArena();
+
+private:
+    std::array<LinearArena, Direct3D::kBufferCount> mArenas;
+    std::array<std::atomic<uint64_t>, Direct3D::kBufferCount> mGenerations = {};
+    std::atomic<uint32_t> mFrameIndex = 0;
+
+    std::thread::id mMainThreadId;
+};
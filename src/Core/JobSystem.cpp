@@ -0,0 +1,366 @@
+#include "JobSystem.h"
+
+#include <random>
+
+static thread_local int32_t gWorkerIndex = -1;
+
+bool JobSystem::WorkStealingDeque::Push(Job *job)
+{
+    int64_t bottom = mBottom.load(std::memory_order_relaxed);
+    int64_t top = mTop.load(std::memory_order_acquire);
+    if (bottom - top >= (int64_t)kDequeSize)
+    {
+        return false;
+    }
+
+    mJobs[bottom & (kDequeSize - 1)].store(job, std::memory_order_relaxed);
+    mBottom.store(bottom + 1, std::memory_order_release);
+    return true;
+}
+
+auto JobSystem::WorkStealingDeque::Pop() -> Job *
+{
+    int64_t bottom = mBottom.load(std::memory_order_relaxed) - 1;
+    mBottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = mTop.load(std::memory_order_relaxed);
+
+    if (top > bottom)
+    {
+        // Empty
+        mBottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job *job = mJobs[bottom & (kDequeSize - 1)].load(std::memory_order_relaxed);
+    if (top == bottom)
+    {
+        // Last job; race against thieves for it
+        if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            job = nullptr;
+        }
+        mBottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+auto JobSystem::WorkStealingDeque::Steal() -> Job *
+{
+    int64_t top = mTop.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = mBottom.load(std::memory_order_acquire);
+
+    if (top >= bottom)
+    {
+        return nullptr;
+    }
+
+    Job *job = mJobs[top & (kDequeSize - 1)].load(std::memory_order_relaxed);
+    if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+        return nullptr;
+    }
+    return job;
+}
+
+JobSystem::~JobSystem()
+{
+    Shutdown();
+}
+
+bool JobSystem::Init(uint32_t workerCount, std::function<void(uint32_t)> onWorkerStart)
+{
+    if (mRunning)
+    {
+        return false;
+    }
+
+    if (workerCount == 0)
+    {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    mMainThreadId = std::this_thread::get_id();
+    gWorkerIndex = 0;
+
+    mDeques.clear();
+    mJobPools.clear();
+    for (uint32_t i = 0; i < workerCount + 1; ++i)
+    {
+        mDeques.push_back(std::make_unique<WorkStealingDeque>());
+        mJobPools.push_back(std::make_unique<JobPool>());
+    }
+
+    mRunning = true;
+    for (uint32_t i = 1; i <= workerCount; ++i)
+    {
+        mWorkers.emplace_back(&JobSystem::WorkerLoop, this, i, onWorkerStart);
+    }
+    return true;
+}
+
+void JobSystem::Shutdown()
+{
+    if (!mRunning)
+    {
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mSleepLock);
+        mRunning = false;
+    }
+    mWakeCondition.notify_all();
+
+    for (auto &worker : mWorkers)
+    {
+        worker.join();
+    }
+    mWorkers.clear();
+
+    // Jobs left behind are finished on the calling thread, so nobody waits forever on their counters
+    while (RunOneJob())
+        ;
+    gWorkerIndex = -1;
+}
+
+void JobSystem::Wait(const JobCounter &counter)
+{
+    while (!counter.IsDone())
+    {
+        if (!RunOneJob())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::ScheduleOnMainThread(std::function<void()> function)
+{
+    std::unique_lock<std::mutex> lock(mMainThreadJobsLock);
+    mMainThreadJobs.push_back(std::move(function));
+}
+
+void JobSystem::RunMainThreadJobs()
+{
+    {
+        std::unique_lock<std::mutex> lock(mMainThreadJobsLock);
+        std::swap(mMainThreadJobs, mRunningMainThreadJobs);
+    }
+
+    for (auto &job : mRunningMainThreadJobs)
+    {
+        job();
+    }
+    mRunningMainThreadJobs.clear();
+}
+
+uint32_t JobSystem::GetWorkerCount() const
+{
+    return (uint32_t)mWorkers.size();
+}
+
+bool JobSystem::IsMainThread() const
+{
+    return std::this_thread::get_id() == mMainThreadId;
+}
+
+auto JobSystem::AllocateJob() -> Job *
+{
+    // Pools belong to the system rather than to threads, so jobs left behind by a worker outlive it
+    if (gWorkerIndex >= 0 && gWorkerIndex < (int32_t)mJobPools.size())
+    {
+        return AllocateJob(*mJobPools[gWorkerIndex]);
+    }
+
+    std::unique_lock<std::mutex> lock(mExternalJobPoolLock);
+    return AllocateJob(mExternalJobPool);
+}
+
+auto JobSystem::AllocateJob(JobPool &pool) -> Job *
+{
+    // Jobs mostly finish in the order they were scheduled, so the slot after the last one handed out is usually free
+    uint32_t capacity = (uint32_t)pool.Blocks.size() * kJobPoolSize;
+    for (uint32_t i = 0; i < capacity; ++i)
+    {
+        uint32_t index = (pool.Next + i) % capacity;
+        Job *job = &pool.Blocks[index / kJobPoolSize][index % kJobPoolSize];
+        if (job->Finished.load(std::memory_order_acquire))
+        {
+            job->Finished.store(false, std::memory_order_relaxed);
+            pool.Next = index + 1;
+            return job;
+        }
+    }
+
+    // Every job is in flight; a new block keeps the ones already handed out where they are
+    pool.Blocks.push_back(std::make_unique<Job[]>(kJobPoolSize));
+    Job *job = &pool.Blocks.back()[0];
+    job->Finished.store(false, std::memory_order_relaxed);
+    pool.Next = capacity + 1;
+    return job;
+}
+
+void JobSystem::Push(Job *job)
+{
+    mQueuedJobs.fetch_add(1, std::memory_order_seq_cst);
+
+    bool pushed = false;
+    if (gWorkerIndex >= 0 && gWorkerIndex < (int32_t)mDeques.size())
+    {
+        pushed = mDeques[gWorkerIndex]->Push(job);
+    }
+    if (!pushed)
+    {
+        std::unique_lock<std::mutex> lock(mInjectedJobsLock);
+        mInjectedJobs.push_back(job);
+    }
+
+    if (mSleepingWorkers.load(std::memory_order_seq_cst) > 0)
+    {
+        std::unique_lock<std::mutex> lock(mSleepLock);
+        mWakeCondition.notify_one();
+    }
+}
+
+bool JobSystem::Park(Job *job)
+{
+    const JobCounter &dependency = *job->Dependency;
+    std::unique_lock<std::mutex> lock(dependency.mWaitersLock);
+    uint32_t pending = dependency.mPending.fetch_or(JobCounter::kWaitersFlag, std::memory_order_acq_rel);
+    if ((pending & ~JobCounter::kWaitersFlag) == 0)
+    {
+        // Done already. Waiters left over belong to whoever brought the counter to zero and is about to release them
+        if (dependency.mWaiters.empty())
+        {
+            dependency.mPending.fetch_and(~JobCounter::kWaitersFlag, std::memory_order_relaxed);
+        }
+        return false;
+    }
+
+    dependency.mWaiters.push_back(job);
+    return true;
+}
+
+void JobSystem::ReleaseWaiters(const JobCounter &counter)
+{
+    std::vector<void *> waiters;
+    {
+        std::unique_lock<std::mutex> lock(counter.mWaitersLock);
+        counter.mPending.fetch_and(~JobCounter::kWaitersFlag, std::memory_order_relaxed);
+        std::swap(waiters, counter.mWaiters);
+    }
+
+    // A counter scheduled on again before the lock was taken may have woken jobs too early; Execute parks them again
+    for (auto waiter : waiters)
+    {
+        Push((Job *)waiter);
+    }
+}
+
+auto JobSystem::FindJob() -> Job *
+{
+    Job *job = nullptr;
+    if (gWorkerIndex >= 0 && gWorkerIndex < (int32_t)mDeques.size())
+    {
+        job = mDeques[gWorkerIndex]->Pop();
+    }
+
+    if (!job)
+    {
+        std::unique_lock<std::mutex> lock(mInjectedJobsLock);
+        if (!mInjectedJobs.empty())
+        {
+            job = mInjectedJobs.back();
+            mInjectedJobs.pop_back();
+        }
+    }
+
+    if (!job && !mDeques.empty())
+    {
+        thread_local std::minstd_rand generator(std::random_device{}());
+        uint32_t dequeCount = (uint32_t)mDeques.size();
+        uint32_t start = generator() % dequeCount;
+        for (uint32_t i = 0; i < dequeCount && !job; ++i)
+        {
+            uint32_t victim = (start + i) % dequeCount;
+            if ((int32_t)victim != gWorkerIndex)
+            {
+                job = mDeques[victim]->Steal();
+            }
+        }
+    }
+
+    if (job)
+    {
+        mQueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+bool JobSystem::RunOneJob()
+{
+    Job *job = FindJob();
+    if (!job)
+    {
+        return false;
+    }
+    Execute(job);
+    return true;
+}
+
+void JobSystem::Execute(Job *job)
+{
+    if (job->Dependency && !job->Dependency->IsDone() && Park(job))
+    {
+        return;
+    }
+
+    auto counter = job->Counter;
+    job->Invoke(job);
+    job->Finished.store(true, std::memory_order_release);
+
+    // Without waiters the counter may be gone as soon as it reaches zero, so it's only touched again if it has some
+    uint32_t pending = counter->mPending.fetch_sub(1, std::memory_order_acq_rel);
+    if (pending == (JobCounter::kWaitersFlag | 1))
+    {
+        ReleaseWaiters(*counter);
+    }
+}
+
+void JobSystem::WorkerLoop(uint32_t workerIndex, std::function<void(uint32_t)> onWorkerStart)
+{
+    gWorkerIndex = (int32_t)workerIndex;
+    if (onWorkerStart)
+    {
+        onWorkerStart(workerIndex);
+    }
+
+    uint32_t idleSpins = 0;
+    while (mRunning.load(std::memory_order_relaxed))
+    {
+        if (RunOneJob())
+        {
+            idleSpins = 0;
+            continue;
+        }
+
+        if (++idleSpins < kSpinCount)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mSleepLock);
+        mSleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+        mWakeCondition.wait(lock, [this]()
+                            {
+                                return !mRunning.load(std::memory_order_relaxed) ||
+                                    mQueuedJobs.load(std::memory_order_seq_cst) > 0;
+                            });
+        mSleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+        idleSpins = 0;
+    }
+}
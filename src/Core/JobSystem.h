@@ -0,0 +1,207 @@
+#pragma once
+
+
+#include <ISingletone.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class JobCounter
+{
+    friend class JobSystem;
+
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter &) = delete;
+    JobCounter &operator=(const JobCounter &) = delete;
+
+public:
+    bool IsDone() const
+    {
+        return (mPending.load(std::memory_order_acquire) & ~kWaitersFlag) == 0;
+    }
+
+private:
+    // Set in mPending while jobs are parked on the counter, so whoever brings it to zero knows to wake them
+    static constexpr const uint32_t kWaitersFlag = 1u << 31;
+
+    // Jobs wait on counters they only read, so the waiter bookkeeping is mutable
+    mutable std::atomic<uint32_t> mPending = 0;
+    mutable std::mutex mWaitersLock;
+    // JobSystem::Job pointers, which isn't a complete type here
+    mutable std::vector<void *> mWaiters;
+};
+
+/// <summary>
+/// Work-stealing job system. Every worker (and the thread that called Init) owns a Chase-Lev deque:
+/// the owner pushes and pops at the bottom, idle threads steal from the top. Jobs are tracked with
+/// JobCounters; Wait() runs other jobs instead of blocking, so it's safe to wait from inside a job.
+/// Jobs scheduled from threads that are not part of the system go through a locked queue.
+/// </summary>
+class JobSystem : public ISingletone<JobSystem>
+{
+    MAKE_SINGLETONE_CAPABLE(JobSystem);
+
+public:
+    static constexpr const uint32_t kDequeSize = 4096;
+    // Jobs are allocated in blocks of this many; a pool grows by a block when all of its jobs are in flight
+    static constexpr const uint32_t kJobPoolSize = 4096;
+    static constexpr const uint32_t kSpinCount = 64;
+
+    struct Job
+    {
+        static constexpr const size_t kStorageSize = 64;
+
+        void (*Invoke)(Job *job);
+        JobCounter *Counter;
+        const JobCounter *Dependency;
+        // Set once the job ran, so its slot can be handed out again
+        std::atomic<bool> Finished = true;
+        alignas(std::max_align_t) unsigned char Storage[kStorageSize];
+    };
+
+private:
+    class WorkStealingDeque
+    {
+    public:
+        bool Push(Job *job);
+        Job *Pop();
+        Job *Steal();
+
+    private:
+        alignas(64) std::atomic<int64_t> mTop = 0;
+        alignas(64) std::atomic<int64_t> mBottom = 0;
+        std::atomic<Job *> mJobs[kDequeSize] = {};
+    };
+
+    struct JobPool
+    {
+        std::vector<std::unique_ptr<Job[]>> Blocks;
+        uint32_t Next = 0;
+    };
+
+private:
+    JobSystem() = default;
+    ~JobSystem();
+
+public:
+    /// <summary>
+    /// Starts workerCount threads (hardware threads - 1 if 0). The calling thread becomes
+    /// the main thread of the system. onWorkerStart runs on every worker before it takes any job
+    /// </summary>
+    bool Init(uint32_t workerCount = 0, std::function<void(uint32_t)> onWorkerStart = nullptr);
+    void Shutdown();
+
+    /// <summary>
+    /// Schedules function to run on any thread. If dependency is given, the job is parked on it and queued once
+    /// it's done, so dependency must live until the job started
+    /// </summary>
+    template <typename Function>
+    void Schedule(JobCounter &counter, Function &&function, const JobCounter *dependency = nullptr)
+    {
+        using Callable = std::decay_t<Function>;
+        static_assert(sizeof(Callable) <= Job::kStorageSize, "Job captures too much state. Capture by reference instead");
+        static_assert(alignof(Callable) <= alignof(std::max_align_t), "Job callable is over-aligned");
+
+        Job *job = AllocateJob();
+        new (job->Storage) Callable(std::forward<Function>(function));
+        job->Invoke = [](Job *job)
+        {
+            auto callable = std::launder((Callable *)job->Storage);
+            (*callable)();
+            callable->~Callable();
+        };
+        job->Counter = &counter;
+        job->Dependency = dependency;
+
+        counter.mPending.fetch_add(1, std::memory_order_relaxed);
+        if (!dependency || !Park(job))
+        {
+            Push(job);
+        }
+    }
+
+    /// <summary>
+    /// Calls function(begin, end) for batches of at most batchSize indices in [0, count) and waits for all of them
+    /// </summary>
+    template <typename Function>
+    void ParallelFor(uint32_t count, uint32_t batchSize, Function &&function)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        batchSize = batchSize == 0 ? 1 : batchSize;
+
+        JobCounter counter;
+        for (uint32_t begin = 0; begin < count; begin += batchSize)
+        {
+            uint32_t end = std::min(count, begin + batchSize);
+            Schedule(counter, [&function, begin, end]()
+                     {
+                         function(begin, end);
+                     });
+        }
+        Wait(counter);
+    }
+
+    /// <summary>
+    /// Runs jobs on the calling thread until counter reaches zero
+    /// </summary>
+    void Wait(const JobCounter &counter);
+
+    /// <summary>
+    /// Queues function to run on the main thread the next time RunMainThreadJobs() is called
+    /// </summary>
+    void ScheduleOnMainThread(std::function<void()> function);
+    void RunMainThreadJobs();
+
+public:
+    uint32_t GetWorkerCount() const;
+    bool IsMainThread() const;
+
+private:
+    Job *AllocateJob();
+    static Job *AllocateJob(JobPool &pool);
+    void Push(Job *job);
+    bool Park(Job *job);
+    void ReleaseWaiters(const JobCounter &counter);
+    Job *FindJob();
+    bool RunOneJob();
+    void Execute(Job *job);
+    void WorkerLoop(uint32_t workerIndex, std::function<void(uint32_t)> onWorkerStart);
+
+private:
+    // Index 0 is the main thread, workers are 1..N
+    std::vector<std::unique_ptr<WorkStealingDeque>> mDeques;
+    std::vector<std::thread> mWorkers;
+
+    // Same indices as mDeques. Threads outside the system share the external pool
+    std::vector<std::unique_ptr<JobPool>> mJobPools;
+    std::mutex mExternalJobPoolLock;
+    JobPool mExternalJobPool;
+
+    std::mutex mInjectedJobsLock;
+    std::vector<Job *> mInjectedJobs;
+
+    std::atomic<bool> mRunning = false;
+    std::atomic<int32_t> mQueuedJobs = 0;
+    std::atomic<uint32_t> mSleepingWorkers = 0;
+    std::mutex mSleepLock;
+    std::condition_variable mWakeCondition;
+
+    std::mutex mMainThreadJobsLock;
+    std::vector<std::function<void()>> mMainThreadJobs;
+    std::vector<std::function<void()>> mRunningMainThreadJobs;
+    std::thread::id mMainThreadId;
+};
@@ -0,0 +1,93 @@
+#include "LinearArena.h"
+#include <malloc.h>
+
+LinearArena::~LinearArena()
+{
+    Release();
+}
+
+bool LinearArena::Init(size_t capacity)
+{
+    Release();
+
+    mMemory = (uint8_t *)_aligned_malloc(capacity, kDefaultAlignment);
+    CHECK(mMemory, false, "Unable to allocate {} bytes for a linear arena", capacity);
+    mCapacity = capacity;
+    mOffset = 0;
+    mPeak = 0;
+
+    return true;
+}
+
+void *LinearArena::Allocate(size_t size, size_t alignment)
+{
+    size_t alignedOffset = Math::AlignUp(mOffset, alignment);
+    if (mMemory && alignedOffset + size <= mCapacity)
+    {
+        mOffset = alignedOffset + size;
+        mPeak = std::max(mPeak, mOffset + mOverflowSize);
+        return mMemory + alignedOffset;
+    }
+
+    auto block = (uint8_t *)_aligned_malloc(std::max<size_t>(size, 1), std::max(alignment, kDefaultAlignment));
+    CHECK(block, nullptr, "Unable to allocate an overflow block of {} bytes", size);
+    mOverflowBlocks.push_back(block);
+    mOverflowSize += size + alignment;
+    mPeak = std::max(mPeak, mOffset + mOverflowSize);
+
+    return block;
+}
+
+void LinearArena::Reset()
+{
+    if (!mOverflowBlocks.empty())
+    {
+        size_t newCapacity = Math::AlignUp(mCapacity + mOverflowSize, (size_t)_64KiB);
+        SHOWWARNING("Linear arena overflowed by {} bytes. Growing it from {} to {} bytes", mOverflowSize, mCapacity, newCapacity);
+
+        for (auto block : mOverflowBlocks)
+        {
+            _aligned_free(block);
+        }
+        mOverflowBlocks.clear();
+        mOverflowSize = 0;
+
+        size_t peak = mPeak;
+        CHECKRET(Init(newCapacity), "Unable to grow linear arena to {} bytes", newCapacity);
+        mPeak = peak;
+    }
+    mOffset = 0;
+}
+
+size_t LinearArena::GetCapacity() const
+{
+    return mCapacity;
+}
+
+size_t LinearArena::GetUsed() const
+{
+    return mOffset + mOverflowSize;
+}
+
+size_t LinearArena::GetPeak() const
+{
+    return mPeak;
+}
+
+void LinearArena::Release()
+{
+    for (auto block : mOverflowBlocks)
+    {
+        _aligned_free(block);
+    }
+    mOverflowBlocks.clear();
+    mOverflowSize = 0;
+
+    if (mMemory)
+    {
+        _aligned_free(mMemory);
+        mMemory = nullptr;
+    }
+    mCapacity = 0;
+    mOffset = 0;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+
+#include <Oblivion.h>
+
+class LinearArena
+{
+public:
+    static constexpr const size_t kDefaultAlignment = alignof(std::max_align_t);
+
+public:
+    LinearArena() = default;
+    ~LinearArena();
+
+    LinearArena(const LinearArena &) = delete;
+    LinearArena &operator=(const LinearArena &) = delete;
+
+public:
+    bool Init(size_t capacity);
+
+    void *Allocate(size_t size, size_t alignment = kDefaultAlignment);
+    /// <summary>
+    /// Releases everything allocated since the last reset. If the previous
+    /// cycle spilled into overflow blocks, the main block grows to fit it
+    /// so that the next cycles won't hit the heap again
+    /// </summary>
+    void Reset();
+
+    template <typename T, typename... Args>
+    T *New(Args &&...args)
+    {
+        void *memory = Allocate(sizeof(T), alignof(T));
+        return new (memory) T(std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    T *AllocateArray(size_t count)
+    {
+        return (T *)Allocate(sizeof(T) * count, alignof(T));
+    }
+
+public:
+    size_t GetCapacity() const;
+    size_t GetUsed() const;
+    size_t GetPeak() const;
+
+private:
+    void Release();
+
+private:
+    uint8_t *mMemory = nullptr;
+    size_t mCapacity = 0;
+    size_t mOffset = 0;
+
+    // Allocations that did not fit in the main block; freed on Reset
+    std::vector<uint8_t *> mOverflowBlocks;
+    size_t mOverflowSize = 0;
+
+    size_t mPeak = 0;
+};
+
+template <typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+public:
+    ArenaAllocator(LinearArena *arena) noexcept :
+        mArena(arena)
+    {
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &rhs) noexcept :
+        mArena(rhs.GetArena())
+    {
+    }
+
+public:
+    T *allocate(size_t count)
+    {
+        return mArena->AllocateArray<T>(count);
+    }
+
+    void deallocate(T *, size_t) noexcept
+    {
+        // Memory is reclaimed when the arena is reset
+    }
+
+    LinearArena *GetArena() const noexcept
+    {
+        return mArena;
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &rhs) const noexcept
+    {
+        return mArena == rhs.GetArena();
+    }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &rhs) const noexcept
+    {
+        return mArena != rhs.GetArena();
+    }
+
+private:
+    LinearArena *mArena;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+template <typename Key, typename Value, typename Compare = std::less<Key>>
+using ArenaMap = std::map<Key, Value, Compare, ArenaAllocator<std::pair<const Key, Value>>>;
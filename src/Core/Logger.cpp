@@ -1,6 +1,7 @@
 #include "Logger.h"
 
 std::ofstream Logger::gOutputStream("OblivionLogs.txt");
+std::mutex Logger::gOutputLock;
 
 void Logger::Init()
 {
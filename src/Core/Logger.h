@@ -3,7 +3,10 @@
 #include "Oblivion.h"
 #include "TypeOutput.h"
 
+#include <mutex>
+
 #include <fmt/core.h>
+#include <fmt/format.h>
 #include <fmt/chrono.h>
 #include <fmt/ranges.h>
 #include <fmt/os.h>
@@ -26,11 +29,12 @@ static constexpr const char *LogLevelString[] =
 };
 
 extern std::ofstream gOutputStream;
+extern std::mutex gOutputLock;
 
 void Init();
 
 template <typename... Args>
-constexpr void Log(LogLevel level, const char *fileName, unsigned int lineNumber, const char *functionName, const char *format, const Args&... args)
+void Log(LogLevel level, const char *fileName, unsigned int lineNumber, const char *functionName, const char *format, const Args&... args)
 {
     if (format[0] == '\0' || format == nullptr)
     {
@@ -51,15 +55,20 @@ constexpr void Log(LogLevel level, const char *fileName, unsigned int lineNumber
         style = fg(fmt::color::white);
     }
 #endif
-    std::string newFormat = fmt::format("[{}] {}:{} ({}) => {}\n", LogLevelString[(uint32_t)level], fileName, lineNumber, functionName, format);
-    std::string stringToPrint = fmt::format(newFormat, std::forward<const Args &>(args)...);
-    
+    // Format everything in a single stack buffer, so short messages don't touch the heap
+    fmt::memory_buffer message;
+    fmt::format_to(std::back_inserter(message), "[{}] {}:{} ({}) => ", LogLevelString[(uint32_t)level], fileName, lineNumber, functionName);
+    fmt::vformat_to(std::back_inserter(message), fmt::string_view(format), fmt::make_format_args(args...));
+    message.push_back('\n');
+    fmt::string_view stringToPrint(message.data(), message.size());
+
+    std::unique_lock<std::mutex> lock(gOutputLock);
 #ifdef COLOR_LOGS
-    fmt::print(style, stringToPrint);
+    fmt::print(style, "{}", stringToPrint);
 #else
-    fmt::print(stringToPrint);
+    fmt::print("{}", stringToPrint);
 #endif
-    gOutputStream << stringToPrint;
+    gOutputStream.write(message.data(), message.size());
     gOutputStream.flush();
 }
 
@@ -0,0 +1,240 @@
+#include "Profiler.h"
+#include "FrameArena.h"
+
+static const auto gProfilerEpoch = std::chrono::steady_clock::now();
+static constexpr const double kAverageFactor = 0.05;
+
+void Profiler::BeginZone(const char *name)
+{
+    auto buffer = GetThreadBuffer();
+    if (buffer->Depth < kMaxZoneDepth)
+    {
+        buffer->OpenZones[buffer->Depth] = { name, Now() };
+    }
+    buffer->Depth++;
+}
+
+void Profiler::EndZone()
+{
+    uint64_t end = Now();
+    auto buffer = GetThreadBuffer();
+    if (buffer->Depth == 0)
+    {
+        return;
+    }
+
+    buffer->Depth--;
+    if (buffer->Depth >= kMaxZoneDepth)
+    {
+        return;
+    }
+
+    auto [name, start] = buffer->OpenZones[buffer->Depth];
+
+    std::unique_lock<std::mutex> lock(buffer->Lock);
+    buffer->Events[buffer->WrittenEvents % kMaxEventsPerThread] = { name, start, end, buffer->Depth };
+    buffer->WrittenEvents++;
+}
+
+void Profiler::SetThreadName(const char *name)
+{
+    auto buffer = GetThreadBuffer();
+    std::unique_lock<std::mutex> lock(buffer->Lock);
+    buffer->ThreadName = name;
+}
+
+void Profiler::BeginFrame()
+{
+    mFrameStart = Now();
+}
+
+void Profiler::EndFrame()
+{
+    uint64_t frameEnd = Now();
+    mLastFrameMs = (double)(frameEnd - mFrameStart) / 1e6;
+
+    struct ZoneAccumulator
+    {
+        uint64_t FirstStart;
+        uint32_t Depth;
+        uint32_t Calls = 0;
+        uint64_t Total = 0;
+        uint64_t Max = 0;
+    };
+    using ZoneKey = std::tuple<uint32_t, const char *>;
+    auto frameArena = FrameArena::Get();
+    ArenaMap<ZoneKey, ZoneAccumulator> frameZones(frameArena->GetAllocator<ZoneKey>());
+
+    {
+        std::unique_lock<std::mutex> buffersLock(mThreadBuffersLock);
+        for (auto &buffer : mThreadBuffers)
+        {
+            std::unique_lock<std::mutex> lock(buffer->Lock);
+
+            uint64_t first = buffer->ScannedEvents;
+            if (buffer->WrittenEvents - first > kMaxEventsPerThread)
+            {
+                first = buffer->WrittenEvents - kMaxEventsPerThread;
+            }
+
+            for (uint64_t i = first; i < buffer->WrittenEvents; ++i)
+            {
+                const auto &event = buffer->Events[i % kMaxEventsPerThread];
+                uint64_t duration = event.End - event.Start;
+
+                auto [it, inserted] = frameZones.try_emplace({ buffer->ThreadId, event.Name });
+                auto &zone = it->second;
+                if (inserted || event.Start < zone.FirstStart)
+                {
+                    zone.FirstStart = event.Start;
+                    zone.Depth = event.Depth;
+                }
+                zone.Calls++;
+                zone.Total += duration;
+                zone.Max = std::max(zone.Max, duration);
+            }
+            buffer->ScannedEvents = buffer->WrittenEvents;
+        }
+    }
+
+    for (auto &zone : mZoneStatistics)
+    {
+        zone.Calls = 0;
+        zone.LastMs = 0.0;
+        zone.AverageMs *= (1.0 - kAverageFactor);
+    }
+
+    auto newZones = frameArena->MakeVector<std::tuple<uint64_t, uint32_t, const char *>>();
+    for (const auto &[key, zone] : frameZones)
+    {
+        const auto &[threadId, name] = key;
+        double totalMs = (double)zone.Total / 1e6;
+        double maxMs = (double)zone.Max / 1e6;
+
+        auto existing = std::find_if(mZoneStatistics.begin(), mZoneStatistics.end(), [&](const ZoneStatistics &stats)
+                                     {
+                                         return stats.ThreadId == threadId && stats.Name == name;
+                                     });
+        if (existing != mZoneStatistics.end())
+        {
+            existing->Calls = zone.Calls;
+            existing->LastMs = totalMs;
+            existing->AverageMs += kAverageFactor * totalMs;
+            existing->MaxMs = std::max(existing->MaxMs, maxMs);
+        }
+        else
+        {
+            newZones.emplace_back(zone.FirstStart, threadId, name);
+        }
+    }
+
+    // New zones are appended in start order, so a parent is always listed before its children
+    std::sort(newZones.begin(), newZones.end());
+    for (const auto &[firstStart, threadId, name] : newZones)
+    {
+        const auto &zone = frameZones[{ threadId, name }];
+        double totalMs = (double)zone.Total / 1e6;
+
+        ZoneStatistics stats = {};
+        stats.Name = name;
+        stats.ThreadId = threadId;
+        stats.Depth = zone.Depth;
+        stats.Calls = zone.Calls;
+        stats.LastMs = totalMs;
+        stats.AverageMs = totalMs;
+        stats.MaxMs = (double)zone.Max / 1e6;
+        mZoneStatistics.push_back(stats);
+    }
+
+    std::stable_sort(mZoneStatistics.begin(), mZoneStatistics.end(), [](const ZoneStatistics &lhs, const ZoneStatistics &rhs)
+                     {
+                         return lhs.ThreadId < rhs.ThreadId;
+                     });
+}
+
+const std::vector<Profiler::ZoneStatistics> &Profiler::GetZoneStatistics() const
+{
+    return mZoneStatistics;
+}
+
+double Profiler::GetLastFrameMs() const
+{
+    return mLastFrameMs;
+}
+
+bool Profiler::ExportChromeTrace(const std::string &path)
+{
+    fmt::memory_buffer trace;
+    fmt::format_to(std::back_inserter(trace), "{{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    auto escape = [](const char *str)
+    {
+        std::string result;
+        for (; str && *str; ++str)
+        {
+            if (*str == '"' || *str == '\\')
+            {
+                result.push_back('\\');
+            }
+            result.push_back(*str);
+        }
+        return result;
+    };
+
+    bool firstEvent = true;
+    uint64_t exportedEvents = 0;
+    {
+        std::unique_lock<std::mutex> buffersLock(mThreadBuffersLock);
+        for (auto &buffer : mThreadBuffers)
+        {
+            std::unique_lock<std::mutex> lock(buffer->Lock);
+
+            std::string threadName = buffer->ThreadName.empty() ? fmt::format("Thread {}", buffer->ThreadId) : buffer->ThreadName;
+            fmt::format_to(std::back_inserter(trace),
+                           "{}{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}",
+                           firstEvent ? "" : ",", buffer->ThreadId, escape(threadName.c_str()));
+            firstEvent = false;
+
+            uint64_t first = buffer->WrittenEvents > kMaxEventsPerThread ? buffer->WrittenEvents - kMaxEventsPerThread : 0;
+            for (uint64_t i = first; i < buffer->WrittenEvents; ++i)
+            {
+                const auto &event = buffer->Events[i % kMaxEventsPerThread];
+                fmt::format_to(std::back_inserter(trace),
+                               ",{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":0,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                               escape(event.Name), buffer->ThreadId,
+                               (double)event.Start / 1e3, (double)(event.End - event.Start) / 1e3);
+                exportedEvents++;
+            }
+        }
+    }
+    fmt::format_to(std::back_inserter(trace), "]}}");
+
+    std::ofstream output(path, std::ios::binary);
+    CHECK(output.is_open(), false, "Unable to open {} for writing the trace", path);
+    output.write(trace.data(), trace.size());
+
+    SHOWINFO("Exported {} profiler events to {}", exportedEvents, path);
+    return true;
+}
+
+Profiler::ThreadBuffer *Profiler::GetThreadBuffer()
+{
+    thread_local std::shared_ptr<ThreadBuffer> threadBuffer;
+    if (!threadBuffer)
+    {
+        auto profiler = Profiler::Get();
+
+        threadBuffer = std::make_shared<ThreadBuffer>();
+        threadBuffer->Events.resize(kMaxEventsPerThread);
+        threadBuffer->ThreadId = profiler->mNextThreadId++;
+
+        std::unique_lock<std::mutex> lock(profiler->mThreadBuffersLock);
+        profiler->mThreadBuffers.push_back(threadBuffer);
+    }
+    return threadBuffer.get();
+}
+
+uint64_t Profiler::Now()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - gProfilerEpoch).count();
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+
+#include <Oblivion.h>
+#include <ISingletone.h>
+
+#include <atomic>
+#include <mutex>
+
+// Set OBLIVION_PROFILE to 0 to compile every PROFILE_* macro out of the engine
+#ifndef OBLIVION_PROFILE
+#define OBLIVION_PROFILE 1
+#endif
+
+class Profiler : public ISingletone<Profiler>
+{
+    MAKE_SINGLETONE_CAPABLE(Profiler);
+
+public:
+    static constexpr const uint32_t kMaxEventsPerThread = 1 << 16;
+    static constexpr const uint32_t kMaxZoneDepth = 64;
+
+    struct Event
+    {
+        const char *Name;
+        uint64_t Start;
+        uint64_t End;
+        uint32_t Depth;
+    };
+
+    struct ZoneStatistics
+    {
+        const char *Name;
+        uint32_t ThreadId;
+        uint32_t Depth;
+        uint32_t Calls;
+        double LastMs;
+        double AverageMs;
+        double MaxMs;
+    };
+
+private:
+    struct ThreadBuffer
+    {
+        std::mutex Lock;
+        std::vector<Event> Events;
+        // Total events ever written; Events is used as a ring of kMaxEventsPerThread
+        uint64_t WrittenEvents = 0;
+        uint64_t ScannedEvents = 0;
+
+        std::array<std::tuple<const char *, uint64_t>, kMaxZoneDepth> OpenZones;
+        uint32_t Depth = 0;
+
+        uint32_t ThreadId = 0;
+        std::string ThreadName;
+    };
+
+private:
+    Profiler() = default;
+    ~Profiler() = default;
+
+public:
+    static void BeginZone(const char *name);
+    static void EndZone();
+    static void SetThreadName(const char *name);
+
+public:
+    void BeginFrame();
+    void EndFrame();
+
+    const std::vector<ZoneStatistics> &GetZoneStatistics() const;
+    double GetLastFrameMs() const;
+
+    bool ExportChromeTrace(const std::string &path);
+
+private:
+    static ThreadBuffer *GetThreadBuffer();
+    static uint64_t Now();
+
+private:
+    std::mutex mThreadBuffersLock;
+    std::vector<std::shared_ptr<ThreadBuffer>> mThreadBuffers;
+    std::atomic<uint32_t> mNextThreadId = 0;
+
+    uint64_t mFrameStart = 0;
+    double mLastFrameMs = 0.0;
+
+    std::vector<ZoneStatistics> mZoneStatistics;
+};
+
+class ProfileScope
+{
+public:
+    ProfileScope(const char *name)
+    {
+        Profiler::BeginZone(name);
+    }
+
+    ~ProfileScope()
+    {
+        Profiler::EndZone();
+    }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+};
+
+#if OBLIVION_PROFILE
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(__profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#define PROFILE_THREAD_NAME(name) Profiler::SetThreadName(name)
+#define PROFILE_BEGIN_FRAME() Profiler::Get()->BeginFrame()
+#define PROFILE_END_FRAME() Profiler::Get()->EndFrame()
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_THREAD_NAME(name)
+#define PROFILE_BEGIN_FRAME()
+#define PROFILE_END_FRAME()
+#endif
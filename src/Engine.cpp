@@ -2,6 +2,14 @@
 #include "Direct3D.h"
 #include "PipelineManager.h"
 #include "TextureManager.h"
+#include "TextureStreamer.h"
+#include "Model.h"
+#include "Profiler.h"
+#include "FrameArena.h"
+#include "AllocationCounter.h"
+#include "JobSystem.h"
+#include "Utils/UploadRingBuffer.h"
+#include "Utils/AsyncUploader.h"
 
 // Imgui stuff
 #include "Graphics/imgui/imgui.h"
@@ -13,6 +21,7 @@ extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg
 constexpr auto APPLICATION_NAME = TEXT("Game");
 constexpr auto ENGINE_NAME = TEXT("Oblivion");
 constexpr const char *CONFIG_FILE = "Oblivion.ini";
+constexpr const char *TRACE_FILE = "OblivionTrace.json";
 
 
 Engine::Engine()
@@ -29,6 +38,7 @@ bool Engine::Init(HINSTANCE hInstance)
 
 void Engine::Run()
 {
+    PROFILE_THREAD_NAME("Main thread");
     CHECKRET(OnInit(), "Failed toinitialize application");
 
     ShowWindow(mWindow, SW_SHOWNORMAL);
@@ -50,8 +60,12 @@ void Engine::Run()
         else
         {
             // SHOWINFO("~~~~~~~~~~~~~~~~~~~~ FRAME {} ~~~~~~~~~~~~~~~~~~~~", mCurrentFrame);
+            PROFILE_BEGIN_FRAME();
+            JobSystem::Get()->RunMainThreadJobs();
             CHECKBK(OnUpdate(), "Failed to update frame {}", mCurrentFrame);
             CHECKBK(OnRender(), "Failed to render frame {}", mCurrentFrame);
+            PROFILE_END_FRAME();
+            AllocationCounter::EndFrame();
             // SHOWINFO("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~");
         }
     }
@@ -98,6 +112,12 @@ bool Engine::OnInit()
     auto d3d = Direct3D::Get();
     SHOWINFO("Started initializing application");
 
+    CHECK(FrameArena::Get()->Init(), false, "Unable to initialize frame arenas");
+    CHECK(JobSystem::Get()->Init(0, [](uint32_t workerIndex)
+                                 {
+                                     PROFILE_THREAD_NAME(fmt::format("Worker {}", workerIndex).c_str());
+                                 }), false, "Unable to initialize job system");
+    SHOWINFO("Started job system with {} workers", JobSystem::Get()->GetWorkerCount());
     CHECK(InitD3D(), false, "Unable to initialize D3D");
     CHECK(InitInput(), false, "Unable to initialize input");
     
@@ -118,9 +138,16 @@ void Engine::OnDestroy()
     d3d->Signal(mFence.Get(), mCurrentFrame);
     d3d->WaitForFenceValue(mFence.Get(), mCurrentFrame++);
 
+    AsyncUploader::Get()->Flush();
+    TextureStreamer::Destroy();
+    AsyncUploader::Destroy();
+    JobSystem::Destroy();
+
     TextureManager::Destroy();
     Model::Destroy();
     PipelineManager::Destroy();
+    FrameArena::Destroy();
+    UploadRingBuffer::Destroy();
 
     ImGui_ImplDX12_Shutdown();
     ImGui_ImplWin32_Shutdown();
@@ -154,6 +181,7 @@ bool Engine::OnResize(uint32_t width, uint32_t height)
 
 bool Engine::OnUpdate()
 {
+    PROFILE_FUNCTION();
     float dt = 1.0f / ImGui::GetIO().Framerate;
     if (ImGui::GetIO().Framerate == 0.0f)
     {
@@ -165,12 +193,23 @@ bool Engine::OnUpdate()
     mCurrentFrameResource = &mFrameResources[mCurrentFrameResourceIndex];
     if (mCurrentFrameResource->FenceValue != 0 && mFence->GetCompletedValue() < mCurrentFrameResource->FenceValue)
     {
+        PROFILE_SCOPE("WaitForFrameResource");
         d3d->WaitForFenceValue(mFence.Get(), mCurrentFrameResource->FenceValue);
     }
+    FrameArena::Get()->BeginFrame(mCurrentFrameResourceIndex);
+    UploadRingBuffer::Get()->BeginFrame(mCurrentFrameResourceIndex);
+    TextureManager::Get()->BeginFrame(mCurrentFrameResourceIndex);
+    AsyncUploader::Get()->Poll();
+    Model::ResetBindlessStatistics();
 
-    MaterialManager::Get()->UpdateMaterialsBuffer(mCurrentFrameResource->MaterialsBuffers);
+    CHECK(MaterialManager::Get()->UpdateMaterialsBuffer(mCurrentFrameResourceIndex), false,
+          "Unable to update materials for frame {}", mCurrentFrame);
 
-    CHECK(OnUpdate(mCurrentFrameResource, dt), false, "Unable to update frame {}", mCurrentFrame);
+    {
+        PROFILE_SCOPE("Application::OnUpdate");
+        CHECK(OnUpdate(mCurrentFrameResource, dt), false, "Unable to update frame {}", mCurrentFrame);
+    }
+    TextureStreamer::Get()->Update();
 
 
     return true;
@@ -178,6 +217,7 @@ bool Engine::OnUpdate()
 
 bool Engine::OnRender()
 {
+    PROFILE_FUNCTION();
     auto d3d = Direct3D::Get();
     auto textureManager = TextureManager::Get();
 
@@ -186,15 +226,21 @@ bool Engine::OnRender()
 
     d3d->OnRenderBegin(mCommandList.Get());
 
-    CHECK(OnRender(mCommandList.Get(), mCurrentFrameResource), false, "Unable to render frame");
+    {
+        PROFILE_SCOPE("Application::OnRender");
+        CHECK(OnRender(mCommandList.Get(), mCurrentFrameResource), false, "Unable to render frame");
+    }
     CHECK(RenderGUI(), false, "Failed to render GUI");
 
     d3d->OnRenderEnd(mCommandList.Get());
 
     CHECK_HR(mCommandList->Close(), false);
 
-    d3d->ExecuteCommandList(mCommandList.Get());
-    d3d->Present();
+    {
+        PROFILE_SCOPE("ExecuteAndPresent");
+        d3d->ExecuteCommandList(mCommandList.Get());
+        d3d->Present();
+    }
     d3d->Signal(mFence.Get(), mCurrentFrame);
   
     mCurrentFrameResource->FenceValue = ++mCurrentFrame;
@@ -208,6 +254,13 @@ bool Engine::InitD3D()
 
     CHECK(d3d->Init(mWindow), false, "Unable to initialize D3D");
     CHECK(PipelineManager::Get()->Init(), false, "Unable to initialize pipeline manager");
+    CHECK(UploadRingBuffer::Get()->Init(), false, "Unable to initialize upload ring buffer");
+    CHECK(AsyncUploader::Get()->Init(), false, "Unable to initialize async uploader");
+    CHECK(TextureStreamer::Get()->Init(), false, "Unable to initialize texture streamer");
+    if (auto videoMemoryBudget = d3d->GetVideoMemoryBudget(); videoMemoryBudget.Valid())
+    {
+        TextureManager::Get()->GetMemoryBudget().SetBudget(videoMemoryBudget.Get());
+    }
 
     auto commandAllocator = d3d->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT);
     CHECK(commandAllocator.Valid(), false, "Unable to create a direct command allocator");
@@ -239,12 +292,7 @@ bool Engine::InitInput()
 
 bool Engine::InitFrameResources()
 {
-    auto d3d = Direct3D::Get();
-
-    CHECK_HR(mInitializationCommandAllocator->Reset(), false);
-    CHECK_HR(mCommandList->Reset(mInitializationCommandAllocator.Get(), nullptr), false);
-
-    MaterialManager::Get()->CloseAddingMaterials();
+    CHECK(MaterialManager::Get()->CloseAddingMaterials(), false, "Unable to close adding materials");
     uint32_t numModels = GetModelCount();
     uint32_t numPasses = GetPassCount();
     uint32_t numMaterials = MaterialManager::Get()->GetNumMaterials();
@@ -257,11 +305,26 @@ bool Engine::InitFrameResources()
     }
 
 
+    // Textures are uploaded on the copy queue while the rest of the engine keeps initializing.
+    // The direct queue waits for them on the GPU before the first frame uses them
+    auto uploader = AsyncUploader::Get();
+    auto uploadCommandList = uploader->GetCommandList();
+    CHECK(uploadCommandList, false, "Unable to get a command list for uploading textures");
+
     std::vector<ComPtr<ID3D12Resource>> temporaryResources;
-    CHECK(TextureManager::Get()->CloseAddingTextures(mCommandList.Get(), temporaryResources), false, "Unable to load all textures");
+    CHECK(TextureManager::Get()->CloseAddingTextures(uploadCommandList, temporaryResources), false, "Unable to load all textures");
+    for (auto &resource : temporaryResources)
+    {
+        uploader->KeepAlive(resource);
+    }
+    uploader->OnComplete([textureCount = (uint32_t)temporaryResources.size()]()
+                         {
+                             SHOWINFO("Finished uploading {} textures", textureCount);
+                         });
 
-    CHECK_HR(mCommandList->Close(), false);
-    d3d->Flush(mCommandList.Get(), mFence.Get(), ++mCurrentFrame);
+    auto uploadTicket = uploader->Submit();
+    CHECK(uploadTicket.Valid(), false, "Unable to submit texture uploads");
+    uploader->WaitOnDirectQueue(uploadTicket.Get());
 
     return true;
 }
@@ -289,6 +352,7 @@ bool Engine::InitImgui()
 
 bool Engine::RenderGUI()
 {
+    PROFILE_FUNCTION();
     ImGui_ImplDX12_NewFrame();
     ImGui_ImplWin32_NewFrame();
     ImGui::NewFrame();
@@ -298,8 +362,45 @@ bool Engine::RenderGUI()
     ImGui::SetNextWindowPos(ImVec2(-1, -1));
     ImGui::Begin("Debug info", nullptr, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize);
     ImGui::Text("Frametime: %f (%.2f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+    auto frameAllocations = AllocationCounter::GetLastFrame();
+    ImGui::Text("Heap allocations last frame: %llu (%llu bytes)", frameAllocations.Allocations, frameAllocations.Bytes);
+    auto frameArena = FrameArena::Get();
+    ImGui::Text("Frame arena: %zu / %zu bytes (peak %zu)", frameArena->GetUsed(), frameArena->GetCapacity(), frameArena->GetPeak());
+    auto uploadRing = UploadRingBuffer::Get();
+    ImGui::Text("Upload ring: %llu / %llu bytes (peak %llu)", uploadRing->GetLastFrameUsed(), uploadRing->GetFrameSize(), uploadRing->GetPeak());
+    auto textureStreamer = TextureStreamer::Get();
+    ImGui::Text("Streamed textures: %u, %llu / %llu bytes resident (%llu streaming in)", textureStreamer->GetTextureCount(),
+                textureStreamer->GetResidentBytes(), textureStreamer->GetBudget(), textureStreamer->GetPendingBytes());
+    auto materialManager = MaterialManager::Get();
+    ImGui::Text("Materials: %u, %u updated last frame in %u copies", materialManager->GetNumMaterials(),
+                materialManager->GetLastUpdatedMaterials(), materialManager->GetLastUpdateCopies());
+    const auto &bindlessStatistics = Model::GetBindlessStatistics();
+    ImGui::Text("Bindless draws: %u, %u with one material per draw", bindlessStatistics.Draws, bindlessStatistics.PerMaterialDraws);
+    const auto &atlasStatistics = TextureManager::Get()->GetAtlasStatistics();
+    ImGui::Text("Texture atlases: %u textures in %u pages, %.1f%% packed, %lld KiB and %u descriptors saved", atlasStatistics.Textures,
+                atlasStatistics.Pages, atlasStatistics.Efficiency * 100.0f, atlasStatistics.SavedBytes / 1024, atlasStatistics.SavedDescriptors);
+    const auto &deduplicationStatistics = TextureManager::Get()->GetDeduplicationStatistics();
+    ImGui::Text("Duplicate texture loads avoided: %u by path, %u by contents, %llu KiB", deduplicationStatistics.PathHits,
+                deduplicationStatistics.ContentHits, deduplicationStatistics.SavedBytes / 1024);
+    const auto &srvUavRanges = TextureManager::Get()->GetSrvUavDescriptors().GetRanges();
+    ImGui::Text("SRV / UAV descriptors: %u / %u persistent (%u waiting to be freed), %u / %u transient", srvUavRanges.GetAllocatedCount(),
+                srvUavRanges.GetPersistentCapacity(), srvUavRanges.GetPendingFreeCount(), srvUavRanges.GetTransientUsed(),
+                srvUavRanges.GetTransientCapacity());
+    const auto &memoryBudget = TextureManager::Get()->GetMemoryBudget();
+    const auto &memoryStatistics = memoryBudget.GetStatistics();
+    ImGui::Text("Video memory: %llu / %llu MiB, %u evictions (%llu MiB)", memoryStatistics.TotalBytes / _1MiB,
+                memoryBudget.GetBudget() / _1MiB, memoryStatistics.Evictions, memoryStatistics.EvictedBytes / _1MiB);
+    for (uint32_t i = 0; i < MemoryBudget::kCategoryCount; ++i)
+    {
+        ImGui::Text("    %s: %u, %llu KiB", MemoryBudget::GetCategoryName((MemoryBudget::Category)i),
+                    memoryStatistics.Allocations[i], memoryStatistics.Bytes[i] / 1024);
+    }
     ImGui::End();
 
+#if OBLIVION_PROFILE
+    RenderProfilerGUI();
+#endif
+
     ImGui::Render();
     mCommandList->SetDescriptorHeaps(1, mImguiDescriptorHeap.GetAddressOf());
     ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), mCommandList.Get());
@@ -307,6 +408,49 @@ bool Engine::RenderGUI()
     return true;
 }
 
+void Engine::RenderProfilerGUI()
+{
+    auto profiler = Profiler::Get();
+
+    ImGui::Begin("Profiler");
+    ImGui::Text("CPU frame: %.3f ms", profiler->GetLastFrameMs());
+    if (ImGui::Button("Export trace"))
+    {
+        CHECKSHOW(profiler->ExportChromeTrace(TRACE_FILE), "Unable to export profiler trace to {}", TRACE_FILE);
+    }
+
+    constexpr auto tableFlags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable;
+    if (ImGui::BeginTable("Zones", 6, tableFlags))
+    {
+        ImGui::TableSetupColumn("Zone");
+        ImGui::TableSetupColumn("Thread");
+        ImGui::TableSetupColumn("Calls");
+        ImGui::TableSetupColumn("Last (ms)");
+        ImGui::TableSetupColumn("Average (ms)");
+        ImGui::TableSetupColumn("Max (ms)");
+        ImGui::TableHeadersRow();
+
+        for (const auto &zone : profiler->GetZoneStatistics())
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%*s%s", zone.Depth * 2, "", zone.Name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", zone.ThreadId);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", zone.Calls);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", zone.LastMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", zone.AverageMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", zone.MaxMs);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
 LRESULT Engine::WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
 {
     static Engine *app;
@@ -63,6 +63,7 @@ private:
 
 private:
     bool RenderGUI();
+    void RenderProfilerGUI();
 
 private:
     HINSTANCE mInstance = nullptr;
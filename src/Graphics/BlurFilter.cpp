@@ -19,15 +19,20 @@ bool BlurFilter::Init(uint32_t width, uint32_t height, float sigma)
                                                          D3D12_HEAP_FLAG_NONE);
     CHECK(indexResult.Valid(), false, "Cannot created render target views");
     mIntermediaryTextureIndex = indexResult.Get();
+    auto handleResult = textureManager->GetHandle(mIntermediaryTextureIndex);
+    CHECK(handleResult.Valid(), false, "Unable to get the handle of the intermediary texture");
+    mIntermediaryTexture = handleResult.Get();
 
     mWidth = width; mHeight = height;
-    auto gaussWeightsResult = GetGaussWeights(sigma);
-    CHECK(gaussWeightsResult.Valid(), false, "Unable to initialize Gauss Weights");
-    auto gaussWeights = gaussWeightsResult.Get();
+    auto taps = GaussianKernel::GetLinearTaps(GaussianKernel::GetWeights(sigma));
+    CHECK(!taps.empty(), false, "Unable to blur with sigma {}", sigma);
+    mTapCount = (uint32_t)taps.size();
+
+    CHECK(mTapsBuffer.Init(mTapCount), false, "Unable to initialize the buffer of {} blur taps", mTapCount);
+    memcpy(mTapsBuffer.GetMappedMemory(), taps.data(), sizeof(taps[0]) * taps.size());
 
     auto mappedBlurInfo = mBlurInfoCB.GetMappedMemory();
-    mappedBlurInfo->blurRadius = mBlurRadius;
-    memcpy(mappedBlurInfo->weights, gaussWeights.data(), sizeof(gaussWeights[0]) * gaussWeights.size());
+    mappedBlurInfo->tapCount = mTapCount;
 
     return true;
 }
@@ -56,25 +61,19 @@ bool BlurFilter::Apply(ID3D12GraphicsCommandList *cmdList, uint32_t textureIndex
     
     cmdList->SetDescriptorHeaps(1, textureManager->GetSrvUavDescriptorHeap().GetAddressOf());
     cmdList->SetComputeRootConstantBufferView(2, mBlurInfoCB.GetGPUVirtualAddress());
+    cmdList->SetComputeRootShaderResourceView(3, mTapsBuffer.GetGPUVirtualAddress());
     
 
-    D3D12_GPU_DESCRIPTOR_HANDLE textureSrvHandle, intermediaryUavHandle, textureUavHandle, intermediarySrvHandle;
-
-    auto gpuHandleResult = textureManager->GetGPUDescriptorSrvHandleForTextureIndex(textureIndex);
-    CHECK(gpuHandleResult.Valid(), false, "Unable to get SRV handle for texture index {}", textureIndex);
-    textureSrvHandle = gpuHandleResult.Get();
-    
-    gpuHandleResult = textureManager->GetGPUDescriptorSrvHandleForTextureIndex(mIntermediaryTextureIndex);
-    CHECK(gpuHandleResult.Valid(), false, "Unable to get UAV handle for texture index {}", mIntermediaryTextureIndex);
-    intermediaryUavHandle = gpuHandleResult.Get();
-
-    gpuHandleResult = textureManager->GetGPUDescriptorSrvHandleForTextureIndex(textureIndex);
-    CHECK(gpuHandleResult.Valid(), false, "Unable to get UAV handle for texture index {}", textureIndex);
-    textureUavHandle = gpuHandleResult.Get();
+    auto textureResult = textureManager->GetHandle(textureIndex);
+    CHECK(textureResult.Valid(), false, "Unable to get the handle of texture index {}", textureIndex);
+    auto texture = textureResult.Get();
 
-    gpuHandleResult = textureManager->GetGPUDescriptorSrvHandleForTextureIndex(mIntermediaryTextureIndex);
-    CHECK(gpuHandleResult.Valid(), false, "Unable to get SRV handle for texture index {}", mIntermediaryTextureIndex);
-    intermediarySrvHandle = gpuHandleResult.Get();
+    D3D12_GPU_DESCRIPTOR_HANDLE textureSrvHandle = textureManager->GetSrvGPUHandle(texture);
+    D3D12_GPU_DESCRIPTOR_HANDLE textureUavHandle = textureManager->GetUavGPUHandle(texture);
+    D3D12_GPU_DESCRIPTOR_HANDLE intermediarySrvHandle = textureManager->GetSrvGPUHandle(mIntermediaryTexture);
+    D3D12_GPU_DESCRIPTOR_HANDLE intermediaryUavHandle = textureManager->GetUavGPUHandle(mIntermediaryTexture);
+    CHECK(textureSrvHandle.ptr && textureUavHandle.ptr, false, "Texture index {} needs a SRV and a UAV to be blurred", textureIndex);
+    CHECK(intermediarySrvHandle.ptr && intermediaryUavHandle.ptr, false, "Intermediary texture of the blur is missing its views");
 
     for (uint32_t i = 0; i < passCount; ++i)
     {
@@ -119,34 +118,3 @@ bool BlurFilter::OnResize(uint32_t width, uint32_t height)
 
     return true;
 }
-
-Result<std::vector<float>> BlurFilter::GetGaussWeights(float sigma)
-{
-    float twoSigmaSq = 2 * sigma * sigma;
-
-    mBlurRadius = (int32_t)ceil(2.0f * sigma);
-    CHECK(mBlurRadius <= MAX_RADIUS, std::nullopt, "Radius too big {}. Try using a smaller sigma", mBlurRadius);
-
-    std::vector<float> weights;
-    weights.resize(2 * mBlurRadius + 1);
-
-    float weightSum = 0.0f;
-
-    for (int32_t i = -mBlurRadius; i <= mBlurRadius; ++i)
-    {
-        float x = (float)i;
-
-        weights[i + mBlurRadius] = expf(-x * x / twoSigmaSq);
-
-        weightSum += weights[i + mBlurRadius];
-    }
-
-    for (auto &it : weights)
-    {
-        it /= weightSum;
-    }
-
-    return weights;
-}
-
-
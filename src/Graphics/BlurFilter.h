@@ -3,13 +3,17 @@
 
 #include <Oblivion.h>
 #include "Utils/UploadBuffer.h"
+#include "TextureManager.h"
+#include "Utils/GaussianKernel.h"
 
 
+/// <summary>
+/// Separable Gaussian blur of any sigma. Both passes read bilinear taps (GaussianKernel) from a structured buffer,
+/// so every fetch covers two texels of the kernel
+/// </summary>
 class BlurFilter
 {
     static constexpr const uint32_t GROUP_SIZE = 256;
-public:
-    static constexpr const uint32_t MAX_RADIUS = 5;
 
 public:
     BlurFilter() = default;
@@ -21,22 +25,20 @@ public:
                D3D12_RESOURCE_STATES finalState, uint32_t passCount);
     bool OnResize(uint32_t width, uint32_t height);
 
-private:
-    Result<std::vector<float>> GetGaussWeights(float sigma);
-
 private:
     struct BlurInfo
     {
-        int blurRadius;
-        float weights[11];
+        uint32_t tapCount;
     };
 
     uint32_t mIntermediaryTextureIndex;
+    TextureManager::TextureHandle mIntermediaryTexture;
 
-    int32_t mBlurRadius;
+    uint32_t mTapCount;
 
     uint32_t mWidth;
     uint32_t mHeight;
 
     UploadBuffer<BlurInfo> mBlurInfoCB;
+    UploadBuffer<GaussianKernel::Tap> mTapsBuffer;
 };
@@ -19,6 +19,7 @@ bool Direct3D::Init(HWND hwnd)
     ASSIGN_RESULT(mAdapter, CreateAdapter(), false, "Cannot create an adapter");
     ASSIGN_RESULT(mDevice, CreateD3D12Device(), false, "Cannot create a D3D12 device");
     ASSIGN_RESULT(mDirectCommandQueue, CreateCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT), false, "Cannot initialize direct command queue");
+    ASSIGN_RESULT(mCopyCommandQueue, CreateCommandQueue(D3D12_COMMAND_LIST_TYPE_COPY), false, "Cannot initialize copy command queue");
     ASSIGN_RESULT(mSwapchain, CreateSwapchain(hwnd), false, "Cannot create swapchain");
     ASSIGN_RESULT(mRTVHeap, CreateDescriptorHeap(kBufferCount, D3D12_DESCRIPTOR_HEAP_TYPE_RTV),
                   false, "Unable to create a rtv descriptor heap with {} descriptors", kBufferCount);
@@ -271,6 +272,59 @@ void Direct3D::Flush(ID3D12GraphicsCommandList *cmdList, ID3D12Fence *fence, uin
     WaitForFenceValue(fence, value);
 }
 
+void Direct3D::SignalCopy(ID3D12Fence *fence, uint64_t value)
+{
+    CHECKRET_HR(mCopyCommandQueue->Signal(fence, value));
+}
+
+void Direct3D::ExecuteCopyCommandList(ID3D12GraphicsCommandList *cmdList)
+{
+    ID3D12CommandList *cmdLists[] = {
+        cmdList
+    };
+    mCopyCommandQueue->ExecuteCommandLists(ARRAYSIZE(cmdLists), cmdLists);
+}
+
+void Direct3D::WaitOnDirectQueue(ID3D12Fence *fence, uint64_t value)
+{
+    CHECKRET_HR(mDirectCommandQueue->Wait(fence, value));
+}
+
+void Direct3D::UpdateTileMappings(ID3D12Resource *resource, const D3D12_TILED_RESOURCE_COORDINATE &coordinate, uint32_t numTiles, ID3D12Heap *heap)
+{
+    D3D12_TILE_REGION_SIZE regionSize = {};
+    regionSize.NumTiles = numTiles;
+    regionSize.UseBox = FALSE;
+
+    D3D12_TILE_RANGE_FLAGS rangeFlags = heap ? D3D12_TILE_RANGE_FLAG_NONE : D3D12_TILE_RANGE_FLAG_NULL;
+    UINT heapRangeStartOffset = 0;
+    UINT rangeTileCount = numTiles;
+
+    mCopyCommandQueue->UpdateTileMappings(resource, 1, &coordinate, &regionSize, heap,
+                                          1, &rangeFlags, &heapRangeStartOffset, &rangeTileCount,
+                                          D3D12_TILE_MAPPING_FLAG_NONE);
+}
+
+D3D12_TILED_RESOURCES_TIER Direct3D::GetTiledResourcesTier()
+{
+    D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+    if (FAILED(mDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options))))
+    {
+        return D3D12_TILED_RESOURCES_TIER_NOT_SUPPORTED;
+    }
+    return options.TiledResourcesTier;
+}
+
+Result<uint64_t> Direct3D::GetVideoMemoryBudget()
+{
+    ComPtr<IDXGIAdapter3> adapter;
+    CHECK_HR(mAdapter.As(&adapter), std::nullopt);
+
+    DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo = {};
+    CHECK_HR(adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memoryInfo), std::nullopt);
+    return memoryInfo.Budget;
+}
+
 Result<ComPtr<ID3D12Resource>> Direct3D::CreateDepthStencilBuffer()
 {
     CHECK(mSwapchain, std::nullopt, "Cannot create a default depth stencil buffer without a valid swapchain");
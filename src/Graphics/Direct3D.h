@@ -59,6 +59,23 @@ public:
     void ExecuteCommandList(ID3D12GraphicsCommandList *cmdList);
     void Flush(ID3D12GraphicsCommandList *cmdList, ID3D12Fence *fence, uint64_t value);
 
+    void SignalCopy(ID3D12Fence *fence, uint64_t value);
+    void ExecuteCopyCommandList(ID3D12GraphicsCommandList *cmdList);
+    /// <summary>
+    /// Makes the direct queue wait on the GPU until fence reaches value. The CPU is not blocked
+    /// </summary>
+    void WaitOnDirectQueue(ID3D12Fence *fence, uint64_t value);
+    /// <summary>
+    /// Maps numTiles tiles of a reserved resource, starting at coordinate, to the beginning of heap.
+    /// A null heap unmaps them. Runs on the copy queue, so copies submitted afterwards see the new mappings
+    /// </summary>
+    void UpdateTileMappings(ID3D12Resource *resource, const D3D12_TILED_RESOURCE_COORDINATE &coordinate, uint32_t numTiles, ID3D12Heap *heap);
+    D3D12_TILED_RESOURCES_TIER GetTiledResourcesTier();
+    /// <summary>
+    /// Local video memory the OS lets this process use. Invalid if the adapter can't tell
+    /// </summary>
+    Result<uint64_t> GetVideoMemoryBudget();
+
     template <D3D12_DESCRIPTOR_HEAP_TYPE heapType>
     constexpr unsigned int GetDescriptorIncrementSize();
 
@@ -82,6 +99,7 @@ private:
     ComPtr<ID3D12Device> mDevice;
 
     ComPtr<ID3D12CommandQueue> mDirectCommandQueue;
+    ComPtr<ID3D12CommandQueue> mCopyCommandQueue;
 
     ComPtr<IDXGISwapChain4> mSwapchain;
 
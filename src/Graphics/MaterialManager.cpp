@@ -1,19 +1,29 @@
 #include "MaterialManager.h"
+#include "Profiler.h"
+#include "TextureManager.h"
+#include "Utils/LightingModel.h"
+
+static_assert(offsetof(MaterialConstants, Shininess) == offsetof(LightingModel::Material, Shininess),
+              "LightingModel::Material must match the start of MaterialConstants");
 
 MaterialManager::Material *MaterialManager::AddMaterial(unsigned int maxDirtyFrames, const std::string &materialName,
                                                         const MaterialConstants &info)
 {
     CHECK(mCanAddMaterial, nullptr, "Material manager is closed for adding materials");
 
-    if (auto materialIt = mMaterials.find(materialName); materialIt != mMaterials.end())
+    if (auto handleIt = mMaterialsByName.find(materialName); handleIt != mMaterialsByName.end())
     {
         SHOWINFO("Material {} already found in material manager. Using it . . .", materialName);
-        return &((*materialIt).second);
+        return &mMaterials[handleIt->second];
     }
 
     SHOWINFO("Material {} not found in material manager. Adding it . . .", materialName);
-    mMaterials.insert({ materialName, Material(maxDirtyFrames, (uint32_t)mMaterials.size(), materialName, info) });
-    return AddMaterial(maxDirtyFrames, materialName, info);
+    uint32_t handle = (uint32_t)mMaterials.size();
+    mMaterials.emplace_back(maxDirtyFrames, handle, materialName, info);
+    mMaterialsByName[materialName] = handle;
+    mPackedConstants.emplace_back();
+    MarkDirty(mMaterials.back());
+    return &mMaterials.back();
 }
 
 MaterialManager::Material *MaterialManager::AddDefaultMaterial(unsigned int maxDirtyFrames)
@@ -28,37 +38,152 @@ MaterialManager::Material *MaterialManager::AddDefaultMaterial(unsigned int maxD
     return AddMaterial(maxDirtyFrames, "DefaultMaterial", defaultMaterial);
 }
 
+void MaterialManager::SetMaterialConstants(Material *material, const MaterialConstants &info)
+{
+    CHECKRET(material != nullptr, "Can't set the constants of a null material");
+    material->Info = info;
+    MarkDirty(*material);
+}
 
-void MaterialManager::UpdateMaterialsBuffer(UploadBuffer<MaterialConstants> &materialsBuffer)
+bool MaterialManager::UpdateMaterialsBuffer(uint32_t frameIndex)
 {
-    for (auto &it : mMaterials)
+    PROFILE_FUNCTION();
+    mFrameIndex = frameIndex;
+    mLastUpdatedMaterials = 0;
+    mLastUpdateCopies = 0;
+    if (mDirtyMaterials.empty())
+    {
+        return true;
+    }
+    CHECK(!mCanAddMaterial, false, "Materials must be closed before they are copied to the materials buffer");
+
+    auto mappedMemory = (uint8_t *)mMaterialsBuffers[frameIndex].GetMappedMemory();
+    std::sort(mDirtyMaterials.begin(), mDirtyMaterials.end());
+
+    // Materials that stay dirty for the next frames are compacted to the front of the list as it's walked
+    uint32_t keptCount = 0;
+    for (uint32_t i = 0; i < (uint32_t)mDirtyMaterials.size();)
     {
-        auto &material = it.second;
-        // if (material.DirtyFrames > 0)
+        uint32_t firstMaterial = mDirtyMaterials[i];
+        uint32_t runLength = 1;
+        while (i + runLength < (uint32_t)mDirtyMaterials.size() && mDirtyMaterials[i + runLength] == firstMaterial + runLength)
+        {
+            runLength++;
+        }
+
+        memcpy(mappedMemory + firstMaterial * kMaterialStride, &mPackedConstants[firstMaterial], runLength * kMaterialStride);
+        mLastUpdatedMaterials += runLength;
+        mLastUpdateCopies++;
+
+        for (uint32_t j = i; j < i + runLength; ++j)
         {
-            auto mappedMemory = materialsBuffer.GetMappedMemory(material.ConstantBufferIndex);
-            memcpy(mappedMemory, &it.second.Info, sizeof(it.second.Info));
-            // material.DirtyFrames--;
+            if (--mMaterials[mDirtyMaterials[j]].DirtyFrames > 0)
+            {
+                mDirtyMaterials[keptCount++] = mDirtyMaterials[j];
+            }
         }
+        i += runLength;
+    }
+    mDirtyMaterials.resize(keptCount);
+    return true;
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS MaterialManager::GetMaterialsBufferAddress() const
+{
+    if (mCanAddMaterial)
+    {
+        return 0;
     }
+    return mMaterialsBuffers[mFrameIndex].GetGPUVirtualAddress();
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS MaterialManager::GetMaterialAddress(const Material *material) const
+{
+    return GetMaterialsBufferAddress() + material->ConstantBufferIndex * kMaterialStride;
 }
 
 MaterialManager::Material *MaterialManager::GetMaterial(const std::string &material)
 {
-    if (auto it = mMaterials.find(material); it != mMaterials.end())
+    if (auto it = mMaterialsByName.find(material); it != mMaterialsByName.end())
     {
-        return &((*it).second);
+        return &mMaterials[it->second];
     }
     return nullptr;
 }
 
+MaterialManager::Material *MaterialManager::GetMaterial(uint32_t handle)
+{
+    return handle < mMaterials.size() ? &mMaterials[handle] : nullptr;
+}
+
 uint32_t MaterialManager::GetNumMaterials() const
 {
     return (uint32_t)mMaterials.size();
 }
 
-void MaterialManager::CloseAddingMaterials()
+bool MaterialManager::CloseAddingMaterials()
 {
     mCanAddMaterial = false;
+    for (uint32_t i = 0; i < (uint32_t)mMaterialsBuffers.size(); ++i)
+    {
+        // Every frame copies only what changed, so each frame in flight keeps its own buffer
+        CHECK(mMaterialsBuffers[i].Init(std::max((uint32_t)mMaterials.size(), 1u), true), false,
+              "Unable to create the materials buffer of frame {}", i);
+    }
+    return true;
 }
 
+uint32_t MaterialManager::GetLastUpdatedMaterials() const
+{
+    return mLastUpdatedMaterials;
+}
+
+uint32_t MaterialManager::GetLastUpdateCopies() const
+{
+    return mLastUpdateCopies;
+}
+
+void MaterialManager::ApplyTextureAtlases()
+{
+    uint32_t appliedMaterials = 0;
+    for (auto &material : mMaterials)
+    {
+        if (TextureManager::Get()->GetAtlasRect((uint32_t)material.Info.textureIndex).Valid())
+        {
+            MarkDirty(material);
+            appliedMaterials++;
+        }
+    }
+    SHOWINFO("Moved {} materials to the atlas rectangles of their textures", appliedMaterials);
+}
+
+void MaterialManager::ApplyTextureAtlas(MaterialConstants &info)
+{
+    auto atlasRectResult = TextureManager::Get()->GetAtlasRect((uint32_t)info.textureIndex);
+    if (!atlasRectResult.Valid())
+    {
+        return;
+    }
+
+    auto atlasRect = atlasRectResult.Get();
+    // Material constants are copied as they are and HLSL reads matrices column major, so the transform is stored transposed
+    auto atlasTransform = DirectX::XMMatrixTranspose(DirectX::XMMatrixScaling(atlasRect.x, atlasRect.y, 1.0f) *
+                                                     DirectX::XMMatrixTranslation(atlasRect.z, atlasRect.w, 0.0f));
+    info.MaterialTransform = DirectX::XMMatrixMultiply(atlasTransform, info.MaterialTransform);
+}
+
+void MaterialManager::MarkDirty(Material &material)
+{
+    // Textures are packed when they are closed, which may have happened before this material was added.
+    // Only the copy for the buffer moves to the atlas rectangle, so this can run any number of times
+    auto &packedInfo = mPackedConstants[material.ConstantBufferIndex].Info;
+    packedInfo = material.Info;
+    ApplyTextureAtlas(packedInfo);
+    if (material.DirtyFrames == 0)
+    {
+        mDirtyMaterials.push_back(material.ConstantBufferIndex);
+    }
+    // Every frame in flight has its own copy of the buffer to bring up to date
+    material.MarkUpdate();
+    material.DirtyFrames = std::max(material.DirtyFrames, (unsigned int)Direct3D::kBufferCount);
+}
@@ -2,13 +2,21 @@
 
 
 #include <Oblivion.h>
+#include <deque>
+#include "Direct3D.h"
 #include "FrameResources.h"
 #include "Utils/UpdateObject.h"
+#include "Utils/UploadBuffer.h"
+#include "Utils/UploadRingBuffer.h"
 
 class MaterialManager : public ISingletone<MaterialManager>
 {
     MAKE_SINGLETONE_CAPABLE(MaterialManager);
 
+public:
+    static constexpr const uint64_t kMaterialStride =
+        (sizeof(MaterialConstants) + UploadRingBuffer::kConstantBufferAlignment - 1) & ~(UploadRingBuffer::kConstantBufferAlignment - 1);
+
 public:
     struct Material : public UpdateObject
     {
@@ -17,7 +25,8 @@ public:
                  std::string materialName, const MaterialConstants &info):
             UpdateObject(maxDirtyFrames, cbIndex), Name(materialName), Info(info)
         {
-            MarkUpdate();
+            // Counted down by MaterialManager once it's in the dirty list
+            DirtyFrames = 0;
         };
 
         MaterialConstants GetMaterialConstants() const
@@ -30,8 +39,17 @@ public:
             return Info.textureIndex;
         }
 
+        /// <summary>
+        /// Index of the material in MaterialManager, and of its constants in the materials buffer
+        /// </summary>
+        uint32_t GetHandle() const
+        {
+            return ConstantBufferIndex;
+        }
+
         std::string Name;
     private:
+        // As set, with the texture's own UVs; the materials buffer gets them moved to the atlas rectangle
         MaterialConstants Info;
     };
 
@@ -42,17 +60,61 @@ public:
 public:
     Material *AddMaterial(unsigned int maxDirtyFrames, const std::string &materialName, const MaterialConstants &);
     Material *AddDefaultMaterial(unsigned int maxDirtyFrames);
-    void UpdateMaterialsBuffer(UploadBuffer<MaterialConstants> &materialsBuffer);
+    /// <summary>
+    /// Replaces the constants of material. They reach the materials buffer of every frame in flight over the next frames
+    /// </summary>
+    void SetMaterialConstants(Material *material, const MaterialConstants &info);
+    /// <summary>
+    /// Copies the materials changed in the last kBufferCount frames to the materials buffer of frameIndex,
+    /// as one copy per run of consecutive materials. Must be called after waiting for the fence of frameIndex
+    /// </summary>
+    bool UpdateMaterialsBuffer(uint32_t frameIndex);
+    D3D12_GPU_VIRTUAL_ADDRESS GetMaterialsBufferAddress() const;
+    D3D12_GPU_VIRTUAL_ADDRESS GetMaterialAddress(const Material *material) const;
     
     Material *GetMaterial(const std::string& material);
+    Material *GetMaterial(uint32_t handle);
 
     uint32_t GetNumMaterials() const;
-    void CloseAddingMaterials();
+    /// <summary>
+    /// Creates a materials buffer for every frame in flight
+    /// </summary>
+    bool CloseAddingMaterials();
+    /// <summary>
+    /// Points the materials whose texture was packed in an atlas page at its rectangle in the materials buffer.
+    /// Called by TextureManager once the atlases are built; calling it again changes nothing
+    /// </summary>
+    void ApplyTextureAtlases();
 
-public:
-    bool mCanAddMaterial = true;
-    std::unordered_map<std::string, Material> mMaterials;
+    /// <summary>
+    /// Materials copied by the last UpdateMaterialsBuffer(frameIndex), and in how many copies
+    /// </summary>
+    uint32_t GetLastUpdatedMaterials() const;
+    uint32_t GetLastUpdateCopies() const;
 
-};
+private:
+    static void ApplyTextureAtlas(MaterialConstants &info);
+    void MarkDirty(Material &material);
 
+private:
+    // Constants laid out as in the materials buffer, so consecutive dirty materials are copied at once
+    struct alignas(UploadRingBuffer::kConstantBufferAlignment) PackedMaterialConstants
+    {
+        MaterialConstants Info;
+    };
+    static_assert(sizeof(PackedMaterialConstants) == kMaterialStride);
 
+    bool mCanAddMaterial = true;
+    // Indexed by handle. A deque, so the pointers handed out stay valid while materials are added
+    std::deque<Material> mMaterials;
+    std::unordered_map<std::string, uint32_t> mMaterialsByName;
+    std::vector<PackedMaterialConstants> mPackedConstants;
+
+    // Handles of the materials with DirtyFrames > 0
+    std::vector<uint32_t> mDirtyMaterials;
+    std::array<UploadBuffer<MaterialConstants>, Direct3D::kBufferCount> mMaterialsBuffers;
+    uint32_t mFrameIndex = 0;
+
+    uint32_t mLastUpdatedMaterials = 0;
+    uint32_t mLastUpdateCopies = 0;
+};
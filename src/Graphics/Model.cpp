@@ -1,7 +1,9 @@
 #include "Model.h"
+#include "Profiler.h"
 #include "Utils/Utils.h"
 #include "Direct3D.h"
 #include "TextureManager.h"
+#include "Utils/AsyncUploader.h"
 
 std::vector<Model::Vertex> Model::mVertices;
 std::vector<uint32_t> Model::mIndices;
@@ -14,6 +16,12 @@ D3D12_INDEX_BUFFER_VIEW Model::mIndexBufferView;
 
 std::unordered_map<std::string, Model::RenderParameters> Model::mModelsRenderParameters;
 
+Model::BindlessStatistics Model::mBindlessStatistics;
+
+// The bindless shaders read World and Color the same way the instanced vertex layout does
+static_assert(sizeof(InstanceInfo) == 80, "BindlessMaterialLightPipeline/Common.hlsli expects an 80 byte InstanceInfo");
+static_assert(sizeof(Model::BindlessInstanceInfo) == 96, "BindlessInstanceInfo must match InstanceInfo in BindlessMaterialLightPipeline/Common.hlsli");
+
 using namespace DirectX;
 
 uint32_t Model::GetIndexCount() const
@@ -46,6 +54,11 @@ MaterialManager::Material const *Model::GetMaterial() const
 	return mInfo.Material;
 }
 
+void Model::SetInstanceMaterial(MaterialManager::Material const *newMaterial, unsigned int instanceID)
+{
+    mInstancesInfo[instanceID].Material = newMaterial;
+}
+
 const InstanceInfo& __vectorcall Model::GetInstanceInfo(unsigned int instanceID) const
 {
     return mInstancesInfo[instanceID].instanceInfo;
@@ -281,6 +294,7 @@ bool Model::Create(ModelType type)
 
 bool Model::Create(const std::string &path)
 {
+    PROFILE_FUNCTION();
 	CHECK(UpdateObject::Valid(), false, "Cannot create a model that was not properly initialized. "\
 		  "Try calling Create(unsigned int, unsigned int, std::string) instead of this");
 	Assimp::Importer importer;
@@ -325,9 +339,10 @@ void Model::ClearInstances()
 	mInstancesInfo.clear();
 }
 
-uint32_t Model::PrepareInstances(std::function<bool(InstanceInfo&)> func,
+uint32_t Model::PrepareInstances(FunctionRef<bool(InstanceInfo&)> func,
 								 std::unordered_map<uuids::uuid, UploadBuffer<InstanceInfo>> &instancesBuffer)
 {
+    PROFILE_FUNCTION();
     if (auto instanceIt = instancesBuffer.find(mObjectUUID); instanceIt != instancesBuffer.end())
 	{
 		auto& instanceInfo = (*instanceIt).second;
@@ -349,9 +364,10 @@ uint32_t Model::PrepareInstances(std::function<bool(InstanceInfo&)> func,
 	}
 }
 
-uint32_t Model::PrepareInstances(std::function<bool(InstanceInfo&, void* Context)> func,
+uint32_t Model::PrepareInstances(FunctionRef<bool(InstanceInfo&, void* Context)> func,
 								 std::unordered_map<uuids::uuid, UploadBuffer<InstanceInfo>> &instancesBuffer)
 {
+    PROFILE_FUNCTION();
     if (auto instanceIt = instancesBuffer.find(mObjectUUID); instanceIt != instancesBuffer.end())
 	{
 		auto &instanceInfo = (*instanceIt).second;
@@ -375,6 +391,7 @@ uint32_t Model::PrepareInstances(std::function<bool(InstanceInfo&, void* Context
 
 uint32_t Model::PrepareInstances(std::unordered_map<uuids::uuid, UploadBuffer<InstanceInfo>>& instancesBuffer)
 {
+    PROFILE_FUNCTION();
     if (auto instanceIt = instancesBuffer.find(mObjectUUID); instanceIt != instancesBuffer.end()) {
         auto& instanceInfo = (*instanceIt).second;
 
@@ -390,6 +407,57 @@ uint32_t Model::PrepareInstances(std::unordered_map<uuids::uuid, UploadBuffer<In
     }
 }
 
+uint32_t Model::PrepareInstances(FunctionRef<bool(InstanceInfo&)> func, UploadRingBuffer::Allocation &instancesAllocation)
+{
+    PROFILE_FUNCTION();
+    instancesAllocation = UploadRingBuffer::Get()->AllocateArray<InstanceInfo>((uint32_t)mInstancesInfo.size());
+    CHECK(instancesAllocation.Valid(), 0, "Unable to allocate {} instances from the upload ring", mInstancesInfo.size());
+
+    auto instances = (InstanceInfo *)instancesAllocation.CPU;
+    unsigned int bufferIndex = 0;
+    for (auto &it : mInstancesInfo)
+    {
+        if (func(it.instanceInfo))
+        {
+            instances[bufferIndex++] = it.instanceInfo;
+        }
+    }
+    return bufferIndex;
+}
+
+uint32_t Model::PrepareInstances(FunctionRef<bool(InstanceInfo&, void* Context)> func, UploadRingBuffer::Allocation &instancesAllocation)
+{
+    PROFILE_FUNCTION();
+    instancesAllocation = UploadRingBuffer::Get()->AllocateArray<InstanceInfo>((uint32_t)mInstancesInfo.size());
+    CHECK(instancesAllocation.Valid(), 0, "Unable to allocate {} instances from the upload ring", mInstancesInfo.size());
+
+    auto instances = (InstanceInfo *)instancesAllocation.CPU;
+    unsigned int bufferIndex = 0;
+    for (auto &it : mInstancesInfo)
+    {
+        if (func(it.instanceInfo, it.Context))
+        {
+            instances[bufferIndex++] = it.instanceInfo;
+        }
+    }
+    return bufferIndex;
+}
+
+uint32_t Model::PrepareInstances(UploadRingBuffer::Allocation &instancesAllocation)
+{
+    PROFILE_FUNCTION();
+    instancesAllocation = UploadRingBuffer::Get()->AllocateArray<InstanceInfo>((uint32_t)mCurrentInstances.size());
+    CHECK(instancesAllocation.Valid(), 0, "Unable to allocate {} instances from the upload ring", mCurrentInstances.size());
+
+    auto instances = (InstanceInfo *)instancesAllocation.CPU;
+    unsigned int bufferIndex = 0;
+    for (auto &it : mCurrentInstances)
+    {
+        instances[bufferIndex++] = it->instanceInfo;
+    }
+    return bufferIndex;
+}
+
 void Model::BindInstancesBuffer(ID3D12GraphicsCommandList *cmdList, uint32_t instanceCount,
 								const std::unordered_map<void *, UploadBuffer<InstanceInfo>> &instancesBuffer)
 {
@@ -409,6 +477,58 @@ void Model::BindInstancesBuffer(ID3D12GraphicsCommandList *cmdList, uint32_t ins
 	}
 }
 
+void Model::BindInstancesBuffer(ID3D12GraphicsCommandList *cmdList, uint32_t instanceCount,
+                                const UploadRingBuffer::Allocation &instancesAllocation)
+{
+    D3D12_VERTEX_BUFFER_VIEW vbView = {};
+    vbView.BufferLocation = instancesAllocation.GPU;
+    vbView.SizeInBytes = sizeof(InstanceInfo) * instanceCount;
+    vbView.StrideInBytes = sizeof(InstanceInfo);
+    cmdList->IASetVertexBuffers(1, 1, &vbView);
+}
+
+uint32_t Model::PrepareBindlessInstances(FunctionRef<bool(InstanceInfo&)> func, UploadRingBuffer::Allocation &instancesAllocation)
+{
+    PROFILE_FUNCTION();
+    instancesAllocation = UploadRingBuffer::Get()->AllocateArray<BindlessInstanceInfo>((uint32_t)mInstancesInfo.size());
+    CHECK(instancesAllocation.Valid(), 0, "Unable to allocate {} bindless instances from the upload ring", mInstancesInfo.size());
+
+    auto instances = (BindlessInstanceInfo *)instancesAllocation.CPU;
+    unsigned int bufferIndex = 0;
+    // Distinct materials are few per model, a small vector beats a set
+    std::vector<MaterialManager::Material const *> usedMaterials;
+    for (auto &it : mInstancesInfo)
+    {
+        if (!func(it.instanceInfo))
+        {
+            continue;
+        }
+
+        auto material = it.Material ? it.Material : mInfo.Material;
+        auto &instance = instances[bufferIndex++];
+        instance.Info = it.instanceInfo;
+        instance.MaterialIndex = material ? material->GetHandle() : 0;
+
+        if (std::find(usedMaterials.begin(), usedMaterials.end(), material) == usedMaterials.end())
+        {
+            usedMaterials.push_back(material);
+        }
+    }
+
+    if (bufferIndex > 0)
+    {
+        mBindlessStatistics.Draws++;
+        mBindlessStatistics.PerMaterialDraws += (uint32_t)usedMaterials.size();
+    }
+    return bufferIndex;
+}
+
+void Model::BindBindlessInstances(ID3D12GraphicsCommandList *cmdList, const UploadRingBuffer::Allocation &instancesAllocation)
+{
+    // Root parameter 2 of the bindless root signature
+    cmdList->SetGraphicsRootShaderResourceView(2, instancesAllocation.GPU);
+}
+
 uint32_t Model::GetInstanceCount() const
 {
 	return (uint32_t)mInstancesInfo.size();
@@ -419,6 +539,61 @@ void Model::CloseAddingInstances()
 	mCanAddInstances = false;
 }
 
+Result<uint32_t> Model::AddToLightmapBaker(LightmapBaker &baker, unsigned int instanceID) const
+{
+    CHECK(instanceID < mInstancesInfo.size(), std::nullopt, "Unable to bake instance {} of a model with {} instances",
+          instanceID, mInstancesInfo.size());
+    CHECK(mInfo.BaseVertexLocation + mInfo.VertexCount <= mVertices.size() &&
+          mInfo.StartIndexLocation + mInfo.IndexCount <= mIndices.size(), std::nullopt,
+          "Unable to bake a model whose vertices are no longer in the geometry pool");
+
+    auto world = mInstancesInfo[instanceID].instanceInfo.WorldMatrix;
+    auto normalWorld = XMMatrixTranspose(XMMatrixInverse(nullptr, world));
+
+    std::vector<LightmapBaker::Vertex> vertices(mInfo.VertexCount);
+    for (uint32_t i = 0; i < mInfo.VertexCount; ++i)
+    {
+        const auto &vertex = mVertices[mInfo.BaseVertexLocation + i];
+        XMFLOAT3 position, normal;
+        XMStoreFloat3(&position, XMVector3TransformCoord(XMLoadFloat3(&vertex.Position), world));
+        XMStoreFloat3(&normal, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&vertex.Normal), normalWorld)));
+        vertices[i] = { { position.x, position.y, position.z }, { normal.x, normal.y, normal.z }, { vertex.TexCoord.x, vertex.TexCoord.y } };
+    }
+
+    std::vector<uint32_t> indices(mIndices.begin() + mInfo.StartIndexLocation,
+                                  mIndices.begin() + mInfo.StartIndexLocation + mInfo.IndexCount);
+    return baker.AddMesh(std::move(vertices), std::move(indices));
+}
+
+uint32_t Model::SelectShadowCasters(const ShadowCascades &cascades, uint32_t cascade)
+{
+    thread_local std::vector<float> centerX, centerY, centerZ, radius;
+    thread_local std::vector<uint32_t> visible;
+
+    uint32_t instanceCount = (uint32_t)mInstancesInfo.size();
+    centerX.resize(instanceCount);
+    centerY.resize(instanceCount);
+    centerZ.resize(instanceCount);
+    radius.resize(instanceCount);
+    for (uint32_t i = 0; i < instanceCount; ++i)
+    {
+        BoundingSphere sphere;
+        mBoundingSphere.Transform(sphere, mInstancesInfo[i].instanceInfo.WorldMatrix);
+        centerX[i] = sphere.Center.x;
+        centerY[i] = sphere.Center.y;
+        centerZ[i] = sphere.Center.z;
+        radius[i] = sphere.Radius;
+    }
+    cascades.CullCasters(cascade, centerX.data(), centerY.data(), centerZ.data(), radius.data(), instanceCount, visible);
+
+    ResetCurrentInstances();
+    for (auto index : visible)
+    {
+        AddCurrentInstance(index);
+    }
+    return (uint32_t)visible.size();
+}
+
 const DirectX::BoundingBox& Model::GetBoundingBox() const
 {
 	return mBoundingBox;
@@ -431,6 +606,7 @@ const DirectX::BoundingSphere& Model::GetBoundingSphere() const
 
 bool Model::InitBuffers(ID3D12GraphicsCommandList *cmdList, ComPtr<ID3D12Resource> intermediaryResources[2])
 {
+    PROFILE_FUNCTION();
 	CHECK(mVertices.size() > 0 && mIndices.size() > 0, false, "Unable to initialize model's buffers, because there are no vertices / indices");
 	auto d3d = Direct3D::Get();
 	auto device = d3d->GetD3D12Device();
@@ -457,6 +633,34 @@ bool Model::InitBuffers(ID3D12GraphicsCommandList *cmdList, ComPtr<ID3D12Resourc
 	return true;
 }
 
+bool Model::InitBuffers()
+{
+    auto uploader = AsyncUploader::Get();
+    auto cmdList = uploader->GetCommandList();
+    CHECK(cmdList, false, "Unable to get a command list for uploading model buffers");
+
+    ComPtr<ID3D12Resource> intermediaryResources[2];
+    CHECK(InitBuffers(cmdList, intermediaryResources), false, "Unable to initialize model buffers");
+    uploader->KeepAlive(intermediaryResources[0]);
+    uploader->KeepAlive(intermediaryResources[1]);
+
+    auto uploadTicket = uploader->Submit();
+    CHECK(uploadTicket.Valid(), false, "Unable to submit model buffers upload");
+    uploader->WaitOnDirectQueue(uploadTicket.Get());
+
+    return true;
+}
+
+void Model::ResetBindlessStatistics()
+{
+    mBindlessStatistics = {};
+}
+
+auto Model::GetBindlessStatistics() -> const BindlessStatistics &
+{
+    return mBindlessStatistics;
+}
+
 void Model::Bind(ID3D12GraphicsCommandList *cmdList)
 {
 	cmdList->IASetVertexBuffers(0, 1, &mVertexBufferView);
@@ -6,6 +6,10 @@
 #include "Vertex.h"
 #include "Utils/UpdateObject.h"
 #include "MaterialManager.h"
+#include "FunctionRef.h"
+#include "Utils/UploadRingBuffer.h"
+#include "Utils/LightmapBaker.h"
+#include "Utils/ShadowCascades.h"
 
 #include <assimp\Importer.hpp>
 #include <assimp\scene.h>
@@ -25,6 +29,25 @@ public:
         "Triangle", "Square", "Grid"
     };
 
+    /// <summary>
+    /// Instance layout of the bindless pipelines; the material is read in the shader, so instances of
+    /// different materials are drawn together
+    /// </summary>
+    struct BindlessInstanceInfo
+    {
+        InstanceInfo Info;
+        uint32_t MaterialIndex;
+        uint32_t Padding[3];
+    };
+
+    struct BindlessStatistics
+    {
+        // Draws issued through the bindless path
+        uint32_t Draws = 0;
+        // Draws it would take with one material bound per draw
+        uint32_t PerMaterialDraws = 0;
+    };
+
     struct GridInitializationInfo
     {
 
@@ -52,23 +75,41 @@ public:
     void ClearInstances();
     uint32_t GetInstanceCount() const;
 
-    uint32_t PrepareInstances(std::function<bool(InstanceInfo&)>,
+    uint32_t PrepareInstances(FunctionRef<bool(InstanceInfo&)>,
         std::unordered_map<uuids::uuid, UploadBuffer<InstanceInfo>>&);
-    uint32_t PrepareInstances(std::function<bool(InstanceInfo&, void* Context)>,
+    uint32_t PrepareInstances(FunctionRef<bool(InstanceInfo&, void* Context)>,
         std::unordered_map<uuids::uuid, UploadBuffer<InstanceInfo>>&);
     uint32_t PrepareInstances(std::unordered_map<uuids::uuid, UploadBuffer<InstanceInfo>>&);
+    // Same as above, but the instances are written to the current frame's upload ring
+    uint32_t PrepareInstances(FunctionRef<bool(InstanceInfo&)>, UploadRingBuffer::Allocation& instancesAllocation);
+    uint32_t PrepareInstances(FunctionRef<bool(InstanceInfo&, void* Context)>, UploadRingBuffer::Allocation& instancesAllocation);
+    uint32_t PrepareInstances(UploadRingBuffer::Allocation& instancesAllocation);
     void BindInstancesBuffer(ID3D12GraphicsCommandList* cmdList, uint32_t instanceCount,
         const std::unordered_map<void*, UploadBuffer<InstanceInfo>>& instancesBuffer);
+    void BindInstancesBuffer(ID3D12GraphicsCommandList* cmdList, uint32_t instanceCount,
+        const UploadRingBuffer::Allocation& instancesAllocation);
+    // Writes BindlessInstanceInfo to the upload ring, each with its instance's material or the model's one
+    uint32_t PrepareBindlessInstances(FunctionRef<bool(InstanceInfo&)>, UploadRingBuffer::Allocation& instancesAllocation);
+    void BindBindlessInstances(ID3D12GraphicsCommandList* cmdList, const UploadRingBuffer::Allocation& instancesAllocation);
 
     void CloseAddingInstances();
 
+    // Adds the model's geometry, placed as the instance, to baker; lightmap UVs are the texture coordinates
+    Result<uint32_t> AddToLightmapBaker(LightmapBaker& baker, unsigned int instanceID = 0) const;
+    // Makes the instances whose bounding spheres can cast a shadow in cascade the current ones; returns how many
+    uint32_t SelectShadowCasters(const ShadowCascades& cascades, uint32_t cascade);
+
     const DirectX::BoundingBox& GetBoundingBox() const;
     const DirectX::BoundingSphere& GetBoundingSphere() const;
 
 public:
     static bool InitBuffers(ID3D12GraphicsCommandList* cmdList, ComPtr<ID3D12Resource> intermediaryResources[2]);
+    // Uploads the geometry on the copy queue; the direct queue waits for it before the next submission
+    static bool InitBuffers();
     static void Bind(ID3D12GraphicsCommandList* cmdList);
     static void Destroy();
+    static void ResetBindlessStatistics();
+    static const BindlessStatistics& GetBindlessStatistics();
 
 public:
     void ResetCurrentInstances();
@@ -82,6 +123,8 @@ public:
 
     void SetMaterial(const MaterialManager::Material*);
     MaterialManager::Material const* GetMaterial() const;
+    // Only used by the bindless path; the other paths bind the model's material
+    void SetInstanceMaterial(const MaterialManager::Material*, unsigned int instanceID = 0);
 
     const InstanceInfo& __vectorcall GetInstanceInfo(unsigned int instanceID = 0) const;
     InstanceInfo& __vectorcall GetInstanceInfo(unsigned int instanceID = 0);
@@ -120,6 +163,8 @@ private:
 
     static std::unordered_map<std::string, RenderParameters> mModelsRenderParameters;
 
+    static BindlessStatistics mBindlessStatistics;
+
 
 private:
     bool CreateTriangle();
@@ -138,6 +183,7 @@ private:
 
         InstanceInfo instanceInfo;
         void* Context;
+        MaterialManager::Material const* Material = nullptr;
     };
 
     std::vector<ModelInstanceInfo> mInstancesInfo;
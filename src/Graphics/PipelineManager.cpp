@@ -1,7 +1,148 @@
 #include "PipelineManager.h"
+#include "Profiler.h"
 #include "Direct3D.h"
 #include "Conversions.h"
+#include "JobSystem.h"
 #include "Utils/BatchRenderer.h"
+#include "Utils/Utils.h"
+
+// FNV-1a, continued from hash
+static uint64_t Hash(const void *data, size_t size, uint64_t hash = 0xcbf29ce484222325ull)
+{
+    auto bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+template <typename T>
+static uint64_t HashValue(const T &value, uint64_t hash)
+{
+    static_assert(std::has_unique_object_representations_v<T> || std::is_enum_v<T>, "Padding bytes can't be hashed");
+    return Hash(&value, sizeof(value), hash);
+}
+
+static uint64_t HashShader(const D3D12_SHADER_BYTECODE &shader, uint64_t hash)
+{
+    hash = HashValue(shader.BytecodeLength, hash);
+    return Hash(shader.pShaderBytecode, shader.BytecodeLength, hash);
+}
+
+// Root signatures are hashed by type: their pointers change from one run to the next
+static uint64_t HashPipelineDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc, RootSignatureType rootSignatureType)
+{
+    uint64_t hash = HashValue(rootSignatureType, 0xcbf29ce484222325ull);
+    for (const auto &shader : { desc.VS, desc.PS, desc.DS, desc.HS, desc.GS })
+    {
+        hash = HashShader(shader, hash);
+    }
+    // The write mask of every render target, and the stencil masks below, are followed by padding
+    hash = HashValue(desc.BlendState.AlphaToCoverageEnable, hash);
+    hash = HashValue(desc.BlendState.IndependentBlendEnable, hash);
+    for (const auto &renderTarget : desc.BlendState.RenderTarget)
+    {
+        hash = HashValue(renderTarget.BlendEnable, hash);
+        hash = HashValue(renderTarget.LogicOpEnable, hash);
+        hash = HashValue(renderTarget.SrcBlend, hash);
+        hash = HashValue(renderTarget.DestBlend, hash);
+        hash = HashValue(renderTarget.BlendOp, hash);
+        hash = HashValue(renderTarget.SrcBlendAlpha, hash);
+        hash = HashValue(renderTarget.DestBlendAlpha, hash);
+        hash = HashValue(renderTarget.BlendOpAlpha, hash);
+        hash = HashValue(renderTarget.LogicOp, hash);
+        hash = HashValue(renderTarget.RenderTargetWriteMask, hash);
+    }
+    hash = HashValue(desc.SampleMask, hash);
+    static_assert(sizeof(D3D12_RASTERIZER_DESC) == 11 * sizeof(uint32_t), "D3D12_RASTERIZER_DESC has padding");
+    hash = Hash(&desc.RasterizerState, sizeof(desc.RasterizerState), hash);
+
+    const auto &depthStencil = desc.DepthStencilState;
+    hash = HashValue(depthStencil.DepthEnable, hash);
+    hash = HashValue(depthStencil.DepthWriteMask, hash);
+    hash = HashValue(depthStencil.DepthFunc, hash);
+    hash = HashValue(depthStencil.StencilEnable, hash);
+    hash = HashValue(depthStencil.StencilReadMask, hash);
+    hash = HashValue(depthStencil.StencilWriteMask, hash);
+    static_assert(sizeof(D3D12_DEPTH_STENCILOP_DESC) == 4 * sizeof(uint32_t), "D3D12_DEPTH_STENCILOP_DESC has padding");
+    hash = Hash(&depthStencil.FrontFace, sizeof(depthStencil.FrontFace), hash);
+    hash = Hash(&depthStencil.BackFace, sizeof(depthStencil.BackFace), hash);
+
+    for (uint32_t i = 0; i < desc.InputLayout.NumElements; ++i)
+    {
+        const auto &element = desc.InputLayout.pInputElementDescs[i];
+        hash = Hash(element.SemanticName, strlen(element.SemanticName), hash);
+        hash = HashValue(element.SemanticIndex, hash);
+        hash = HashValue(element.Format, hash);
+        hash = HashValue(element.InputSlot, hash);
+        hash = HashValue(element.AlignedByteOffset, hash);
+        hash = HashValue(element.InputSlotClass, hash);
+        hash = HashValue(element.InstanceDataStepRate, hash);
+    }
+    hash = HashValue(desc.IBStripCutValue, hash);
+    hash = HashValue(desc.PrimitiveTopologyType, hash);
+    hash = HashValue(desc.NumRenderTargets, hash);
+    hash = Hash(desc.RTVFormats, sizeof(desc.RTVFormats), hash);
+    hash = HashValue(desc.DSVFormat, hash);
+    hash = HashValue(desc.SampleDesc.Count, hash);
+    hash = HashValue(desc.SampleDesc.Quality, hash);
+    hash = HashValue(desc.NodeMask, hash);
+    return HashValue(desc.Flags, hash);
+}
+
+static uint64_t HashPipelineDesc(const D3D12_COMPUTE_PIPELINE_STATE_DESC &desc, RootSignatureType rootSignatureType)
+{
+    uint64_t hash = HashValue(rootSignatureType, 0xcbf29ce484222325ull);
+    hash = HashShader(desc.CS, hash);
+    hash = HashValue(desc.NodeMask, hash);
+    return HashValue(desc.Flags, hash);
+}
+
+static HRESULT LoadPipeline(ID3D12PipelineLibrary *library, const std::wstring &name,
+                            const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc, ComPtr<ID3D12PipelineState> &pipeline)
+{
+    return library->LoadGraphicsPipeline(name.c_str(), &desc, IID_PPV_ARGS(&pipeline));
+}
+
+static HRESULT LoadPipeline(ID3D12PipelineLibrary *library, const std::wstring &name,
+                            const D3D12_COMPUTE_PIPELINE_STATE_DESC &desc, ComPtr<ID3D12PipelineState> &pipeline)
+{
+    return library->LoadComputePipeline(name.c_str(), &desc, IID_PPV_ARGS(&pipeline));
+}
+
+// PositionNormalTexCoordVertex followed by the world and texture matrices of every instance, in slot 1
+static std::vector<D3D12_INPUT_ELEMENT_DESC> GetInstancedInputElementDesc()
+{
+    auto elementDesc = PositionNormalTexCoordVertex::GetInputElementDesc();
+    std::vector<D3D12_INPUT_ELEMENT_DESC> inputElements(elementDesc.begin(), elementDesc.end());
+    D3D12_INPUT_ELEMENT_DESC worldMatrix[4], texWorldMatrix[4];
+    worldMatrix[0].AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT;
+    worldMatrix[0].Format = DXGI_FORMAT::DXGI_FORMAT_R32G32B32A32_FLOAT;
+    worldMatrix[0].InputSlot = 1;
+    worldMatrix[0].InputSlotClass = D3D12_INPUT_CLASSIFICATION::D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA;
+    worldMatrix[0].InstanceDataStepRate = 1;
+    worldMatrix[0].SemanticIndex = 0;
+    worldMatrix[0].SemanticName = "WORLDMATRIX";
+    texWorldMatrix[0].AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT;
+    texWorldMatrix[0].Format = DXGI_FORMAT::DXGI_FORMAT_R32G32B32A32_FLOAT;
+    texWorldMatrix[0].InputSlot = 1;
+    texWorldMatrix[0].InputSlotClass = D3D12_INPUT_CLASSIFICATION::D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA;
+    texWorldMatrix[0].InstanceDataStepRate = 1;
+    texWorldMatrix[0].SemanticIndex = 0;
+    texWorldMatrix[0].SemanticName = "TEXWORLDMATRIX";
+    for (int i = 1; i < 4; ++i)
+    {
+        worldMatrix[i] = worldMatrix[0];
+        worldMatrix[i].SemanticIndex = i;
+        texWorldMatrix[i] = texWorldMatrix[0];
+        texWorldMatrix[i].SemanticIndex = i;
+    }
+    std::copy(std::begin(worldMatrix), std::end(worldMatrix), std::back_inserter(inputElements));
+    std::copy(std::begin(texWorldMatrix), std::end(texWorldMatrix), std::back_inserter(inputElements));
+    return inputElements;
+}
 
 std::array<CD3DX12_STATIC_SAMPLER_DESC, 4> GetSamplers()
 {
@@ -38,6 +179,7 @@ std::array<CD3DX12_STATIC_SAMPLER_DESC, 4> GetSamplers()
 
 bool PipelineManager::Init()
 {
+    PROFILE_FUNCTION();
     mSamplers = GetSamplers();
 
     CHECK(InitRootSignatures(), false, "Unable to initialize all root signatures");
@@ -99,8 +241,14 @@ auto PipelineManager::GetPipelineAndRootSignature(PipelineType pipelineType) ->
     return result;
 }
 
+auto PipelineManager::GetPipelineStatistics() const -> const std::unordered_map<PipelineType, PipelineStatistics> &
+{
+    return mPipelineStatistics;
+}
+
 bool PipelineManager::InitRootSignatures()
 {
+    PROFILE_FUNCTION();
     CHECK(InitEmptyRootSignature(), false, "Unable to initialize an empty root signature");
     CHECK(InitSimpleColorRootSignature(), false, "Unable to initialize simple color's root signature");
     CHECK(InitObjectFrameMaterialRootSignature(), false, "Unable to initialize object frame material root signature");
@@ -108,6 +256,7 @@ bool PipelineManager::InitRootSignatures()
     CHECK(InitTextureSrvUavBufferRootSignature(), false, "Unable to initialize texture srv uav and buffer signature");
     CHECK(InitPassMaterialLightsTextureInstance(), false, "Unable to initialize pass material light texture instance signature");
     CHECK(InitOneCBV(), false, "Unable to initialize one CBV root signature");
+    CHECK(InitBindlessRootSignature(), false, "Unable to initialize bindless root signature");
 
     SHOWINFO("Successfully initialized all root signatures");
     return true;
@@ -115,21 +264,322 @@ bool PipelineManager::InitRootSignatures()
 
 bool PipelineManager::InitPipelines()
 {
-    CHECK(InitSimpleColorPipeline(), false, "Unable to initialize simple color pipeline");
-    CHECK(InitMaterialLightPipeline(), false, "Unable to initialize material light pipeline");
-    CHECK(InitRawTexturePipeline(), false, "Unable to initialize raw texture pipeline");
-    CHECK(InitBlurPipelines(), false, "Unable to initialize blur pipelines");
-    CHECK(InitInstancedMaterialLightPipeline(), false, "Unable to initialize material light pipeline");
-    CHECK(InitTerrainPipeline(), false, "Unable to initialize terrain pipeline");
-    CHECK(InitInstancedMaterialColorLightPipeline(), false, "Unable to initialize instanced material color light pipeline");
-    CHECK(InitDebugPipeline(), false, "Unable to initialize debug pipeline");
+    PROFILE_FUNCTION();
+    using InitFunction = bool (PipelineManager::*)();
+    struct PipelineInitializer
+    {
+        InitFunction Init;
+        const char *Name;
+    };
+    static constexpr PipelineInitializer initializers[] =
+    {
+        { &PipelineManager::InitSimpleColorPipeline, "simple color" },
+        { &PipelineManager::InitMaterialLightPipeline, "material light" },
+        { &PipelineManager::InitRawTexturePipeline, "raw texture" },
+        { &PipelineManager::InitBlurPipelines, "blur" },
+        { &PipelineManager::InitInstancedMaterialLightPipeline, "instanced material light" },
+        { &PipelineManager::InitTerrainPipeline, "terrain" },
+        { &PipelineManager::InitInstancedMaterialColorLightPipeline, "instanced material color light" },
+        { &PipelineManager::InitDebugPipeline, "debug" },
+        { &PipelineManager::InitBindlessMaterialLightPipeline, "bindless material light" },
+    };
+    constexpr uint32_t initializerCount = ARRAYSIZE(initializers);
+
+    InitPipelineLibrary();
+
+    // The pipelines don't depend on each other and only read the root signatures, so each one is a job
+    bool succeeded[initializerCount] = {};
+    float milliseconds[initializerCount] = {};
+    auto start = std::chrono::steady_clock::now();
+    JobSystem::Get()->ParallelFor(initializerCount, 1, [&](uint32_t begin, uint32_t end)
+                                  {
+                                      for (uint32_t i = begin; i < end; ++i)
+                                      {
+                                          auto initStart = std::chrono::steady_clock::now();
+                                          succeeded[i] = (this->*initializers[i].Init)();
+                                          milliseconds[i] = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - initStart).count();
+                                      }
+                                  });
+    float totalMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    for (uint32_t i = 0; i < initializerCount; ++i)
+    {
+        CHECK(succeeded[i], false, "Unable to initialize {} pipeline", initializers[i].Name);
+        SHOWINFO("Initialized {} pipeline in {:.2f} ms", initializers[i].Name, milliseconds[i]);
+    }
+    uint32_t fromLibrary = 0;
+    for (const auto &[type, statistics] : mPipelineStatistics)
+    {
+        SHOWINFO("Pipeline state {}: {:.2f} ms, {}", PipelineTypeString[(int)type], statistics.Milliseconds,
+                 statistics.FromLibrary ? "loaded from the library" : "compiled");
+        fromLibrary += statistics.FromLibrary ? 1 : 0;
+    }
+    if (!SavePipelineLibrary())
+    {
+        SHOWWARNING("Unable to save the pipeline library. Pipelines will be compiled again on the next run");
+    }
+
+    SHOWINFO("Successfully initialized all pipelines in {:.2f} ms, {} of {} from the library", totalMilliseconds,
+             fromLibrary, mPipelineStatistics.size());
+    return true;
+}
+
+uint32_t MaterialLightPermutation::GetKey() const
+{
+    return (Textured ? 1u : 0u) | ((uint32_t)Instancing << 1) | ((uint32_t)Lights << 3);
+}
+
+LightCountTier MaterialLightPermutation::GetLightCountTier(uint32_t lightCount)
+{
+    if (lightCount == 0)
+    {
+        return LightCountTier::None;
+    }
+    return lightCount <= kLowTierLightCount ? LightCountTier::Low : LightCountTier::Full;
+}
+
+auto PipelineManager::GetPipelineAndRootSignature(const MaterialLightPermutation &permutation)
+    -> Result<std::tuple<ID3D12PipelineState *, ID3D12RootSignature *>>
+{
+    static constexpr PipelineType genericPipelines[] =
+    {
+        PipelineType::MaterialLight, PipelineType::InstancedMaterialLight, PipelineType::InstancedColorMaterialLight
+    };
+    auto genericPipeline = genericPipelines[(int)permutation.Instancing];
+
+    auto compiledPermutation = RequestPermutation(permutation);
+    if (!compiledPermutation->Compiled.IsDone() || !compiledPermutation->Pipeline)
+    {
+        return GetPipelineAndRootSignature(genericPipeline);
+    }
+
+    auto rootSignatureResult = GetRootSignature(genericPipeline);
+    CHECK(rootSignatureResult.Valid(), std::nullopt, "Unable to get the root signature of permutation {}", permutation.GetKey());
+
+    std::tuple<ID3D12PipelineState *, ID3D12RootSignature *> result = { compiledPermutation->Pipeline.Get(), rootSignatureResult.Get() };
+    return result;
+}
+
+bool PipelineManager::WaitForPermutation(const MaterialLightPermutation &permutation)
+{
+    PROFILE_FUNCTION();
+    auto compiledPermutation = RequestPermutation(permutation);
+    JobSystem::Get()->Wait(compiledPermutation->Compiled);
+    return compiledPermutation->Pipeline != nullptr;
+}
+
+uint32_t PipelineManager::GetPermutationCount() const
+{
+    std::unique_lock<std::mutex> lock(mPermutationsLock);
+    return (uint32_t)mPermutations.size();
+}
+
+auto PipelineManager::RequestPermutation(const MaterialLightPermutation &permutation) -> Permutation *
+{
+    Permutation *result;
+    {
+        std::unique_lock<std::mutex> lock(mPermutationsLock);
+        auto &entry = mPermutations[permutation.GetKey()];
+        if (entry)
+        {
+            return entry.get();
+        }
+        entry = std::make_unique<Permutation>();
+        result = entry.get();
+    }
+
+    JobSystem::Get()->Schedule(result->Compiled, [this, permutation, result]()
+                               {
+                                   CompilePermutation(permutation, *result);
+                               });
+    return result;
+}
+
+bool PipelineManager::CompilePermutation(const MaterialLightPermutation &permutation, Permutation &result)
+{
+    PROFILE_FUNCTION();
+    auto start = std::chrono::steady_clock::now();
 
-    SHOWINFO("Successfully initialized all pipelines");
+    static constexpr const char *instancingModes[] = { "0", "1", "2" };
+    static constexpr const char *lightCounts[] = { "0", "4", "MAX_LIGHTS" };
+    static_assert(MaterialLightPermutation::kLowTierLightCount == 4, "The low tier's LIGHT_COUNT must match kLowTierLightCount");
+    D3D_SHADER_MACRO defines[] =
+    {
+        { "HAS_TEXTURE", permutation.Textured ? "1" : "0" },
+        { "INSTANCING_MODE", instancingModes[(int)permutation.Instancing] },
+        { "LIGHT_COUNT", lightCounts[(int)permutation.Lights] },
+        { nullptr, nullptr }
+    };
+
+    // The build and the install copy the sources next to the executable
+    static const std::wstring sourceDirectory = Utils::GetExecutableDirectory() + L"Shaders\\Sources\\MaterialLightPermutations\\";
+    std::wstring vertexShaderPath = sourceDirectory + L"VertexShader.hlsl";
+    std::wstring pixelShaderPath = sourceDirectory + L"PixelShader.hlsl";
+
+    ComPtr<ID3DBlob> vertexShader, pixelShader;
+    ASSIGN_RESULT(vertexShader, Utils::CompileShader(vertexShaderPath.c_str(), "vs_5_1", defines),
+                  false, "Unable to compile the vertex shader of permutation {}", permutation.GetKey());
+    ASSIGN_RESULT(pixelShader, Utils::CompileShader(pixelShaderPath.c_str(), "ps_5_1", defines),
+                  false, "Unable to compile the pixel shader of permutation {}", permutation.GetKey());
+
+    auto rootSignatureType = permutation.Instancing == InstancingMode::StructuredBuffer ?
+        RootSignatureType::PassMaterialLightsTextureInstance : RootSignatureType::ObjectFrameMaterialLights;
+    auto rootSignature = mRootSignatures.find(rootSignatureType);
+    CHECK(!(rootSignature == mRootSignatures.end()), false, "Unable to find the root signature of permutation {}", permutation.GetKey());
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC pipelineDesc = {};
+    pipelineDesc.NodeMask = 0;
+    pipelineDesc.BlendState = CD3DX12_BLEND_DESC(CD3DX12_DEFAULT());
+    pipelineDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(CD3DX12_DEFAULT());
+    pipelineDesc.DepthStencilState.StencilEnable = FALSE;
+    pipelineDesc.DepthStencilState.DepthEnable = TRUE;
+    pipelineDesc.DSVFormat = Direct3D::kDepthStencilFormat;
+    pipelineDesc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+    pipelineDesc.IBStripCutValue = D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED;
+    pipelineDesc.NumRenderTargets = 1;
+    pipelineDesc.RTVFormats[0] = Direct3D::kBackbufferFormat;
+    pipelineDesc.SampleDesc.Count = 1;
+    pipelineDesc.SampleDesc.Quality = 0;
+    pipelineDesc.SampleMask = D3D12_DEFAULT_SAMPLE_MASK;
+    pipelineDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    pipelineDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(CD3DX12_DEFAULT());
+    pipelineDesc.pRootSignature = rootSignature->second.Get();
+
+    auto elementDesc = PositionNormalTexCoordVertex::GetInputElementDesc();
+    std::vector<D3D12_INPUT_ELEMENT_DESC> inputElements(elementDesc.begin(), elementDesc.end());
+    if (permutation.Instancing == InstancingMode::VertexStream)
+    {
+        inputElements = GetInstancedInputElementDesc();
+    }
+    pipelineDesc.InputLayout.NumElements = (uint32_t)inputElements.size();
+    pipelineDesc.InputLayout.pInputElementDescs = inputElements.data();
+
+    pipelineDesc.VS.BytecodeLength = vertexShader->GetBufferSize();
+    pipelineDesc.VS.pShaderBytecode = vertexShader->GetBufferPointer();
+    pipelineDesc.PS.BytecodeLength = pixelShader->GetBufferSize();
+    pipelineDesc.PS.pShaderBytecode = pixelShader->GetBufferPointer();
+
+    ASSIGN_RESULT(result.Pipeline, Direct3D::Get()->CreatePipelineState(pipelineDesc), false,
+                  "Unable to create the pipeline of permutation {}", permutation.GetKey());
+
+    float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    SHOWINFO("Compiled material light permutation {} (texture {}, instancing {}, light tier {}) in {:.2f} ms", permutation.GetKey(),
+             permutation.Textured, (int)permutation.Instancing, (int)permutation.Lights, milliseconds);
     return true;
 }
 
+void PipelineManager::InitPipelineLibrary()
+{
+    PROFILE_FUNCTION();
+    ComPtr<ID3D12Device1> device;
+    if (FAILED(Direct3D::Get()->GetD3D12Device().As(&device)))
+    {
+        SHOWWARNING("Pipeline libraries are not supported. Every pipeline will be compiled");
+        return;
+    }
+
+    std::ifstream file(kPipelineLibraryPath, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        SHOWINFO("There's no pipeline library at {}. Every pipeline will be compiled", Conversions::ws2s(kPipelineLibraryPath));
+        return;
+    }
+    mPipelineLibraryData.resize((size_t)file.tellg());
+    file.seekg(0);
+    file.read(mPipelineLibraryData.data(), mPipelineLibraryData.size());
+
+    // Fails when the driver or the adapter changed since the library was saved
+    HRESULT result = device->CreatePipelineLibrary(mPipelineLibraryData.data(), mPipelineLibraryData.size(),
+                                                   IID_PPV_ARGS(&mPipelineLibrary));
+    if (FAILED(result))
+    {
+        SHOWWARNING("Unable to use the pipeline library at {} (error code {:#x}). Every pipeline will be compiled",
+                    Conversions::ws2s(kPipelineLibraryPath), (uint32_t)result);
+        mPipelineLibrary.Reset();
+        mPipelineLibraryData.clear();
+    }
+}
+
+bool PipelineManager::SavePipelineLibrary()
+{
+    PROFILE_FUNCTION();
+    bool upToDate = std::all_of(mPipelineStatistics.begin(), mPipelineStatistics.end(), [](const auto &statistics)
+                                {
+                                    return statistics.second.FromLibrary;
+                                });
+    ComPtr<ID3D12Device1> device;
+    if (upToDate || FAILED(Direct3D::Get()->GetD3D12Device().As(&device)))
+    {
+        return true;
+    }
+
+    // A new library, so pipelines that changed don't leave their old versions behind
+    ComPtr<ID3D12PipelineLibrary> library;
+    CHECK_HR(device->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&library)), false);
+    for (const auto &[type, name] : mPipelineNames)
+    {
+        CHECK_HR(library->StorePipeline(name.c_str(), mPipelines[type].Get()), false);
+    }
+
+    std::vector<char> data(library->GetSerializedSize());
+    CHECK_HR(library->Serialize(data.data(), data.size()), false);
+    std::ofstream file(kPipelineLibraryPath, std::ios::binary);
+    CHECK(file.is_open(), false, "Unable to open {} for writing", Conversions::ws2s(kPipelineLibraryPath));
+    file.write(data.data(), data.size());
+    CHECK(file.good(), false, "Unable to write {} bytes to {}", data.size(), Conversions::ws2s(kPipelineLibraryPath));
+
+    SHOWINFO("Saved {} pipelines to {}", mPipelineNames.size(), Conversions::ws2s(kPipelineLibraryPath));
+    return true;
+}
+
+auto PipelineManager::CreatePipelineState(PipelineType type, RootSignatureType rootSignatureType,
+                                          const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc) -> Result<ComPtr<ID3D12PipelineState>>
+{
+    return LoadOrCreatePipelineState(type, HashPipelineDesc(desc, rootSignatureType), desc);
+}
+
+auto PipelineManager::CreatePipelineState(PipelineType type, RootSignatureType rootSignatureType,
+                                          const D3D12_COMPUTE_PIPELINE_STATE_DESC &desc) -> Result<ComPtr<ID3D12PipelineState>>
+{
+    return LoadOrCreatePipelineState(type, HashPipelineDesc(desc, rootSignatureType), desc);
+}
+
+template <typename PipelineStateDesc>
+auto PipelineManager::LoadOrCreatePipelineState(PipelineType type, uint64_t key, const PipelineStateDesc &desc)
+    -> Result<ComPtr<ID3D12PipelineState>>
+{
+    PROFILE_FUNCTION();
+    auto name = Conversions::s2ws(fmt::format("{}_{:016x}", PipelineTypeString[(int)type], key));
+    auto start = std::chrono::steady_clock::now();
+
+    // The library is free threaded as long as different threads load different pipelines
+    ComPtr<ID3D12PipelineState> pipeline;
+    bool fromLibrary = mPipelineLibrary && SUCCEEDED(LoadPipeline(mPipelineLibrary.Get(), name, desc, pipeline));
+    if (!fromLibrary)
+    {
+        ASSIGN_RESULT(pipeline, Direct3D::Get()->CreatePipelineState(desc), std::nullopt,
+                      "Unable to create pipeline type {}", PipelineTypeString[(int)type]);
+    }
+    float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::unique_lock<std::mutex> lock(mPipelinesLock);
+    mPipelineNames[type] = std::move(name);
+    mPipelineStatistics[type] = { milliseconds, fromLibrary };
+    return pipeline;
+}
+
+void PipelineManager::AddPipeline(PipelineType type, RootSignatureType rootSignatureType, ComPtr<ID3D12PipelineState> pipeline,
+                                  std::initializer_list<ComPtr<ID3DBlob>> shaders)
+{
+    std::unique_lock<std::mutex> lock(mPipelinesLock);
+    mPipelines[type] = pipeline;
+    mShaders[type].insert(mShaders[type].end(), shaders.begin(), shaders.end());
+    mPipelineToRootSignature[type] = rootSignatureType;
+}
+
 bool PipelineManager::InitEmptyRootSignature()
 {
+    PROFILE_FUNCTION();
     auto d3d = Direct3D::Get();
 
     auto type = RootSignatureType::Empty;
@@ -149,6 +599,7 @@ bool PipelineManager::InitEmptyRootSignature()
 
 bool PipelineManager::InitSimpleColorRootSignature()
 {
+    PROFILE_FUNCTION();
     auto d3d = Direct3D::Get();
     auto type = RootSignatureType::SimpleColor;
 
@@ -172,6 +623,7 @@ bool PipelineManager::InitSimpleColorRootSignature()
 
 bool PipelineManager::InitObjectFrameMaterialRootSignature()
 {
+    PROFILE_FUNCTION();
     auto d3d = Direct3D::Get();
     auto type = RootSignatureType::ObjectFrameMaterialLights;
 
@@ -202,6 +654,7 @@ bool PipelineManager::InitObjectFrameMaterialRootSignature()
 
 bool PipelineManager::InitTextureOnlyRootSignature()
 {
+    PROFILE_FUNCTION();
     auto d3d = Direct3D::Get();
     auto type = RootSignatureType::TextureOnly;
 
@@ -227,22 +680,24 @@ bool PipelineManager::InitTextureOnlyRootSignature()
 
 bool PipelineManager::InitTextureSrvUavBufferRootSignature()
 {
+    PROFILE_FUNCTION();
     auto d3d = Direct3D::Get();
     auto type = RootSignatureType::TextureSrvUavBuffer;
 
     CD3DX12_DESCRIPTOR_RANGE srvRanges[1], uavRanges[1];
     srvRanges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0, 0);
     uavRanges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0, 0);
-    CD3DX12_ROOT_PARAMETER parameters[3];
+    CD3DX12_ROOT_PARAMETER parameters[4];
     parameters[0].InitAsDescriptorTable(ARRAYSIZE(srvRanges), srvRanges);
     parameters[1].InitAsDescriptorTable(ARRAYSIZE(uavRanges), uavRanges);
     parameters[2].InitAsConstantBufferView(0);
+    parameters[3].InitAsShaderResourceView(1); // Buffer
 
     D3D12_ROOT_SIGNATURE_DESC signatureDesc = {};
     signatureDesc.NumParameters = ARRAYSIZE(parameters);
     signatureDesc.pParameters = parameters;
-    signatureDesc.NumStaticSamplers = 0;
-    signatureDesc.pStaticSamplers = nullptr;
+    signatureDesc.NumStaticSamplers = (uint32_t)mSamplers.size();
+    signatureDesc.pStaticSamplers = mSamplers.data();
     signatureDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_NONE;
 
     auto signature = d3d->CreateRootSignature(signatureDesc);
@@ -255,6 +710,7 @@ bool PipelineManager::InitTextureSrvUavBufferRootSignature()
 
 bool PipelineManager::InitPassMaterialLightsTextureInstance()
 {
+    PROFILE_FUNCTION();
     auto d3d = Direct3D::Get();
     auto type = RootSignatureType::PassMaterialLightsTextureInstance;
 
@@ -284,8 +740,46 @@ bool PipelineManager::InitPassMaterialLightsTextureInstance()
     return true;
 }
 
+bool PipelineManager::InitBindlessRootSignature()
+{
+    PROFILE_FUNCTION();
+    auto d3d = Direct3D::Get();
+    auto type = RootSignatureType::Bindless;
+
+    // Every shader resource view of TextureManager, indexed through the texture table
+    CD3DX12_DESCRIPTOR_RANGE srvRanges[1];
+    srvRanges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, 0, 2);
+
+    CD3DX12_ROOT_PARAMETER parameters[10];
+    parameters[0].InitAsConstantBufferView(0); // PerFrame
+    parameters[1].InitAsConstantBufferView(1); // Lights
+    parameters[2].InitAsShaderResourceView(0, 1); // Instances, with their material index
+    parameters[3].InitAsShaderResourceView(1, 1); // Materials
+    parameters[4].InitAsShaderResourceView(2, 1, D3D12_SHADER_VISIBILITY_PIXEL); // Texture table
+    parameters[5].InitAsDescriptorTable(ARRAYSIZE(srvRanges), srvRanges, D3D12_SHADER_VISIBILITY_PIXEL);
+    parameters[6].InitAsConstants(8, 2, 0, D3D12_SHADER_VISIBILITY_PIXEL); // Cluster info
+    parameters[7].InitAsShaderResourceView(3, 1, D3D12_SHADER_VISIBILITY_PIXEL); // Clustered lights
+    parameters[8].InitAsShaderResourceView(4, 1, D3D12_SHADER_VISIBILITY_PIXEL); // Light clusters
+    parameters[9].InitAsShaderResourceView(5, 1, D3D12_SHADER_VISIBILITY_PIXEL); // Cluster light indices
+
+    D3D12_ROOT_SIGNATURE_DESC signatureDesc = {};
+    signatureDesc.NumParameters = ARRAYSIZE(parameters);
+    signatureDesc.pParameters = parameters;
+    signatureDesc.NumStaticSamplers = (uint32_t)mSamplers.size();
+    signatureDesc.pStaticSamplers = mSamplers.data();
+    signatureDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+
+    auto signature = d3d->CreateRootSignature(signatureDesc);
+    CHECK(signature.Valid(), false, "Unable to create a valid Bindless signature");
+    mRootSignatures[type] = signature.Get();
+
+    SHOWINFO("Successfully initialized Bindless");
+    return true;
+}
+
 bool PipelineManager::InitOneCBV()
 {
+    PROFILE_FUNCTION();
     auto d3d = Direct3D::Get();
     auto type = RootSignatureType::OneCBV;
 
@@ -309,7 +803,7 @@ bool PipelineManager::InitOneCBV()
 
 bool PipelineManager::InitSimpleColorPipeline()
 {
-    auto d3d = Direct3D::Get();
+    PROFILE_FUNCTION();
     PipelineType type = PipelineType::SimpleColor;
     RootSignatureType rootSignatureType = RootSignatureType::SimpleColor;
     D3D12_GRAPHICS_PIPELINE_STATE_DESC simpleColorPipeline = {};
@@ -350,13 +844,10 @@ bool PipelineManager::InitSimpleColorPipeline()
     simpleColorPipeline.PS.BytecodeLength = pixelShader->GetBufferSize();
     simpleColorPipeline.PS.pShaderBytecode = pixelShader->GetBufferPointer();
 
-    auto pipeline = d3d->CreatePipelineState(simpleColorPipeline);
+    auto pipeline = CreatePipelineState(type, rootSignatureType, simpleColorPipeline);
     CHECK(pipeline.Valid(), false, "Unable to create pipeline type {}", PipelineTypeString[int(type)]);
     
-    mPipelines[type] = pipeline.Get();
-    mShaders[type].push_back(vertexShader);
-    mShaders[type].push_back(pixelShader);
-    mPipelineToRootSignature[type] = rootSignatureType;
+    AddPipeline(type, rootSignatureType, pipeline.Get(), { vertexShader, pixelShader });
 
     SHOWINFO("Successfully initialized simple color pipeline");
     return true;
@@ -364,7 +855,7 @@ bool PipelineManager::InitSimpleColorPipeline()
 
 bool PipelineManager::InitMaterialLightPipeline()
 {
-    auto d3d = Direct3D::Get();
+    PROFILE_FUNCTION();
     PipelineType type = PipelineType::MaterialLight;
     RootSignatureType rootSignatureType = RootSignatureType::ObjectFrameMaterialLights;
     D3D12_GRAPHICS_PIPELINE_STATE_DESC materialLightPipeline = {};
@@ -397,21 +888,19 @@ bool PipelineManager::InitMaterialLightPipeline()
     materialLightPipeline.InputLayout.pInputElementDescs = elementDesc.data();
 
     ComPtr<ID3DBlob> vertexShader, pixelShader;
-    CHECK_HR(D3DReadFileToBlob(L"Shaders\\MaterialLightPipeline_VertexShader.cso", &vertexShader), false);
-    CHECK_HR(D3DReadFileToBlob(L"Shaders\\MaterialLightPipeline_PixelShader.cso", &pixelShader), false);
+    // The permutation source compiled with its defaults is the generic pipeline
+    CHECK_HR(D3DReadFileToBlob(L"Shaders\\MaterialLightPermutations_VertexShader.cso", &vertexShader), false);
+    CHECK_HR(D3DReadFileToBlob(L"Shaders\\MaterialLightPermutations_PixelShader.cso", &pixelShader), false);
 
     materialLightPipeline.VS.BytecodeLength = vertexShader->GetBufferSize();
     materialLightPipeline.VS.pShaderBytecode = vertexShader->GetBufferPointer();
     materialLightPipeline.PS.BytecodeLength = pixelShader->GetBufferSize();
     materialLightPipeline.PS.pShaderBytecode = pixelShader->GetBufferPointer();
 
-    auto pipeline = d3d->CreatePipelineState(materialLightPipeline);
+    auto pipeline = CreatePipelineState(type, rootSignatureType, materialLightPipeline);
     CHECK(pipeline.Valid(), false, "Unable to create pipeline type {}", PipelineTypeString[int(type)]);
 
-    mPipelines[type] = pipeline.Get();
-    mShaders[type].push_back(vertexShader);
-    mShaders[type].push_back(pixelShader);
-    mPipelineToRootSignature[type] = rootSignatureType;
+    AddPipeline(type, rootSignatureType, pipeline.Get(), { vertexShader, pixelShader });
 
     SHOWINFO("Successfully initialized material light pipeline");
     return true;
@@ -419,7 +908,7 @@ bool PipelineManager::InitMaterialLightPipeline()
 
 bool PipelineManager::InitRawTexturePipeline()
 {
-    auto d3d = Direct3D::Get();
+    PROFILE_FUNCTION();
     PipelineType type = PipelineType::RawTexture;
     RootSignatureType rootSignatureType = RootSignatureType::TextureOnly;
     D3D12_GRAPHICS_PIPELINE_STATE_DESC materialLightPipeline = {};
@@ -459,13 +948,10 @@ bool PipelineManager::InitRawTexturePipeline()
     materialLightPipeline.PS.BytecodeLength = pixelShader->GetBufferSize();
     materialLightPipeline.PS.pShaderBytecode = pixelShader->GetBufferPointer();
 
-    auto pipeline = d3d->CreatePipelineState(materialLightPipeline);
+    auto pipeline = CreatePipelineState(type, rootSignatureType, materialLightPipeline);
     CHECK(pipeline.Valid(), false, "Unable to create pipeline type {}", PipelineTypeString[int(type)]);
 
-    mPipelines[type] = pipeline.Get();
-    mShaders[type].push_back(vertexShader);
-    mShaders[type].push_back(pixelShader);
-    mPipelineToRootSignature[type] = rootSignatureType;
+    AddPipeline(type, rootSignatureType, pipeline.Get(), { vertexShader, pixelShader });
 
     SHOWINFO("Successfully initialized raw texture pipeline");
     return true;
@@ -473,7 +959,7 @@ bool PipelineManager::InitRawTexturePipeline()
 
 bool PipelineManager::InitBlurPipelines()
 {
-    auto d3d = Direct3D::Get();
+    PROFILE_FUNCTION();
     PipelineType type = PipelineType::HorizontalBlur;
     RootSignatureType rootSignatureType = RootSignatureType::TextureSrvUavBuffer;
 
@@ -481,7 +967,11 @@ bool PipelineManager::InitBlurPipelines()
 
     pipelineStateDesc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
     pipelineStateDesc.NodeMask = 0;
-    pipelineStateDesc.pRootSignature = mRootSignatures[rootSignatureType].Get();
+    // Pipelines are initialized in parallel, so the root signatures can only be looked up
+    auto rootSignature = mRootSignatures.find(rootSignatureType);
+    CHECK(!(rootSignature == mRootSignatures.end()), false,
+          "Unable to find root signature for pipeline type {}", PipelineTypeString[int(type)]);
+    pipelineStateDesc.pRootSignature = rootSignature->second.Get();
     pipelineStateDesc.CachedPSO.CachedBlobSizeInBytes = 0;
     pipelineStateDesc.CachedPSO.pCachedBlob = nullptr;
     
@@ -492,30 +982,26 @@ bool PipelineManager::InitBlurPipelines()
     pipelineStateDesc.CS.BytecodeLength = horizontalBlurComputeShader->GetBufferSize();
     pipelineStateDesc.CS.pShaderBytecode = horizontalBlurComputeShader->GetBufferPointer();
 
-    auto pipeline = d3d->CreatePipelineState(pipelineStateDesc);
+    auto pipeline = CreatePipelineState(type, rootSignatureType, pipelineStateDesc);
     CHECK(pipeline.Valid(), false, "Unable to create pipeline type {}", PipelineTypeString[int(type)]);
 
-    mPipelines[type] = pipeline.Get();
-    mShaders[type].push_back(horizontalBlurComputeShader);
-    mPipelineToRootSignature[type] = rootSignatureType;
+    AddPipeline(type, rootSignatureType, pipeline.Get(), { horizontalBlurComputeShader });
 
     type = PipelineType::VerticalBlur;
 
     pipelineStateDesc.CS.BytecodeLength = verticalBlurComputeShader->GetBufferSize();
     pipelineStateDesc.CS.pShaderBytecode = verticalBlurComputeShader->GetBufferPointer();
-    pipeline = d3d->CreatePipelineState(pipelineStateDesc);
+    pipeline = CreatePipelineState(type, rootSignatureType, pipelineStateDesc);
     CHECK(pipeline.Valid(), false, "Unable to create pipeline type {}", PipelineTypeString[int(type)]);
     
-    mPipelines[type] = pipeline.Get();
-    mShaders[type].push_back(verticalBlurComputeShader);
-    mPipelineToRootSignature[type] = rootSignatureType;
+    AddPipeline(type, rootSignatureType, pipeline.Get(), { verticalBlurComputeShader });
 
     return true;
 }
 
 bool PipelineManager::InitInstancedMaterialLightPipeline()
 {
-    auto d3d = Direct3D::Get();
+    PROFILE_FUNCTION();
     PipelineType type = PipelineType::InstancedMaterialLight;
     RootSignatureType rootSignatureType = RootSignatureType::ObjectFrameMaterialLights;
     D3D12_GRAPHICS_PIPELINE_STATE_DESC materialLightPipeline = {};
@@ -543,34 +1029,7 @@ bool PipelineManager::InitInstancedMaterialLightPipeline()
           "Unable to find empty root signature for pipeline type {}", PipelineTypeString[int(type)]);
     materialLightPipeline.pRootSignature = rootSignature->second.Get();
 
-    // Init input element desc
-    auto elementDesc = PositionNormalTexCoordVertex::GetInputElementDesc();
-    std::vector<D3D12_INPUT_ELEMENT_DESC> inputElements(elementDesc.begin(), elementDesc.end());
-    D3D12_INPUT_ELEMENT_DESC worldMatrix[4], texWorldMatrix[4];
-    worldMatrix[0].AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT;
-    worldMatrix[0].Format = DXGI_FORMAT::DXGI_FORMAT_R32G32B32A32_FLOAT;
-    worldMatrix[0].InputSlot = 1;
-    worldMatrix[0].InputSlotClass = D3D12_INPUT_CLASSIFICATION::D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA;
-    worldMatrix[0].InstanceDataStepRate = 1;
-    worldMatrix[0].SemanticIndex = 0;
-    worldMatrix[0].SemanticName = "WORLDMATRIX";
-    texWorldMatrix[0].AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT;
-    texWorldMatrix[0].Format = DXGI_FORMAT::DXGI_FORMAT_R32G32B32A32_FLOAT;
-    texWorldMatrix[0].InputSlot = 1;
-    texWorldMatrix[0].InputSlotClass = D3D12_INPUT_CLASSIFICATION::D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA;
-    texWorldMatrix[0].InstanceDataStepRate = 1;
-    texWorldMatrix[0].SemanticIndex = 0;
-    texWorldMatrix[0].SemanticName = "TEXWORLDMATRIX";
-    for (int i = 1; i < 4; ++i)
-    {
-        worldMatrix[i] = worldMatrix[0];
-        worldMatrix[i].SemanticIndex = i;
-        texWorldMatrix[i] = texWorldMatrix[0];
-        texWorldMatrix[i].SemanticIndex = i;
-    }
-    std::copy(std::begin(worldMatrix), std::end(worldMatrix), std::back_inserter(inputElements));
-    std::copy(std::begin(texWorldMatrix), std::end(texWorldMatrix), std::back_inserter(inputElements));
-
+    auto inputElements = GetInstancedInputElementDesc();
     materialLightPipeline.InputLayout.NumElements = (uint32_t)inputElements.size();
     materialLightPipeline.InputLayout.pInputElementDescs = inputElements.data();
 
@@ -583,13 +1042,10 @@ bool PipelineManager::InitInstancedMaterialLightPipeline()
     materialLightPipeline.PS.BytecodeLength = pixelShader->GetBufferSize();
     materialLightPipeline.PS.pShaderBytecode = pixelShader->GetBufferPointer();
 
-    auto pipeline = d3d->CreatePipelineState(materialLightPipeline);
+    auto pipeline = CreatePipelineState(type, rootSignatureType, materialLightPipeline);
     CHECK(pipeline.Valid(), false, "Unable to create pipeline type {}", PipelineTypeString[int(type)]);
 
-    mPipelines[type] = pipeline.Get();
-    mShaders[type].push_back(vertexShader);
-    mShaders[type].push_back(pixelShader);
-    mPipelineToRootSignature[type] = rootSignatureType;
+    AddPipeline(type, rootSignatureType, pipeline.Get(), { vertexShader, pixelShader });
 
     SHOWINFO("Successfully initialized material light pipeline");
     return true;
@@ -598,7 +1054,7 @@ bool PipelineManager::InitInstancedMaterialLightPipeline()
 
 bool PipelineManager::InitTerrainPipeline()
 {
-    auto d3d = Direct3D::Get();
+    PROFILE_FUNCTION();
     PipelineType type = PipelineType::Terrain;
     RootSignatureType rootSignatureType = RootSignatureType::ObjectFrameMaterialLights;
     D3D12_GRAPHICS_PIPELINE_STATE_DESC terrainPipeline = {};
@@ -646,13 +1102,10 @@ bool PipelineManager::InitTerrainPipeline()
     terrainPipeline.PS.BytecodeLength = pixelShader->GetBufferSize();
     terrainPipeline.PS.pShaderBytecode = pixelShader->GetBufferPointer();
 
-    auto pipeline = d3d->CreatePipelineState(terrainPipeline);
+    auto pipeline = CreatePipelineState(type, rootSignatureType, terrainPipeline);
     CHECK(pipeline.Valid(), false, "Unable to create pipeline type {}", PipelineTypeString[int(type)]);
 
-    mPipelines[type] = pipeline.Get();
-    mShaders[type].push_back(vertexShader);
-    mShaders[type].push_back(pixelShader);
-    mPipelineToRootSignature[type] = rootSignatureType;
+    AddPipeline(type, rootSignatureType, pipeline.Get(), { vertexShader, pixelShader });
 
     SHOWINFO("Successfully initialized material light pipeline");
     return true;
@@ -660,6 +1113,7 @@ bool PipelineManager::InitTerrainPipeline()
 
 bool PipelineManager::InitInstancedMaterialColorLightPipeline()
 {
+    PROFILE_FUNCTION();
     auto d3d = Direct3D::Get();
     PipelineType type = PipelineType::InstancedColorMaterialLight;
     RootSignatureType rootSignatureType = RootSignatureType::PassMaterialLightsTextureInstance;
@@ -698,13 +1152,10 @@ bool PipelineManager::InitInstancedMaterialColorLightPipeline()
     pipelineDesc.PS.BytecodeLength = pixelShader->GetBufferSize();
     pipelineDesc.PS.pShaderBytecode = pixelShader->GetBufferPointer();
 
-    auto pipeline = d3d->CreatePipelineState(pipelineDesc);
+    auto pipeline = CreatePipelineState(type, rootSignatureType, pipelineDesc);
     CHECK(pipeline.Valid(), false, "Unable to create pipeline type {}", PipelineTypeString[int(type)]);
 
-    mPipelines[type] = pipeline.Get();
-    mShaders[type].push_back(vertexShader);
-    mShaders[type].push_back(pixelShader);
-    mPipelineToRootSignature[type] = rootSignatureType;
+    AddPipeline(type, rootSignatureType, pipeline.Get(), { vertexShader, pixelShader });
 
     SHOWINFO("Successfully initialized instanced material light color pipeline");
     return true;
@@ -712,7 +1163,7 @@ bool PipelineManager::InitInstancedMaterialColorLightPipeline()
 
 bool PipelineManager::InitDebugPipeline()
 {
-    auto d3d = Direct3D::Get();
+    PROFILE_FUNCTION();
     PipelineType type = PipelineType::DebugPipeline;
     RootSignatureType rootSignatureType = RootSignatureType::OneCBV;
     D3D12_GRAPHICS_PIPELINE_STATE_DESC simpleColorPipeline = {};
@@ -753,14 +1204,60 @@ bool PipelineManager::InitDebugPipeline()
     simpleColorPipeline.PS.BytecodeLength = pixelShader->GetBufferSize();
     simpleColorPipeline.PS.pShaderBytecode = pixelShader->GetBufferPointer();
 
-    auto pipeline = d3d->CreatePipelineState(simpleColorPipeline);
+    auto pipeline = CreatePipelineState(type, rootSignatureType, simpleColorPipeline);
     CHECK(pipeline.Valid(), false, "Unable to create pipeline type {}", PipelineTypeString[int(type)]);
 
-    mPipelines[type] = pipeline.Get();
-    mShaders[type].push_back(vertexShader);
-    mShaders[type].push_back(pixelShader);
-    mPipelineToRootSignature[type] = rootSignatureType;
+    AddPipeline(type, rootSignatureType, pipeline.Get(), { vertexShader, pixelShader });
 
     SHOWINFO("Successfully initialized debug pipeline");
     return true;
 }
+
+bool PipelineManager::InitBindlessMaterialLightPipeline()
+{
+    PROFILE_FUNCTION();
+    auto d3d = Direct3D::Get();
+    PipelineType type = PipelineType::BindlessMaterialLight;
+    RootSignatureType rootSignatureType = RootSignatureType::Bindless;
+
+    auto layoutDesc = PositionNormalTexCoordVertex::GetInputElementDesc();
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC pipelineDesc = {};
+    pipelineDesc.NodeMask = 0;
+    pipelineDesc.BlendState = CD3DX12_BLEND_DESC(CD3DX12_DEFAULT());
+    pipelineDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(CD3DX12_DEFAULT());
+    pipelineDesc.DSVFormat = d3d->kDepthStencilFormat;
+    pipelineDesc.IBStripCutValue = D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED;
+    pipelineDesc.InputLayout.pInputElementDescs = layoutDesc.data();
+    pipelineDesc.InputLayout.NumElements = (uint32_t)layoutDesc.size();
+    pipelineDesc.NumRenderTargets = 1;
+    pipelineDesc.RTVFormats[0] = d3d->kBackbufferFormat;
+    pipelineDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    pipelineDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(CD3DX12_DEFAULT());
+    pipelineDesc.RasterizerState.FrontCounterClockwise = FALSE;
+    pipelineDesc.SampleDesc.Count = 1;
+    pipelineDesc.SampleDesc.Quality = 0;
+    pipelineDesc.SampleMask = D3D12_DEFAULT_SAMPLE_MASK;
+    
+    auto rootSignature = mRootSignatures.find(rootSignatureType);
+    CHECK(!(rootSignature == mRootSignatures.end()), false,
+        "Unable to find empty root signature for pipeline type {}", PipelineTypeString[int(type)]);
+    pipelineDesc.pRootSignature = rootSignature->second.Get();
+
+    ComPtr<ID3DBlob> vertexShader, pixelShader;
+    CHECK_HR(D3DReadFileToBlob(L"Shaders\\BindlessMaterialLightPipeline_VertexShader.cso", &vertexShader), false);
+    CHECK_HR(D3DReadFileToBlob(L"Shaders\\BindlessMaterialLightPipeline_PixelShader.cso", &pixelShader), false);
+
+    pipelineDesc.VS.BytecodeLength = vertexShader->GetBufferSize();
+    pipelineDesc.VS.pShaderBytecode = vertexShader->GetBufferPointer();
+    pipelineDesc.PS.BytecodeLength = pixelShader->GetBufferSize();
+    pipelineDesc.PS.pShaderBytecode = pixelShader->GetBufferPointer();
+
+    auto pipeline = CreatePipelineState(type, rootSignatureType, pipelineDesc);
+    CHECK(pipeline.Valid(), false, "Unable to create pipeline type {}", PipelineTypeString[int(type)]);
+
+    AddPipeline(type, rootSignatureType, pipeline.Get(), { vertexShader, pixelShader });
+
+    SHOWINFO("Successfully initialized bindless material light pipeline");
+    return true;
+}
@@ -4,33 +4,85 @@
 #include <Oblivion.h>
 #include "Direct3D.h"
 #include "Vertex.h"
+#include "JobSystem.h"
+
+#include <mutex>
 
 enum class PipelineType
 {
     SimpleColor = 0, MaterialLight, RawTexture, HorizontalBlur, VerticalBlur,
-    InstancedMaterialLight, Terrain, InstancedColorMaterialLight, DebugPipeline
+    InstancedMaterialLight, Terrain, InstancedColorMaterialLight, DebugPipeline, BindlessMaterialLight
 };
 static constexpr const char *PipelineTypeString[] =
 {
     "SimpleColor", "MaterialLight", "RawTexture", "HorizontalBlur", "VerticalBlur",
-    "InstancedMaterialLight", "Terrain", "InstancedColorMaterialLight", "DebugPipeline"
+    "InstancedMaterialLight", "Terrain", "InstancedColorMaterialLight", "DebugPipeline", "BindlessMaterialLight"
 };
 
 enum class RootSignatureType
 {
     Empty = 0, SimpleColor, ObjectFrameMaterialLights, TextureOnly, TextureSrvUavBuffer,
-    PassMaterialLightsTextureInstance, OneCBV
+    PassMaterialLightsTextureInstance, OneCBV, Bindless
 
 };
 static constexpr const char *RootSignatureTypeString[] =
 {
     "Empty", "SimpleColor", "ObjectFrameMaterialLights", "TextureOnly", "TextureSrvUavBuffer",
-    "PassMaterialLightsTextureInstance", "OneCBV"
+    "PassMaterialLightsTextureInstance", "OneCBV", "Bindless"
+};
+
+enum class InstancingMode : uint8_t
+{
+    // World matrix in the per object constant buffer, like MaterialLight
+    None = 0,
+    // World matrices in a per instance vertex stream, like InstancedMaterialLight
+    VertexStream,
+    // World matrix and color in a structured buffer, like InstancedColorMaterialLight
+    StructuredBuffer
+};
+
+enum class LightCountTier : uint8_t
+{
+    // Ambient light only
+    None = 0,
+    // Up to kLowTierLightCount lights
+    Low,
+    // Up to MAX_LIGHTS lights
+    Full
+};
+
+/// <summary>
+/// Variant of the MaterialLightPermutations shaders. Every field is a preprocessor define, so what the
+/// generic material light pipelines branch on at runtime is decided at compile time
+/// </summary>
+struct MaterialLightPermutation
+{
+    static constexpr const uint32_t kLowTierLightCount = 4;
+
+    // The material has a diffuse texture (HasTexture != -1)
+    bool Textured = true;
+    InstancingMode Instancing = InstancingMode::None;
+    LightCountTier Lights = LightCountTier::Full;
+
+    uint32_t GetKey() const;
+    // Smallest tier that covers lightCount lights
+    static LightCountTier GetLightCountTier(uint32_t lightCount);
 };
 
 class PipelineManager : public ISingletone<PipelineManager>
 {
     MAKE_SINGLETONE_CAPABLE(PipelineManager);
+public:
+    // Compiled pipelines from the previous run, so the driver doesn't have to compile them again
+    static constexpr const wchar_t *kPipelineLibraryPath = L"PipelineLibrary.bin";
+
+    struct PipelineStatistics
+    {
+        // Spent creating, or loading, the pipeline state object
+        float Milliseconds = 0.0f;
+        bool FromLibrary = false;
+    };
+
 private:
     PipelineManager() = default;
     ~PipelineManager() = default;
@@ -42,11 +94,51 @@ public:
     auto GetPipeline(PipelineType pipeline)->Result<ID3D12PipelineState *>;
     auto GetRootSignature(PipelineType pipeline)->Result<ID3D12RootSignature *>;
     auto GetPipelineAndRootSignature(PipelineType pipeline)->Result<std::tuple<ID3D12PipelineState *, ID3D12RootSignature *>>;
+    const std::unordered_map<PipelineType, PipelineStatistics> &GetPipelineStatistics() const;
+
+    /// <summary>
+    /// Pipeline and root signature of a shader permutation. Permutations are only compiled once they're asked for:
+    /// the first call schedules the compilation on the job system and, until it's done, returns the generic pipeline
+    /// of the same instancing mode, which renders the same image with runtime branches
+    /// </summary>
+    auto GetPipelineAndRootSignature(const MaterialLightPermutation &permutation)
+        -> Result<std::tuple<ID3D12PipelineState *, ID3D12RootSignature *>>;
+    // Compiles the permutation if it isn't already and waits for it
+    bool WaitForPermutation(const MaterialLightPermutation &permutation);
+    uint32_t GetPermutationCount() const;
 
 private:
     bool InitRootSignatures();
     bool InitPipelines();
 
+private:
+    void InitPipelineLibrary();
+    // Stores every pipeline in a new library, unless all of them were loaded from the current one
+    bool SavePipelineLibrary();
+    /// <summary>
+    /// Loads the pipeline from the library if an identical one was stored there, creates it otherwise.
+    /// Identical means same shader bytecode, same state and same root signature type. Safe to call from any thread
+    /// </summary>
+    auto CreatePipelineState(PipelineType type, RootSignatureType rootSignatureType,
+                             const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc) -> Result<ComPtr<ID3D12PipelineState>>;
+    auto CreatePipelineState(PipelineType type, RootSignatureType rootSignatureType,
+                             const D3D12_COMPUTE_PIPELINE_STATE_DESC &desc) -> Result<ComPtr<ID3D12PipelineState>>;
+    template <typename PipelineStateDesc>
+    auto LoadOrCreatePipelineState(PipelineType type, uint64_t key, const PipelineStateDesc &desc) -> Result<ComPtr<ID3D12PipelineState>>;
+    void AddPipeline(PipelineType type, RootSignatureType rootSignatureType, ComPtr<ID3D12PipelineState> pipeline,
+                     std::initializer_list<ComPtr<ID3DBlob>> shaders);
+
+private:
+    struct Permutation
+    {
+        // Done once Pipeline is set, or the compilation failed
+        JobCounter Compiled;
+        ComPtr<ID3D12PipelineState> Pipeline;
+    };
+
+    Permutation *RequestPermutation(const MaterialLightPermutation &permutation);
+    bool CompilePermutation(const MaterialLightPermutation &permutation, Permutation &result);
+
 private:
     bool InitEmptyRootSignature();
     bool InitSimpleColorRootSignature();
@@ -55,6 +147,7 @@ private:
     bool InitTextureSrvUavBufferRootSignature();
     bool InitPassMaterialLightsTextureInstance();
     bool InitOneCBV();
+    bool InitBindlessRootSignature();
 
 private:
     bool InitSimpleColorPipeline();
@@ -65,6 +158,7 @@ private:
     bool InitTerrainPipeline();
     bool InitInstancedMaterialColorLightPipeline();
     bool InitDebugPipeline();
+    bool InitBindlessMaterialLightPipeline();
 
 private:
     bool mCreated = false;
@@ -76,5 +170,17 @@ private:
     std::unordered_map<PipelineType, std::vector<ComPtr<ID3DBlob>>> mShaders;
 
     std::unordered_map<RootSignatureType, ComPtr<ID3D12RootSignature>> mRootSignatures;
+
+    // Pipelines are initialized in parallel
+    std::mutex mPipelinesLock;
+    std::unordered_map<PipelineType, std::wstring> mPipelineNames;
+    std::unordered_map<PipelineType, PipelineStatistics> mPipelineStatistics;
+
+    ComPtr<ID3D12PipelineLibrary> mPipelineLibrary;
+    // The library reads from it for as long as it lives
+    std::vector<char> mPipelineLibraryData;
+
+    mutable std::mutex mPermutationsLock;
+    std::unordered_map<uint32_t, std::unique_ptr<Permutation>> mPermutations;
 };
 
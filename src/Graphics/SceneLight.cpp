@@ -1,4 +1,54 @@
 #include "SceneLight.h"
+#include "Profiler.h"
+#include "Utils/LightingModel.h"
+
+static_assert(sizeof(LightCB) == sizeof(LightingModel::Light), "LightingModel::Light must match LightCB");
+
+static float GetLuminance(const DirectX::XMFLOAT3 &color)
+{
+    return 0.2126f * color.x + 0.7152f * color.y + 0.0722f * color.z;
+}
+
+// Near and far planes of a left handed perspective projection: [2][2] = f / (f - n), [3][2] = -n * f / (f - n)
+static void GetNearFar(const DirectX::XMMATRIX &projection, float &nearZ, float &farZ)
+{
+    float zScale = DirectX::XMVectorGetZ(projection.r[2]);
+    float zOffset = DirectX::XMVectorGetZ(projection.r[3]);
+    nearZ = -zOffset / zScale;
+    farZ = zOffset / (1.0f - zScale);
+}
+
+static LightCuller::Frustum ComputeFrustum(const DirectX::XMMATRIX &view, const DirectX::XMMATRIX &projection)
+{
+    using namespace DirectX;
+
+    // Planes of the clip space volume, in world space (Gribb & Hartmann). Columns of the view projection matrix
+    XMMATRIX columns = XMMatrixTranspose(XMMatrixMultiply(view, projection));
+    XMVECTOR planes[6] = {
+        XMVectorAdd(columns.r[3], columns.r[0]),
+        XMVectorSubtract(columns.r[3], columns.r[0]),
+        XMVectorAdd(columns.r[3], columns.r[1]),
+        XMVectorSubtract(columns.r[3], columns.r[1]),
+        columns.r[2],
+        XMVectorSubtract(columns.r[3], columns.r[2]),
+    };
+
+    LightCuller::Frustum frustum;
+    for (uint32_t i = 0; i < 6; ++i)
+    {
+        XMFLOAT4 plane;
+        XMStoreFloat4(&plane, XMPlaneNormalize(planes[i]));
+        frustum.Planes[i] = { plane.x, plane.y, plane.z, plane.w };
+    }
+
+    XMFLOAT3 eye;
+    XMStoreFloat3(&eye, XMMatrixInverse(nullptr, view).r[3]);
+    frustum.EyeX = eye.x;
+    frustum.EyeY = eye.y;
+    frustum.EyeZ = eye.z;
+    frustum.YScale = XMVectorGetY(projection.r[1]);
+    return frustum;
+}
 
 SceneLight::SceneLight(unsigned int maxDirtyFrames):
     UpdateObject(maxDirtyFrames, 0)
@@ -23,8 +73,8 @@ void SceneLight::SetAmbientColor(DirectX::XMFLOAT4 &&color)
 
 bool SceneLight::AddDirectionalLight(std::string &&name, DirectX::XMFLOAT3 &&direction, DirectX::XMFLOAT3 &&strength)
 {
-    unsigned int allLights = GetLightCount();
-    CHECK(allLights < MAX_LIGHTS, false, "Maximum lights count {} reached: {}", MAX_LIGHTS, allLights);
+    unsigned int directionalLights = (unsigned int)mDirectionalLights.size();
+    CHECK(directionalLights < MAX_LIGHTS, false, "Maximum directional lights count {} reached: {}", MAX_LIGHTS, directionalLights);
     CHECK(!(direction.x == 0.0f && direction.y == 0.0f && direction.z == 0.0f), false, "Cannot set a null direction");
 
     direction = Math::Normalize(direction);
@@ -42,8 +92,8 @@ bool SceneLight::AddDirectionalLight(std::string &&name, DirectX::XMFLOAT3 &&dir
 
 bool SceneLight::AddPointLight(std::string &&name, DirectX::XMFLOAT3 &&Position, DirectX::XMFLOAT3 &&strength, float falloffStart, float falloffEnd)
 {
-    unsigned int allLights = GetLightCount();
-    CHECK(allLights < MAX_LIGHTS, false, "Maximum lights count {} reached: ", MAX_LIGHTS, allLights);
+    unsigned int clusteredLights = (unsigned int)(mPointLights.size() + mSpotlights.size());
+    CHECK(clusteredLights < kMaxClusteredLights, false, "Maximum point and spot lights count {} reached: {}", kMaxClusteredLights, clusteredLights);
 
     LightCB lightCB;
     lightCB.Position = Position;
@@ -60,8 +110,8 @@ bool SceneLight::AddPointLight(std::string &&name, DirectX::XMFLOAT3 &&Position,
 
 bool SceneLight::AddSpotlight(std::string &&name, DirectX::XMFLOAT3 &&Position, DirectX::XMFLOAT3 &&direction, DirectX::XMFLOAT3 &&strength, float falloffStart, float falloffEnd, float spotPower)
 {
-    unsigned int allLights = GetLightCount();
-    CHECK(allLights < MAX_LIGHTS, false, "Maximum lights count {} reached: {}", MAX_LIGHTS, allLights);
+    unsigned int clusteredLights = (unsigned int)(mPointLights.size() + mSpotlights.size());
+    CHECK(clusteredLights < kMaxClusteredLights, false, "Maximum point and spot lights count {} reached: {}", kMaxClusteredLights, clusteredLights);
     CHECK(!(direction.x == 0.0f && direction.y == 0.0f && direction.z == 0.0f), false, "Cannot set a null direction");
 
     LightCB lightCB;
@@ -81,7 +131,7 @@ bool SceneLight::AddSpotlight(std::string &&name, DirectX::XMFLOAT3 &&Position,
 
 unsigned int SceneLight::GetLightCount() const
 {
-    return (unsigned int)(mDirectionalLights.size());
+    return (unsigned int)(mDirectionalLights.size() + mPointLights.size() + mSpotlights.size());
 }
 
 const std::vector<std::string> &SceneLight::GetDirectionalLightsNames() const
@@ -213,11 +263,21 @@ void SceneLight::UpdateLightsBuffer(UploadBuffer<LightsBuffer> &buffer)
     }
 }
 
+UploadRingBuffer::Allocation SceneLight::UpdateLightsBuffer() const
+{
+    auto allocation = UploadRingBuffer::Get()->AllocateConstantBuffer<LightsBuffer>();
+    CHECK(allocation.Valid(), allocation, "Unable to allocate lights buffer from the upload ring");
+
+    UpdateLightsBuffer((LightsBuffer *)allocation.CPU);
+    return allocation;
+}
+
 void SceneLight::UpdateLightsBuffer(LightsBuffer *lb) const
 {
     lb->AmbientColor = mAmbientColor;
     unsigned int destinationIndex = 0;
 
+    // Lights past MAX_LIGHTS don't fit; pipelines that need them use the clustered lights
     lb->NumDirectionalLights = (unsigned int)mDirectionalLights.size();
     if (lb->NumDirectionalLights)
     {
@@ -225,14 +285,14 @@ void SceneLight::UpdateLightsBuffer(LightsBuffer *lb) const
         destinationIndex += lb->NumDirectionalLights;
     }
 
-    lb->NumPointLights = (unsigned int)mPointLights.size();
+    lb->NumPointLights = std::min((unsigned int)mPointLights.size(), MAX_LIGHTS - destinationIndex);
     if (lb->NumPointLights)
     {
         memcpy(&lb->Lights[destinationIndex], mPointLights.data(), sizeof(LightCB) * lb->NumPointLights);
         destinationIndex += lb->NumPointLights;
     }
 
-    lb->NumSpotLights = (unsigned int)mSpotlights.size();
+    lb->NumSpotLights = std::min((unsigned int)mSpotlights.size(), MAX_LIGHTS - destinationIndex);
     if (lb->NumSpotLights)
     {
         memcpy(&lb->Lights[destinationIndex], mSpotlights.data(), sizeof(LightCB) * lb->NumSpotLights);
@@ -240,3 +300,181 @@ void SceneLight::UpdateLightsBuffer(LightsBuffer *lb) const
     }
 }
 
+void SceneLight::UpdateLightsBuffer(LightsBuffer *lb, const DirectX::XMMATRIX &view, const DirectX::XMMATRIX &projection,
+                                    uint32_t maxLights) const
+{
+    PROFILE_FUNCTION();
+    lb->AmbientColor = mAmbientColor;
+    maxLights = std::min(maxLights, (uint32_t)MAX_LIGHTS);
+
+    // Directional lights light everything
+    lb->NumDirectionalLights = std::min((uint32_t)mDirectionalLights.size(), maxLights);
+    if (lb->NumDirectionalLights)
+    {
+        memcpy(&lb->Lights[0], mDirectionalLights.data(), sizeof(LightCB) * lb->NumDirectionalLights);
+    }
+
+    auto pointLightCount = (uint32_t)mPointLights.size();
+    mCullingLights.Resize(pointLightCount + (uint32_t)mSpotlights.size());
+    for (uint32_t i = 0; i < pointLightCount; ++i)
+    {
+        const auto &light = mPointLights[i];
+        mCullingLights.SetPointLight(i, light.Position.x, light.Position.y, light.Position.z, light.FalloffEnd,
+                                     GetLuminance(light.Strength));
+    }
+    for (uint32_t i = 0; i < (uint32_t)mSpotlights.size(); ++i)
+    {
+        const auto &light = mSpotlights[i];
+        mCullingLights.SetSpotlight(pointLightCount + i, light.Position.x, light.Position.y, light.Position.z,
+                                    light.Direction.x, light.Direction.y, light.Direction.z, light.FalloffEnd,
+                                    light.SpotPower, GetLuminance(light.Strength));
+    }
+
+    auto frustum = ComputeFrustum(view, projection);
+    uint32_t visibleCount = LightCuller::CullAndRank(frustum, mCullingLights, maxLights - lb->NumDirectionalLights, mSelectedLights);
+
+    // Selected lights are sorted, so the point lights come first as LightsBuffer expects
+    unsigned int destinationIndex = lb->NumDirectionalLights;
+    lb->NumPointLights = 0;
+    lb->NumSpotLights = 0;
+    for (auto lightIndex : mSelectedLights)
+    {
+        if (lightIndex < pointLightCount)
+        {
+            lb->Lights[destinationIndex++] = mPointLights[lightIndex];
+            lb->NumPointLights++;
+        }
+        else
+        {
+            lb->Lights[destinationIndex++] = mSpotlights[lightIndex - pointLightCount];
+            lb->NumSpotLights++;
+        }
+    }
+
+    mCullingStatistics.Candidates = mCullingLights.Count;
+    mCullingStatistics.Visible = visibleCount;
+    mCullingStatistics.Written = (uint32_t)mSelectedLights.size();
+}
+
+UploadRingBuffer::Allocation SceneLight::UpdateLightsBuffer(const DirectX::XMMATRIX &view, const DirectX::XMMATRIX &projection,
+                                                            uint32_t maxLights) const
+{
+    auto allocation = UploadRingBuffer::Get()->AllocateConstantBuffer<LightsBuffer>();
+    CHECK(allocation.Valid(), allocation, "Unable to allocate lights buffer from the upload ring");
+
+    UpdateLightsBuffer((LightsBuffer *)allocation.CPU, view, projection, maxLights);
+    return allocation;
+}
+
+auto SceneLight::GetCullingStatistics() const -> const CullingStatistics &
+{
+    return mCullingStatistics;
+}
+
+LightingModel::LightList SceneLight::GetLights(std::vector<LightingModel::Light> &lights) const
+{
+    lights.resize(mDirectionalLights.size() + mPointLights.size() + mSpotlights.size());
+    auto destination = (LightCB *)lights.data();
+    destination = std::copy(mDirectionalLights.begin(), mDirectionalLights.end(), destination);
+    destination = std::copy(mPointLights.begin(), mPointLights.end(), destination);
+    std::copy(mSpotlights.begin(), mSpotlights.end(), destination);
+
+    return { lights.data(), (uint32_t)mDirectionalLights.size(), (uint32_t)mPointLights.size(), (uint32_t)mSpotlights.size() };
+}
+
+auto SceneLight::UpdateClusteredLights(LightClusterBuilder &builder, const DirectX::XMMATRIX &view,
+                                       const DirectX::XMMATRIX &projection, uint32_t width, uint32_t height) const
+    -> Result<ClusteredLights>
+{
+    PROFILE_FUNCTION();
+    using namespace DirectX;
+
+    float nearZ, farZ;
+    GetNearFar(projection, nearZ, farZ);
+    builder.SetProjection(XMVectorGetX(projection.r[0]), XMVectorGetY(projection.r[1]), nearZ, farZ);
+
+    uint32_t lightCount = (uint32_t)(mPointLights.size() + mSpotlights.size());
+    mLightSpheres.resize(lightCount);
+    for (uint32_t i = 0; i < lightCount; ++i)
+    {
+        const auto &light = i < mPointLights.size() ? mPointLights[i] : mSpotlights[i - mPointLights.size()];
+        // Spotlights are binned by the sphere around their whole range
+        XMFLOAT3 position;
+        XMStoreFloat3(&position, XMVector3TransformCoord(XMLoadFloat3(&light.Position), view));
+        mLightSpheres[i] = { position.x, position.y, position.z, light.FalloffEnd };
+    }
+    {
+        PROFILE_SCOPE("LightClusterBuilder::Build");
+        builder.Build(mLightSpheres.data(), lightCount);
+    }
+
+    // Structured buffers can't be empty
+    const auto &clusters = builder.GetClusters();
+    const auto &lightIndices = builder.GetLightIndices();
+    auto uploadRing = UploadRingBuffer::Get();
+    ClusteredLights result = {};
+    result.Lights = uploadRing->AllocateArray<LightCB>(std::max(lightCount, 1u));
+    result.Clusters = uploadRing->AllocateArray<LightClusterBuilder::Cluster>((uint32_t)clusters.size());
+    result.LightIndices = uploadRing->AllocateArray<uint32_t>(std::max((uint32_t)lightIndices.size(), 1u));
+    CHECK(result.Lights.Valid() && result.Clusters.Valid() && result.LightIndices.Valid(), std::nullopt,
+          "Unable to allocate {} clustered lights and {} light indices from the upload ring", lightCount, lightIndices.size());
+
+    auto lights = (LightCB *)result.Lights.CPU;
+    if (!mPointLights.empty())
+    {
+        memcpy(lights, mPointLights.data(), sizeof(LightCB) * mPointLights.size());
+    }
+    if (!mSpotlights.empty())
+    {
+        memcpy(lights + mPointLights.size(), mSpotlights.data(), sizeof(LightCB) * mSpotlights.size());
+    }
+    memcpy(result.Clusters.CPU, clusters.data(), sizeof(LightClusterBuilder::Cluster) * clusters.size());
+    if (!lightIndices.empty())
+    {
+        memcpy(result.LightIndices.CPU, lightIndices.data(), sizeof(uint32_t) * lightIndices.size());
+    }
+
+    result.Constants.GridSize[0] = builder.GetGridX();
+    result.Constants.GridSize[1] = builder.GetGridY();
+    result.Constants.GridSize[2] = builder.GetGridZ();
+    result.Constants.PointLightCount = (uint32_t)mPointLights.size();
+    result.Constants.InvScreenSize[0] = 1.0f / std::max(width, 1u);
+    result.Constants.InvScreenSize[1] = 1.0f / std::max(height, 1u);
+    result.Constants.DepthScale = builder.GetDepthScale();
+    result.Constants.DepthBias = builder.GetDepthBias();
+    return result;
+}
+
+void SceneLight::BindClusteredLights(ID3D12GraphicsCommandList *cmdList, const ClusteredLights &lights)
+{
+    constexpr uint32_t constantsCount = sizeof(lights.Constants) / sizeof(uint32_t);
+    cmdList->SetGraphicsRoot32BitConstants(6, constantsCount, &lights.Constants, 0);
+    cmdList->SetGraphicsRootShaderResourceView(7, lights.Lights.GPU);
+    cmdList->SetGraphicsRootShaderResourceView(8, lights.Clusters.GPU);
+    cmdList->SetGraphicsRootShaderResourceView(9, lights.LightIndices.GPU);
+}
+
+bool SceneLight::UpdateShadowCascades(ShadowCascades &cascades, const DirectX::XMMATRIX &view, const DirectX::XMMATRIX &projection,
+                                      const ShadowCascades::Settings &settings) const
+{
+    PROFILE_FUNCTION();
+    using namespace DirectX;
+    CHECK(!mDirectionalLights.empty(), false, "Cascaded shadows need a directional light");
+
+    // Rows of the inverse view: the camera's right, up and forward axes and its position
+    XMMATRIX world = XMMatrixInverse(nullptr, view);
+    ShadowCascades::CameraInfo camera;
+    XMStoreFloat3((XMFLOAT3 *)camera.Right, XMVector3Normalize(world.r[0]));
+    XMStoreFloat3((XMFLOAT3 *)camera.Up, XMVector3Normalize(world.r[1]));
+    XMStoreFloat3((XMFLOAT3 *)camera.Forward, XMVector3Normalize(world.r[2]));
+    XMStoreFloat3((XMFLOAT3 *)camera.Position, world.r[3]);
+
+    camera.TanHalfFovX = 1.0f / XMVectorGetX(projection.r[0]);
+    camera.TanHalfFovY = 1.0f / XMVectorGetY(projection.r[1]);
+    GetNearFar(projection, camera.NearZ, camera.FarZ);
+
+    const auto &direction = mDirectionalLights[0].Direction;
+    float lightDirection[3] = { direction.x, direction.y, direction.z };
+    CHECK(cascades.Update(camera, lightDirection, settings), false, "Unable to fit shadow cascades to the camera");
+    return true;
+}
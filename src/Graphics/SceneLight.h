@@ -4,9 +4,48 @@
 #include <Oblivion.h>
 #include "Utils/UpdateObject.h"
 #include "FrameResources.h"
+#include "Utils/UploadRingBuffer.h"
+#include "Utils/LightClusterBuilder.h"
+#include "Utils/LightCuller.h"
+#include "Utils/LightingModel.h"
+#include "Utils/ShadowCascades.h"
 
 class SceneLight : public UpdateObject
 {
+public:
+    // Point lights and spotlights; only the first MAX_LIGHTS lights fit in LightsBuffer, the rest are only clustered
+    static constexpr const uint32_t kMaxClusteredLights = 4096;
+
+    /// <summary>
+    /// Buffers of the clustered lighting, all in the current frame's upload ring.
+    /// Lights holds the point lights followed by the spotlights
+    /// </summary>
+    struct ClusteredLights
+    {
+        UploadRingBuffer::Allocation Lights;
+        UploadRingBuffer::Allocation Clusters;
+        UploadRingBuffer::Allocation LightIndices;
+
+        // ClusterInfo in the shaders, set as root constants
+        struct
+        {
+            uint32_t GridSize[3];
+            uint32_t PointLightCount;
+            float InvScreenSize[2];
+            float DepthScale;
+            float DepthBias;
+        } Constants;
+    };
+
+    struct CullingStatistics
+    {
+        uint32_t Candidates = 0;
+        // Intersect the frustum
+        uint32_t Visible = 0;
+        // Made it to LightsBuffer
+        uint32_t Written = 0;
+    };
+
 public:
     SceneLight() = default;
     SceneLight(unsigned int maxDirtyFrames);
@@ -44,6 +83,35 @@ public:
 
     void UpdateLightsBuffer(UploadBuffer<LightsBuffer> &buffer);
     void UpdateLightsBuffer(LightsBuffer *lb) const;
+    // Writes the lights to the current frame's upload ring; bind the result as a CBV
+    UploadRingBuffer::Allocation UpdateLightsBuffer() const;
+    /// <summary>
+    /// Same as above, but point lights and spotlights that can't light anything in the camera's frustum are left out.
+    /// When more than maxLights lights are left, directional ones included, only those with the most screen influence are written
+    /// </summary>
+    void UpdateLightsBuffer(LightsBuffer *lb, const DirectX::XMMATRIX &view, const DirectX::XMMATRIX &projection,
+                            uint32_t maxLights = MAX_LIGHTS) const;
+    UploadRingBuffer::Allocation UpdateLightsBuffer(const DirectX::XMMATRIX &view, const DirectX::XMMATRIX &projection,
+                                                    uint32_t maxLights = MAX_LIGHTS) const;
+    const CullingStatistics &GetCullingStatistics() const;
+    /// <summary>
+    /// Copies every light to lights, in LightsBuffer order, for the CPU lighting model
+    /// </summary>
+    LightingModel::LightList GetLights(std::vector<LightingModel::Light> &lights) const;
+    /// <summary>
+    /// Bins the point lights and spotlights into builder's clusters for the given camera and writes the result to
+    /// the current frame's upload ring. Directional lights are still read from LightsBuffer
+    /// </summary>
+    Result<ClusteredLights> UpdateClusteredLights(LightClusterBuilder &builder, const DirectX::XMMATRIX &view,
+                                                  const DirectX::XMMATRIX &projection, uint32_t width, uint32_t height) const;
+    // Binds to root parameters 6 to 9 of the bindless root signature
+    static void BindClusteredLights(ID3D12GraphicsCommandList *cmdList, const ClusteredLights &lights);
+    /// <summary>
+    /// Fits cascades' shadow maps to the camera for the first directional light. Only the fitting and the caster
+    /// culling (Model::SelectShadowCasters) exist so far: nothing renders the shadow maps or samples them yet
+    /// </summary>
+    bool UpdateShadowCascades(ShadowCascades &cascades, const DirectX::XMMATRIX &view, const DirectX::XMMATRIX &projection,
+                              const ShadowCascades::Settings &settings) const;
 
 private:
     DirectX::XMFLOAT4 mAmbientColor;
@@ -56,6 +124,12 @@ private:
 
     std::vector<LightCB> mSpotlights;
     std::vector<std::string> mSpotlightsNames;
+
+    mutable std::vector<LightClusterBuilder::Sphere> mLightSpheres;
+
+    mutable LightCuller::Lights mCullingLights;
+    mutable std::vector<uint32_t> mSelectedLights;
+    mutable CullingStatistics mCullingStatistics;
 };
 
 
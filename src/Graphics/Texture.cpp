@@ -1,17 +1,88 @@
 #include "Texture.h"
+#include "Profiler.h"
 #include "Utils/DDSTextureLoader.h"
+#include "Utils/MipGenerator.h"
 #include "Conversions.h"
 
+void Texture::GenerateMissingMips(DirectX::DDSTextureData &textureData)
+{
+    if (textureData.mipCount != 1 || textureData.arraySize != 1 || textureData.isCubeMap ||
+        textureData.resDim != D3D12_RESOURCE_DIMENSION_TEXTURE2D || textureData.subresources.size() != 1)
+    {
+        return;
+    }
+
+    bool srgb;
+    switch (textureData.format)
+    {
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8X8_UNORM:
+        srgb = false;
+        break;
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+        srgb = true;
+        break;
+    default:
+        return;
+    }
+
+    PROFILE_FUNCTION();
+    const auto &topMip = textureData.subresources[0];
+    auto mipChain = MipGenerator::Generate((const uint8_t *)topMip.pData, (uint32_t)textureData.width, (uint32_t)textureData.height,
+                                           (uint32_t)topMip.RowPitch, srgb);
+    if (mipChain.Levels.size() <= 1)
+    {
+        return;
+    }
+
+    // The generated chain replaces the file contents; the subresources point inside it
+    const uint8_t *data = mipChain.Data.get();
+    textureData.fileData = std::shared_ptr<const uint8_t>(mipChain.Data.release(), std::default_delete<uint8_t[]>());
+    textureData.mipCount = mipChain.Levels.size();
+    textureData.subresources.clear();
+    for (const auto &level : mipChain.Levels)
+    {
+        D3D12_SUBRESOURCE_DATA subresource;
+        subresource.pData = data + level.Offset;
+        subresource.RowPitch = level.RowPitch;
+        subresource.SlicePitch = (LONG_PTR)level.RowPitch * level.Height;
+        textureData.subresources.push_back(subresource);
+    }
+}
+
 bool Texture::Init(ID3D12GraphicsCommandList *cmdList, const wchar_t* path, ComPtr<ID3D12Resource>& intermediary)
 {
-    CHECK(D3DObject::Init(), false, "Unable to initialize d3d object for path {}", Conversions::ws2s(path));
-    
-    CHECK_HR(DirectX::CreateDDSTextureFromFile12(mDevice.Get(), cmdList, path,
+    PROFILE_FUNCTION();
+    DirectX::DDSTextureData textureData;
+    CHECK_HR(DirectX::LoadDDSTextureData(path, textureData), false);
+    GenerateMissingMips(textureData);
+
+    CHECK(Init(cmdList, textureData, intermediary), false, "Unable to create texture {}", Conversions::ws2s(path));
+
+    return true;
+}
+
+bool Texture::Init(ID3D12GraphicsCommandList *cmdList, const DirectX::DDSTextureData &textureData, ComPtr<ID3D12Resource> &intermediary)
+{
+    CHECK(D3DObject::Init(), false, "Unable to initialize d3d object for texture");
+
+    CHECK_HR(DirectX::CreateDDSTextureFromData12(mDevice.Get(), cmdList, textureData,
                                                  mResource, intermediary), false);
 
-    mCurrentResourceState = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    if (cmdList->GetType() == D3D12_COMMAND_LIST_TYPE_COPY)
+    {
+        mCurrentResourceState = D3D12_RESOURCE_STATE_COMMON;
+    }
+    else
+    {
+        mCurrentResourceState = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    }
     mDesc = mResource->GetDesc();
-    
+    mAllocationSize = mDevice->GetResourceAllocationInfo(0, 1, &mDesc).SizeInBytes;
+
     return true;
 }
 
@@ -26,6 +97,21 @@ bool Texture::Init(const D3D12_RESOURCE_DESC &resourceDesc, D3D12_CLEAR_VALUE *c
 
     mCurrentResourceState = state;
     mDesc = mResource->GetDesc();
+    mAllocationSize = mDevice->GetResourceAllocationInfo(0, 1, &mDesc).SizeInBytes;
+
+    return true;
+}
+
+bool Texture::InitReserved(const D3D12_RESOURCE_DESC &resourceDesc)
+{
+    CHECK(D3DObject::Init(), false, "Unable to initialize d3d object for texture");
+
+    CHECK_HR(mDevice->CreateReservedResource(
+        &resourceDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&mResource)), false);
+
+    mCurrentResourceState = D3D12_RESOURCE_STATE_COMMON;
+    mDesc = mResource->GetDesc();
+    mAllocationSize = 0;
 
     return true;
 }
@@ -43,6 +129,26 @@ void Texture::Transition(ID3D12GraphicsCommandList *cmdList, D3D12_RESOURCE_STAT
     cmdList->ResourceBarrier(1, &barrier);
 }
 
+ID3D12Resource *Texture::GetResource() const
+{
+    return mResource.Get();
+}
+
+const D3D12_RESOURCE_DESC &Texture::GetDesc() const
+{
+    return mDesc;
+}
+
+uint64_t Texture::GetAllocationSize() const
+{
+    return mAllocationSize;
+}
+
+void Texture::SetMinLODClamp(float clamp)
+{
+    mMinLODClamp = clamp;
+}
+
 void Texture::CreateShaderResourceView(ID3D12DescriptorHeap *heap, D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle)
 {
     auto d3d = Direct3D::Get();
@@ -53,7 +159,7 @@ void Texture::CreateShaderResourceView(ID3D12DescriptorHeap *heap, D3D12_CPU_DES
     srvDesc.Texture2D.MipLevels = mDesc.MipLevels;
     srvDesc.Texture2D.MostDetailedMip = 0;
     srvDesc.Texture2D.PlaneSlice = 0;
-    srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
+    srvDesc.Texture2D.ResourceMinLODClamp = mMinLODClamp;
     srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
 
     d3d->CreateShaderResourceView(mResource.Get(), srvDesc, cpuHandle);
@@ -4,20 +4,50 @@
 #include <Oblivion.h>
 #include "./Utils/D3DObject.h"
 
+namespace DirectX
+{
+    struct DDSTextureData;
+}
 
 class Texture : public D3DObject
 {
 public:
     Texture() = default;
 
+public:
+    /// <summary>
+    /// Replaces the contents of a 2D RGBA8 / BGRA8 texture that has a single mip with a full mip chain
+    /// generated on the CPU. Other textures are left untouched. Can be called from any thread
+    /// </summary>
+    static void GenerateMissingMips(DirectX::DDSTextureData &textureData);
+
 public:
     bool Init(ID3D12GraphicsCommandList *cmdList, const wchar_t *path, ComPtr<ID3D12Resource>& intermediary);
+    /// <summary>
+    /// Creates the texture from a DDS file that was already loaded with DirectX::LoadDDSTextureData
+    /// </summary>
+    bool Init(ID3D12GraphicsCommandList *cmdList, const DirectX::DDSTextureData &textureData, ComPtr<ID3D12Resource> &intermediary);
     bool Init(const D3D12_RESOURCE_DESC &resourceDesc, D3D12_CLEAR_VALUE *clearValue, const D3D12_HEAP_PROPERTIES &heapProperties,
               const D3D12_HEAP_FLAGS &heapFlags,
               const D3D12_RESOURCE_STATES &state);
+    /// <summary>
+    /// Creates a reserved resource. Nothing is backed by memory until tiles are mapped
+    /// </summary>
+    bool InitReserved(const D3D12_RESOURCE_DESC &resourceDesc);
 
     void Transition(ID3D12GraphicsCommandList *cmdList, D3D12_RESOURCE_STATES state);
 
+    ID3D12Resource *GetResource() const;
+    const D3D12_RESOURCE_DESC &GetDesc() const;
+    /// <summary>
+    /// Bytes the resource takes in video memory, from its desc. Reserved resources take none, their memory is in the heaps mapped to them
+    /// </summary>
+    uint64_t GetAllocationSize() const;
+    /// <summary>
+    /// Mips finer than clamp won't be sampled through the shader resource views created afterwards
+    /// </summary>
+    void SetMinLODClamp(float clamp);
+
 public:
     void CreateShaderResourceView(ID3D12DescriptorHeap* heap, D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle);
     void CreateUnorederedAccessView(ID3D12DescriptorHeap *heap, D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle);
@@ -27,6 +57,8 @@ public:
 private:
     D3D12_RESOURCE_STATES mCurrentResourceState;
     D3D12_RESOURCE_DESC mDesc;
+    float mMinLODClamp = 0.0f;
+    uint64_t mAllocationSize = 0;
     ComPtr<ID3D12Resource> mResource;
 };
 
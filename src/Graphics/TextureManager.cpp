@@ -1,11 +1,103 @@
 #include "TextureManager.h"
+#include "TextureStreamer.h"
+#include "JobSystem.h"
+#include "Profiler.h"
 #include "Conversions.h"
-#include "Conversions.h"
+#include "MaterialManager.h"
+#include "Utils/AsyncUploader.h"
+#include "Utils/DDSTextureLoader.h"
+#include "Utils/TextureAtlasPacker.h"
+#include "Utils/UploadRingBuffer.h"
 
 using DESCRIPTOR_FLAG_TYPE = uint8_t;
 constexpr DESCRIPTOR_FLAG_TYPE FLAG_MASK = ~0;
 constexpr auto FLAG_SIZE = 8;
 
+// FNV-1a of the contents of a file
+static Result<uint64_t> HashFile(const std::filesystem::path &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    CHECK(file.is_open(), std::nullopt, "Unable to open {} for hashing", path.string());
+
+    uint64_t hash = 0xcbf29ce484222325ull;
+    std::vector<char> buffer(64 * 1024);
+    while (file)
+    {
+        file.read(buffer.data(), buffer.size());
+        for (std::streamsize i = 0; i < file.gcount(); ++i)
+        {
+            hash ^= (uint8_t)buffer[i];
+            hash *= 0x100000001b3ull;
+        }
+    }
+    return hash;
+}
+
+// Only 32 bit uncompressed formats are packed. Block compressed mips would lose their block alignment
+// once the padding is halved past 4 texels
+static bool CanBeAtlased(const DirectX::DDSTextureData &textureData)
+{
+    switch (textureData.format)
+    {
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8X8_UNORM:
+    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+        break;
+    default:
+        return false;
+    }
+
+    return textureData.resDim == D3D12_RESOURCE_DIMENSION_TEXTURE2D && textureData.arraySize == 1 && !textureData.isCubeMap &&
+        textureData.width <= TextureManager::kMaxAtlasedTextureSize && textureData.height <= TextureManager::kMaxAtlasedTextureSize &&
+        textureData.subresources.size() == textureData.mipCount;
+}
+
+// Copies one mip of a packed texture to (x, y) in its page and repeats the edge texels over the padding around it
+static void CopyToAtlasPage(const D3D12_SUBRESOURCE_DATA &source, uint32_t width, uint32_t height,
+                            uint8_t *page, uint32_t pageWidth, uint32_t x, uint32_t y, uint32_t padding)
+{
+    for (uint32_t row = 0; row < height + 2 * padding; ++row)
+    {
+        uint32_t sourceY = (uint32_t)std::clamp((int32_t)row - (int32_t)padding, 0, (int32_t)height - 1);
+        auto sourceRow = (const uint32_t *)((const uint8_t *)source.pData + sourceY * source.RowPitch);
+        auto destinationRow = (uint32_t *)page + (size_t)(y - padding + row) * pageWidth + (x - padding);
+        for (uint32_t column = 0; column < width + 2 * padding; ++column)
+        {
+            destinationRow[column] = sourceRow[std::clamp((int32_t)column - (int32_t)padding, 0, (int32_t)width - 1)];
+        }
+    }
+}
+
+// Models refer to shared textures with different relative paths, so paths are compared canonical and,
+// as paths on Windows are case insensitive, lower case
+static std::filesystem::path GetCanonicalPath(LPCWSTR path)
+{
+    std::error_code error;
+    auto canonicalPath = std::filesystem::weakly_canonical(path, error);
+    if (error)
+    {
+        canonicalPath = std::filesystem::path(path).lexically_normal();
+    }
+    return canonicalPath;
+}
+
+static std::wstring GetPathKey(const std::filesystem::path &canonicalPath)
+{
+    auto pathKey = canonicalPath.wstring();
+    std::transform(pathKey.begin(), pathKey.end(), pathKey.begin(), [](wchar_t c) { return (wchar_t)towlower(c); });
+    return pathKey;
+}
+
+static uintmax_t GetFileSize(const std::filesystem::path &canonicalPath)
+{
+    std::error_code error;
+    auto fileSize = std::filesystem::file_size(canonicalPath, error);
+    // LoadDDSTextureData reports missing files later on
+    return error ? 0 : fileSize;
+}
 
 Result<uint32_t> TextureManager::AddTexture(const std::string &path)
 {    
@@ -14,15 +106,53 @@ Result<uint32_t> TextureManager::AddTexture(const std::string &path)
 
 Result<uint32_t> TextureManager::AddTexture(LPCWSTR path)
 {
-    CHECK(mCanAddTextures, std::nullopt,
-          "Cannot add new textures to texture manager, as it is closed");
+    auto canonicalPath = GetCanonicalPath(path);
+    auto pathKey = GetPathKey(canonicalPath);
+    auto fileSize = GetFileSize(canonicalPath);
+
+    if (auto it = mTexturesByPath.find(pathKey); it != mTexturesByPath.end())
+    {
+        mDeduplicationStatistics.PathHits++;
+        mDeduplicationStatistics.SavedBytes += fileSize;
+        mTextureReferences[it->second]++;
+        return uint32_t(it->second);
+    }
+
+    // The index AddTextureSlot() will hand out
+    uint32_t textureIndex = mFreeTextureIndices.empty() ? mNumTextures : mFreeTextureIndices.back();
+    if (fileSize > 0)
+    {
+        auto duplicateResult = FindTextureWithSameContents(canonicalPath, fileSize, textureIndex);
+        if (duplicateResult.Valid())
+        {
+            uint32_t duplicateIndex = duplicateResult.Get();
+            SHOWINFO("Texture {} has the same contents as {}. Using it . . .", canonicalPath.string(),
+                     Conversions::ws2s(mTexturesToLoad[duplicateIndex]._Path));
+            mTexturesByPath[pathKey] = duplicateIndex;
+            mDeduplicationStatistics.ContentHits++;
+            mDeduplicationStatistics.SavedBytes += fileSize;
+            mTextureReferences[duplicateIndex]++;
+            return duplicateIndex;
+        }
+    }
+
+    textureIndex = AddTextureSlot(TextureInitializationParams(path));
+    mTexturesByPath[pathKey] = textureIndex;
 
-    mTexturesToLoad.emplace_back(path);
+    if (!mCanAddTextures)
+    {
+        if (!CreateTexture(textureIndex))
+        {
+            RemoveTexture(textureIndex);
+            SHOWWARNING("Unable to create texture {}", canonicalPath.string());
+            return std::nullopt;
+        }
+        return textureIndex;
+    }
 
-    uint32_t textureIndex = mNumTextures++;
     SHOWINFO("Will create SRV with descriptor {}", textureIndex);
 
-    mTextureIndexToHeapIndex[textureIndex] = { mNumCbvSrvUav++, -1, -1, -1 };
+    mTextureTable.GetEntry(textureIndex).HeapIndices = { (int32_t)mNumCbvSrvUav++, -1, -1, -1 };
 
     return textureIndex;
 }
@@ -30,19 +160,25 @@ Result<uint32_t> TextureManager::AddTexture(LPCWSTR path)
 Result<uint32_t> TextureManager::AddTexture(const D3D12_RESOURCE_DESC &resourceDesc, const D3D12_HEAP_PROPERTIES &heapProperties,
                                             const D3D12_RESOURCE_STATES &state, const D3D12_HEAP_FLAGS &heapFlags, D3D12_CLEAR_VALUE *clearValue)
 {
-    CHECK(mCanAddTextures, std::nullopt,
-          "Cannot add new textures to texture manager, as it is closed");
-
-    mTexturesToLoad.emplace_back(resourceDesc, heapProperties, state, heapFlags, clearValue);
+    uint32_t textureIndex = AddTextureSlot(TextureInitializationParams(resourceDesc, heapProperties, state, heapFlags, clearValue));
 
-    uint32_t textureIndex = mNumTextures++;
+    if (!mCanAddTextures)
+    {
+        if (!CreateTexture(textureIndex))
+        {
+            RemoveTexture(textureIndex);
+            SHOWWARNING("Unable to create texture at index {}", textureIndex);
+            return std::nullopt;
+        }
+        return textureIndex;
+    }
 
     int32_t srvIndex = resourceDesc.Flags & D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE ? -1 : mNumCbvSrvUav++;
     int32_t uavIndex = resourceDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS ? mNumCbvSrvUav++ : -1;
     int32_t rtvIndex = resourceDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET ? mNumRtv++ : -1;
     int32_t dsvIndex = resourceDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL ? mNumDsv++ : -1;
 
-    mTextureIndexToHeapIndex[textureIndex] = { srvIndex, uavIndex, rtvIndex, dsvIndex };
+    mTextureTable.GetEntry(textureIndex).HeapIndices = { srvIndex, uavIndex, rtvIndex, dsvIndex };
 
 
     SHOWINFO("Created texture with descriptor {}", textureIndex);
@@ -50,6 +186,39 @@ Result<uint32_t> TextureManager::AddTexture(const D3D12_RESOURCE_DESC &resourceD
     return textureIndex;
 }
 
+Result<uint32_t> TextureManager::FindTextureWithSameContents(const std::filesystem::path &path, uintmax_t fileSize, uint32_t textureIndex)
+{
+    // Most textures have a size no other texture has, those are never read here
+    auto [sizeIt, firstOfSize] = mUnhashedTexturesBySize.try_emplace(fileSize);
+    if (firstOfSize)
+    {
+        sizeIt->second.push_back(textureIndex);
+        return std::nullopt;
+    }
+
+    for (auto unhashedIndex : sizeIt->second)
+    {
+        auto hashResult = HashFile(mTexturesToLoad[unhashedIndex]._Path);
+        if (hashResult.Valid())
+        {
+            mTexturesByContentHash.try_emplace(hashResult.Get(), unhashedIndex);
+        }
+    }
+    sizeIt->second.clear();
+
+    auto hashResult = HashFile(path);
+    if (!hashResult.Valid())
+    {
+        return std::nullopt;
+    }
+    auto [hashIt, inserted] = mTexturesByContentHash.try_emplace(hashResult.Get(), textureIndex);
+    if (inserted)
+    {
+        return std::nullopt;
+    }
+    return uint32_t(hashIt->second);
+}
+
 bool TextureManager::UpdateTexture(uint32_t textureIndex, ID3D12GraphicsCommandList *cmdList, const std::string &path,
                                    ComPtr<ID3D12Resource> intermediaryResource)
 {
@@ -59,9 +228,36 @@ bool TextureManager::UpdateTexture(uint32_t textureIndex, ID3D12GraphicsCommandL
 bool TextureManager::UpdateTexture(uint32_t textureIndex, ID3D12GraphicsCommandList *cmdList, LPCWSTR path,
                                    ComPtr<ID3D12Resource> intermediaryResource)
 {
-    CHECK(mTextures[textureIndex].Init(cmdList, mTexturesToLoad[textureIndex]._Path.c_str(), intermediaryResource),
-          false, "Unable to initialize texture {}", Conversions::ws2s(mTexturesToLoad[textureIndex]._Path));
+    CHECK(mAtlasEntries.find(textureIndex) == mAtlasEntries.end(), false,
+          "Texture {} is packed in an atlas page and can't be replaced", textureIndex);
+    // Deduplicated textures are shared by every AddTexture() that found them, replacing one would replace them all
+    CHECK(mTextureReferences[textureIndex] <= 1, false,
+          "Texture {} is shared by {} references and can't be replaced", textureIndex, mTextureReferences[textureIndex]);
     mTexturesToLoad[textureIndex] = TextureInitializationParams(path);
+
+    // Later AddTexture() calls must find the new file, not the old one
+    ForgetTextureSources(textureIndex);
+    auto canonicalPath = GetCanonicalPath(path);
+    mTexturesByPath.try_emplace(GetPathKey(canonicalPath), textureIndex);
+    if (auto fileSize = GetFileSize(canonicalPath); fileSize > 0)
+    {
+        // Hashed along with the next file of the same size, as AddTexture() does
+        mUnhashedTexturesBySize[fileSize].push_back(textureIndex);
+    }
+
+    if (mCanAddTextures)
+    {
+        // Created by CloseAddingTextures()
+        return true;
+    }
+
+    TextureStreamer::Get()->RemoveTexture(textureIndex);
+    // The frames in flight may still use the old texture and its views
+    RetireTexture(textureIndex);
+    CHECK(mTextures[textureIndex].Init(cmdList, path, intermediaryResource),
+          false, "Unable to initialize texture {}", Conversions::ws2s(path));
+    TrackTexture(textureIndex);
+    CHECK(AllocateDescriptors(textureIndex), false, "Unable to allocate descriptors for texture {}", textureIndex);
     InitAllViews(textureIndex);
 
     return true;
@@ -71,10 +267,34 @@ bool TextureManager::UpdateTexture(uint32_t textureIndex, const D3D12_RESOURCE_D
                                    const D3D12_RESOURCE_STATES &state, const D3D12_HEAP_FLAGS &heapFlags,
                                    D3D12_CLEAR_VALUE *clearValue)
 {
+    CHECK(mAtlasEntries.find(textureIndex) == mAtlasEntries.end(), false,
+          "Texture {} is packed in an atlas page and can't be replaced", textureIndex);
+    // Deduplicated textures are shared by every AddTexture() that found them, replacing one would replace them all
+    CHECK(mTextureReferences[textureIndex] <= 1, false,
+          "Texture {} is shared by {} references and can't be replaced", textureIndex, mTextureReferences[textureIndex]);
+    mTexturesToLoad[textureIndex] = TextureInitializationParams(resourceDesc, heapProperties, state, heapFlags, clearValue);
+    // Not a file anymore, so no AddTexture() may find it
+    ForgetTextureSources(textureIndex);
+    if (mCanAddTextures)
+    {
+        // Created by CloseAddingTextures(), with the views of the new flags
+        const auto &[srvIndex, uavIndex, rtvIndex, dsvIndex] = mTextureTable.GetEntry(textureIndex).HeapIndices;
+        CHECK((srvIndex != -1) == !(resourceDesc.Flags & D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE) &&
+              (uavIndex != -1) == !!(resourceDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS) &&
+              (rtvIndex != -1) == !!(resourceDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET) &&
+              (dsvIndex != -1) == !!(resourceDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL), false,
+              "Texture {} can't change its views before textures are closed", textureIndex);
+        return true;
+    }
+
+    TextureStreamer::Get()->RemoveTexture(textureIndex);
+    // The frames in flight may still use the old texture and its views
+    RetireTexture(textureIndex);
     CHECK(mTextures[textureIndex].Init(resourceDesc, clearValue ? clearValue : nullptr,
                             heapProperties, heapFlags, state), false,
           "Unable to initialize texture at index {}", textureIndex);
-    mTexturesToLoad[textureIndex] = TextureInitializationParams(resourceDesc, heapProperties, state, heapFlags, clearValue);
+    TrackTexture(textureIndex);
+    CHECK(AllocateDescriptors(textureIndex), false, "Unable to allocate descriptors for texture {}", textureIndex);
     InitAllViews(textureIndex);
 
     return true;
@@ -85,166 +305,348 @@ bool TextureManager::CloseAddingTextures(ID3D12GraphicsCommandList* cmdList, std
     CHECK(InitTextures(cmdList, intermediaryResources), false, "Unable to initialize textures");
     CHECK(InitDescriptors(), false, "Unable to initialize descriptors for textures");
     mCanAddTextures = false;
+
+    SHOWINFO("Texture deduplication avoided {} loads ({} by path, {} by contents), {} KiB",
+             mDeduplicationStatistics.PathHits + mDeduplicationStatistics.ContentHits, mDeduplicationStatistics.PathHits,
+             mDeduplicationStatistics.ContentHits, mDeduplicationStatistics.SavedBytes / 1024);
+
+    if (!mAtlasEntries.empty())
+    {
+        MaterialManager::Get()->ApplyTextureAtlases();
+    }
     return true;
 }
 
+bool TextureManager::RemoveTexture(uint32_t textureIndex)
+{
+    CHECK(!mCanAddTextures, false, "Textures can only be removed after CloseAddingTextures");
+    CHECK(textureIndex < mTextures.size() && mTextureReferences[textureIndex] > 0, false,
+          "Texture index {} is invalid", textureIndex);
+    CHECK(mAtlasEntries.find(textureIndex) == mAtlasEntries.end(), false,
+          "Texture {} is packed in an atlas page and lives as long as the page", textureIndex);
+
+    if (--mTextureReferences[textureIndex] > 0)
+    {
+        return true;
+    }
+
+    TextureStreamer::Get()->RemoveTexture(textureIndex);
+    RetireTexture(textureIndex);
+    // Handles to the old texture stop resolving
+    mTextureTable.Release(textureIndex);
+
+    ForgetTextureSources(textureIndex);
+
+    mFreeTextureIndices.push_back(textureIndex);
+    return true;
+}
+
+void TextureManager::ForgetTextureSources(uint32_t textureIndex)
+{
+    std::erase_if(mTexturesByPath, [&](const auto &entry) { return entry.second == textureIndex; });
+    std::erase_if(mTexturesByContentHash, [&](const auto &entry) { return entry.second == textureIndex; });
+    for (auto &[fileSize, textures] : mUnhashedTexturesBySize)
+    {
+        std::erase(textures, textureIndex);
+    }
+}
+
 uint32_t TextureManager::GetTextureCount() const
 {
     return mNumTextures;
 }
 
+void TextureManager::BeginFrame(uint32_t frameIndex)
+{
+    mFrameIndex = frameIndex;
+    mRetiredTextures[frameIndex].clear();
+    mMemoryBudget.BeginFrame();
+    if (!mCanAddTextures)
+    {
+        mSrvUavDescriptors.BeginFrame(frameIndex);
+        mRtvDescriptors.BeginFrame(frameIndex);
+        mDsvDescriptors.BeginFrame(frameIndex);
+        // In case a heap grew from outside, through GetSrvUavDescriptors()
+        RefreshDescriptorHandles();
+    }
+}
+
 void TextureManager::Transition(ID3D12GraphicsCommandList* cmdList, uint32_t textureIndex, D3D12_RESOURCE_STATES state)
 {
-    mTextures[textureIndex].Transition(cmdList, state);
+    GetTexture(textureIndex).Transition(cmdList, state);
+}
+
+void TextureManager::SetAtlasing(bool enabled)
+{
+    CHECKRET(mCanAddTextures, "Atlasing can't be changed after textures were closed");
+    mAtlasingEnabled = enabled;
+}
+
+Result<DirectX::XMFLOAT4> TextureManager::GetAtlasRect(uint32_t textureIndex) const
+{
+    auto it = mAtlasEntries.find(textureIndex);
+    if (it == mAtlasEntries.end())
+    {
+        return std::nullopt;
+    }
+    return DirectX::XMFLOAT4(it->second.Rect);
+}
+
+const TextureManager::AtlasStatistics &TextureManager::GetAtlasStatistics() const
+{
+    return mAtlasStatistics;
+}
+
+const TextureManager::DeduplicationStatistics &TextureManager::GetDeduplicationStatistics() const
+{
+    return mDeduplicationStatistics;
+}
+
+MemoryBudget &TextureManager::GetMemoryBudget()
+{
+    return mMemoryBudget;
+}
+
+Texture &TextureManager::GetTexture(uint32_t textureIndex)
+{
+    // Packed textures have no resource of their own
+    auto it = mAtlasEntries.find(textureIndex);
+    return it == mAtlasEntries.end() ? mTextures[textureIndex] : mAtlasPages[it->second.Page];
+}
+
+void TextureManager::SetMinLODClamp(uint32_t textureIndex, float clamp)
+{
+    CHECKRET(textureIndex < mTextures.size(),
+             "Texture index {} is invalid. This value should be less than {}", textureIndex, mTextures.size());
+    CHECKRET(mAtlasEntries.find(textureIndex) == mAtlasEntries.end(),
+             "Texture {} is packed in an atlas page, its views are shared", textureIndex);
+    mTextures[textureIndex].SetMinLODClamp(clamp);
+
+    auto &entry = mTextureTable.GetEntry(textureIndex);
+    int32_t oldSrvIndex = entry.HeapIndices[SRV_INDEX];
+    if (!mSrvUavDescriptors.Valid() || oldSrvIndex == -1)
+    {
+        // The view is created with the clamp when the descriptors are
+        return;
+    }
+
+    // Frames in flight may still read the old view, so it isn't overwritten: the new one gets a descriptor of
+    // its own and the old one is only reused once this frame comes around again, as with RetireTexture()
+    auto srvIndexResult = mSrvUavDescriptors.Allocate();
+    CHECKRET(srvIndexResult.Valid(), "Unable to allocate a shader resource view for texture {}", textureIndex);
+    uint32_t srvIndex = srvIndexResult.Get();
+    mTextures[textureIndex].CreateShaderResourceView(mSrvUavDescriptors.GetHeap(), mSrvUavDescriptors.GetCPUHandle(srvIndex));
+    mSrvUavDescriptors.Commit(srvIndex);
+    mSrvUavDescriptors.Free(oldSrvIndex);
+
+    entry.HeapIndices[SRV_INDEX] = (int32_t)srvIndex;
+    UpdateDescriptorHandles(textureIndex);
+    RefreshDescriptorHandles();
 }
 
 ComPtr<ID3D12DescriptorHeap> TextureManager::GetSrvUavDescriptorHeap()
 {
-    return mSrvUavDescriptorHeap;
+    return mSrvUavDescriptors.GetHeap();
+}
+
+DescriptorAllocator &TextureManager::GetSrvUavDescriptors()
+{
+    return mSrvUavDescriptors;
+}
+
+auto TextureManager::GetHandle(uint32_t textureIndex) const -> Result<TextureHandle>
+{
+    CHECK(textureIndex < mTextureTable.GetSize() && mTextureReferences[textureIndex] > 0, std::nullopt,
+          "Texture index {} is invalid", textureIndex);
+    return mTextureTable.GetHandle(textureIndex);
+}
+
+bool TextureManager::IsValid(TextureHandle handle) const
+{
+    return mTextureTable.IsValid(handle);
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE TextureManager::GetSrvGPUHandle(TextureHandle handle) const
+{
+    return D3D12_GPU_DESCRIPTOR_HANDLE{ mTextureTable.GetSrvGPU(handle) };
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE TextureManager::GetUavGPUHandle(TextureHandle handle) const
+{
+    return D3D12_GPU_DESCRIPTOR_HANDLE{ mTextureTable.GetUavGPU(handle) };
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE TextureManager::GetRtvCPUHandle(TextureHandle handle) const
+{
+    return D3D12_CPU_DESCRIPTOR_HANDLE{ (SIZE_T)mTextureTable.GetRtvCPU(handle) };
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE TextureManager::GetDsvCPUHandle(TextureHandle handle) const
+{
+    return D3D12_CPU_DESCRIPTOR_HANDLE{ (SIZE_T)mTextureTable.GetDsvCPU(handle) };
+}
+
+Result<D3D12_GPU_VIRTUAL_ADDRESS> TextureManager::WriteBindlessTextureTable()
+{
+    // Never empty, so there's always a buffer to bind
+    auto tableCount = std::max(mTextureTable.GetSize(), 1u);
+    auto allocation = UploadRingBuffer::Get()->AllocateArray<int32_t>(tableCount);
+    CHECK(allocation.Valid(), std::nullopt, "Unable to allocate the bindless texture table of {} textures", tableCount);
+
+    mTextureTable.WriteSrvIndices((int32_t *)allocation.CPU);
+    return allocation.GPU;
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE TextureManager::GetBindlessTexturesHandle() const
+{
+    return mSrvUavDescriptors.GetGPUHandle(0);
 }
 
 Result<D3D12_GPU_DESCRIPTOR_HANDLE> TextureManager::GetGPUDescriptorSrvHandleForTextureIndex(uint32_t textureIndex)
 {
     CHECK(textureIndex < mTextures.size(), std::nullopt,
           "Texture index {} is invalid. This value should be less than {}", textureIndex, mTextures.size());
-    CHECK(mTextureIndexToHeapIndex.find(textureIndex) != mTextureIndexToHeapIndex.end(), std::nullopt,
-          "Texture index {} is not a index recognized by TextureManager");
-    auto heapIndex = std::get<SRV_INDEX>(mTextureIndexToHeapIndex[textureIndex]);
-    CHECK(heapIndex != -1, std::nullopt, "Texture index {} is not a SRV");
+    const auto &entry = mTextureTable.GetEntry(textureIndex);
+    CHECK(entry.HeapIndices[SRV_INDEX] != -1, std::nullopt, "Texture index {} is not a SRV", textureIndex);
 
-    auto d3d = Direct3D::Get();
-    CD3DX12_GPU_DESCRIPTOR_HANDLE gpuHandle(mSrvUavDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
-    gpuHandle.Offset(heapIndex, d3d->GetDescriptorIncrementSize<D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV>());
-    return gpuHandle;
+    return D3D12_GPU_DESCRIPTOR_HANDLE{ entry.SrvGPU };
 }
 
 Result<D3D12_CPU_DESCRIPTOR_HANDLE> TextureManager::GetCPUDescriptorSrvHandleForTextureIndex(uint32_t textureIndex)
 {
     CHECK(textureIndex < mTextures.size(), std::nullopt,
           "Texture index {} is invalid. This value should be less than {}", textureIndex, mTextures.size());
-    CHECK(mTextureIndexToHeapIndex.find(textureIndex) != mTextureIndexToHeapIndex.end(), std::nullopt,
-          "Texture index {} is not a index recognized by TextureManager");
-    auto heapIndex = std::get<SRV_INDEX>(mTextureIndexToHeapIndex[textureIndex]);
-    CHECK(heapIndex != -1, std::nullopt, "Texture index {} is not a SRV");
+    const auto &entry = mTextureTable.GetEntry(textureIndex);
+    CHECK(entry.HeapIndices[SRV_INDEX] != -1, std::nullopt, "Texture index {} is not a SRV", textureIndex);
 
-    auto d3d = Direct3D::Get();
-    CD3DX12_CPU_DESCRIPTOR_HANDLE cpuHandle(mSrvUavDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
-    cpuHandle.Offset(heapIndex, d3d->GetDescriptorIncrementSize<D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV>());
-    return cpuHandle;
+    return D3D12_CPU_DESCRIPTOR_HANDLE{ (SIZE_T)entry.SrvCPU };
 }
 
 Result<D3D12_GPU_DESCRIPTOR_HANDLE> TextureManager::GetGPUDescriptorUavHandleForTextureIndex(uint32_t textureIndex)
 {
     CHECK(textureIndex < mTextures.size(), std::nullopt,
           "Texture index {} is invalid. This value should be less than {}", textureIndex, mTextures.size());
-    CHECK(mTextureIndexToHeapIndex.find(textureIndex) != mTextureIndexToHeapIndex.end(), std::nullopt,
-          "Texture index {} is not a index recognized by TextureManager");
-    auto heapIndex = std::get<UAV_INDEX>(mTextureIndexToHeapIndex[textureIndex]);
-    CHECK(heapIndex != -1, std::nullopt, "Texture index {} is not a UAV");
+    const auto &entry = mTextureTable.GetEntry(textureIndex);
+    CHECK(entry.HeapIndices[UAV_INDEX] != -1, std::nullopt, "Texture index {} is not a UAV", textureIndex);
 
-    auto d3d = Direct3D::Get();
-    CD3DX12_GPU_DESCRIPTOR_HANDLE gpuHandle(mSrvUavDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
-    gpuHandle.Offset(heapIndex, d3d->GetDescriptorIncrementSize<D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV>());
-    return gpuHandle;
+    return D3D12_GPU_DESCRIPTOR_HANDLE{ entry.UavGPU };
 }
 
 Result<D3D12_CPU_DESCRIPTOR_HANDLE> TextureManager::GetCPUDescriptorUavHandleForTextureIndex(uint32_t textureIndex)
 {
     CHECK(textureIndex < mTextures.size(), std::nullopt,
           "Texture index {} is invalid. This value should be less than {}", textureIndex, mTextures.size());
-    CHECK(mTextureIndexToHeapIndex.find(textureIndex) != mTextureIndexToHeapIndex.end(), std::nullopt,
-          "Texture index {} is not a index recognized by TextureManager");
-    auto heapIndex = std::get<UAV_INDEX>(mTextureIndexToHeapIndex[textureIndex]);
-    CHECK(heapIndex != -1, std::nullopt, "Texture index {} is not a UAV");
+    const auto &entry = mTextureTable.GetEntry(textureIndex);
+    CHECK(entry.HeapIndices[UAV_INDEX] != -1, std::nullopt, "Texture index {} is not a UAV", textureIndex);
 
-    auto d3d = Direct3D::Get();
-    CD3DX12_CPU_DESCRIPTOR_HANDLE cpuHandle(mSrvUavDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
-    cpuHandle.Offset(heapIndex, d3d->GetDescriptorIncrementSize<D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV>());
-    return cpuHandle;
+    return D3D12_CPU_DESCRIPTOR_HANDLE{ (SIZE_T)entry.UavCPU };
 }
 
 ComPtr<ID3D12DescriptorHeap> TextureManager::GetRtvDescriptorHeap()
 {
-    return mRtvDescriptorHeap;
+    return mRtvDescriptors.GetHeap();
 }
 
 Result<D3D12_GPU_DESCRIPTOR_HANDLE> TextureManager::GetGPUDescriptorRtvHandleForTextureIndex(uint32_t textureIndex)
 {
     CHECK(textureIndex < mTextures.size(), std::nullopt,
           "Texture index {} is invalid. This value should be less than {}", textureIndex, mTextures.size());
-    CHECK(mTextureIndexToHeapIndex.find(textureIndex) != mTextureIndexToHeapIndex.end(), std::nullopt,
-          "Texture index {} is not a index recognized by TextureManager");
-    auto heapIndex = std::get<RTV_INDEX>(mTextureIndexToHeapIndex[textureIndex]);
-    CHECK(heapIndex != -1, std::nullopt, "Texture index {} is not a RTV");
+    const auto &entry = mTextureTable.GetEntry(textureIndex);
+    CHECK(entry.HeapIndices[RTV_INDEX] != -1, std::nullopt, "Texture index {} is not a RTV", textureIndex);
 
-    auto d3d = Direct3D::Get();
-    CD3DX12_GPU_DESCRIPTOR_HANDLE gpuHandle(mRtvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
-    gpuHandle.Offset(heapIndex, d3d->GetDescriptorIncrementSize<D3D12_DESCRIPTOR_HEAP_TYPE_RTV>());
-    return gpuHandle;
+    return mRtvDescriptors.GetGPUHandle(entry.HeapIndices[RTV_INDEX]);
 }
 
 Result<D3D12_CPU_DESCRIPTOR_HANDLE> TextureManager::GetCPUDescriptorRtvHandleForTextureIndex(uint32_t textureIndex)
 {
     CHECK(textureIndex < mTextures.size(), std::nullopt,
           "Texture index {} is invalid. This value should be less than {}", textureIndex, mTextures.size());
-    CHECK(mTextureIndexToHeapIndex.find(textureIndex) != mTextureIndexToHeapIndex.end(), std::nullopt,
-          "Texture index {} is not a index recognized by TextureManager");
-    auto heapIndex = std::get<RTV_INDEX>(mTextureIndexToHeapIndex[textureIndex]);
-    CHECK(heapIndex != -1, std::nullopt, "Texture index {} is not a RTV");
+    const auto &entry = mTextureTable.GetEntry(textureIndex);
+    CHECK(entry.HeapIndices[RTV_INDEX] != -1, std::nullopt, "Texture index {} is not a RTV", textureIndex);
 
-    auto d3d = Direct3D::Get();
-    CD3DX12_CPU_DESCRIPTOR_HANDLE cpuHandle(mRtvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
-    cpuHandle.Offset(heapIndex, d3d->GetDescriptorIncrementSize<D3D12_DESCRIPTOR_HEAP_TYPE_RTV>());
-    return cpuHandle;
+    return D3D12_CPU_DESCRIPTOR_HANDLE{ (SIZE_T)entry.RtvCPU };
 }
 
 ComPtr<ID3D12DescriptorHeap> TextureManager::GetDsvDescriptorHeap()
 {
-    return mDsvDescriptorHeap;
+    return mDsvDescriptors.GetHeap();
 }
 
 Result<D3D12_GPU_DESCRIPTOR_HANDLE> TextureManager::GetGPUDescriptorDsvHandleForTextureIndex(uint32_t textureIndex)
 {
     CHECK(textureIndex < mTextures.size(), std::nullopt,
           "Texture index {} is invalid. This value should be less than {}", textureIndex, mTextures.size());
-    CHECK(mTextureIndexToHeapIndex.find(textureIndex) != mTextureIndexToHeapIndex.end(), std::nullopt,
-          "Texture index {} is not a index recognized by TextureManager");
-    auto heapIndex = std::get<DSV_INDEX>(mTextureIndexToHeapIndex[textureIndex]);
-    CHECK(heapIndex != -1, std::nullopt, "Texture index {} is not a DSV");
+    const auto &entry = mTextureTable.GetEntry(textureIndex);
+    CHECK(entry.HeapIndices[DSV_INDEX] != -1, std::nullopt, "Texture index {} is not a DSV", textureIndex);
 
-    auto d3d = Direct3D::Get();
-    CD3DX12_GPU_DESCRIPTOR_HANDLE gpuHandle(mDsvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
-    gpuHandle.Offset(heapIndex, d3d->GetDescriptorIncrementSize<D3D12_DESCRIPTOR_HEAP_TYPE_DSV>());
-    return gpuHandle;
+    return mDsvDescriptors.GetGPUHandle(entry.HeapIndices[DSV_INDEX]);
 }
 
 Result<D3D12_CPU_DESCRIPTOR_HANDLE> TextureManager::GetCPUDescriptorDsvHandleForTextureIndex(uint32_t textureIndex)
 {
     CHECK(textureIndex < mTextures.size(), std::nullopt,
           "Texture index {} is invalid. This value should be less than {}", textureIndex, mTextures.size());
-    CHECK(mTextureIndexToHeapIndex.find(textureIndex) != mTextureIndexToHeapIndex.end(), std::nullopt,
-          "Texture index {} is not a index recognized by TextureManager");
-    auto heapIndex = std::get<DSV_INDEX>(mTextureIndexToHeapIndex[textureIndex]);
-    CHECK(heapIndex != -1, std::nullopt, "Texture index {} is not a DSV");
+    const auto &entry = mTextureTable.GetEntry(textureIndex);
+    CHECK(entry.HeapIndices[DSV_INDEX] != -1, std::nullopt, "Texture index {} is not a DSV", textureIndex);
 
-    auto d3d = Direct3D::Get();
-    CD3DX12_CPU_DESCRIPTOR_HANDLE cpuHandle(mDsvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
-    cpuHandle.Offset(heapIndex, d3d->GetDescriptorIncrementSize<D3D12_DESCRIPTOR_HEAP_TYPE_DSV>());
-    return cpuHandle;
+    return D3D12_CPU_DESCRIPTOR_HANDLE{ (SIZE_T)entry.DsvCPU };
 }
 
 bool TextureManager::InitTextures(ID3D12GraphicsCommandList *cmdList, std::vector<ComPtr<ID3D12Resource>> &intermediaryResources)
 {
+    PROFILE_FUNCTION();
     SHOWINFO("Loading {} textures", mTexturesToLoad.size());
     mTextures.resize(mTexturesToLoad.size());
     intermediaryResources.resize(mTexturesToLoad.size());
 
+    // Reading and parsing the files doesn't need the device, so it runs on the job system.
+    // Only resource creation and copy recording stay on this thread
+    std::vector<DirectX::DDSTextureData> textureData(mTexturesToLoad.size());
+    std::vector<HRESULT> loadResults(mTexturesToLoad.size(), S_OK);
+    {
+        PROFILE_SCOPE("LoadTextureData");
+        JobSystem::Get()->ParallelFor((uint32_t)mTexturesToLoad.size(), 1, [&](uint32_t begin, uint32_t end)
+                                      {
+                                          for (uint32_t i = begin; i < end; ++i)
+                                          {
+                                              if (mTexturesToLoad[i]._InitializationType == TextureInitializationParams::Path)
+                                              {
+                                                  PROFILE_SCOPE("LoadDDSTextureData");
+                                                  loadResults[i] = DirectX::LoadDDSTextureData(mTexturesToLoad[i]._Path.c_str(), textureData[i]);
+                                                  if (SUCCEEDED(loadResults[i]))
+                                                  {
+                                                      Texture::GenerateMissingMips(textureData[i]);
+                                                  }
+                                              }
+                                          }
+                                      });
+    }
+
+    if (mAtlasingEnabled)
+    {
+        CHECK(PackAtlases(cmdList, textureData, loadResults, intermediaryResources), false, "Unable to pack textures in atlases");
+    }
+
     for (uint32_t i = 0; i < (uint32_t)mTexturesToLoad.size(); ++i)
     {
+        if (mAtlasEntries.find(i) != mAtlasEntries.end())
+        {
+            continue;
+        }
+
         if (mTexturesToLoad[i]._InitializationType == TextureInitializationParams::Path)
         {
-            CHECK(mTextures[i].Init(cmdList, mTexturesToLoad[i]._Path.c_str(), intermediaryResources[i]),
-                  false, "Unable to initialize texture {}", Conversions::ws2s(mTexturesToLoad[i]._Path));
+            CHECK(SUCCEEDED(loadResults[i]), false, "Unable to load texture {}. Error code: {:#x}",
+                  Conversions::ws2s(mTexturesToLoad[i]._Path), (uint32_t)loadResults[i]);
+            // Large textures only get their coarse mips now, the rest is streamed on demand
+            if (!TextureStreamer::Get()->AddTexture(i, mTexturesToLoad[i]._Path, cmdList, textureData[i],
+                                                    mTextures[i], intermediaryResources[i]))
+            {
+                CHECK(mTextures[i].Init(cmdList, textureData[i], intermediaryResources[i]),
+                      false, "Unable to initialize texture {}", Conversions::ws2s(mTexturesToLoad[i]._Path));
+            }
+            // The upload is recorded, so the file contents can go
+            textureData[i] = DirectX::DDSTextureData();
         }
         else if (mTexturesToLoad[i]._InitializationType == TextureInitializationParams::InitializationParams)
         {
@@ -253,119 +655,462 @@ bool TextureManager::InitTextures(ID3D12GraphicsCommandList *cmdList, std::vecto
                                     initParams.heapProperties, initParams.heapFlags, initParams.state), false,
                   "Unable to initialize texture at index {}", i);
         }
+        TrackTexture(i);
     }
 
     SHOWINFO("Successfully initialized {} textures", mTexturesToLoad.size());
     return true;
 }
 
+bool TextureManager::PackAtlases(ID3D12GraphicsCommandList *cmdList, std::vector<DirectX::DDSTextureData> &textureData,
+                                 const std::vector<HRESULT> &loadResults, std::vector<ComPtr<ID3D12Resource>> &intermediaryResources)
+{
+    PROFILE_FUNCTION();
+
+    // Only textures with the same format and mip count can share a page
+    std::map<std::pair<DXGI_FORMAT, uint32_t>, std::vector<uint32_t>> groups;
+    for (uint32_t i = 0; i < (uint32_t)mTexturesToLoad.size(); ++i)
+    {
+        if (mTexturesToLoad[i]._InitializationType == TextureInitializationParams::Path &&
+            SUCCEEDED(loadResults[i]) && CanBeAtlased(textureData[i]))
+        {
+            uint32_t mipCount = std::min((uint32_t)textureData[i].mipCount, kAtlasMaxMips);
+            groups[{ textureData[i].format, mipCount }].push_back(i);
+        }
+    }
+
+    auto device = Direct3D::Get()->GetD3D12Device();
+    uint64_t usedTexels = 0;
+    uint64_t pageTexels = 0;
+    for (const auto &[key, textures] : groups)
+    {
+        const auto &[format, mipCount] = key;
+        if (textures.size() < 2)
+        {
+            continue;
+        }
+
+        std::vector<TextureAtlasPacker::Rect> rects;
+        for (auto textureIndex : textures)
+        {
+            rects.push_back({ (uint32_t)textureData[textureIndex].width, (uint32_t)textureData[textureIndex].height });
+        }
+        auto pages = TextureAtlasPacker::Pack(rects, kAtlasPageSize, kAtlasPadding, kAtlasAlignment);
+
+        for (uint32_t pageIndex = 0; pageIndex < (uint32_t)pages.size(); ++pageIndex)
+        {
+            const auto &page = pages[pageIndex];
+            if (page.RectCount < 2)
+            {
+                // A page with a single texture would only add padding
+                continue;
+            }
+
+            std::vector<size_t> mipOffsets;
+            size_t pageSize = 0;
+            for (uint32_t mip = 0; mip < mipCount; ++mip)
+            {
+                mipOffsets.push_back(pageSize);
+                pageSize += (size_t)(page.Width >> mip) * (page.Height >> mip) * sizeof(uint32_t);
+            }
+            std::shared_ptr<uint8_t> pageMemory(new uint8_t[pageSize](), std::default_delete<uint8_t[]>());
+
+            uint32_t atlasPage = (uint32_t)mAtlasPages.size();
+            auto pageDesc = CD3DX12_RESOURCE_DESC::Tex2D(format, page.Width, page.Height, 1, (uint16_t)mipCount);
+            int64_t savedBytes = -(int64_t)device->GetResourceAllocationInfo(0, 1, &pageDesc).SizeInBytes;
+            for (uint32_t rectIndex = 0; rectIndex < (uint32_t)rects.size(); ++rectIndex)
+            {
+                const auto &rect = rects[rectIndex];
+                if (!rect.Packed || rect.Page != pageIndex)
+                {
+                    continue;
+                }
+
+                uint32_t textureIndex = textures[rectIndex];
+                const auto &source = textureData[textureIndex];
+                for (uint32_t mip = 0; mip < mipCount; ++mip)
+                {
+                    CopyToAtlasPage(source.subresources[mip], std::max(rect.Width >> mip, 1u), std::max(rect.Height >> mip, 1u),
+                                    pageMemory.get() + mipOffsets[mip], page.Width >> mip,
+                                    rect.X >> mip, rect.Y >> mip, kAtlasPadding >> mip);
+                }
+
+                auto textureDesc = CD3DX12_RESOURCE_DESC::Tex2D(format, rect.Width, rect.Height, 1, (uint16_t)source.mipCount);
+                savedBytes += (int64_t)device->GetResourceAllocationInfo(0, 1, &textureDesc).SizeInBytes;
+
+                mAtlasEntries[textureIndex] = { atlasPage,
+                    DirectX::XMFLOAT4((float)rect.Width / page.Width, (float)rect.Height / page.Height,
+                                      (float)rect.X / page.Width, (float)rect.Y / page.Height) };
+                // The texels were copied, the file contents can go
+                textureData[textureIndex] = DirectX::DDSTextureData();
+            }
+
+            DirectX::DDSTextureData pageData;
+            pageData.resDim = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+            pageData.width = page.Width;
+            pageData.height = page.Height;
+            pageData.depth = 1;
+            pageData.mipCount = mipCount;
+            pageData.arraySize = 1;
+            pageData.format = format;
+            for (uint32_t mip = 0; mip < mipCount; ++mip)
+            {
+                D3D12_SUBRESOURCE_DATA subresource = {};
+                subresource.pData = pageMemory.get() + mipOffsets[mip];
+                subresource.RowPitch = (LONG_PTR)(page.Width >> mip) * sizeof(uint32_t);
+                subresource.SlicePitch = subresource.RowPitch * (page.Height >> mip);
+                pageData.subresources.push_back(subresource);
+            }
+            pageData.fileData = std::move(pageMemory);
+
+            mAtlasPages.emplace_back();
+            intermediaryResources.emplace_back();
+            CHECK(mAtlasPages.back().Init(cmdList, pageData, intermediaryResources.back()), false,
+                  "Unable to initialize atlas page {}", atlasPage);
+            mMemoryBudget.Track(MemoryBudget::Category::AtlasPage, atlasPage, mAtlasPages.back().GetAllocationSize());
+
+            mAtlasStatistics.Pages++;
+            mAtlasStatistics.Textures += page.RectCount;
+            mAtlasStatistics.SavedBytes += savedBytes;
+            mAtlasStatistics.SavedDescriptors += page.RectCount - 1;
+            usedTexels += page.UsedTexels;
+            pageTexels += (uint64_t)page.Width * page.Height;
+        }
+    }
+
+    if (mAtlasStatistics.Pages == 0)
+    {
+        return true;
+    }
+
+    mAtlasStatistics.Efficiency = (float)usedTexels / pageTexels;
+    AssignAtlasDescriptors();
+    SHOWINFO("Packed {} textures in {} atlas pages, {:.1f}% of the texels used. Saved {} KiB and {} descriptors",
+             mAtlasStatistics.Textures, mAtlasStatistics.Pages, mAtlasStatistics.Efficiency * 100.0f,
+             mAtlasStatistics.SavedBytes / 1024, mAtlasStatistics.SavedDescriptors);
+    return true;
+}
+
+void TextureManager::AssignAtlasDescriptors()
+{
+    // Shader resource and unordered access views are numbered again without the packed textures,
+    // which then share the view of their page
+    mNumCbvSrvUav = 0;
+    for (uint32_t i = 0; i < mNumTextures; ++i)
+    {
+        if (mAtlasEntries.find(i) != mAtlasEntries.end())
+        {
+            continue;
+        }
+        auto &heapIndices = mTextureTable.GetEntry(i).HeapIndices;
+        if (heapIndices[SRV_INDEX] != -1)
+        {
+            heapIndices[SRV_INDEX] = mNumCbvSrvUav++;
+        }
+        if (heapIndices[UAV_INDEX] != -1)
+        {
+            heapIndices[UAV_INDEX] = mNumCbvSrvUav++;
+        }
+    }
+
+    mAtlasPageSrvIndices.clear();
+    for (uint32_t i = 0; i < (uint32_t)mAtlasPages.size(); ++i)
+    {
+        mAtlasPageSrvIndices.push_back(mNumCbvSrvUav++);
+    }
+
+    for (const auto &[textureIndex, entry] : mAtlasEntries)
+    {
+        mTextureTable.GetEntry(textureIndex).HeapIndices[SRV_INDEX] = mAtlasPageSrvIndices[entry.Page];
+    }
+}
+
 bool TextureManager::InitDescriptors()
 {
-    auto d3d = Direct3D::Get();
-    
-    // Apparently PIX doesn't like it when heaps with 0 descriptors are created
+    CHECK(mSrvUavDescriptors.Init(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, mNumCbvSrvUav + kDescriptorHeadroom,
+                                  kTransientDescriptorsPerFrame),
+          false, "Unable to create descriptor heap for srv & uav");
+    CHECK(mRtvDescriptors.Init(D3D12_DESCRIPTOR_HEAP_TYPE_RTV, mNumRtv + kDescriptorHeadroom), false,
+          "Unable to create descriptor heap for rtv");
+    CHECK(mDsvDescriptors.Init(D3D12_DESCRIPTOR_HEAP_TYPE_DSV, mNumDsv + kDescriptorHeadroom), false,
+          "Unable to create descriptor heap for dsv");
 
+    // The descriptors counted while adding textures are taken as one range per heap. The indices handed out
+    // were relative to the start of that range
+    uint32_t srvUavBase = 0, rtvBase = 0, dsvBase = 0;
     if (mNumCbvSrvUav > 0)
     {
-        ASSIGN_RESULT(mSrvUavDescriptorHeap,
-                      d3d->CreateDescriptorHeap(mNumCbvSrvUav, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
-                                                D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE),
-                      false, "Unable to create descriptor heap for srv & uav");
+        ASSIGN_RESULT(srvUavBase, mSrvUavDescriptors.Allocate(mNumCbvSrvUav), false, "Unable to allocate {} srv & uav", mNumCbvSrvUav);
     }
-
     if (mNumRtv > 0)
     {
-        ASSIGN_RESULT(mRtvDescriptorHeap,
-                      d3d->CreateDescriptorHeap(mNumRtv, D3D12_DESCRIPTOR_HEAP_TYPE_RTV),
-                      false, "Unable to create descriptor heap for rtv");
+        ASSIGN_RESULT(rtvBase, mRtvDescriptors.Allocate(mNumRtv), false, "Unable to allocate {} rtv", mNumRtv);
     }
-
     if (mNumDsv > 0)
     {
-        ASSIGN_RESULT(mDsvDescriptorHeap,
-                      d3d->CreateDescriptorHeap(mNumDsv, D3D12_DESCRIPTOR_HEAP_TYPE_DSV),
-                      false, "Unable to create descriptor heap for dsv");
+        ASSIGN_RESULT(dsvBase, mDsvDescriptors.Allocate(mNumDsv), false, "Unable to allocate {} dsv", mNumDsv);
+    }
+
+    auto offset = [](int32_t &heapIndex, uint32_t base)
+    {
+        if (heapIndex != -1)
+        {
+            heapIndex += (int32_t)base;
+        }
+    };
+    for (uint32_t i = 0; i < mTextureTable.GetSize(); ++i)
+    {
+        auto &entry = mTextureTable.GetEntry(i);
+        offset(entry.HeapIndices[SRV_INDEX), srvUavBase);
+        offset(entry.HeapIndices[UAV_INDEX], srvUavBase);
+        offset(entry.HeapIndices[RTV_INDEX], rtvBase);
+        offset(entry.HeapIndices[DSV_INDEX], dsvBase);
+    }
+    for (auto &pageSrvIndex : mAtlasPageSrvIndices)
+    {
+        offset(pageSrvIndex, srvUavBase);
+    }
+    for (uint32_t i = 0; i < mTextureTable.GetSize(); ++i)
+    {
+        UpdateDescriptorHandles(i);
     }
+    mDescriptorVersions = { mSrvUavDescriptors.GetVersion(), mRtvDescriptors.GetVersion(), mDsvDescriptors.GetVersion() };
 
     CHECK(InitAllViews(), false, "Unable to initialize all SRVs");
 
     return true;
 }
 
-void TextureManager::InitAllViews(uint32_t descriptorIndex)
+uint32_t TextureManager::AddTextureSlot(TextureInitializationParams &&params)
 {
-    auto d3d = Direct3D::Get();
-    if (mTexturesToLoad[descriptorIndex]._InitializationType == TextureInitializationParams::Path)
+    uint32_t textureIndex;
+    if (!mFreeTextureIndices.empty())
     {
-        CD3DX12_CPU_DESCRIPTOR_HANDLE cpuHandle(mSrvUavDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
-        // Path-only textures are only shader resource views
-        mTextures[descriptorIndex].CreateShaderResourceView(
-            mSrvUavDescriptorHeap.Get(),
-            cpuHandle.Offset(std::get<SRV_INDEX>(mTextureIndexToHeapIndex[descriptorIndex]),
-                             d3d->GetDescriptorIncrementSize<D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV>())
-        );
+        // Only textures removed after closing leave slots behind
+        textureIndex = mFreeTextureIndices.back();
+        mFreeTextureIndices.pop_back();
+        mTexturesToLoad[textureIndex] = std::move(params);
     }
-    else if (mTexturesToLoad[descriptorIndex]._InitializationType == TextureInitializationParams::InitializationParams)
+    else
     {
-        uint32_t createdViews = 0;
-        if (!(mTexturesToLoad[descriptorIndex]._InitializationParams.resourceDesc.Flags & D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE))
-        {
-            CD3DX12_CPU_DESCRIPTOR_HANDLE cpuHandle(mSrvUavDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
-            // Create SRV if needed
-            mTextures[descriptorIndex].CreateShaderResourceView(
-                mSrvUavDescriptorHeap.Get(),
-                cpuHandle.Offset(std::get<SRV_INDEX>(mTextureIndexToHeapIndex[descriptorIndex]),
-                                 d3d->GetDescriptorIncrementSize<D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV>())
-            );
-            createdViews++;
-        }
-        if (mTexturesToLoad[descriptorIndex]._InitializationParams.resourceDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS)
+        textureIndex = mNumTextures++;
+        mTexturesToLoad.push_back(std::move(params));
+        mTextureReferences.push_back(0);
+        mTextureTable.Add();
+        if (!mCanAddTextures)
         {
-            CD3DX12_CPU_DESCRIPTOR_HANDLE cpuHandle(mSrvUavDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
-            // Create UAV if needed
-            mTextures[descriptorIndex].CreateUnorederedAccessView(
-                mSrvUavDescriptorHeap.Get(),
-                cpuHandle.Offset(std::get<UAV_INDEX>(mTextureIndexToHeapIndex[descriptorIndex]),
-                                 d3d->GetDescriptorIncrementSize<D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV>())
-            );
-            createdViews++;
+            mTextures.emplace_back();
         }
-        if (mTexturesToLoad[descriptorIndex]._InitializationParams.resourceDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET)
+    }
+    mTextureReferences[textureIndex] = 1;
+    return textureIndex;
+}
+
+bool TextureManager::CreateTexture(uint32_t textureIndex)
+{
+    PROFILE_FUNCTION();
+    const auto &params = mTexturesToLoad[textureIndex];
+    if (params._InitializationType == TextureInitializationParams::Path)
+    {
+        // The direct queue waits for the upload before it uses the texture
+        auto uploader = AsyncUploader::Get();
+        ComPtr<ID3D12Resource> intermediary;
+        CHECK(mTextures[textureIndex].Init(uploader->GetCommandList(), params._Path.c_str(), intermediary), false,
+              "Unable to initialize texture {}", Conversions::ws2s(params._Path));
+        uploader->KeepAlive(intermediary);
+        auto ticketResult = uploader->Submit();
+        CHECK(ticketResult.Valid(), false, "Unable to submit the upload of texture {}", Conversions::ws2s(params._Path));
+        uploader->WaitOnDirectQueue(ticketResult.Get());
+    }
+    else
+    {
+        const auto &initParams = params._InitializationParams;
+        CHECK(mTextures[textureIndex].Init(initParams.resourceDesc, initParams.clearValue ? initParams.clearValue.get() : nullptr,
+                                           initParams.heapProperties, initParams.heapFlags, initParams.state), false,
+              "Unable to initialize texture at index {}", textureIndex);
+    }
+    TrackTexture(textureIndex);
+
+    CHECK(AllocateDescriptors(textureIndex), false, "Unable to allocate descriptors for texture {}", textureIndex);
+    InitAllViews(textureIndex);
+    return true;
+}
+
+bool TextureManager::AllocateDescriptors(uint32_t textureIndex)
+{
+    const auto &params = mTexturesToLoad[textureIndex];
+    // Path textures are only shader resource views
+    auto flags = params._InitializationType == TextureInitializationParams::Path ?
+        D3D12_RESOURCE_FLAG_NONE : params._InitializationParams.resourceDesc.Flags;
+
+    std::array<DescriptorAllocator *, 4> allocators = { &mSrvUavDescriptors, &mSrvUavDescriptors, &mRtvDescriptors, &mDsvDescriptors };
+    std::array<bool, 4> needed = {
+        !(flags & D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE),
+        !!(flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+        !!(flags & D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET),
+        !!(flags & D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL),
+    };
+    std::array<int32_t, 4> heapIndices = { -1, -1, -1, -1 };
+    for (uint32_t i = 0; i < heapIndices.size(); ++i)
+    {
+        if (!needed[i])
         {
-            CD3DX12_CPU_DESCRIPTOR_HANDLE cpuHandle(mRtvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
-            // Create RTV if needed
-            mTextures[descriptorIndex].CreateRenderTargetView(
-                mRtvDescriptorHeap.Get(),
-                cpuHandle.Offset(std::get<RTV_INDEX>(mTextureIndexToHeapIndex[descriptorIndex]),
-                                 d3d->GetDescriptorIncrementSize<D3D12_DESCRIPTOR_HEAP_TYPE_RTV>())
-            );
-            createdViews++;
+            continue;
         }
-        if (mTexturesToLoad[descriptorIndex]._InitializationParams.resourceDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)
+
+        auto heapIndexResult = allocators[i]->Allocate();
+        if (!heapIndexResult.Valid())
         {
-            CD3DX12_CPU_DESCRIPTOR_HANDLE cpuHandle(mDsvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
-            // Create DSV if needed
-            mTextures[descriptorIndex].CreateDepthStencilView(
-                mDsvDescriptorHeap.Get(),
-                cpuHandle.Offset(std::get<DSV_INDEX>(mTextureIndexToHeapIndex[descriptorIndex]),
-                                 d3d->GetDescriptorIncrementSize<D3D12_DESCRIPTOR_HEAP_TYPE_DSV>()));
-            createdViews++;
+            for (uint32_t j = 0; j < i; ++j)
+            {
+                if (heapIndices[j] != -1)
+                {
+                    allocators[j]->Free(heapIndices[j]);
+                }
+            }
+            return false;
         }
+        heapIndices[i] = (int32_t)heapIndexResult.Get();
+    }
+
+    mTextureTable.GetEntry(textureIndex).HeapIndices = heapIndices;
+    UpdateDescriptorHandles(textureIndex);
+    RefreshDescriptorHandles();
+    return true;
+}
+
+void TextureManager::FreeDescriptors(uint32_t textureIndex)
+{
+    auto &entry = mTextureTable.GetEntry(textureIndex);
+    auto [srvIndex, uavIndex, rtvIndex, dsvIndex] = entry.HeapIndices;
+    if (srvIndex != -1)
+    {
+        mSrvUavDescriptors.Free(srvIndex);
+    }
+    if (uavIndex != -1)
+    {
+        mSrvUavDescriptors.Free(uavIndex);
+    }
+    if (rtvIndex != -1)
+    {
+        mRtvDescriptors.Free(rtvIndex);
+    }
+    if (dsvIndex != -1)
+    {
+        mDsvDescriptors.Free(dsvIndex);
+    }
+    entry.HeapIndices = { -1, -1, -1, -1 };
+    UpdateDescriptorHandles(textureIndex);
+}
+
+void TextureManager::RetireTexture(uint32_t textureIndex)
+{
+    FreeDescriptors(textureIndex);
+    mMemoryBudget.Untrack(MemoryBudget::Category::Texture, textureIndex);
+    mMemoryBudget.Untrack(MemoryBudget::Category::RenderTarget, textureIndex);
+    mRetiredTextures[mFrameIndex].push_back(std::move(mTextures[textureIndex]));
+    mTextures[textureIndex] = Texture();
+}
+
+void TextureManager::UpdateDescriptorHandles(uint32_t textureIndex)
+{
+    auto &entry = mTextureTable.GetEntry(textureIndex);
+    auto [srvIndex, uavIndex, rtvIndex, dsvIndex] = entry.HeapIndices;
+    entry.SrvGPU = srvIndex != -1 ? mSrvUavDescriptors.GetGPUHandle(srvIndex).ptr : 0;
+    entry.SrvCPU = srvIndex != -1 ? mSrvUavDescriptors.GetCPUHandle(srvIndex).ptr : 0;
+    entry.UavGPU = uavIndex != -1 ? mSrvUavDescriptors.GetGPUHandle(uavIndex).ptr : 0;
+    entry.UavCPU = uavIndex != -1 ? mSrvUavDescriptors.GetCPUHandle(uavIndex).ptr : 0;
+    entry.RtvCPU = rtvIndex != -1 ? mRtvDescriptors.GetCPUHandle(rtvIndex).ptr : 0;
+    entry.DsvCPU = dsvIndex != -1 ? mDsvDescriptors.GetCPUHandle(dsvIndex).ptr : 0;
+}
+
+void TextureManager::RefreshDescriptorHandles()
+{
+    std::array<uint32_t, 3> versions = { mSrvUavDescriptors.GetVersion(), mRtvDescriptors.GetVersion(), mDsvDescriptors.GetVersion() };
+    if (versions == mDescriptorVersions)
+    {
+        return;
+    }
+
+    PROFILE_FUNCTION();
+    for (uint32_t i = 0; i < mTextureTable.GetSize(); ++i)
+    {
+        UpdateDescriptorHandles(i);
+    }
+    mDescriptorVersions = versions;
+}
+
+void TextureManager::TrackTexture(uint32_t textureIndex)
+{
+    const auto &texture = mTextures[textureIndex];
+    // Reserved textures are accounted for by the streamer, which knows how much of them is resident
+    if (texture.GetAllocationSize() == 0)
+    {
+        return;
+    }
+
+    constexpr auto kRenderTargetFlags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL |
+        D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+    auto category = (texture.GetDesc().Flags & kRenderTargetFlags) ? MemoryBudget::Category::RenderTarget : MemoryBudget::Category::Texture;
+    mMemoryBudget.Track(category, textureIndex, texture.GetAllocationSize());
+}
+
+void TextureManager::InitAllViews(uint32_t descriptorIndex)
+{
+    if (mAtlasEntries.find(descriptorIndex) != mAtlasEntries.end())
+    {
+        // The view of the page is created by InitAllViews()
+        return;
+    }
+
+    // Removed textures have no views left
+    auto [srvIndex, uavIndex, rtvIndex, dsvIndex] = mTextureTable.GetEntry(descriptorIndex).HeapIndices;
+
+    auto &texture = mTextures[descriptorIndex];
+    uint32_t createdViews = 0;
+    if (srvIndex != -1)
+    {
+        texture.CreateShaderResourceView(mSrvUavDescriptors.GetHeap(), mSrvUavDescriptors.GetCPUHandle(srvIndex));
+        mSrvUavDescriptors.Commit(srvIndex);
+        createdViews++;
+    }
+    if (uavIndex != -1)
+    {
+        texture.CreateUnorederedAccessView(mSrvUavDescriptors.GetHeap(), mSrvUavDescriptors.GetCPUHandle(uavIndex));
+        mSrvUavDescriptors.Commit(uavIndex);
+        createdViews++;
+    }
+    if (rtvIndex != -1)
+    {
+        texture.CreateRenderTargetView(mRtvDescriptors.GetHeap(), mRtvDescriptors.GetCPUHandle(rtvIndex));
+        createdViews++;
+    }
+    if (dsvIndex != -1)
+    {
+        texture.CreateDepthStencilView(mDsvDescriptors.GetHeap(), mDsvDescriptors.GetCPUHandle(dsvIndex));
+        createdViews++;
+    }
+    if (mTexturesToLoad[descriptorIndex]._InitializationType == TextureInitializationParams::InitializationParams)
+    {
         SHOWINFO("Created {} views for texture located at index {}", createdViews, descriptorIndex);
     }
 }
 
 bool TextureManager::InitAllViews()
 {
-    auto d3d = Direct3D::Get();
     SHOWINFO("Creating {} views", mNumTextures);
-    
 
     for (unsigned int i = 0; i < mTextures.size(); ++i)
     {
         InitAllViews(i);
     }
 
+    for (uint32_t i = 0; i < (uint32_t)mAtlasPages.size(); ++i)
+    {
+        mAtlasPages[i].CreateShaderResourceView(mSrvUavDescriptors.GetHeap(), mSrvUavDescriptors.GetCPUHandle(mAtlasPageSrvIndices[i]));
+        mSrvUavDescriptors.Commit(mAtlasPageSrvIndices[i]);
+    }
+
     SHOWINFO("Successfully created {} cbv / srv / uav", mNumCbvSrvUav);
     SHOWINFO("Successfully created {} rtv", mNumRtv);
     SHOWINFO("Successfully created {} dsv", mNumDsv);
@@ -5,41 +5,151 @@
 #include <ISingletone.h>
 
 #include "Texture.h"
+#include "Utils/DescriptorAllocator.h"
+#include "Utils/MemoryBudget.h"
+#include "Utils/TextureTable.h"
 
 class TextureManager : public ISingletone<TextureManager>
 {
     MAKE_SINGLETONE_CAPABLE(TextureManager);
 
-    static constexpr const uint32_t SRV_INDEX = 0;
-    static constexpr const uint32_t UAV_INDEX = 1;
-    static constexpr const uint32_t RTV_INDEX = 2;
-    static constexpr const uint32_t DSV_INDEX = 3;
+    static constexpr const uint32_t SRV_INDEX = TextureTable::kSrv;
+    static constexpr const uint32_t UAV_INDEX = TextureTable::kUav;
+    static constexpr const uint32_t RTV_INDEX = TextureTable::kRtv;
+    static constexpr const uint32_t DSV_INDEX = TextureTable::kDsv;
+
+public:
+    // Descriptors created on top of the ones counted while adding textures, for the textures added after closing
+    static constexpr const uint32_t kDescriptorHeadroom = 64;
+    // Shader visible descriptors every frame can write with AllocateTransient() on GetSrvUavDescriptors()
+    static constexpr const uint32_t kTransientDescriptorsPerFrame = 256;
+
+    // Path textures this size or smaller are packed in shared atlas pages, with others of their format
+    static constexpr const uint32_t kMaxAtlasedTextureSize = 256;
+    static constexpr const uint32_t kAtlasPageSize = 2048;
+    // Texels repeated around every packed texture, so filtering doesn't bleed its neighbours in
+    static constexpr const uint32_t kAtlasPadding = 8;
+    static constexpr const uint32_t kAtlasAlignment = 16;
+    // The padding of mip n is kAtlasPadding >> n, so later mips would have none. The last one keeps a single texel,
+    // enough for the bilinear footprint of clampLinearSampler but not for anisotropic filtering or for UVs outside
+    // [0, 1]: those read the neighbours in the page
+    static constexpr const uint32_t kAtlasMaxMips = 4;
+
+    struct AtlasStatistics
+    {
+        uint32_t Pages = 0;
+        uint32_t Textures = 0;
+        // Texels covered by packed textures over the texels of the pages
+        float Efficiency = 0.0f;
+        // Memory and descriptors the packed textures would have taken on their own, minus what the pages take
+        int64_t SavedBytes = 0;
+        uint32_t SavedDescriptors = 0;
+    };
+
+    /// <summary>
+    /// Texture index with the generation of its slot. Removing a texture bumps the generation, so handles
+    /// kept across the removal stop resolving instead of reaching the texture that reuses the index
+    /// </summary>
+    using TextureHandle = TextureTable::Handle;
+
+    struct DeduplicationStatistics
+    {
+        // AddTexture calls answered with a texture that was already added, found by its path or by its file contents
+        uint32_t PathHits = 0;
+        uint32_t ContentHits = 0;
+        // File bytes that weren't loaded and uploaded again
+        uint64_t SavedBytes = 0;
+    };
 
 public:
     TextureManager() = default;
     ~TextureManager() = default;
 
 public:
+    /// <summary>
+    /// Textures added before CloseAddingTextures() are created when it's called, the ones added afterwards right away.
+    /// Path textures added afterwards are uploaded on the copy queue. Every call takes a reference that RemoveTexture() gives back
+    /// </summary>
     Result<uint32_t> AddTexture(const std::string &path);
     Result<uint32_t> AddTexture(LPCWSTR path);
     Result<uint32_t> AddTexture(const D3D12_RESOURCE_DESC &resourceDesc, const D3D12_HEAP_PROPERTIES &heapProperties,
                                 const D3D12_RESOURCE_STATES &state = D3D12_RESOURCE_STATE_GENERIC_READ,
                                 const D3D12_HEAP_FLAGS &heapFlags = D3D12_HEAP_FLAG_NONE,
                                 D3D12_CLEAR_VALUE *clearValue = nullptr);
+    /// <summary>
+    /// Replaces textureIndex in place. Fails if the texture is packed in an atlas page or if other AddTexture() calls
+    /// were deduplicated to it, since they'd all see the new texture
+    /// </summary>
     bool UpdateTexture(uint32_t textureIndex, ID3D12GraphicsCommandList *cmdList, const std::string &path, ComPtr<ID3D12Resource> intermediaryResource);
     bool UpdateTexture(uint32_t textureIndex, ID3D12GraphicsCommandList *cmdList, LPCWSTR path, ComPtr<ID3D12Resource> intermediaryResource);
     bool UpdateTexture(uint32_t textureIndex, const D3D12_RESOURCE_DESC &resourceDesc, const D3D12_HEAP_PROPERTIES &heapProperties,
                        const D3D12_RESOURCE_STATES &state = D3D12_RESOURCE_STATE_GENERIC_READ,
                        const D3D12_HEAP_FLAGS &heapFlags = D3D12_HEAP_FLAG_NONE,
                        D3D12_CLEAR_VALUE *clearValue = nullptr);
+    /// <summary>
+    /// Gives back a reference taken by AddTexture(). The last one releases the texture and its descriptors once the
+    /// frames in flight are done with them, and textureIndex can be handed out again. Only after CloseAddingTextures()
+    /// </summary>
+    bool RemoveTexture(uint32_t textureIndex);
 
 public:
     bool CloseAddingTextures(ID3D12GraphicsCommandList *cmdList, std::vector<ComPtr<ID3D12Resource>> &intermediaryResources);
     uint32_t GetTextureCount() const;
+    /// <summary>
+    /// Must be called after waiting for the fence of the frame resource at frameIndex
+    /// </summary>
+    void BeginFrame(uint32_t frameIndex);
 
     void Transition(ID3D12GraphicsCommandList *cmdList, uint32_t textureIndex, D3D12_RESOURCE_STATES state);
 
+    /// <summary>
+    /// Packing small textures in atlas pages is off by default. Only turn it on when every pipeline that samples
+    /// path textures maps its UVs through MatTransform, which carries the atlas rect. The structured buffer instancing
+    /// of MaterialLightPermutations passes them through as they are. Call before CloseAddingTextures().
+    /// Packed textures can't be replaced with UpdateTexture()
+    /// </summary>
+    void SetAtlasing(bool enabled);
+    /// <summary>
+    /// Scale (xy) and offset (zw) that map the UVs of textureIndex to its rectangle in its atlas page.
+    /// Invalid if textureIndex wasn't packed
+    /// </summary>
+    Result<DirectX::XMFLOAT4> GetAtlasRect(uint32_t textureIndex) const;
+    const AtlasStatistics &GetAtlasStatistics() const;
+    const DeduplicationStatistics &GetDeduplicationStatistics() const;
+    /// <summary>
+    /// Video memory of every texture, render target and atlas page. The streamer adds its textures and evicts them from it
+    /// </summary>
+    MemoryBudget &GetMemoryBudget();
+    /// <summary>
+    /// Creates a shader resource view of textureIndex that doesn't sample mips finer than clamp, in a new descriptor.
+    /// The old descriptor is freed with the current frame; handles fetched from the table afterwards get the new one
+    /// </summary>
+    void SetMinLODClamp(uint32_t textureIndex, float clamp);
+
+    /// <summary>
+    /// The heap changes when it grows; bind it again every frame
+    /// </summary>
     ComPtr<ID3D12DescriptorHeap> GetSrvUavDescriptorHeap();
+    DescriptorAllocator &GetSrvUavDescriptors();
+
+    Result<TextureHandle> GetHandle(uint32_t textureIndex) const;
+    bool IsValid(TextureHandle handle) const;
+    /// <summary>
+    /// Binding path: the handles are precomputed, so these are a lookup in the texture table. A stale handle
+    /// or a view the texture doesn't have gives a null descriptor handle
+    /// </summary>
+    D3D12_GPU_DESCRIPTOR_HANDLE GetSrvGPUHandle(TextureHandle handle) const;
+    D3D12_GPU_DESCRIPTOR_HANDLE GetUavGPUHandle(TextureHandle handle) const;
+    D3D12_CPU_DESCRIPTOR_HANDLE GetRtvCPUHandle(TextureHandle handle) const;
+    D3D12_CPU_DESCRIPTOR_HANDLE GetDsvCPUHandle(TextureHandle handle) const;
+
+    /// <summary>
+    /// For bindless shaders: writes the descriptor index of the shader resource view of every texture index to
+    /// the upload ring, -1 where there's none, and returns its address. Indices are relative to GetBindlessTexturesHandle()
+    /// </summary>
+    Result<D3D12_GPU_VIRTUAL_ADDRESS> WriteBindlessTextureTable();
+    D3D12_GPU_DESCRIPTOR_HANDLE GetBindlessTexturesHandle() const;
+
     Result<D3D12_GPU_DESCRIPTOR_HANDLE> GetGPUDescriptorSrvHandleForTextureIndex(uint32_t textureIndex);
     Result<D3D12_CPU_DESCRIPTOR_HANDLE> GetCPUDescriptorSrvHandleForTextureIndex(uint32_t textureIndex);
     Result<D3D12_GPU_DESCRIPTOR_HANDLE> GetGPUDescriptorUavHandleForTextureIndex(uint32_t textureIndex);
@@ -53,10 +163,32 @@ public:
     Result<D3D12_GPU_DESCRIPTOR_HANDLE> GetGPUDescriptorDsvHandleForTextureIndex(uint32_t textureIndex);
     Result<D3D12_CPU_DESCRIPTOR_HANDLE> GetCPUDescriptorDsvHandleForTextureIndex(uint32_t textureIndex);
 
+private:
+    struct TextureInitializationParams;
+
 private:
     bool InitTextures(ID3D12GraphicsCommandList *cmdList, std::vector<ComPtr<ID3D12Resource>> &intermediaryResources);
     bool InitDescriptors();
 
+    bool PackAtlases(ID3D12GraphicsCommandList *cmdList, std::vector<DirectX::DDSTextureData> &textureData,
+                     const std::vector<HRESULT> &loadResults, std::vector<ComPtr<ID3D12Resource>> &intermediaryResources);
+    void AssignAtlasDescriptors();
+    Result<uint32_t> FindTextureWithSameContents(const std::filesystem::path &path, uintmax_t fileSize, uint32_t textureIndex);
+    /// <summary>
+    /// Removes textureIndex from the path and content lookups, so AddTexture() no longer deduplicates to it
+    /// </summary>
+    void ForgetTextureSources(uint32_t textureIndex);
+    Texture &GetTexture(uint32_t textureIndex);
+
+    uint32_t AddTextureSlot(TextureInitializationParams &&params);
+    bool CreateTexture(uint32_t textureIndex);
+    bool AllocateDescriptors(uint32_t textureIndex);
+    void FreeDescriptors(uint32_t textureIndex);
+    void RetireTexture(uint32_t textureIndex);
+    void UpdateDescriptorHandles(uint32_t textureIndex);
+    void RefreshDescriptorHandles();
+    void TrackTexture(uint32_t textureIndex);
+
     void InitAllViews(uint32_t descriptorIndex);
 
     bool InitAllViews();
@@ -105,16 +237,44 @@ private:
         } _InitializationType;
     };
 
-    ComPtr<ID3D12DescriptorHeap> mSrvUavDescriptorHeap;
-    ComPtr<ID3D12DescriptorHeap> mRtvDescriptorHeap;
-    ComPtr<ID3D12DescriptorHeap> mDsvDescriptorHeap;
+    DescriptorAllocator mSrvUavDescriptors;
+    DescriptorAllocator mRtvDescriptors;
+    DescriptorAllocator mDsvDescriptors;
 
     std::vector<TextureInitializationParams> mTexturesToLoad;
+    std::vector<uint32_t> mTextureReferences;
+    std::vector<uint32_t> mFreeTextureIndices;
+    // Textures removed or replaced; released when the frame that retired them comes around again
+    std::array<std::vector<Texture>, Direct3D::kBufferCount> mRetiredTextures;
+    uint32_t mFrameIndex = 0;
 
-    std::unordered_map<uint32_t, std::tuple<int32_t, int32_t, int32_t, int32_t>> mTextureIndexToHeapIndex;
+    // One entry per texture index. The handles are computed again when a descriptor heap grows
+    TextureTable mTextureTable;
+    std::array<uint32_t, 3> mDescriptorVersions = {};
 
     std::vector<Texture> mTextures;
 
+    struct AtlasEntry
+    {
+        uint32_t Page;
+        DirectX::XMFLOAT4 Rect;
+    };
+
+    bool mAtlasingEnabled = false;
+    std::vector<Texture> mAtlasPages;
+    std::vector<int32_t> mAtlasPageSrvIndices;
+    std::unordered_map<uint32_t, AtlasEntry> mAtlasEntries;
+    AtlasStatistics mAtlasStatistics;
+
+    // Path textures by canonical path, and by a hash of their contents. Files are only hashed once another
+    // file with the same size is added, the textures waiting for that are kept by size
+    std::unordered_map<std::wstring, uint32_t> mTexturesByPath;
+    std::unordered_map<uint64_t, uint32_t> mTexturesByContentHash;
+    std::unordered_map<uintmax_t, std::vector<uint32_t>> mUnhashedTexturesBySize;
+    DeduplicationStatistics mDeduplicationStatistics;
+
+    MemoryBudget mMemoryBudget;
+
     uint32_t mNumTextures = 0;
     uint32_t mNumCbvSrvUav = 0;
     uint32_t mNumRtv = 0;
@@ -0,0 +1,464 @@
+#include "TextureStreamer.h"
+#include "TextureManager.h"
+#include "Model.h"
+#include "Interfaces/ICamera.h"
+#include "Utils/AsyncUploader.h"
+#include "Profiler.h"
+#include "Conversions.h"
+
+static Result<ComPtr<ID3D12Heap>> CreateTileHeap(uint32_t numTiles)
+{
+    auto heapDesc = CD3DX12_HEAP_DESC((uint64_t)numTiles * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES, D3D12_HEAP_TYPE_DEFAULT, 0,
+                                      D3D12_HEAP_FLAG_DENY_BUFFERS | D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES);
+
+    ComPtr<ID3D12Heap> heap;
+    CHECK_HR(Direct3D::Get()->GetD3D12Device()->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap)), std::nullopt);
+    return heap;
+}
+
+static uint32_t GetTileCount(const D3D12_SUBRESOURCE_TILING &tiling)
+{
+    return tiling.WidthInTiles * tiling.HeightInTiles * tiling.DepthInTiles;
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    // Loads in flight write into the textures' pending state
+    for (auto &texture : mTextures)
+    {
+        if (texture->Load)
+        {
+            JobSystem::Get()->Wait(texture->Load->Counter);
+        }
+    }
+}
+
+bool TextureStreamer::Init(uint64_t budget)
+{
+    mBudget = budget;
+    mEnabled = Direct3D::Get()->GetTiledResourcesTier() != D3D12_TILED_RESOURCES_TIER_NOT_SUPPORTED;
+    if (!mEnabled)
+    {
+        SHOWWARNING("Tiled resources are not supported; every texture will be loaded with all its mips");
+    }
+    return true;
+}
+
+bool TextureStreamer::CanStream(ID3D12GraphicsCommandList *cmdList, const DirectX::DDSTextureData &textureData) const
+{
+    return mEnabled && cmdList && cmdList->GetType() == D3D12_COMMAND_LIST_TYPE_COPY &&
+        textureData.resDim == D3D12_RESOURCE_DIMENSION_TEXTURE2D && textureData.arraySize == 1 && !textureData.isCubeMap &&
+        textureData.mipCount > 1 && textureData.subresources.size() == textureData.mipCount &&
+        std::max(textureData.width, textureData.height) > kStartupMipSize;
+}
+
+bool TextureStreamer::AddTexture(uint32_t textureIndex, const std::wstring &path, ID3D12GraphicsCommandList *cmdList,
+                                 const DirectX::DDSTextureData &textureData, Texture &texture, ComPtr<ID3D12Resource> &intermediary)
+{
+    PROFILE_FUNCTION();
+    if (!CanStream(cmdList, textureData))
+    {
+        return false;
+    }
+
+    auto d3d = Direct3D::Get();
+
+    auto resourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(textureData.format, textureData.width, (uint32_t)textureData.height,
+                                                     1, (uint16_t)textureData.mipCount);
+    resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE;
+    CHECK(texture.InitReserved(resourceDesc), false, "Unable to create a reserved resource for {}", Conversions::ws2s(path));
+
+    auto streamed = std::make_unique<StreamedTexture>();
+    streamed->TextureIndex = textureIndex;
+    streamed->Path = path;
+    streamed->Resource = texture.GetResource();
+    streamed->MipCount = (uint32_t)textureData.mipCount;
+    streamed->Tilings.resize(streamed->MipCount);
+
+    UINT numTiles = 0;
+    UINT numSubresourceTilings = streamed->MipCount;
+    D3D12_PACKED_MIP_INFO packedMipInfo = {};
+    D3D12_TILE_SHAPE tileShape = {};
+    d3d->GetD3D12Device()->GetResourceTiling(streamed->Resource.Get(), &numTiles, &packedMipInfo, &tileShape,
+                                             &numSubresourceTilings, 0, streamed->Tilings.data());
+    streamed->NumStandardMips = packedMipInfo.NumStandardMips;
+    streamed->MipHeaps.resize(streamed->NumStandardMips);
+
+    // Everything up to kStartupMipSize is loaded now and never evicted. The packed mips can't be mapped
+    // one by one, so they're always part of it
+    uint32_t tailMip = 0;
+    while (tailMip + 1 < streamed->MipCount &&
+           std::max(textureData.width >> tailMip, textureData.height >> tailMip) > kStartupMipSize)
+    {
+        tailMip++;
+    }
+    tailMip = std::min(tailMip, streamed->NumStandardMips);
+    if (tailMip == 0)
+    {
+        // Every mip is packed; the caller loads the texture whole
+        return false;
+    }
+
+    for (uint32_t mip = tailMip; mip < streamed->NumStandardMips; ++mip)
+    {
+        CHECK(MapMip(*streamed, mip), false, "Unable to map mip {} of {}", mip, Conversions::ws2s(path));
+    }
+    if (packedMipInfo.NumPackedMips > 0)
+    {
+        ASSIGN_RESULT(streamed->PackedMipsHeap, CreateTileHeap(packedMipInfo.NumTilesForPackedMips), false,
+                      "Unable to create a heap for the packed mips of {}", Conversions::ws2s(path));
+        d3d->UpdateTileMappings(streamed->Resource.Get(), CD3DX12_TILED_RESOURCE_COORDINATE(0, 0, 0, streamed->NumStandardMips),
+                                packedMipInfo.NumTilesForPackedMips, streamed->PackedMipsHeap.Get());
+    }
+
+    CHECK(Upload(*streamed, cmdList, textureData, tailMip, streamed->MipCount, intermediary), false,
+          "Unable to upload the coarse mips of {}", Conversions::ws2s(path));
+    texture.SetMinLODClamp((float)tailMip);
+
+    TextureResidency::TextureDesc residencyDesc;
+    residencyDesc.Width = (uint32_t)textureData.width;
+    residencyDesc.Height = (uint32_t)textureData.height;
+    residencyDesc.MipCount = streamed->MipCount;
+    residencyDesc.TailMip = tailMip;
+    residencyDesc.MipSizes.resize(streamed->MipCount, 0);
+    for (uint32_t mip = 0; mip < streamed->NumStandardMips; ++mip)
+    {
+        residencyDesc.MipSizes[mip] = (uint64_t)GetTileCount(streamed->Tilings[mip]) * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+    }
+    if (packedMipInfo.NumPackedMips > 0)
+    {
+        residencyDesc.MipSizes[streamed->NumStandardMips] =
+            (uint64_t)packedMipInfo.NumTilesForPackedMips * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+    }
+
+    uint32_t streamedIndex = mResidency.AddTexture(residencyDesc);
+    mTextureIndexToStreamed[textureIndex] = streamedIndex;
+    mTextures.push_back(std::move(streamed));
+
+    return true;
+}
+
+void TextureStreamer::RemoveTexture(uint32_t textureIndex)
+{
+    auto it = mTextureIndexToStreamed.find(textureIndex);
+    if (it == mTextureIndexToStreamed.end())
+    {
+        return;
+    }
+
+    // The residency entry stays; nobody requests it anymore, so its mips go away with the usual delay
+    mTextures[it->second]->Removed = true;
+    TextureManager::Get()->GetMemoryBudget().Untrack(MemoryBudget::Category::StreamedTexture, textureIndex);
+    mTextureIndexToStreamed.erase(it);
+}
+
+void TextureStreamer::RequestTexture(uint32_t textureIndex, float screenSize)
+{
+    if (auto it = mTextureIndexToStreamed.find(textureIndex); it != mTextureIndexToStreamed.end())
+    {
+        mResidency.Request(it->second, screenSize);
+        TextureManager::Get()->GetMemoryBudget().Touch(textureIndex);
+    }
+}
+
+void TextureStreamer::RequestModel(const Model &model, const ICamera &camera, float viewportHeight)
+{
+    auto material = model.GetMaterial();
+    if (!material || mTextureIndexToStreamed.find(material->GetTextureIndex()) == mTextureIndexToStreamed.end())
+    {
+        return;
+    }
+
+    const auto &projection = camera.GetProjection();
+    const auto &cameraPosition = camera.GetPosition();
+    // Projection[1][1] scales view space y to NDC; w of the last row is 1 only for orthographic projections
+    float projectionScale = DirectX::XMVectorGetY(projection.r[1]);
+    bool orthographic = DirectX::XMVectorGetW(projection.r[3]) == 1.0f;
+
+    float screenSize = 0.0f;
+    for (uint32_t i = 0; i < model.GetInstanceCount(); ++i)
+    {
+        DirectX::BoundingSphere sphere;
+        model.GetBoundingSphere().Transform(sphere, model.GetInstanceInfo(i).WorldMatrix);
+
+        float pixelsPerUnit = projectionScale * viewportHeight * 0.5f;
+        if (!orthographic)
+        {
+            auto toSphere = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&sphere.Center), cameraPosition);
+            float distance = DirectX::XMVectorGetX(DirectX::XMVector3Length(toSphere)) - sphere.Radius;
+            pixelsPerUnit /= std::max(distance, 0.1f);
+        }
+        screenSize = std::max(screenSize, 2.0f * sphere.Radius * pixelsPerUnit);
+    }
+
+    RequestTexture(material->GetTextureIndex(), screenSize);
+}
+
+void TextureStreamer::Update()
+{
+    PROFILE_FUNCTION();
+    if (mTextures.empty())
+    {
+        return;
+    }
+    mFrame++;
+
+    auto uploader = AsyncUploader::Get();
+    bool recorded = false;
+
+    std::erase_if(mRetiredHeaps, [uploader](const RetiredHeaps &retired)
+                  {
+                      return uploader->IsComplete(retired.Ticket);
+                  });
+
+    // The shader resource views were clamped kBufferCount frames ago, so no frame in flight samples these mips anymore
+    for (auto it = mEvictions.begin(); it != mEvictions.end();)
+    {
+        if (mFrame - it->Frame >= (uint64_t)Direct3D::kBufferCount)
+        {
+            ReleaseEvictedMips(it->Texture);
+            it = mEvictions.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    // The heaps must outlive the unmapping, which runs on the copy queue before the next batch.
+    // If no batch can be opened, they wait for the next frame's
+    bool retireUnmappedHeaps = !mUnmappedHeaps.empty() && uploader->GetCommandList();
+    recorded |= retireUnmappedHeaps;
+
+    for (uint32_t i = 0; i < (uint32_t)mTextures.size(); ++i)
+    {
+        if (mTextures[i]->Load && mTextures[i]->Load->Counter.IsDone())
+        {
+            recorded |= FinishStreamIn(i);
+        }
+    }
+
+    mChanges.clear();
+    auto &memoryBudget = TextureManager::Get()->GetMemoryBudget();
+    EvictLeastRecentlyUsed(memoryBudget);
+
+    // Streaming only gets what the rest of the video memory leaves of the global budget
+    uint64_t otherBytes = memoryBudget.GetTotalBytes() - memoryBudget.GetBytes(MemoryBudget::Category::StreamedTexture);
+    uint64_t budget = memoryBudget.GetBudget() > otherBytes ? std::min(mBudget, memoryBudget.GetBudget() - otherBytes) : 0;
+    mResidency.Update(budget, kMaxStreamInBytesPerFrame, mChanges);
+    for (const auto &change : mChanges)
+    {
+        if (change.TargetMip > change.ResidentMip)
+        {
+            // Clamp now, unmap once the frames that still use the old view are done
+            SetMinLODClamp(*mTextures[change.Texture], change.TargetMip);
+            mEvictions.push_back({ change.Texture, mFrame });
+        }
+        else
+        {
+            StartStreamIn(change.Texture, change.TargetMip);
+        }
+    }
+
+    for (uint32_t i = 0; i < (uint32_t)mTextures.size(); ++i)
+    {
+        if (mTextures[i]->Removed)
+        {
+            continue;
+        }
+        // Mips streaming in already have their heaps
+        memoryBudget.TrackEvictable(mTextures[i]->TextureIndex, mResidency.GetBytes(i, mResidency.GetPendingMip(i)),
+                                    mResidency.GetBytes(i, mResidency.GetTailMip(i)));
+    }
+
+    if (recorded)
+    {
+        auto ticket = uploader->Submit();
+        CHECKRET(ticket.Valid(), "Unable to submit streamed mips");
+        if (retireUnmappedHeaps)
+        {
+            mRetiredHeaps.push_back({ ticket.Get(), std::move(mUnmappedHeaps) });
+            mUnmappedHeaps.clear();
+        }
+    }
+}
+
+void TextureStreamer::SetBudget(uint64_t budget)
+{
+    mBudget = budget;
+}
+
+uint64_t TextureStreamer::GetBudget() const
+{
+    return mBudget;
+}
+
+uint64_t TextureStreamer::GetResidentBytes() const
+{
+    return mResidency.GetResidentBytes();
+}
+
+uint64_t TextureStreamer::GetPendingBytes() const
+{
+    return mResidency.GetPendingBytes();
+}
+
+uint32_t TextureStreamer::GetTextureCount() const
+{
+    return (uint32_t)mTextures.size();
+}
+
+bool TextureStreamer::MapMip(StreamedTexture &texture, uint32_t mip)
+{
+    if (texture.MipHeaps[mip])
+    {
+        // Evicted, but not released yet
+        return true;
+    }
+
+    uint32_t numTiles = GetTileCount(texture.Tilings[mip]);
+    ASSIGN_RESULT(texture.MipHeaps[mip], CreateTileHeap(numTiles), false, "Unable to create a heap with {} tiles", numTiles);
+    Direct3D::Get()->UpdateTileMappings(texture.Resource.Get(), CD3DX12_TILED_RESOURCE_COORDINATE(0, 0, 0, mip),
+                                        numTiles, texture.MipHeaps[mip].Get());
+    return true;
+}
+
+bool TextureStreamer::Upload(StreamedTexture &texture, ID3D12GraphicsCommandList *cmdList, const DirectX::DDSTextureData &textureData,
+                             uint32_t firstMip, uint32_t lastMip, ComPtr<ID3D12Resource> &intermediary)
+{
+    uint32_t numMips = lastMip - firstMip;
+    auto uploadHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+    auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(GetRequiredIntermediateSize(texture.Resource.Get(), firstMip, numMips));
+    CHECK_HR(Direct3D::Get()->GetD3D12Device()->CreateCommittedResource(
+        &uploadHeapProperties, D3D12_HEAP_FLAG_NONE,
+        &bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
+        IID_PPV_ARGS(&intermediary)), false);
+
+    // UpdateSubresources wants a mutable array. Copy queues promote the texture to COPY_DEST by themselves
+    std::vector<D3D12_SUBRESOURCE_DATA> subresources(textureData.subresources.begin() + firstMip,
+                                                     textureData.subresources.begin() + lastMip);
+    CHECK(UpdateSubresources(cmdList, texture.Resource.Get(), intermediary.Get(), 0, firstMip, numMips, subresources.data()) != 0,
+          false, "Unable to record the upload of mips {} to {}", firstMip, lastMip - 1);
+    return true;
+}
+
+void TextureStreamer::SetMinLODClamp(const StreamedTexture &texture, uint32_t mip)
+{
+    if (texture.Removed)
+    {
+        return;
+    }
+
+    // Frames in flight keep reading the old view, which is fine: clamps only go down once the finer mips
+    // are uploaded and only go up kBufferCount frames before they're unmapped
+    TextureManager::Get()->SetMinLODClamp(texture.TextureIndex, (float)mip);
+}
+
+void TextureStreamer::StartStreamIn(uint32_t texture, uint32_t targetMip)
+{
+    auto &streamed = *mTextures[texture];
+    streamed.Load = std::make_unique<PendingLoad>();
+    streamed.Load->TargetMip = targetMip;
+
+    auto load = streamed.Load.get();
+    auto path = streamed.Path.c_str();
+    JobSystem::Get()->Schedule(load->Counter, [load, path]()
+                               {
+                                   PROFILE_SCOPE("StreamTextureMips");
+                                   load->Result = DirectX::LoadDDSTextureData(path, load->Data);
+                                   if (SUCCEEDED(load->Result))
+                                   {
+                                       // Textures without mips in the file were streamed with generated ones
+                                       Texture::GenerateMissingMips(load->Data);
+                                   }
+                               });
+}
+
+bool TextureStreamer::FinishStreamIn(uint32_t texture)
+{
+    PROFILE_FUNCTION();
+    auto &streamed = *mTextures[texture];
+    auto load = std::move(streamed.Load);
+    uint32_t targetMip = load->TargetMip;
+    uint32_t residentMip = mResidency.GetResidentMip(texture);
+
+    auto fail = [&](const std::string &reason)
+    {
+        SHOWWARNING("Unable to stream mips {} to {} of {}: {}", targetMip, residentMip - 1, Conversions::ws2s(streamed.Path), reason);
+        mResidency.OnStreamInFailed(texture);
+        // Releases whatever got mapped
+        mEvictions.push_back({ texture, mFrame });
+        return false;
+    };
+
+    if (FAILED(load->Result) || load->Data.mipCount != streamed.MipCount)
+    {
+        return fail("the file can't be loaded or changed");
+    }
+
+    for (uint32_t mip = targetMip; mip < residentMip; ++mip)
+    {
+        if (!MapMip(streamed, mip))
+        {
+            return fail("out of memory");
+        }
+    }
+
+    auto uploader = AsyncUploader::Get();
+    auto cmdList = uploader->GetCommandList();
+    ComPtr<ID3D12Resource> intermediary;
+    if (!cmdList || !Upload(streamed, cmdList, load->Data, targetMip, residentMip, intermediary))
+    {
+        return fail("the upload can't be recorded");
+    }
+
+    uploader->KeepAlive(intermediary);
+    uploader->OnComplete([this, texture, targetMip]()
+                         {
+                             SetMinLODClamp(*mTextures[texture], targetMip);
+                             mResidency.OnStreamedIn(texture, targetMip);
+                         });
+    return true;
+}
+
+void TextureStreamer::EvictLeastRecentlyUsed(MemoryBudget &memoryBudget)
+{
+    mSelectedEvictions.clear();
+    memoryBudget.SelectEvictions(mSelectedEvictions);
+    for (uint32_t textureIndex : mSelectedEvictions)
+    {
+        auto it = mTextureIndexToStreamed.find(textureIndex);
+        if (it == mTextureIndexToStreamed.end())
+        {
+            continue;
+        }
+
+        // Down to the mips that are always resident; the next request streams the rest in again
+        uint32_t tailMip = mResidency.GetTailMip(it->second);
+        uint64_t residentBytes = mResidency.GetBytes(it->second, mResidency.GetResidentMip(it->second));
+        TextureResidency::Change change;
+        if (mResidency.Evict(it->second, tailMip, change))
+        {
+            SetMinLODClamp(*mTextures[change.Texture], change.TargetMip);
+            mEvictions.push_back({ change.Texture, mFrame });
+            memoryBudget.OnEvicted(textureIndex, residentBytes - mResidency.GetBytes(it->second, tailMip));
+        }
+    }
+}
+
+void TextureStreamer::ReleaseEvictedMips(uint32_t texture)
+{
+    auto &streamed = *mTextures[texture];
+    auto d3d = Direct3D::Get();
+
+    // Mips that became resident or started streaming in again since the eviction are kept
+    uint32_t firstKeptMip = std::min(mResidency.GetPendingMip(texture), streamed.NumStandardMips);
+    for (uint32_t mip = 0; mip < firstKeptMip; ++mip)
+    {
+        if (streamed.MipHeaps[mip])
+        {
+            d3d->UpdateTileMappings(streamed.Resource.Get(), CD3DX12_TILED_RESOURCE_COORDINATE(0, 0, 0, mip),
+                                    GetTileCount(streamed.Tilings[mip]), nullptr);
+            mUnmappedHeaps.push_back(std::move(streamed.MipHeaps[mip]));
+        }
+    }
+}
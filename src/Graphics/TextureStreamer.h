@@ -0,0 +1,145 @@
+#pragma once
+
+
+#include <Oblivion.h>
+#include <ISingletone.h>
+
+#include "Texture.h"
+#include "JobSystem.h"
+#include "Utils/DDSTextureLoader.h"
+#include "Utils/TextureResidency.h"
+#include "Utils/MemoryBudget.h"
+
+class Model;
+class ICamera;
+
+/// <summary>
+/// Streams the mips of DDS textures in and out of memory. A streamed texture is a reserved resource:
+/// only its coarsest mips (everything up to kStartupMipSize and the packed tail) are uploaded at startup,
+/// finer mips get a heap of their own when TextureResidency asks for them. Their contents are read again
+/// from the file on the job system and copied on the copy queue. The shader resource view is clamped to
+/// the finest resident mip, so unmapped tiles are never sampled.
+/// Every frame, report the on-screen size of what's drawn with RequestModel / RequestTexture, then call Update().
+/// Streamed textures are also accounted in the memory budget of TextureManager; when it runs over, the least
+/// recently requested ones drop back to their tail mips.
+/// </summary>
+class TextureStreamer : public ISingletone<TextureStreamer>
+{
+    MAKE_SINGLETONE_CAPABLE(TextureStreamer);
+
+public:
+    static constexpr const uint64_t kDefaultBudget = _256MiB;
+    static constexpr const uint64_t kMaxStreamInBytesPerFrame = _16MiB;
+    static constexpr const uint32_t kStartupMipSize = 128;
+
+private:
+    struct PendingLoad
+    {
+        JobCounter Counter;
+        HRESULT Result = S_OK;
+        DirectX::DDSTextureData Data;
+        uint32_t TargetMip = 0;
+    };
+
+    struct StreamedTexture
+    {
+        uint32_t TextureIndex;
+        std::wstring Path;
+        ComPtr<ID3D12Resource> Resource;
+        uint32_t MipCount;
+        uint32_t NumStandardMips;
+        std::vector<D3D12_SUBRESOURCE_TILING> Tilings;
+        // One heap for every standard mip that is mapped, plus one for the packed mips
+        std::vector<ComPtr<ID3D12Heap>> MipHeaps;
+        ComPtr<ID3D12Heap> PackedMipsHeap;
+        std::unique_ptr<PendingLoad> Load;
+        // Set once TextureManager replaced the texture. Its views must not be touched anymore
+        bool Removed = false;
+    };
+
+    struct Eviction
+    {
+        uint32_t Texture;
+        uint64_t Frame;
+    };
+
+    // Heaps of unmapped mips, released once the copy batch submitted after the unmapping is done
+    struct RetiredHeaps
+    {
+        uint64_t Ticket;
+        std::vector<ComPtr<ID3D12Heap>> Heaps;
+    };
+
+private:
+    TextureStreamer() = default;
+    ~TextureStreamer();
+
+public:
+    bool Init(uint64_t budget = kDefaultBudget);
+
+    /// <summary>
+    /// Returns false if textureData can't be streamed; it should be loaded whole instead.
+    /// Streaming needs tiled resources, a copy command list and a 2D texture with no array slices
+    /// </summary>
+    bool CanStream(ID3D12GraphicsCommandList *cmdList, const DirectX::DDSTextureData &textureData) const;
+    /// <summary>
+    /// Creates texture as a reserved resource and records the upload of its coarse mips on cmdList,
+    /// which must belong to the copy queue. Returns false if the texture turned out not to be streamable
+    /// </summary>
+    bool AddTexture(uint32_t textureIndex, const std::wstring &path, ID3D12GraphicsCommandList *cmdList,
+                    const DirectX::DDSTextureData &textureData, Texture &texture, ComPtr<ID3D12Resource> &intermediary);
+    /// <summary>
+    /// Stops streaming textureIndex, for when TextureManager replaces it
+    /// </summary>
+    void RemoveTexture(uint32_t textureIndex);
+
+    /// <summary>
+    /// Reports that textureIndex covers screenSize pixels along its largest side this frame
+    /// </summary>
+    void RequestTexture(uint32_t textureIndex, float screenSize);
+    /// <summary>
+    /// Requests the texture of model's material with the size of its largest instance on screen.
+    /// Assumes the texture is mapped once over the model
+    /// </summary>
+    void RequestModel(const Model &model, const ICamera &camera, float viewportHeight);
+
+    /// <summary>
+    /// Applies the residency changes for this frame's requests. Call once per frame, after the
+    /// fence of the frame resource was waited on and after every request was made
+    /// </summary>
+    void Update();
+
+public:
+    void SetBudget(uint64_t budget);
+    uint64_t GetBudget() const;
+    uint64_t GetResidentBytes() const;
+    uint64_t GetPendingBytes() const;
+    uint32_t GetTextureCount() const;
+
+private:
+    bool MapMip(StreamedTexture &texture, uint32_t mip);
+    bool Upload(StreamedTexture &texture, ID3D12GraphicsCommandList *cmdList, const DirectX::DDSTextureData &textureData,
+                uint32_t firstMip, uint32_t lastMip, ComPtr<ID3D12Resource> &intermediary);
+    void SetMinLODClamp(const StreamedTexture &texture, uint32_t mip);
+
+    void StartStreamIn(uint32_t texture, uint32_t targetMip);
+    bool FinishStreamIn(uint32_t texture);
+    void EvictLeastRecentlyUsed(MemoryBudget &memoryBudget);
+    void ReleaseEvictedMips(uint32_t texture);
+
+private:
+    bool mEnabled = false;
+    uint64_t mBudget = kDefaultBudget;
+    uint64_t mFrame = 0;
+
+    TextureResidency mResidency;
+    std::vector<std::unique_ptr<StreamedTexture>> mTextures;
+    std::unordered_map<uint32_t, uint32_t> mTextureIndexToStreamed;
+
+    std::vector<Eviction> mEvictions;
+    // Unmapped this frame, waiting for a batch to be submitted after the unmapping
+    std::vector<ComPtr<ID3D12Heap>> mUnmappedHeaps;
+    std::vector<RetiredHeaps> mRetiredHeaps;
+    std::vector<TextureResidency::Change> mChanges;
+    std::vector<uint32_t> mSelectedEvictions;
+};
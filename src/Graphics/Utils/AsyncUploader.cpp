@@ -0,0 +1,148 @@
+#include "AsyncUploader.h"
+#include "Profiler.h"
+
+bool AsyncUploader::Init()
+{
+    auto d3d = Direct3D::Get();
+
+    for (uint32_t i = 0; i < mBatches.size(); ++i)
+    {
+        ASSIGN_RESULT(mBatches[i].Allocator, d3d->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY),
+                      false, "Unable to create copy command allocator {}", i);
+    }
+
+    ASSIGN_RESULT(mCommandList, d3d->CreateCommandList(mBatches[0].Allocator.Get(), D3D12_COMMAND_LIST_TYPE_COPY),
+                  false, "Unable to create copy command list");
+    CHECK_HR(mCommandList->Close(), false);
+
+    ASSIGN_RESULT(mFence, d3d->CreateFence(0), false, "Unable to create copy fence");
+
+    mLastSubmittedValue = 0;
+    mCurrentBatch = 0;
+    mRecording = false;
+    return true;
+}
+
+ID3D12GraphicsCommandList *AsyncUploader::GetCommandList()
+{
+    if (!mRecording)
+    {
+        CHECK(OpenBatch(), nullptr, "Unable to open a new upload batch");
+    }
+    return mCommandList.Get();
+}
+
+void AsyncUploader::KeepAlive(ComPtr<ID3D12Resource> resource)
+{
+    CHECKRET(mRecording, "Cannot keep a resource alive without an open upload batch");
+    if (resource)
+    {
+        mBatches[mCurrentBatch].Resources.push_back(resource);
+    }
+}
+
+void AsyncUploader::OnComplete(std::function<void()> callback)
+{
+    CHECKRET(mRecording, "Cannot add a completion callback without an open upload batch");
+    mBatches[mCurrentBatch].Callbacks.push_back(std::move(callback));
+}
+
+Result<uint64_t> AsyncUploader::Submit()
+{
+    PROFILE_FUNCTION();
+    if (!mRecording)
+    {
+        return uint64_t(mLastSubmittedValue);
+    }
+
+    auto d3d = Direct3D::Get();
+    auto &batch = mBatches[mCurrentBatch];
+
+    CHECK_HR(mCommandList->Close(), std::nullopt);
+    d3d->ExecuteCopyCommandList(mCommandList.Get());
+
+    batch.FenceValue = ++mLastSubmittedValue;
+    d3d->SignalCopy(mFence.Get(), batch.FenceValue);
+
+    mCurrentBatch = (mCurrentBatch + 1) % kMaxBatchesInFlight;
+    mRecording = false;
+
+    return uint64_t(batch.FenceValue);
+}
+
+bool AsyncUploader::IsComplete(uint64_t ticket) const
+{
+    return mFence->GetCompletedValue() >= ticket;
+}
+
+void AsyncUploader::WaitOnDirectQueue(uint64_t ticket)
+{
+    if (IsComplete(ticket))
+    {
+        return;
+    }
+    Direct3D::Get()->WaitOnDirectQueue(mFence.Get(), ticket);
+}
+
+void AsyncUploader::Poll()
+{
+    uint64_t completedValue = mFence->GetCompletedValue();
+    for (auto &batch : mBatches)
+    {
+        if (batch.FenceValue != 0 && batch.FenceValue <= completedValue)
+        {
+            RetireBatch(batch);
+        }
+    }
+}
+
+void AsyncUploader::Flush()
+{
+    PROFILE_FUNCTION();
+    auto submitResult = Submit();
+    CHECKRET(submitResult.Valid(), "Unable to submit pending uploads");
+
+    Direct3D::Get()->WaitForFenceValue(mFence.Get(), mLastSubmittedValue);
+    Poll();
+}
+
+uint32_t AsyncUploader::GetBatchesInFlight() const
+{
+    uint32_t batchesInFlight = 0;
+    for (const auto &batch : mBatches)
+    {
+        if (batch.FenceValue != 0)
+        {
+            batchesInFlight++;
+        }
+    }
+    return batchesInFlight;
+}
+
+bool AsyncUploader::OpenBatch()
+{
+    auto &batch = mBatches[mCurrentBatch];
+    if (batch.FenceValue != 0)
+    {
+        // Every batch is in flight; wait for the oldest one
+        PROFILE_SCOPE("WaitForUploadBatch");
+        Direct3D::Get()->WaitForFenceValue(mFence.Get(), batch.FenceValue);
+        RetireBatch(batch);
+    }
+
+    CHECK_HR(batch.Allocator->Reset(), false);
+    CHECK_HR(mCommandList->Reset(batch.Allocator.Get(), nullptr), false);
+    mRecording = true;
+    return true;
+}
+
+void AsyncUploader::RetireBatch(Batch &batch)
+{
+    batch.Resources.clear();
+    for (auto &callback : batch.Callbacks)
+    {
+        callback();
+    }
+    batch.Callbacks.clear();
+    batch.FenceValue = 0;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+
+#include <Oblivion.h>
+#include <ISingletone.h>
+#include "../Direct3D.h"
+
+/// <summary>
+/// Records uploads on the copy queue, so they run while the application keeps initializing or rendering.
+/// Usage: record copies on GetCommandList(), keep the intermediary resources alive with KeepAlive(),
+/// then Submit(). Before the direct queue touches the uploaded resources, call WaitOnDirectQueue() with
+/// the returned ticket. Completion callbacks and intermediary releases happen in Poll().
+/// Not thread safe; use it from the thread that owns the frame loop.
+/// </summary>
+class AsyncUploader : public ISingletone<AsyncUploader>
+{
+    MAKE_SINGLETONE_CAPABLE(AsyncUploader);
+
+public:
+    static constexpr const uint32_t kMaxBatchesInFlight = 4;
+
+private:
+    struct Batch
+    {
+        ComPtr<ID3D12CommandAllocator> Allocator;
+        uint64_t FenceValue = 0;
+        std::vector<ComPtr<ID3D12Resource>> Resources;
+        std::vector<std::function<void()>> Callbacks;
+    };
+
+private:
+    AsyncUploader() = default;
+    ~AsyncUploader() = default;
+
+public:
+    bool Init();
+
+    /// <summary>
+    /// Returns the copy command list of the current batch, opening a new batch if needed
+    /// </summary>
+    ID3D12GraphicsCommandList *GetCommandList();
+    void KeepAlive(ComPtr<ID3D12Resource> resource);
+    /// <summary>
+    /// Called from Poll() once the current batch has finished executing on the GPU
+    /// </summary>
+    void OnComplete(std::function<void()> callback);
+
+    /// <summary>
+    /// Submits the current batch to the copy queue and returns its ticket. Returns the last
+    /// submitted ticket if there is nothing to submit
+    /// </summary>
+    Result<uint64_t> Submit();
+
+    bool IsComplete(uint64_t ticket) const;
+    void WaitOnDirectQueue(uint64_t ticket);
+    /// <summary>
+    /// Releases intermediary resources and runs the callbacks of every finished batch
+    /// </summary>
+    void Poll();
+    /// <summary>
+    /// Blocks the CPU until every submitted batch finished
+    /// </summary>
+    void Flush();
+
+public:
+    uint32_t GetBatchesInFlight() const;
+
+private:
+    bool OpenBatch();
+    void RetireBatch(Batch &batch);
+
+private:
+    ComPtr<ID3D12GraphicsCommandList> mCommandList;
+    ComPtr<ID3D12Fence> mFence;
+    uint64_t mLastSubmittedValue = 0;
+
+    std::array<Batch, kMaxBatchesInFlight> mBatches;
+    uint32_t mCurrentBatch = 0;
+    bool mRecording = false;
+};
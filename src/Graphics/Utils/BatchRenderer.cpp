@@ -4,8 +4,7 @@
 
 bool BatchRenderer::Create(uint32_t maxVertices)
 {
-    mMaxVertices = maxVertices;
-    CHECKSIMPLE(Reconstruct(mMaxVertices));
+    mVertices.reserve(maxVertices);
     return true;
 }
 
@@ -16,19 +15,16 @@ void BatchRenderer::Begin()
 
 bool BatchRenderer::Vertex(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT4& color)
 {
-    CHECK(mCurrentIndex < mMaxVertices, false,
-        "Cannot add vertex (Position = {}, Color = {}) to batch renderer, cause it's already full (size = {}, capacity = {}).",
-        position, color, mCurrentIndex, mMaxVertices);
-    auto* vertex = mVertexBuffer.GetMappedMemory(mCurrentIndex);
+    // Keep the vector's size from previous frames, so steady state frames only overwrite
+    if (mCurrentIndex >= mVertices.size())
+    {
+        mVertices.emplace_back();
+    }
+    auto* vertex = &mVertices[mCurrentIndex];
     vertex->Position = position;
     vertex->Color = color;
 
     mCurrentIndex++;
-    if (mCurrentIndex >= mMaxVertices)
-    {
-        CHECK(ReconstructAndCopy(mMaxVertices * 10), true,
-            "Cannot reconstruct & copy after adding vertex (Position = {}, Color = {}). Future Vertex() calls will fail.", position, color);
-    }
     return true;
 }
 
@@ -153,8 +149,12 @@ bool BatchRenderer::End(ID3D12GraphicsCommandList* cmdList)
         return true;
     }
 
+    auto vertexAllocation = UploadRingBuffer::Get()->AllocateArray<PositionColorVertex>(mCurrentIndex);
+    CHECK(vertexAllocation.Valid(), false, "Unable to allocate {} vertices for batch renderer", mCurrentIndex);
+    memcpy(vertexAllocation.CPU, mVertices.data(), sizeof(PositionColorVertex) * mCurrentIndex);
+
     D3D12_VERTEX_BUFFER_VIEW vbView = {};
-    vbView.BufferLocation = mVertexBuffer.GetGPUVirtualAddress();
+    vbView.BufferLocation = vertexAllocation.GPU;
     vbView.SizeInBytes = sizeof(PositionColorVertex) * mCurrentIndex;
     vbView.StrideInBytes = sizeof(PositionColorVertex);
     cmdList->IASetVertexBuffers(0, 1, &vbView);
@@ -164,36 +164,3 @@ bool BatchRenderer::End(ID3D12GraphicsCommandList* cmdList)
 
     return true;
 }
-
-bool BatchRenderer::Reconstruct(uint32_t maxVertices)
-{
-    CHECK(mVertexBuffer.Init(maxVertices), false, "Unable to initialize vertex buffer for batch renderer");
-    return true;
-}
-
-bool BatchRenderer::ReconstructAndCopy(uint32_t maxVertices)
-{
-    CHECK(maxVertices >= mMaxVertices, true, "Batch renderer already at size {} or more ({})", maxVertices, mMaxVertices);
-    mMaxVertices = maxVertices;
-    if (mVertexBuffer.GetElementCount() > 0)
-    {
-        CHECKSIMPLE(Reconstruct(maxVertices));
-
-        auto mappedMemory = mVertexBuffer.GetMappedMemory();
-        std::vector<PositionColorVertex> vertices(mappedMemory, mappedMemory + mCurrentIndex);
-        for (uint32_t i = 0; i < mCurrentIndex; ++i)
-        {
-            auto* destination = mVertexBuffer.GetMappedMemory(i);
-            *destination = vertices[i];
-        }
-    }
-    else
-    {
-        CHECKSIMPLE(Reconstruct(maxVertices));
-    }
-
-
-    return true;
-}
-
-
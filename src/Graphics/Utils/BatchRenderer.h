@@ -3,7 +3,7 @@
 
 #include <Oblivion.h>
 #include <ISingletone.h>
-#include <Utils/UploadBuffer.h>
+#include <Utils/UploadRingBuffer.h>
 #include "../Vertex.h"
 #include "PipelineManager.h"
 
@@ -30,14 +30,10 @@ public:
     /// <returns>true if the rendering could be submitted to the command list, false otherwise</returns>
     bool End(ID3D12GraphicsCommandList* cmdList);
 
-private:
-    bool Reconstruct(uint32_t maxVertices);
-    bool ReconstructAndCopy(uint32_t maxVertices);
-
 public:
     uint32_t mCurrentIndex = 0;
-    uint32_t mMaxVertices;
-    UploadBuffer<PositionColorVertex> mVertexBuffer;
+    // Vertices are gathered on the CPU and copied to the upload ring in End()
+    std::vector<PositionColorVertex> mVertices;
     
 
 };
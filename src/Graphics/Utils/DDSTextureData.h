@@ -0,0 +1,49 @@
+#pragma once
+
+
+#include "DDSPlatform.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/// <summary>
+/// The part of the DDS loader that doesn't need a device: reading the file, validating the header and laying out
+/// the subresources. DDSTextureLoader creates the resources from what's loaded here
+/// </summary>
+namespace DirectX
+{
+    enum DDS_ALPHA_MODE
+    {
+        DDS_ALPHA_MODE_UNKNOWN       = 0,
+        DDS_ALPHA_MODE_STRAIGHT      = 1,
+        DDS_ALPHA_MODE_PREMULTIPLIED = 2,
+        DDS_ALPHA_MODE_OPAQUE        = 3,
+        DDS_ALPHA_MODE_CUSTOM        = 4,
+    };
+
+	// Contents of a DDS file, read and validated without touching the device. Loading can run on
+	// any thread; the resource is created later by CreateDDSTextureFromData12. Subresources point into fileData,
+	// which is a read-only mapping of the file, or a heap copy when the file can't be mapped
+	struct DDSTextureData
+	{
+		std::shared_ptr<const uint8_t> fileData;
+		uint32_t resDim = 0;
+		size_t width = 0;
+		size_t height = 0;
+		size_t depth = 0;
+		size_t mipCount = 0;
+		size_t arraySize = 0;
+		DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+		bool isCubeMap = false;
+		DDS_ALPHA_MODE alphaMode = DDS_ALPHA_MODE_UNKNOWN;
+		std::vector<D3D12_SUBRESOURCE_DATA> subresources;
+	};
+
+	// mapFile = false reads the whole file into a heap buffer instead, which is also the fallback for files that can't be mapped
+	HRESULT LoadDDSTextureData(_In_z_ const wchar_t* szFileName,
+		                       _Out_ DDSTextureData& textureData,
+		                       _In_ size_t maxsize = 0,
+		                       _In_ bool mapFile = true
+		                       );
+}
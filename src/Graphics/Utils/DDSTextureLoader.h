@@ -25,10 +25,13 @@
 #include <wrl.h>
 #include <d3d11_1.h>
 #include "d3dx12.h"
+#include "DDSTextureData.h"
 
 #pragma warning(push)
 #pragma warning(disable : 4005)
 #include <stdint.h>
+#include <memory>
+#include <vector>
 
 #pragma warning(pop)
 
@@ -46,15 +49,6 @@
 
 namespace DirectX
 {
-    enum DDS_ALPHA_MODE
-    {
-        DDS_ALPHA_MODE_UNKNOWN       = 0,
-        DDS_ALPHA_MODE_STRAIGHT      = 1,
-        DDS_ALPHA_MODE_PREMULTIPLIED = 2,
-        DDS_ALPHA_MODE_OPAQUE        = 3,
-        DDS_ALPHA_MODE_CUSTOM        = 4,
-    };
-
     // Standard version
     HRESULT CreateDDSTextureFromMemory( _In_ ID3D11Device* d3dDevice,
                                         _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
@@ -92,6 +86,13 @@ namespace DirectX
 		                               _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
 		                               );
 
+	HRESULT CreateDDSTextureFromData12(_In_ ID3D12Device* device,
+		                               _In_ ID3D12GraphicsCommandList* cmdList,
+		                               _In_ const DDSTextureData& textureData,
+		                               _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& texture,
+		                               _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& textureUploadHeap
+		                               );
+
     // Standard version with optional auto-gen mipmap support
     HRESULT CreateDDSTextureFromMemory( _In_ ID3D11Device* d3dDevice,
                                         _In_opt_ ID3D11DeviceContext* d3dContext,
@@ -0,0 +1,142 @@
+#include "DescriptorAllocator.h"
+
+bool DescriptorAllocator::Init(D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t persistentCapacity, uint32_t transientCapacity)
+{
+    auto d3d = Direct3D::Get();
+    mType = type;
+    mShaderVisible = type == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV || type == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER;
+    mDescriptorSize = d3d->GetD3D12Device()->GetDescriptorHandleIncrementSize(type);
+    mFrameIndex = 0;
+
+    // Apparently PIX doesn't like it when heaps with 0 descriptors are created
+    mRanges.Init(0, transientCapacity, Direct3D::kBufferCount);
+    mCPUHeap.Reset();
+    mGPUHeap.Reset();
+    CHECK(Grow(std::max(persistentCapacity, 1u)), false, "Unable to create a descriptor heap of type {} with {} descriptors",
+          (uint32_t)type, persistentCapacity);
+
+    return true;
+}
+
+Result<uint32_t> DescriptorAllocator::Allocate(uint32_t count)
+{
+    uint32_t index = mRanges.Allocate(count);
+    if (index == DescriptorRangeAllocator::kInvalidOffset)
+    {
+        // Doubling keeps the number of copies low when many textures are added one after the other
+        uint32_t persistentCapacity = std::max(mRanges.GetPersistentCapacity() * 2, mRanges.GetPersistentCapacity() + count);
+        CHECK(Grow(persistentCapacity), std::nullopt, "Unable to grow descriptor heap of type {} to {} descriptors",
+              (uint32_t)mType, persistentCapacity);
+        index = mRanges.Allocate(count);
+        CHECK(index != DescriptorRangeAllocator::kInvalidOffset, std::nullopt, "Unable to allocate {} descriptors", count);
+    }
+    return index;
+}
+
+void DescriptorAllocator::Free(uint32_t index, uint32_t count)
+{
+    mRanges.Free(index, count);
+}
+
+Result<uint32_t> DescriptorAllocator::AllocateTransient(uint32_t count)
+{
+    uint32_t index = mRanges.AllocateTransient(count);
+    CHECK(index != DescriptorRangeAllocator::kInvalidOffset, std::nullopt,
+          "Unable to allocate {} transient descriptors. {} of {} are used this frame",
+          count, mRanges.GetTransientUsed(), mRanges.GetTransientCapacity());
+    return index;
+}
+
+void DescriptorAllocator::BeginFrame(uint32_t frameIndex)
+{
+    mFrameIndex = frameIndex;
+    mRetiredHeaps[frameIndex].clear();
+    mRanges.BeginFrame(frameIndex);
+}
+
+void DescriptorAllocator::Commit(uint32_t index, uint32_t count)
+{
+    if (!mShaderVisible)
+    {
+        return;
+    }
+
+    auto device = Direct3D::Get()->GetD3D12Device();
+    CD3DX12_CPU_DESCRIPTOR_HANDLE destination(mGPUHeap->GetCPUDescriptorHandleForHeapStart(), (INT)index, mDescriptorSize);
+    device->CopyDescriptorsSimple(count, destination, GetCPUHandle(index), mType);
+}
+
+bool DescriptorAllocator::Valid() const
+{
+    return mCPUHeap != nullptr;
+}
+
+ID3D12DescriptorHeap *DescriptorAllocator::GetHeap() const
+{
+    return mShaderVisible ? mGPUHeap.Get() : mCPUHeap.Get();
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorAllocator::GetCPUHandle(uint32_t index) const
+{
+    return CD3DX12_CPU_DESCRIPTOR_HANDLE(mCPUHeap->GetCPUDescriptorHandleForHeapStart(), (INT)index, mDescriptorSize);
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE DescriptorAllocator::GetGPUHandle(uint32_t index) const
+{
+    if (!mShaderVisible)
+    {
+        return D3D12_GPU_DESCRIPTOR_HANDLE{};
+    }
+    return CD3DX12_GPU_DESCRIPTOR_HANDLE(mGPUHeap->GetGPUDescriptorHandleForHeapStart(), (INT)index, mDescriptorSize);
+}
+
+const DescriptorRangeAllocator &DescriptorAllocator::GetRanges() const
+{
+    return mRanges;
+}
+
+uint32_t DescriptorAllocator::GetVersion() const
+{
+    return mVersion;
+}
+
+bool DescriptorAllocator::Grow(uint32_t persistentCapacity)
+{
+    auto d3d = Direct3D::Get();
+    auto device = d3d->GetD3D12Device();
+
+    uint32_t oldCapacity = mRanges.GetCapacity();
+    uint32_t capacity = oldCapacity + persistentCapacity - mRanges.GetPersistentCapacity();
+
+    ComPtr<ID3D12DescriptorHeap> cpuHeap;
+    ASSIGN_RESULT(cpuHeap, d3d->CreateDescriptorHeap(capacity, mType), false,
+                  "Unable to create a CPU descriptor heap with {} descriptors", capacity);
+    ComPtr<ID3D12DescriptorHeap> gpuHeap;
+    if (mShaderVisible)
+    {
+        ASSIGN_RESULT(gpuHeap, d3d->CreateDescriptorHeap(capacity, mType, D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE), false,
+                      "Unable to create a shader visible descriptor heap with {} descriptors", capacity);
+    }
+
+    if (mCPUHeap)
+    {
+        // Shader visible heaps can't be copied from, so everything goes through the CPU heap
+        device->CopyDescriptorsSimple(oldCapacity, cpuHeap->GetCPUDescriptorHandleForHeapStart(),
+                                      mCPUHeap->GetCPUDescriptorHandleForHeapStart(), mType);
+        if (mShaderVisible)
+        {
+            device->CopyDescriptorsSimple(oldCapacity, gpuHeap->GetCPUDescriptorHandleForHeapStart(),
+                                          cpuHeap->GetCPUDescriptorHandleForHeapStart(), mType);
+        }
+        SHOWINFO("Grew descriptor heap of type {} from {} to {} descriptors", (uint32_t)mType, oldCapacity, capacity);
+
+        mRetiredHeaps[mFrameIndex].push_back(mCPUHeap);
+        mRetiredHeaps[mFrameIndex].push_back(mGPUHeap);
+    }
+
+    mCPUHeap = cpuHeap;
+    mGPUHeap = gpuHeap;
+    mRanges.Grow(persistentCapacity);
+    mVersion++;
+    return true;
+}
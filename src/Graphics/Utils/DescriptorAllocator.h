@@ -0,0 +1,68 @@
+#pragma once
+
+
+#include <Oblivion.h>
+#include "../Direct3D.h"
+#include "DescriptorRangeAllocator.h"
+
+/// <summary>
+/// Descriptor heap of one type that grows on demand, with the indices handed out by a DescriptorRangeAllocator.
+/// Views are written to a CPU only heap through GetCPUHandle() and copied to the shader visible heap by Commit(),
+/// so a full heap can be replaced with a larger copy. Replaced heaps stay alive until the frames in flight are done
+/// with them. GetHeap() and the GPU handles change when the heap grows, so fetch them every frame.
+/// RTV and DSV heaps are never shader visible; they only have the CPU heap and Commit() does nothing
+/// </summary>
+class DescriptorAllocator
+{
+public:
+    bool Init(D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t persistentCapacity, uint32_t transientCapacity = 0);
+
+    /// <summary>
+    /// Returns the first of count consecutive descriptors, growing the heap if needed
+    /// </summary>
+    Result<uint32_t> Allocate(uint32_t count = 1);
+    /// <summary>
+    /// The descriptors are reused once the current frame comes around again
+    /// </summary>
+    void Free(uint32_t index, uint32_t count = 1);
+    /// <summary>
+    /// Returns the first of count consecutive descriptors that are valid until the current frame comes around again
+    /// </summary>
+    Result<uint32_t> AllocateTransient(uint32_t count = 1);
+    /// <summary>
+    /// Must be called after waiting for the fence of the frame resource at frameIndex
+    /// </summary>
+    void BeginFrame(uint32_t frameIndex);
+
+    /// <summary>
+    /// Copies the views written at the CPU handles of [index, index + count) to the shader visible heap
+    /// </summary>
+    void Commit(uint32_t index, uint32_t count = 1);
+
+public:
+    bool Valid() const;
+    ID3D12DescriptorHeap *GetHeap() const;
+    D3D12_CPU_DESCRIPTOR_HANDLE GetCPUHandle(uint32_t index) const;
+    D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHandle(uint32_t index) const;
+    const DescriptorRangeAllocator &GetRanges() const;
+    /// <summary>
+    /// Changes every time the heap is replaced; handles taken before are stale afterwards
+    /// </summary>
+    uint32_t GetVersion() const;
+
+private:
+    bool Grow(uint32_t persistentCapacity);
+
+private:
+    D3D12_DESCRIPTOR_HEAP_TYPE mType = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    bool mShaderVisible = false;
+    uint32_t mDescriptorSize = 0;
+    DescriptorRangeAllocator mRanges;
+
+    ComPtr<ID3D12DescriptorHeap> mCPUHeap;
+    ComPtr<ID3D12DescriptorHeap> mGPUHeap;
+    // Heaps replaced when growing; released when the frame that replaced them comes around again
+    std::array<std::vector<ComPtr<ID3D12DescriptorHeap>>, Direct3D::kBufferCount> mRetiredHeaps;
+    uint32_t mFrameIndex = 0;
+    uint32_t mVersion = 0;
+};
@@ -0,0 +1,158 @@
+#include "DescriptorRangeAllocator.h"
+
+#include <algorithm>
+
+void DescriptorRangeAllocator::Init(uint32_t persistentCapacity, uint32_t transientCapacity, uint32_t frameCount)
+{
+    mPersistentCapacity = 0;
+    mTransientCapacity = transientCapacity;
+    mFrameCount = std::max(frameCount, 1u);
+    mFrameIndex = 0;
+
+    mFreeRanges.clear();
+    mPendingFrees.assign(mFrameCount, {});
+    mTransientUsed.assign(mFrameCount, 0);
+    mAllocatedCount = 0;
+    mPendingFreeCount = 0;
+
+    Grow(persistentCapacity);
+}
+
+uint32_t DescriptorRangeAllocator::Allocate(uint32_t count)
+{
+    if (count == 0)
+    {
+        return kInvalidOffset;
+    }
+
+    for (auto it = mFreeRanges.begin(); it != mFreeRanges.end(); ++it)
+    {
+        auto [offset, freeCount] = *it;
+        if (freeCount < count)
+        {
+            continue;
+        }
+
+        mFreeRanges.erase(it);
+        if (freeCount > count)
+        {
+            mFreeRanges.emplace(offset + count, freeCount - count);
+        }
+        mAllocatedCount += count;
+        return offset;
+    }
+    return kInvalidOffset;
+}
+
+void DescriptorRangeAllocator::Free(uint32_t offset, uint32_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    mPendingFrees[mFrameIndex].push_back({ offset, count });
+    mPendingFreeCount += count;
+}
+
+void DescriptorRangeAllocator::Grow(uint32_t persistentCapacity)
+{
+    if (persistentCapacity <= mPersistentCapacity)
+    {
+        return;
+    }
+
+    uint32_t firstNewIndex = mTransientCapacity * mFrameCount + mPersistentCapacity;
+    uint32_t addedCount = persistentCapacity - mPersistentCapacity;
+    mPersistentCapacity = persistentCapacity;
+    // Counted as allocated, so Release() can treat it like any other range
+    mAllocatedCount += addedCount;
+    Release(firstNewIndex, addedCount);
+}
+
+void DescriptorRangeAllocator::BeginFrame(uint32_t frameIndex)
+{
+    mFrameIndex = frameIndex % mFrameCount;
+
+    for (const auto &pendingFree : mPendingFrees[mFrameIndex])
+    {
+        Release(pendingFree.Offset, pendingFree.Count);
+        mPendingFreeCount -= pendingFree.Count;
+    }
+    mPendingFrees[mFrameIndex].clear();
+    mTransientUsed[mFrameIndex] = 0;
+}
+
+uint32_t DescriptorRangeAllocator::AllocateTransient(uint32_t count)
+{
+    uint32_t &used = mTransientUsed[mFrameIndex];
+    if (count == 0 || used + count > mTransientCapacity)
+    {
+        return kInvalidOffset;
+    }
+
+    uint32_t offset = mFrameIndex * mTransientCapacity + used;
+    used += count;
+    return offset;
+}
+
+uint32_t DescriptorRangeAllocator::GetCapacity() const
+{
+    return mTransientCapacity * mFrameCount + mPersistentCapacity;
+}
+
+uint32_t DescriptorRangeAllocator::GetPersistentCapacity() const
+{
+    return mPersistentCapacity;
+}
+
+uint32_t DescriptorRangeAllocator::GetTransientCapacity() const
+{
+    return mTransientCapacity;
+}
+
+uint32_t DescriptorRangeAllocator::GetAllocatedCount() const
+{
+    return mAllocatedCount;
+}
+
+uint32_t DescriptorRangeAllocator::GetPendingFreeCount() const
+{
+    return mPendingFreeCount;
+}
+
+uint32_t DescriptorRangeAllocator::GetLargestFreeRange() const
+{
+    uint32_t largest = 0;
+    for (const auto &[offset, count] : mFreeRanges)
+    {
+        largest = std::max(largest, count);
+    }
+    return largest;
+}
+
+uint32_t DescriptorRangeAllocator::GetTransientUsed() const
+{
+    return mTransientUsed.empty() ? 0 : mTransientUsed[mFrameIndex];
+}
+
+void DescriptorRangeAllocator::Release(uint32_t offset, uint32_t count)
+{
+    mAllocatedCount -= count;
+
+    auto next = mFreeRanges.lower_bound(offset);
+    if (next != mFreeRanges.end() && offset + count == next->first)
+    {
+        count += next->second;
+        next = mFreeRanges.erase(next);
+    }
+    if (next != mFreeRanges.begin())
+    {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset)
+        {
+            previous->second += count;
+            return;
+        }
+    }
+    mFreeRanges.emplace(offset, count);
+}
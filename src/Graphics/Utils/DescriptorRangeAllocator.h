@@ -0,0 +1,78 @@
+#pragma once
+
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+/// <summary>
+/// Hands out ranges of descriptor indices. It only does bookkeeping, there's no D3D in here: the owner maps
+/// the indices to heaps. Indices start with one linear region of transient descriptors per frame in flight,
+/// reset by BeginFrame(). The persistent descriptors follow, taken first fit from a list of free ranges that
+/// are merged back when freed. Freed ranges are only reused once the frame that freed them comes around again,
+/// as the command lists of the frames in flight may still reference them. Growing only appends persistent
+/// indices, so indices handed out earlier stay valid
+/// </summary>
+class DescriptorRangeAllocator
+{
+public:
+    static constexpr const uint32_t kInvalidOffset = ~0u;
+
+public:
+    void Init(uint32_t persistentCapacity, uint32_t transientCapacity, uint32_t frameCount);
+
+    /// <summary>
+    /// Returns the first of count consecutive persistent indices, or kInvalidOffset when no free range is large enough
+    /// </summary>
+    uint32_t Allocate(uint32_t count);
+    void Free(uint32_t offset, uint32_t count);
+    /// <summary>
+    /// Makes room for persistentCapacity persistent indices. Nothing happens if there's already room for them
+    /// </summary>
+    void Grow(uint32_t persistentCapacity);
+
+    /// <summary>
+    /// Releases the ranges freed the last time frameIndex was in flight and empties its transient region
+    /// </summary>
+    void BeginFrame(uint32_t frameIndex);
+    /// <summary>
+    /// Returns the first of count consecutive indices that are valid until the current frame comes around again,
+    /// or kInvalidOffset when the transient region of the current frame is full
+    /// </summary>
+    uint32_t AllocateTransient(uint32_t count);
+
+public:
+    uint32_t GetCapacity() const;
+    uint32_t GetPersistentCapacity() const;
+    uint32_t GetTransientCapacity() const;
+    uint32_t GetAllocatedCount() const;
+    /// <summary>
+    /// Persistent indices that were freed but wait for their frame to come around again
+    /// </summary>
+    uint32_t GetPendingFreeCount() const;
+    uint32_t GetLargestFreeRange() const;
+    uint32_t GetTransientUsed() const;
+
+private:
+    void Release(uint32_t offset, uint32_t count);
+
+private:
+    struct PendingFree
+    {
+        uint32_t Offset;
+        uint32_t Count;
+    };
+
+private:
+    uint32_t mPersistentCapacity = 0;
+    uint32_t mTransientCapacity = 0;
+    uint32_t mFrameCount = 0;
+    uint32_t mFrameIndex = 0;
+
+    // Free persistent ranges, count by offset, so neighbours can be found when merging
+    std::map<uint32_t, uint32_t> mFreeRanges;
+    std::vector<std::vector<PendingFree>> mPendingFrees;
+    std::vector<uint32_t> mTransientUsed;
+    uint32_t mAllocatedCount = 0;
+    uint32_t mPendingFreeCount = 0;
+};
@@ -0,0 +1,80 @@
+#include "GaussianKernel.h"
+
+#include <cmath>
+
+uint32_t GaussianKernel::GetRadius(float sigma)
+{
+    return sigma > 0.0f ? (uint32_t)std::ceil(2.0f * sigma) : 0;
+}
+
+std::vector<float> GaussianKernel::GetWeights(float sigma)
+{
+    if (!(sigma > 0.0f))
+    {
+        return {};
+    }
+
+    uint32_t radius = GetRadius(sigma);
+    float twoSigmaSq = 2.0f * sigma * sigma;
+
+    std::vector<float> weights(radius + 1);
+    double weightSum = 0.0;
+    for (uint32_t i = 0; i <= radius; ++i)
+    {
+        float x = (float)i;
+        weights[i] = std::exp(-x * x / twoSigmaSq);
+        weightSum += i == 0 ? weights[i] : 2.0 * weights[i];
+    }
+
+    for (auto &weight : weights)
+    {
+        weight = (float)(weight / weightSum);
+    }
+    return weights;
+}
+
+std::vector<GaussianKernel::Tap> GaussianKernel::GetLinearTaps(const std::vector<float> &weights)
+{
+    if (weights.empty())
+    {
+        return {};
+    }
+
+    std::vector<Tap> taps;
+    taps.reserve(1 + weights.size() / 2);
+    taps.push_back({ 0.0f, weights[0] });
+    for (size_t i = 1; i < weights.size(); i += 2)
+    {
+        // The last texel of an odd radius is alone: its tap sits on its center
+        if (i + 1 == weights.size())
+        {
+            taps.push_back({ (float)i, weights[i] });
+            break;
+        }
+
+        float weight = weights[i] + weights[i + 1];
+        float offset = weight > 0.0f ? (i * weights[i] + (i + 1) * weights[i + 1]) / weight : (float)i;
+        taps.push_back({ offset, weight });
+    }
+    return taps;
+}
+
+std::vector<float> GaussianKernel::ExpandLinearTaps(const std::vector<Tap> &taps, uint32_t radius)
+{
+    std::vector<float> weights(radius + 1, 0.0f);
+    for (const auto &tap : taps)
+    {
+        // Filtering hardware only has to keep 8 bits of the position between two texels
+        uint32_t texel = (uint32_t)std::floor(tap.Offset);
+        float fraction = std::round((tap.Offset - texel) * 256.0f) / 256.0f;
+        if (texel <= radius)
+        {
+            weights[texel] += tap.Weight * (1.0f - fraction);
+        }
+        if (fraction > 0.0f && texel + 1 <= radius)
+        {
+            weights[texel + 1] += tap.Weight * fraction;
+        }
+    }
+    return weights;
+}
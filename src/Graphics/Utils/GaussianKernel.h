@@ -0,0 +1,40 @@
+#pragma once
+
+
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// Weights of a separable Gaussian blur of any sigma. There's no D3D in here. The discrete kernel has one weight per
+/// texel in [-radius, radius]. Adjacent weights are folded into one bilinear tap, placed between the two texels so
+/// the hardware's linear filter weighs them as the kernel does, which halves the fetches. Only the taps at offsets
+/// >= 0 are stored: the shader samples every tap but the first at +offset and -offset
+/// </summary>
+namespace GaussianKernel
+{
+
+struct Tap
+{
+    // In texels, from the center of the blurred one
+    float Offset;
+    float Weight;
+};
+
+/// <summary>
+/// Radius covered by the kernel of sigma, in texels
+/// </summary>
+uint32_t GetRadius(float sigma);
+/// <summary>
+/// radius + 1 weights, for offsets 0 to radius. They add up to 1 counting both sides. Empty if sigma isn't positive
+/// </summary>
+std::vector<float> GetWeights(float sigma);
+/// <summary>
+/// Folds the weights of texels 2k + 1 and 2k + 2 into one tap; the center keeps a tap of its own
+/// </summary>
+std::vector<Tap> GetLinearTaps(const std::vector<float> &weights);
+/// <summary>
+/// CPU reference of what bilinear sampling makes of taps: the weight each texel at offset 0 to radius ends up with
+/// </summary>
+std::vector<float> ExpandLinearTaps(const std::vector<Tap> &taps, uint32_t radius);
+
+}
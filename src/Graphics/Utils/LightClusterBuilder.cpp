@@ -0,0 +1,220 @@
+#include "LightClusterBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+
+void LightClusterBuilder::Init(uint32_t gridX, uint32_t gridY, uint32_t gridZ)
+{
+    mGridX = std::max(gridX, 1u);
+    mGridY = std::max(gridY, 1u);
+    mGridZ = std::max(gridZ, 1u);
+
+    mClusters.assign(GetClusterCount(), {});
+    mLightIndices.clear();
+    mHits.clear();
+    mStatistics = {};
+
+    if (mNearZ > 0.0f)
+    {
+        ComputeClusterBounds();
+    }
+}
+
+void LightClusterBuilder::SetProjection(float xScale, float yScale, float nearZ, float farZ)
+{
+    if (xScale == mXScale && yScale == mYScale && nearZ == mNearZ && farZ == mFarZ && !mClusterBounds.empty())
+    {
+        return;
+    }
+
+    mXScale = xScale;
+    mYScale = yScale;
+    mNearZ = std::max(nearZ, 1e-4f);
+    mFarZ = std::max(farZ, mNearZ * 1.001f);
+    ComputeClusterBounds();
+}
+
+void LightClusterBuilder::Build(const Sphere *lights, uint32_t lightCount)
+{
+    mHits.clear();
+    mStatistics = {};
+    for (auto &cluster : mClusters)
+    {
+        cluster = {};
+    }
+    if (mClusterBounds.empty())
+    {
+        mLightIndices.clear();
+        return;
+    }
+
+    for (uint32_t lightIndex = 0; lightIndex < lightCount; ++lightIndex)
+    {
+        const auto &light = lights[lightIndex];
+        if (light.Radius <= 0.0f || light.Z + light.Radius < mNearZ || light.Z - light.Radius > mFarZ)
+        {
+            continue;
+        }
+
+        // The extremes of x / z over the sphere's bounding box are at its corners, as long as z stays positive
+        float minZ = std::max(light.Z - light.Radius, mNearZ);
+        float maxZ = std::min(light.Z + light.Radius, mFarZ);
+        float minNdcX = std::min((light.X - light.Radius) / minZ, (light.X - light.Radius) / maxZ) * mXScale;
+        float maxNdcX = std::max((light.X + light.Radius) / minZ, (light.X + light.Radius) / maxZ) * mXScale;
+        float minNdcY = std::min((light.Y - light.Radius) / minZ, (light.Y - light.Radius) / maxZ) * mYScale;
+        float maxNdcY = std::max((light.Y + light.Radius) / minZ, (light.Y + light.Radius) / maxZ) * mYScale;
+        if (maxNdcX < -1.0f || minNdcX > 1.0f || maxNdcY < -1.0f || minNdcY > 1.0f)
+        {
+            continue;
+        }
+
+        uint32_t firstColumn = GetTile(minNdcX, mGridX);
+        uint32_t lastColumn = GetTile(maxNdcX, mGridX);
+        // Rows go from the top of the screen
+        uint32_t firstRow = GetTile(-maxNdcY, mGridY);
+        uint32_t lastRow = GetTile(-minNdcY, mGridY);
+        uint32_t firstSlice = GetSlice(minZ);
+        uint32_t lastSlice = GetSlice(maxZ);
+
+        float radiusSquared = light.Radius * light.Radius;
+        bool visible = false;
+        for (uint32_t slice = firstSlice; slice <= lastSlice; ++slice)
+        {
+            for (uint32_t row = firstRow; row <= lastRow; ++row)
+            {
+                uint32_t clusterIndex = (slice * mGridY + row) * mGridX + firstColumn;
+                for (uint32_t column = firstColumn; column <= lastColumn; ++column, ++clusterIndex)
+                {
+                    const auto &bounds = mClusterBounds[clusterIndex];
+                    float dx = std::clamp(light.X, bounds.MinX, bounds.MaxX) - light.X;
+                    float dy = std::clamp(light.Y, bounds.MinY, bounds.MaxY) - light.Y;
+                    float dz = std::clamp(light.Z, bounds.MinZ, bounds.MaxZ) - light.Z;
+                    if (dx * dx + dy * dy + dz * dz > radiusSquared)
+                    {
+                        continue;
+                    }
+
+                    mHits.push_back({ clusterIndex, lightIndex });
+                    mClusters[clusterIndex].Count++;
+                    visible = true;
+                }
+            }
+        }
+        mStatistics.VisibleLights += visible ? 1 : 0;
+    }
+
+    uint32_t offset = 0;
+    for (auto &cluster : mClusters)
+    {
+        cluster.Offset = offset;
+        offset += cluster.Count;
+
+        mStatistics.OccupiedClusters += cluster.Count ? 1 : 0;
+        mStatistics.MaxLightsPerCluster = std::max(mStatistics.MaxLightsPerCluster, cluster.Count);
+        // Counted again while scattering
+        cluster.Count = 0;
+    }
+    mStatistics.LightIndices = offset;
+
+    // Hits are in light order, so every cluster's lights stay sorted
+    mLightIndices.resize(offset);
+    for (const auto &hit : mHits)
+    {
+        auto &cluster = mClusters[hit.Cluster];
+        mLightIndices[cluster.Offset + cluster.Count++] = hit.Light;
+    }
+}
+
+uint32_t LightClusterBuilder::GetGridX() const
+{
+    return mGridX;
+}
+
+uint32_t LightClusterBuilder::GetGridY() const
+{
+    return mGridY;
+}
+
+uint32_t LightClusterBuilder::GetGridZ() const
+{
+    return mGridZ;
+}
+
+uint32_t LightClusterBuilder::GetClusterCount() const
+{
+    return mGridX * mGridY * mGridZ;
+}
+
+float LightClusterBuilder::GetDepthScale() const
+{
+    return mDepthScale;
+}
+
+float LightClusterBuilder::GetDepthBias() const
+{
+    return mDepthBias;
+}
+
+auto LightClusterBuilder::GetClusters() const -> const std::vector<Cluster> &
+{
+    return mClusters;
+}
+
+const std::vector<uint32_t> &LightClusterBuilder::GetLightIndices() const
+{
+    return mLightIndices;
+}
+
+auto LightClusterBuilder::GetStatistics() const -> const Statistics &
+{
+    return mStatistics;
+}
+
+void LightClusterBuilder::ComputeClusterBounds()
+{
+    if (GetClusterCount() == 0)
+    {
+        return;
+    }
+
+    float logDepthRange = std::log(mFarZ / mNearZ);
+    mDepthScale = (float)mGridZ / logDepthRange;
+    mDepthBias = -(float)mGridZ * std::log(mNearZ) / logDepthRange;
+
+    mClusterBounds.resize(GetClusterCount());
+    for (uint32_t slice = 0; slice < mGridZ; ++slice)
+    {
+        float sliceNear = mNearZ * std::pow(mFarZ / mNearZ, (float)slice / mGridZ);
+        float sliceFar = mNearZ * std::pow(mFarZ / mNearZ, (float)(slice + 1) / mGridZ);
+        for (uint32_t row = 0; row < mGridY; ++row)
+        {
+            float topNdc = 1.0f - 2.0f * row / mGridY;
+            float bottomNdc = 1.0f - 2.0f * (row + 1) / mGridY;
+            for (uint32_t column = 0; column < mGridX; ++column)
+            {
+                float leftNdc = -1.0f + 2.0f * column / mGridX;
+                float rightNdc = -1.0f + 2.0f * (column + 1) / mGridX;
+
+                auto &bounds = mClusterBounds[(slice * mGridY + row) * mGridX + column];
+                bounds.MinX = std::min(leftNdc * sliceNear, leftNdc * sliceFar) / mXScale;
+                bounds.MaxX = std::max(rightNdc * sliceNear, rightNdc * sliceFar) / mXScale;
+                bounds.MinY = std::min(bottomNdc * sliceNear, bottomNdc * sliceFar) / mYScale;
+                bounds.MaxY = std::max(topNdc * sliceNear, topNdc * sliceFar) / mYScale;
+                bounds.MinZ = sliceNear;
+                bounds.MaxZ = sliceFar;
+            }
+        }
+    }
+}
+
+uint32_t LightClusterBuilder::GetSlice(float z) const
+{
+    float slice = std::floor(std::log(std::max(z, mNearZ)) * mDepthScale + mDepthBias);
+    return (uint32_t)std::clamp(slice, 0.0f, (float)(mGridZ - 1));
+}
+
+uint32_t LightClusterBuilder::GetTile(float ndc, uint32_t tileCount) const
+{
+    float tile = std::floor((ndc + 1.0f) * 0.5f * tileCount);
+    return (uint32_t)std::clamp(tile, 0.0f, (float)(tileCount - 1));
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// Bins lights into the clusters of a view frustum, for clustered shading. There's no D3D in here.
+/// The frustum is split into GridX x GridY screen tiles and GridZ depth slices that grow exponentially
+/// with the distance, so near clusters aren't stretched. Lights are given as bounding spheres in view space
+/// (left handed, +Z forward); every light lands in each cluster its sphere touches. Build() produces one
+/// (Offset, Count) range per cluster into a compact list of light indices, ready to be uploaded as is.
+/// Clusters are ordered by slice, then tile row from the top of the screen, then tile column
+/// </summary>
+class LightClusterBuilder
+{
+public:
+    static constexpr const uint32_t kDefaultGridX = 16;
+    static constexpr const uint32_t kDefaultGridY = 9;
+    static constexpr const uint32_t kDefaultGridZ = 24;
+
+    struct Sphere
+    {
+        float X;
+        float Y;
+        float Z;
+        float Radius;
+    };
+
+    // Same layout as LightCluster in the shaders
+    struct Cluster
+    {
+        uint32_t Offset;
+        uint32_t Count;
+    };
+
+    struct Statistics
+    {
+        // Lights that touch at least one cluster
+        uint32_t VisibleLights = 0;
+        uint32_t OccupiedClusters = 0;
+        uint32_t LightIndices = 0;
+        uint32_t MaxLightsPerCluster = 0;
+    };
+
+public:
+    void Init(uint32_t gridX = kDefaultGridX, uint32_t gridY = kDefaultGridY, uint32_t gridZ = kDefaultGridZ);
+    /// <summary>
+    /// xScale and yScale are the [0][0] and [1][1] entries of the projection matrix.
+    /// Only recomputes the clusters when something changed, so it's fine to call every frame
+    /// </summary>
+    void SetProjection(float xScale, float yScale, float nearZ, float farZ);
+    void Build(const Sphere *lights, uint32_t lightCount);
+
+public:
+    uint32_t GetGridX() const;
+    uint32_t GetGridY() const;
+    uint32_t GetGridZ() const;
+    uint32_t GetClusterCount() const;
+    /// <summary>
+    /// The depth slice of view depth z is floor(log(z) * GetDepthScale() + GetDepthBias())
+    /// </summary>
+    float GetDepthScale() const;
+    float GetDepthBias() const;
+
+    const std::vector<Cluster> &GetClusters() const;
+    const std::vector<uint32_t> &GetLightIndices() const;
+    const Statistics &GetStatistics() const;
+
+private:
+    struct Bounds
+    {
+        float MinX, MinY, MinZ;
+        float MaxX, MaxY, MaxZ;
+    };
+
+    struct Hit
+    {
+        uint32_t Cluster;
+        uint32_t Light;
+    };
+
+private:
+    void ComputeClusterBounds();
+    uint32_t GetSlice(float z) const;
+    uint32_t GetTile(float ndc, uint32_t tileCount) const;
+
+private:
+    uint32_t mGridX = 0;
+    uint32_t mGridY = 0;
+    uint32_t mGridZ = 0;
+
+    float mXScale = 0.0f;
+    float mYScale = 0.0f;
+    float mNearZ = 0.0f;
+    float mFarZ = 0.0f;
+    float mDepthScale = 0.0f;
+    float mDepthBias = 0.0f;
+
+    // View space bounding box of every cluster
+    std::vector<Bounds> mClusterBounds;
+
+    std::vector<Hit> mHits;
+    std::vector<Cluster> mClusters;
+    std::vector<uint32_t> mLightIndices;
+
+    Statistics mStatistics;
+};
@@ -0,0 +1,144 @@
+#include "LightCuller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+
+namespace LightCuller
+{
+
+void Lights::Resize(uint32_t count)
+{
+    Count = count;
+    // Padding lights are all zeros; CullAndRank never looks at lanes past Count
+    size_t paddedCount = (count + kLaneCount - 1) / kLaneCount * kLaneCount;
+    for (auto *array : { &X, &Y, &Z, &Range, &DirectionX, &DirectionY, &DirectionZ, &ConeRadius, &Intensity })
+    {
+        array->assign(paddedCount, 0.0f);
+    }
+}
+
+void Lights::SetPointLight(uint32_t index, float x, float y, float z, float range, float intensity)
+{
+    X[index] = x;
+    Y[index] = y;
+    Z[index] = z;
+    Range[index] = range;
+    DirectionX[index] = 0.0f;
+    DirectionY[index] = 0.0f;
+    DirectionZ[index] = 0.0f;
+    ConeRadius[index] = range;
+    Intensity[index] = intensity;
+}
+
+void Lights::SetSpotlight(uint32_t index, float x, float y, float z, float directionX, float directionY, float directionZ,
+                          float range, float spotPower, float intensity)
+{
+    float cosAngle = spotPower > 0.0f ? std::pow(kSpotCutoff, 1.0f / spotPower) : 0.0f;
+    float length = std::sqrt(directionX * directionX + directionY * directionY + directionZ * directionZ);
+    if (cosAngle < 1e-3f || length == 0.0f)
+    {
+        // Lights (almost) the whole half space in front of it, the cone doesn't bound anything
+        SetPointLight(index, x, y, z, range, intensity);
+        return;
+    }
+
+    X[index] = x;
+    Y[index] = y;
+    Z[index] = z;
+    Range[index] = range;
+    DirectionX[index] = directionX / length;
+    DirectionY[index] = directionY / length;
+    DirectionZ[index] = directionZ / length;
+    // The cone of height range holds the whole lit sector of the sphere
+    ConeRadius[index] = range * std::sqrt(1.0f - cosAngle * cosAngle) / cosAngle;
+    Intensity[index] = intensity;
+}
+
+uint32_t CullAndRank(const Frustum &frustum, const Lights &lights, uint32_t maxLights, std::vector<uint32_t> &selected)
+{
+    // Kept between calls so culling doesn't allocate every frame
+    static thread_local std::vector<float> scores;
+    scores.resize(lights.X.size());
+    selected.clear();
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 eyeX = _mm_set1_ps(frustum.EyeX);
+    const __m128 eyeY = _mm_set1_ps(frustum.EyeY);
+    const __m128 eyeZ = _mm_set1_ps(frustum.EyeZ);
+    const __m128 yScaleSquared = _mm_set1_ps(frustum.YScale * frustum.YScale);
+
+    for (uint32_t first = 0; first < lights.Count; first += kLaneCount)
+    {
+        __m128 x = _mm_loadu_ps(&lights.X[first]);
+        __m128 y = _mm_loadu_ps(&lights.Y[first]);
+        __m128 z = _mm_loadu_ps(&lights.Z[first]);
+        __m128 range = _mm_loadu_ps(&lights.Range[first]);
+        __m128 directionX = _mm_loadu_ps(&lights.DirectionX[first]);
+        __m128 directionY = _mm_loadu_ps(&lights.DirectionY[first]);
+        __m128 directionZ = _mm_loadu_ps(&lights.DirectionZ[first]);
+        __m128 coneRadius = _mm_loadu_ps(&lights.ConeRadius[first]);
+
+        __m128 inside = _mm_cmpeq_ps(zero, zero);
+        for (const auto &plane : frustum.Planes)
+        {
+            __m128 normalX = _mm_set1_ps(plane.NormalX);
+            __m128 normalY = _mm_set1_ps(plane.NormalY);
+            __m128 normalZ = _mm_set1_ps(plane.NormalZ);
+
+            __m128 apexDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX, x), _mm_mul_ps(normalY, y)),
+                                             _mm_add_ps(_mm_mul_ps(normalZ, z), _mm_set1_ps(plane.Distance)));
+            __m128 insideSphere = _mm_cmpge_ps(_mm_add_ps(apexDistance, range), zero);
+
+            // Farthest point of the cone's base along the plane normal: the axis end, plus the base radius
+            // times the length of the normal's component perpendicular to the axis
+            __m128 normalDotAxis = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX, directionX), _mm_mul_ps(normalY, directionY)),
+                                              _mm_mul_ps(normalZ, directionZ));
+            __m128 perpendicular = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(one, _mm_mul_ps(normalDotAxis, normalDotAxis)), zero));
+            __m128 baseDistance = _mm_add_ps(_mm_add_ps(apexDistance, _mm_mul_ps(range, normalDotAxis)),
+                                             _mm_mul_ps(coneRadius, perpendicular));
+            __m128 insideCone = _mm_cmpge_ps(_mm_max_ps(apexDistance, baseDistance), zero);
+
+            inside = _mm_and_ps(inside, _mm_and_ps(insideSphere, insideCone));
+        }
+
+        int insideMask = _mm_movemask_ps(inside);
+        if (insideMask == 0)
+        {
+            continue;
+        }
+
+        // Screen influence: intensity times the squared fraction of the screen height the sphere covers
+        __m128 toLightX = _mm_sub_ps(x, eyeX);
+        __m128 toLightY = _mm_sub_ps(y, eyeY);
+        __m128 toLightZ = _mm_sub_ps(z, eyeZ);
+        __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(toLightX, toLightX), _mm_mul_ps(toLightY, toLightY)),
+                                            _mm_mul_ps(toLightZ, toLightZ));
+        __m128 rangeSquared = _mm_mul_ps(range, range);
+        __m128 coverage = _mm_div_ps(_mm_mul_ps(rangeSquared, yScaleSquared),
+                                     _mm_max_ps(_mm_max_ps(distanceSquared, rangeSquared), _mm_set1_ps(1e-6f)));
+        __m128 score = _mm_mul_ps(_mm_loadu_ps(&lights.Intensity[first]), _mm_min_ps(coverage, one));
+        _mm_storeu_ps(&scores[first], score);
+
+        for (uint32_t lane = 0; lane < kLaneCount && first + lane < lights.Count; ++lane)
+        {
+            if (insideMask & (1 << lane))
+            {
+                selected.push_back(first + lane);
+            }
+        }
+    }
+
+    auto visibleCount = (uint32_t)selected.size();
+    if (visibleCount > maxLights)
+    {
+        std::nth_element(selected.begin(), selected.begin() + maxLights, selected.end(),
+                         [](uint32_t lhs, uint32_t rhs) { return scores[lhs] > scores[rhs]; });
+        selected.resize(maxLights);
+        std::sort(selected.begin(), selected.end());
+    }
+    return visibleCount;
+}
+
+} // namespace LightCuller
@@ -0,0 +1,78 @@
+#pragma once
+
+
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// Culls point lights and spotlights against a view frustum and ranks the survivors by how much of the screen
+/// they can affect. There's no D3D in here. Lights are kept as structure of arrays and tested four at a time
+/// with SSE. Every light is bounded by the sphere of its range; spotlights are also bounded by their cone,
+/// which rejects the many spotlights whose sphere touches the frustum but that point away from it
+/// </summary>
+namespace LightCuller
+{
+
+static constexpr const uint32_t kLaneCount = 4;
+
+// Points p with dot(Normal, p) + Distance >= 0 are on the inner side
+struct Plane
+{
+    float NormalX;
+    float NormalY;
+    float NormalZ;
+    float Distance;
+};
+
+struct Frustum
+{
+    // Left, right, bottom, top, near, far
+    Plane Planes[6];
+    float EyeX;
+    float EyeY;
+    float EyeZ;
+    // [1][1] of the projection matrix; turns radius / distance into a fraction of the screen height
+    float YScale;
+};
+
+/// <summary>
+/// Every array is padded with lights that are always culled up to a multiple of kLaneCount
+/// </summary>
+struct Lights
+{
+    uint32_t Count = 0;
+
+    // Sphere centre and cone apex
+    std::vector<float> X;
+    std::vector<float> Y;
+    std::vector<float> Z;
+    // Sphere radius and cone height
+    std::vector<float> Range;
+    // Cone axis, normalized. Zero for point lights, which makes the cone test the sphere test
+    std::vector<float> DirectionX;
+    std::vector<float> DirectionY;
+    std::vector<float> DirectionZ;
+    // Radius of the cone's base; the range for point lights
+    std::vector<float> ConeRadius;
+    // Perceived brightness of the light, weighs its rank
+    std::vector<float> Intensity;
+
+    void Resize(uint32_t count);
+    void SetPointLight(uint32_t index, float x, float y, float z, float range, float intensity);
+    /// <summary>
+    /// The cone ends where pow(cos(angle), spotPower) drops below kSpotCutoff
+    /// </summary>
+    void SetSpotlight(uint32_t index, float x, float y, float z, float directionX, float directionY, float directionZ,
+                      float range, float spotPower, float intensity);
+};
+
+// Spotlight attenuation below which a direction counts as outside the cone
+static constexpr const float kSpotCutoff = 1.0f / 256.0f;
+
+/// <summary>
+/// Writes to selected the indices of at most maxLights lights that intersect frustum, the ones with the highest
+/// screen influence, in ascending index order. Returns how many lights intersect frustum
+/// </summary>
+uint32_t CullAndRank(const Frustum &frustum, const Lights &lights, uint32_t maxLights, std::vector<uint32_t> &selected);
+
+} // namespace LightCuller
@@ -0,0 +1,337 @@
+#include "LightingModel.h"
+#include "CpuFeatures.h"
+
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+
+namespace LightingModel
+{
+
+static const bool gHasAVX = CpuFeatures::HasAVX();
+
+static float Saturate(float value)
+{
+    return std::min(std::max(value, 0.0f), 1.0f);
+}
+
+static float Dot(const float lhs[3], const float rhs[3])
+{
+    return lhs[0] * rhs[0] + lhs[1] * rhs[1] + lhs[2] * rhs[2];
+}
+
+static void SchlickFresnel(const float R0[3], const float normal[3], const float lightVec[3], float result[3])
+{
+    float cosIncidentAngle = Saturate(Dot(normal, lightVec));
+
+    float f0 = 1.0f - cosIncidentAngle;
+    float f5 = f0 * f0 * f0 * f0 * f0;
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        result[i] = R0[i] + (1.0f - R0[i]) * f5;
+    }
+}
+
+static void BlinnPhong(const float lightStrength[3], const float lightVec[3], const float toEye[3], const Material &material,
+                       float result[3])
+{
+    const float m = material.Shininess * 256.0f;
+    float halfVec[3] = { toEye[0] + lightVec[0], toEye[1] + lightVec[1], toEye[2] + lightVec[2] };
+    float halfLength = std::sqrt(Dot(halfVec, halfVec));
+    for (auto &component : halfVec)
+    {
+        component /= halfLength;
+    }
+
+    // The shader raises max(dot(halfVec, normal), 0) to the power of 0, so the highlight doesn't depend on the normal
+    float roughnessFactor = (m + 8.0f) / 8.0f;
+    float fresnelFactor[3];
+    SchlickFresnel(material.FresnelR0, halfVec, lightVec, fresnelFactor);
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        float specAlbedo = fresnelFactor[i] * roughnessFactor;
+        specAlbedo = specAlbedo / (specAlbedo + 1.0f);
+        result[i] = (material.DiffuseAlbedo[i] + specAlbedo) * lightStrength[i];
+    }
+}
+
+static float CalcAttenuation(float d, float attStart, float attEnd)
+{
+    return Saturate((attEnd - d) / (attEnd - attStart));
+}
+
+static void ComputeDirectionalLight(const float toEye[3], const float normal[3], const Material &material, const Light &light,
+                                    float result[3])
+{
+    float lightVec[3] = { -light.Direction[0], -light.Direction[1], -light.Direction[2] };
+
+    float NdotL = std::max(Dot(lightVec, normal), 0.0f);
+    float lightStrength[3] = { light.Strength[0] * NdotL, light.Strength[1] * NdotL, light.Strength[2] * NdotL };
+
+    BlinnPhong(lightStrength, lightVec, toEye, material, result);
+}
+
+static void ComputePunctualLight(const Light &light, const Material &material, const float position[3], const float normal[3],
+                                 const float toEye[3], bool spotlight, float result[3])
+{
+    float toLight[3] = { light.Position[0] - position[0], light.Position[1] - position[1], light.Position[2] - position[2] };
+
+    float d = std::sqrt(Dot(toLight, toLight));
+    if (d > light.FalloffEnd)
+    {
+        result[0] = result[1] = result[2] = 0.0f;
+        return;
+    }
+
+    for (auto &component : toLight)
+    {
+        component /= d;
+    }
+
+    float NdotL = std::max(Dot(toLight, normal), 0.0f);
+    float lightStrength[3] = { light.Strength[0] * NdotL, light.Strength[1] * NdotL, light.Strength[2] * NdotL };
+
+    float att = CalcAttenuation(d, light.FalloffStart, light.FalloffEnd);
+    float spotFactor = 1.0f;
+    if (spotlight)
+    {
+        float toPosition[3] = { -toLight[0], -toLight[1], -toLight[2] };
+        spotFactor = std::pow(std::max(Dot(toPosition, light.Direction), 0.0f), light.SpotPower);
+    }
+    for (auto &component : lightStrength)
+    {
+        component *= att;
+        if (spotlight)
+        {
+            component *= spotFactor;
+        }
+    }
+
+    BlinnPhong(lightStrength, toLight, toEye, material, result);
+}
+
+void ComputeLighting(const LightList &lights, const Material &material, const float position[3], const float normal[3],
+                     const float toEye[3], float result[3])
+{
+    result[0] = result[1] = result[2] = 0.0f;
+
+    uint32_t lightCount = lights.DirectionalCount + lights.PointCount + lights.SpotCount;
+    for (uint32_t i = 0; i < lightCount; ++i)
+    {
+        float lightResult[3];
+        if (i < lights.DirectionalCount)
+        {
+            ComputeDirectionalLight(toEye, normal, material, lights.Lights[i], lightResult);
+        }
+        else
+        {
+            bool spotlight = i >= lights.DirectionalCount + lights.PointCount;
+            ComputePunctualLight(lights.Lights[i], material, position, normal, toEye, spotlight, lightResult);
+        }
+
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            result[c] += lightResult[c];
+        }
+    }
+}
+
+namespace
+{
+
+struct Vector8
+{
+    __m256 X;
+    __m256 Y;
+    __m256 Z;
+};
+
+} // namespace
+
+static TARGET_AVX __m256 Dot8(const Vector8 &lhs, const Vector8 &rhs)
+{
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(lhs.X, rhs.X), _mm256_mul_ps(lhs.Y, rhs.Y)), _mm256_mul_ps(lhs.Z, rhs.Z));
+}
+
+static TARGET_AVX __m256 Saturate8(__m256 value)
+{
+    return _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+}
+
+static TARGET_AVX void BlinnPhong8(const Vector8 &lightStrength, const Vector8 &lightVec, const Vector8 &toEye,
+                                   const Material &material, Vector8 &result)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const float m = material.Shininess * 256.0f;
+
+    Vector8 halfVec = { _mm256_add_ps(toEye.X, lightVec.X), _mm256_add_ps(toEye.Y, lightVec.Y), _mm256_add_ps(toEye.Z, lightVec.Z) };
+    __m256 halfLength = _mm256_sqrt_ps(Dot8(halfVec, halfVec));
+    halfVec = { _mm256_div_ps(halfVec.X, halfLength), _mm256_div_ps(halfVec.Y, halfLength), _mm256_div_ps(halfVec.Z, halfLength) };
+
+    __m256 roughnessFactor = _mm256_set1_ps((m + 8.0f) / 8.0f);
+    __m256 f0 = _mm256_sub_ps(one, Saturate8(Dot8(halfVec, lightVec)));
+    __m256 f5 = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(f0, f0), f0), f0), f0);
+
+    __m256 *components[3] = { &result.X, &result.Y, &result.Z };
+    const __m256 *strengths[3] = { &lightStrength.X, &lightStrength.Y, &lightStrength.Z };
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        __m256 R0 = _mm256_set1_ps(material.FresnelR0[i]);
+        __m256 fresnelFactor = _mm256_add_ps(R0, _mm256_mul_ps(_mm256_sub_ps(one, R0), f5));
+        __m256 specAlbedo = _mm256_mul_ps(fresnelFactor, roughnessFactor);
+        specAlbedo = _mm256_div_ps(specAlbedo, _mm256_add_ps(specAlbedo, one));
+        *components[i] = _mm256_mul_ps(_mm256_add_ps(_mm256_set1_ps(material.DiffuseAlbedo[i]), specAlbedo), *strengths[i]);
+    }
+}
+
+static TARGET_AVX void ComputeDirectionalLight8(const Vector8 &toEye, const Vector8 &normal, const Material &material,
+                                                const Light &light, Vector8 &result)
+{
+    Vector8 lightVec = { _mm256_set1_ps(-light.Direction[0]), _mm256_set1_ps(-light.Direction[1]), _mm256_set1_ps(-light.Direction[2]) };
+
+    __m256 NdotL = _mm256_max_ps(Dot8(lightVec, normal), _mm256_setzero_ps());
+    Vector8 lightStrength = { _mm256_mul_ps(_mm256_set1_ps(light.Strength[0]), NdotL), _mm256_mul_ps(_mm256_set1_ps(light.Strength[1]), NdotL),
+                              _mm256_mul_ps(_mm256_set1_ps(light.Strength[2]), NdotL) };
+
+    BlinnPhong8(lightStrength, lightVec, toEye, material, result);
+}
+
+static TARGET_AVX void ComputePunctualLight8(const Light &light, const Material &material, const Vector8 &position,
+                                             const Vector8 &normal, const Vector8 &toEye, bool spotlight, Vector8 &result)
+{
+    Vector8 toLight = { _mm256_sub_ps(_mm256_set1_ps(light.Position[0]), position.X), _mm256_sub_ps(_mm256_set1_ps(light.Position[1]), position.Y),
+                        _mm256_sub_ps(_mm256_set1_ps(light.Position[2]), position.Z) };
+
+    __m256 d = _mm256_sqrt_ps(Dot8(toLight, toLight));
+    __m256 inRange = _mm256_cmp_ps(d, _mm256_set1_ps(light.FalloffEnd), _CMP_LE_OQ);
+    if (_mm256_movemask_ps(inRange) == 0)
+    {
+        result = { _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps() };
+        return;
+    }
+
+    toLight = { _mm256_div_ps(toLight.X, d), _mm256_div_ps(toLight.Y, d), _mm256_div_ps(toLight.Z, d) };
+
+    __m256 NdotL = _mm256_max_ps(Dot8(toLight, normal), _mm256_setzero_ps());
+    __m256 att = Saturate8(_mm256_div_ps(_mm256_sub_ps(_mm256_set1_ps(light.FalloffEnd), d),
+                                         _mm256_set1_ps(light.FalloffEnd - light.FalloffStart)));
+    Vector8 lightStrength = { _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(light.Strength[0]), NdotL), att),
+                              _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(light.Strength[1]), NdotL), att),
+                              _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(light.Strength[2]), NdotL), att) };
+    if (spotlight)
+    {
+        Vector8 direction = { _mm256_set1_ps(light.Direction[0]), _mm256_set1_ps(light.Direction[1]), _mm256_set1_ps(light.Direction[2]) };
+        Vector8 toPosition = { _mm256_sub_ps(_mm256_setzero_ps(), toLight.X), _mm256_sub_ps(_mm256_setzero_ps(), toLight.Y),
+                               _mm256_sub_ps(_mm256_setzero_ps(), toLight.Z) };
+        __m256 cosAngle = _mm256_max_ps(Dot8(toPosition, direction), _mm256_setzero_ps());
+
+        // No pow in AVX; lanes go through the same std::pow as the reference
+        alignas(32) float lanes[kLaneCount];
+        _mm256_store_ps(lanes, cosAngle);
+        for (auto &lane : lanes)
+        {
+            lane = std::pow(lane, light.SpotPower);
+        }
+        __m256 spotFactor = _mm256_load_ps(lanes);
+        lightStrength = { _mm256_mul_ps(lightStrength.X, spotFactor), _mm256_mul_ps(lightStrength.Y, spotFactor),
+                          _mm256_mul_ps(lightStrength.Z, spotFactor) };
+    }
+
+    BlinnPhong8(lightStrength, toLight, toEye, material, result);
+    result = { _mm256_and_ps(result.X, inRange), _mm256_and_ps(result.Y, inRange), _mm256_and_ps(result.Z, inRange) };
+}
+
+static TARGET_AVX void ComputeLightingAVX(const LightList &lights, const Material &material, const Samples &samples,
+                                          Colors &colors)
+{
+    uint32_t lightCount = lights.DirectionalCount + lights.PointCount + lights.SpotCount;
+    for (uint32_t first = 0; first < samples.Count; first += kLaneCount)
+    {
+        Vector8 position = { _mm256_loadu_ps(&samples.PositionX[first]), _mm256_loadu_ps(&samples.PositionY[first]),
+                             _mm256_loadu_ps(&samples.PositionZ[first]) };
+        Vector8 normal = { _mm256_loadu_ps(&samples.NormalX[first]), _mm256_loadu_ps(&samples.NormalY[first]),
+                           _mm256_loadu_ps(&samples.NormalZ[first]) };
+        Vector8 toEye = { _mm256_loadu_ps(&samples.ToEyeX[first]), _mm256_loadu_ps(&samples.ToEyeY[first]),
+                          _mm256_loadu_ps(&samples.ToEyeZ[first]) };
+
+        Vector8 sum = { _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps() };
+        for (uint32_t i = 0; i < lightCount; ++i)
+        {
+            Vector8 lightResult;
+            if (i < lights.DirectionalCount)
+            {
+                ComputeDirectionalLight8(toEye, normal, material, lights.Lights[i], lightResult);
+            }
+            else
+            {
+                bool spotlight = i >= lights.DirectionalCount + lights.PointCount;
+                ComputePunctualLight8(lights.Lights[i], material, position, normal, toEye, spotlight, lightResult);
+            }
+            sum = { _mm256_add_ps(sum.X, lightResult.X), _mm256_add_ps(sum.Y, lightResult.Y), _mm256_add_ps(sum.Z, lightResult.Z) };
+        }
+
+        _mm256_storeu_ps(&colors.R[first], sum.X);
+        _mm256_storeu_ps(&colors.G[first], sum.Y);
+        _mm256_storeu_ps(&colors.B[first], sum.Z);
+    }
+    _mm256_zeroupper();
+}
+
+void Samples::Resize(uint32_t count)
+{
+    Count = count;
+    // Padding samples face +Z and look at +Z, so they shade to finite values that nobody reads
+    size_t paddedCount = (count + kLaneCount - 1) / kLaneCount * kLaneCount;
+    for (auto *array : { &PositionX, &PositionY, &PositionZ, &NormalX, &NormalY, &ToEyeX, &ToEyeY })
+    {
+        array->assign(paddedCount, 0.0f);
+    }
+    NormalZ.assign(paddedCount, 1.0f);
+    ToEyeZ.assign(paddedCount, 1.0f);
+}
+
+void Samples::Set(uint32_t index, const float position[3], const float normal[3], const float toEye[3])
+{
+    PositionX[index] = position[0];
+    PositionY[index] = position[1];
+    PositionZ[index] = position[2];
+    NormalX[index] = normal[0];
+    NormalY[index] = normal[1];
+    NormalZ[index] = normal[2];
+    ToEyeX[index] = toEye[0];
+    ToEyeY[index] = toEye[1];
+    ToEyeZ[index] = toEye[2];
+}
+
+void ComputeLighting(const LightList &lights, const Material &material, const Samples &samples, Colors &colors)
+{
+    colors.R.resize(samples.PositionX.size());
+    colors.G.resize(samples.PositionX.size());
+    colors.B.resize(samples.PositionX.size());
+
+    if (gHasAVX)
+    {
+        ComputeLightingAVX(lights, material, samples, colors);
+        return;
+    }
+
+    for (uint32_t i = 0; i < samples.Count; ++i)
+    {
+        float position[3] = { samples.PositionX[i], samples.PositionY[i], samples.PositionZ[i] };
+        float normal[3] = { samples.NormalX[i], samples.NormalY[i], samples.NormalZ[i] };
+        float toEye[3] = { samples.ToEyeX[i], samples.ToEyeY[i], samples.ToEyeZ[i] };
+        float result[3];
+        ComputeLighting(lights, material, position, normal, toEye, result);
+        colors.R[i] = result[0];
+        colors.G[i] = result[1];
+        colors.B[i] = result[2];
+    }
+}
+
+bool UsesAVX()
+{
+    return gHasAVX;
+}
+
+} // namespace LightingModel
@@ -0,0 +1,95 @@
+#pragma once
+
+
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// CPU version of the lighting in Shaders/Common/Utils.hlsli (ComputeLighting and the functions it calls),
+/// for validation, precomputation and offline shading. There's no D3D in here. The scalar functions follow the
+/// HLSL line by line and are the reference; the batched ComputeLighting() shades 8 samples at a time with AVX
+/// when the CPU has it, with the same operations in the same order, so both agree to the last bit or close
+/// </summary>
+namespace LightingModel
+{
+
+static constexpr const uint32_t kLaneCount = 8;
+
+/// <summary>
+/// Same layout as LightCB and Light in the shaders, so LightCB arrays can be passed as they are
+/// </summary>
+struct Light
+{
+    float Strength[3];
+    float FalloffStart;
+    float Direction[3];
+    float FalloffEnd;
+    float Position[3];
+    float SpotPower;
+};
+
+/// <summary>
+/// Same layout as the start of MaterialConstants and Material in the shaders
+/// </summary>
+struct Material
+{
+    float DiffuseAlbedo[4];
+    float FresnelR0[3];
+    float Shininess;
+};
+
+/// <summary>
+/// Lights in LightsBuffer order: the directional lights, then the point lights, then the spotlights
+/// </summary>
+struct LightList
+{
+    const Light *Lights = nullptr;
+    uint32_t DirectionalCount = 0;
+    uint32_t PointCount = 0;
+    uint32_t SpotCount = 0;
+};
+
+/// <summary>
+/// Structure of arrays, padded to a multiple of kLaneCount. Normals and directions to the eye must be normalized
+/// </summary>
+struct Samples
+{
+    uint32_t Count = 0;
+
+    std::vector<float> PositionX;
+    std::vector<float> PositionY;
+    std::vector<float> PositionZ;
+    std::vector<float> NormalX;
+    std::vector<float> NormalY;
+    std::vector<float> NormalZ;
+    std::vector<float> ToEyeX;
+    std::vector<float> ToEyeY;
+    std::vector<float> ToEyeZ;
+
+    void Resize(uint32_t count);
+    void Set(uint32_t index, const float position[3], const float normal[3], const float toEye[3]);
+};
+
+struct Colors
+{
+    std::vector<float> R;
+    std::vector<float> G;
+    std::vector<float> B;
+};
+
+/// <summary>
+/// Reference for a single sample; writes the rgb of the shader's ComputeLighting() to result
+/// </summary>
+void ComputeLighting(const LightList &lights, const Material &material, const float position[3], const float normal[3],
+                     const float toEye[3], float result[3]);
+/// <summary>
+/// Shades every sample; colors is resized to the padded sample count
+/// </summary>
+void ComputeLighting(const LightList &lights, const Material &material, const Samples &samples, Colors &colors);
+
+/// <summary>
+/// Whether the batched ComputeLighting() runs on AVX on this CPU
+/// </summary>
+bool UsesAVX();
+
+} // namespace LightingModel
@@ -0,0 +1,554 @@
+#include "LightmapBaker.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+// Leaves hold at most this many triangles
+static constexpr uint32_t kMaxLeafTriangles = 4;
+// Median splits keep the depth under log2 of the triangle count, far from this
+static constexpr uint32_t kMaxTraversalDepth = 64;
+static constexpr float kPi = 3.14159265358979f;
+// Tiles are batched up to this many texels per job, as long as every thread still gets kJobsPerThread jobs
+static constexpr uint32_t kTexelsPerJob = 16 * 1024;
+static constexpr uint32_t kJobsPerThread = 4;
+
+static float Dot(const float lhs[3], const float rhs[3])
+{
+    return lhs[0] * rhs[0] + lhs[1] * rhs[1] + lhs[2] * rhs[2];
+}
+
+static void Cross(const float lhs[3], const float rhs[3], float result[3])
+{
+    result[0] = lhs[1] * rhs[2] - lhs[2] * rhs[1];
+    result[1] = lhs[2] * rhs[0] - lhs[0] * rhs[2];
+    result[2] = lhs[0] * rhs[1] - lhs[1] * rhs[0];
+}
+
+static void Normalize(float vector[3])
+{
+    float length = std::sqrt(Dot(vector, vector));
+    if (length > 0.0f)
+    {
+        vector[0] /= length;
+        vector[1] /= length;
+        vector[2] /= length;
+    }
+}
+
+static float RadicalInverse(uint32_t bits)
+{
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return (float)bits * 2.3283064365386963e-10f;
+}
+
+static float HashToUnit(uint32_t value)
+{
+    value ^= value >> 16;
+    value *= 0x7feb352dU;
+    value ^= value >> 15;
+    value *= 0x846ca68bU;
+    value ^= value >> 16;
+    return (float)(value >> 8) / (float)(1u << 24);
+}
+
+uint32_t LightmapBaker::AddMesh(std::vector<Vertex> vertices, std::vector<uint32_t> indices)
+{
+    mMeshes.push_back({ std::move(vertices), std::move(indices) });
+    return (uint32_t)mMeshes.size() - 1;
+}
+
+void LightmapBaker::BuildAccelerationStructure()
+{
+    std::vector<Triangle> triangles;
+    std::vector<float> centroids;
+    for (const auto &mesh : mMeshes)
+    {
+        for (size_t i = 0; i + 2 < mesh.Indices.size(); i += 3)
+        {
+            const float *p0 = mesh.Vertices[mesh.Indices[i]].Position;
+            const float *p1 = mesh.Vertices[mesh.Indices[i + 1]].Position;
+            const float *p2 = mesh.Vertices[mesh.Indices[i + 2]].Position;
+
+            Triangle triangle;
+            for (uint32_t axis = 0; axis < 3; ++axis)
+            {
+                triangle.Vertex0[axis] = p0[axis];
+                triangle.Edge1[axis] = p1[axis] - p0[axis];
+                triangle.Edge2[axis] = p2[axis] - p0[axis];
+                centroids.push_back((p0[axis] + p1[axis] + p2[axis]) / 3.0f);
+            }
+            triangles.push_back(triangle);
+        }
+    }
+
+    mNodes.clear();
+    mTriangles.clear();
+    mDepth = 0;
+    if (triangles.empty())
+    {
+        return;
+    }
+
+    std::vector<uint32_t> order(triangles.size());
+    for (uint32_t i = 0; i < (uint32_t)order.size(); ++i)
+    {
+        order[i] = i;
+    }
+
+    mNodes.reserve(2 * triangles.size() / kMaxLeafTriangles + 1);
+    mNodes.push_back({});
+    BuildNode(0, 0, 0, (uint32_t)triangles.size(), triangles, centroids, order);
+    assert(mDepth + 1 <= kMaxTraversalDepth);
+
+    // Leaves refer to ranges of order
+    mTriangles.reserve(triangles.size());
+    for (auto triangleIndex : order)
+    {
+        mTriangles.push_back(triangles[triangleIndex]);
+    }
+}
+
+void LightmapBaker::BuildNode(uint32_t nodeIndex, uint32_t depth, uint32_t first, uint32_t count, const std::vector<Triangle> &triangles,
+                              const std::vector<float> &centroids, std::vector<uint32_t> &order)
+{
+    mDepth = std::max(mDepth, depth);
+
+    Node node;
+    float centroidMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float centroidMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    std::fill(std::begin(node.Min), std::end(node.Min), FLT_MAX);
+    std::fill(std::begin(node.Max), std::end(node.Max), -FLT_MAX);
+    for (uint32_t i = first; i < first + count; ++i)
+    {
+        const auto &triangle = triangles[order[i]];
+        for (uint32_t axis = 0; axis < 3; ++axis)
+        {
+            float p0 = triangle.Vertex0[axis];
+            float p1 = p0 + triangle.Edge1[axis];
+            float p2 = p0 + triangle.Edge2[axis];
+            node.Min[axis] = std::min({ node.Min[axis], p0, p1, p2 });
+            node.Max[axis] = std::max({ node.Max[axis], p0, p1, p2 });
+            centroidMin[axis] = std::min(centroidMin[axis], centroids[order[i] * 3 + axis]);
+            centroidMax[axis] = std::max(centroidMax[axis], centroids[order[i] * 3 + axis]);
+        }
+    }
+
+    if (count <= kMaxLeafTriangles)
+    {
+        node.First = first;
+        node.TriangleCount = count;
+        mNodes[nodeIndex] = node;
+        return;
+    }
+
+    // Median split along the axis the centroids spread the most on
+    uint32_t axis = 0;
+    for (uint32_t i = 1; i < 3; ++i)
+    {
+        if (centroidMax[i] - centroidMin[i] > centroidMax[axis] - centroidMin[axis])
+        {
+            axis = i;
+        }
+    }
+    uint32_t middle = first + count / 2;
+    std::nth_element(order.begin() + first, order.begin() + middle, order.begin() + first + count,
+                     [&centroids, axis](uint32_t lhs, uint32_t rhs) { return centroids[lhs * 3 + axis] < centroids[rhs * 3 + axis]; });
+
+    node.First = (uint32_t)mNodes.size();
+    node.TriangleCount = 0;
+    mNodes[nodeIndex] = node;
+    mNodes.push_back({});
+    mNodes.push_back({});
+    BuildNode(node.First, depth + 1, first, middle - first, triangles, centroids, order);
+    BuildNode(node.First + 1, depth + 1, middle, first + count - middle, triangles, centroids, order);
+}
+
+bool LightmapBaker::IsOccluded(const float origin[3], const float direction[3], float maxDistance) const
+{
+    if (mNodes.empty())
+    {
+        return false;
+    }
+
+    float inverseDirection[3];
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        inverseDirection[axis] = direction[axis] != 0.0f ? 1.0f / direction[axis] : FLT_MAX;
+    }
+
+    uint32_t stack[kMaxTraversalDepth];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+        const auto &node = mNodes[stack[--stackSize]];
+
+        float tMin = 0.0f;
+        float tMax = maxDistance;
+        for (uint32_t axis = 0; axis < 3; ++axis)
+        {
+            float t0 = (node.Min[axis] - origin[axis]) * inverseDirection[axis];
+            float t1 = (node.Max[axis] - origin[axis]) * inverseDirection[axis];
+            tMin = std::max(tMin, std::min(t0, t1));
+            tMax = std::min(tMax, std::max(t0, t1));
+        }
+        if (tMin > tMax)
+        {
+            continue;
+        }
+
+        if (node.TriangleCount == 0)
+        {
+            // At most one pending sibling per level above this node, so this fits when the tree does
+            assert(stackSize + 2 <= kMaxTraversalDepth);
+            stack[stackSize++] = node.First;
+            stack[stackSize++] = node.First + 1;
+            continue;
+        }
+
+        for (uint32_t i = node.First; i < node.First + node.TriangleCount; ++i)
+        {
+            // Moller-Trumbore, both faces
+            const auto &triangle = mTriangles[i];
+            float p[3];
+            Cross(direction, triangle.Edge2, p);
+            float determinant = Dot(triangle.Edge1, p);
+            if (std::abs(determinant) < 1e-12f)
+            {
+                continue;
+            }
+            float inverseDeterminant = 1.0f / determinant;
+
+            float s[3] = { origin[0] - triangle.Vertex0[0], origin[1] - triangle.Vertex0[1], origin[2] - triangle.Vertex0[2] };
+            float u = Dot(s, p) * inverseDeterminant;
+            if (u < 0.0f || u > 1.0f)
+            {
+                continue;
+            }
+
+            float q[3];
+            Cross(s, triangle.Edge1, q);
+            float v = Dot(direction, q) * inverseDeterminant;
+            if (v < 0.0f || u + v > 1.0f)
+            {
+                continue;
+            }
+
+            float t = Dot(triangle.Edge2, q) * inverseDeterminant;
+            if (t > 0.0f && t < maxDistance)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool LightmapBaker::Bake(uint32_t meshIndex, const LightingModel::LightList &lights, const Settings &settings, Lightmap &lightmap) const
+{
+    if (meshIndex >= mMeshes.size() || settings.Width == 0 || settings.Height == 0 || settings.TileSize == 0)
+    {
+        return false;
+    }
+    const auto &mesh = mMeshes[meshIndex];
+    if (!mesh.Indices.empty() && mNodes.empty())
+    {
+        // BuildAccelerationStructure() wasn't called
+        return false;
+    }
+
+    uint32_t width = settings.Width;
+    uint32_t height = settings.Height;
+    uint32_t texelCount = width * height;
+    lightmap.Width = width;
+    lightmap.Height = height;
+    lightmap.Texels.assign((size_t)texelCount * 4, 0.0f);
+
+    // Surface of every texel center covered by a triangle
+    std::vector<float> positions((size_t)texelCount * 3);
+    std::vector<float> normals((size_t)texelCount * 3);
+    std::vector<uint8_t> covered(texelCount, 0);
+    for (size_t i = 0; i + 2 < mesh.Indices.size(); i += 3)
+    {
+        const Vertex *vertices[3] = { &mesh.Vertices[mesh.Indices[i]], &mesh.Vertices[mesh.Indices[i + 1]],
+                                      &mesh.Vertices[mesh.Indices[i + 2]] };
+        float x[3], y[3];
+        for (uint32_t v = 0; v < 3; ++v)
+        {
+            x[v] = vertices[v]->TexCoord[0] * width;
+            y[v] = vertices[v]->TexCoord[1] * height;
+        }
+        float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+        if (std::abs(area) < 1e-12f)
+        {
+            continue;
+        }
+
+        int32_t minX = std::max((int32_t)std::floor(std::min({ x[0], x[1], x[2] })), 0);
+        int32_t maxX = std::min((int32_t)std::ceil(std::max({ x[0], x[1], x[2] })), (int32_t)width - 1);
+        int32_t minY = std::max((int32_t)std::floor(std::min({ y[0], y[1], y[2] })), 0);
+        int32_t maxY = std::min((int32_t)std::ceil(std::max({ y[0], y[1], y[2] })), (int32_t)height - 1);
+        for (int32_t texelY = minY; texelY <= maxY; ++texelY)
+        {
+            for (int32_t texelX = minX; texelX <= maxX; ++texelX)
+            {
+                float centerX = texelX + 0.5f;
+                float centerY = texelY + 0.5f;
+                float weights[3] = {
+                    ((x[1] - centerX) * (y[2] - centerY) - (x[2] - centerX) * (y[1] - centerY)) / area,
+                    ((x[2] - centerX) * (y[0] - centerY) - (x[0] - centerX) * (y[2] - centerY)) / area,
+                    0.0f,
+                };
+                weights[2] = 1.0f - weights[0] - weights[1];
+                if (weights[0] < -1e-5f || weights[1] < -1e-5f || weights[2] < -1e-5f)
+                {
+                    continue;
+                }
+
+                uint32_t texel = texelY * width + texelX;
+                for (uint32_t axis = 0; axis < 3; ++axis)
+                {
+                    positions[texel * 3 + axis] = weights[0] * vertices[0]->Position[axis] + weights[1] * vertices[1]->Position[axis] +
+                                                  weights[2] * vertices[2]->Position[axis];
+                    normals[texel * 3 + axis] = weights[0] * vertices[0]->Normal[axis] + weights[1] * vertices[1]->Normal[axis] +
+                                                weights[2] * vertices[2]->Normal[axis];
+                }
+                Normalize(&normals[texel * 3]);
+                covered[texel] = 1;
+            }
+        }
+    }
+
+    // The shader model with a white, non reflective material gives the irradiance
+    LightingModel::Material irradianceMaterial = { { 1.0f, 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 0.0f }, 0.0f };
+    uint32_t lightCount = lights.DirectionalCount + lights.PointCount + lights.SpotCount;
+
+    uint32_t tilesX = (width + settings.TileSize - 1) / settings.TileSize;
+    uint32_t tilesY = (height + settings.TileSize - 1) / settings.TileSize;
+    uint32_t tileCount = tilesX * tilesY;
+    // Batches amortize the scheduling and the scratch buffers below; several per thread even out the empty tiles
+    uint32_t threadCount = JobSystem::Get()->GetWorkerCount() + 1;
+    uint32_t batchSize = std::clamp(kTexelsPerJob / (settings.TileSize * settings.TileSize), 1u,
+                                    std::max(tileCount / (threadCount * kJobsPerThread), 1u));
+    JobSystem::Get()->ParallelFor(tileCount, batchSize, [&](uint32_t begin, uint32_t end)
+    {
+        std::vector<uint32_t> tileTexels;
+        LightingModel::Samples samples;
+        LightingModel::Colors colors;
+        for (uint32_t tile = begin; tile < end; ++tile)
+        {
+            uint32_t firstX = (tile % tilesX) * settings.TileSize;
+            uint32_t firstY = (tile / tilesX) * settings.TileSize;
+            tileTexels.clear();
+            for (uint32_t y = firstY; y < std::min(firstY + settings.TileSize, height); ++y)
+            {
+                for (uint32_t x = firstX; x < std::min(firstX + settings.TileSize, width); ++x)
+                {
+                    if (covered[y * width + x])
+                    {
+                        tileTexels.push_back(y * width + x);
+                    }
+                }
+            }
+            if (tileTexels.empty())
+            {
+                continue;
+            }
+
+            samples.Resize((uint32_t)tileTexels.size());
+            for (uint32_t i = 0; i < (uint32_t)tileTexels.size(); ++i)
+            {
+                const float *normal = &normals[tileTexels[i] * 3];
+                samples.Set(i, &positions[tileTexels[i] * 3], normal, normal);
+            }
+
+            // One light at a time, so every light gets its own shadow ray
+            for (uint32_t lightIndex = 0; lightIndex < lightCount; ++lightIndex)
+            {
+                const auto &light = lights.Lights[lightIndex];
+                bool directional = lightIndex < lights.DirectionalCount;
+                bool point = !directional && lightIndex < lights.DirectionalCount + lights.PointCount;
+                LightingModel::LightList singleLight = { &light, directional ? 1u : 0u, point ? 1u : 0u,
+                                                         directional || point ? 0u : 1u };
+                LightingModel::ComputeLighting(singleLight, irradianceMaterial, samples, colors);
+
+                for (uint32_t i = 0; i < (uint32_t)tileTexels.size(); ++i)
+                {
+                    if (colors.R[i] <= 0.0f && colors.G[i] <= 0.0f && colors.B[i] <= 0.0f)
+                    {
+                        continue;
+                    }
+
+                    const float *position = &positions[tileTexels[i] * 3];
+                    const float *normal = &normals[tileTexels[i] * 3];
+                    float origin[3], toLight[3];
+                    float distance = FLT_MAX;
+                    for (uint32_t axis = 0; axis < 3; ++axis)
+                    {
+                        origin[axis] = position[axis] + normal[axis] * settings.RayOffset;
+                        toLight[axis] = directional ? -light.Direction[axis] : light.Position[axis] - origin[axis];
+                    }
+                    if (!directional)
+                    {
+                        distance = std::sqrt(Dot(toLight, toLight));
+                    }
+                    Normalize(toLight);
+                    if (IsOccluded(origin, toLight, distance))
+                    {
+                        continue;
+                    }
+
+                    float *texel = &lightmap.Texels[tileTexels[i] * 4];
+                    texel[0] += colors.R[i];
+                    texel[1] += colors.G[i];
+                    texel[2] += colors.B[i];
+                }
+            }
+
+            for (auto texelIndex : tileTexels)
+            {
+                const float *position = &positions[texelIndex * 3];
+                const float *normal = &normals[texelIndex * 3];
+
+                float tangent[3], bitangent[3];
+                float up[3] = { 0.0f, std::abs(normal[1]) < 0.999f ? 1.0f : 0.0f, std::abs(normal[1]) < 0.999f ? 0.0f : 1.0f };
+                Cross(up, normal, tangent);
+                Normalize(tangent);
+                Cross(normal, tangent, bitangent);
+
+                float origin[3];
+                for (uint32_t axis = 0; axis < 3; ++axis)
+                {
+                    origin[axis] = position[axis] + normal[axis] * settings.RayOffset;
+                }
+
+                // Hammersley points, shifted per texel so the pattern doesn't show
+                float shiftU = HashToUnit(texelIndex * 2);
+                float shiftV = HashToUnit(texelIndex * 2 + 1);
+                uint32_t unoccluded = 0;
+                for (uint32_t ray = 0; ray < settings.AORayCount; ++ray)
+                {
+                    float u = std::fmod((ray + 0.5f) / settings.AORayCount + shiftU, 1.0f);
+                    float v = std::fmod(RadicalInverse(ray) + shiftV, 1.0f);
+
+                    // Cosine weighted
+                    float radius = std::sqrt(u);
+                    float phi = 2.0f * kPi * v;
+                    float localX = radius * std::cos(phi);
+                    float localY = radius * std::sin(phi);
+                    float localZ = std::sqrt(std::max(1.0f - u, 0.0f));
+
+                    float direction[3];
+                    for (uint32_t axis = 0; axis < 3; ++axis)
+                    {
+                        direction[axis] = tangent[axis] * localX + bitangent[axis] * localY + normal[axis] * localZ;
+                    }
+                    unoccluded += IsOccluded(origin, direction, settings.AODistance) ? 0 : 1;
+                }
+                lightmap.Texels[texelIndex * 4 + 3] = settings.AORayCount ? (float)unoccluded / settings.AORayCount : 1.0f;
+            }
+        }
+    });
+
+    lightmap.CoveredTexels = 0;
+    for (auto texelCovered : covered)
+    {
+        lightmap.CoveredTexels += texelCovered;
+    }
+
+    // Grow the covered texels outwards, each new texel the average of its covered neighbours
+    std::vector<uint8_t> nextCovered;
+    for (uint32_t pass = 0; pass < settings.DilationPasses; ++pass)
+    {
+        nextCovered = covered;
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                if (covered[y * width + x])
+                {
+                    continue;
+                }
+
+                float sum[4] = {};
+                uint32_t neighbours = 0;
+                for (int32_t offsetY = -1; offsetY <= 1; ++offsetY)
+                {
+                    for (int32_t offsetX = -1; offsetX <= 1; ++offsetX)
+                    {
+                        int32_t neighbourX = (int32_t)x + offsetX;
+                        int32_t neighbourY = (int32_t)y + offsetY;
+                        if (neighbourX < 0 || neighbourY < 0 || neighbourX >= (int32_t)width || neighbourY >= (int32_t)height ||
+                            !covered[neighbourY * width + neighbourX])
+                        {
+                            continue;
+                        }
+
+                        const float *neighbour = &lightmap.Texels[(neighbourY * width + neighbourX) * 4];
+                        for (uint32_t c = 0; c < 4; ++c)
+                        {
+                            sum[c] += neighbour[c];
+                        }
+                        neighbours++;
+                    }
+                }
+                if (neighbours == 0)
+                {
+                    continue;
+                }
+
+                float *texel = &lightmap.Texels[(y * width + x) * 4];
+                for (uint32_t c = 0; c < 4; ++c)
+                {
+                    texel[c] = sum[c] / neighbours;
+                }
+                nextCovered[y * width + x] = 1;
+            }
+        }
+        covered.swap(nextCovered);
+    }
+    return true;
+}
+
+bool LightmapBaker::SaveDDS(const Lightmap &lightmap, const std::string &path)
+{
+    if (lightmap.Texels.size() != (size_t)lightmap.Width * lightmap.Height * 4 || lightmap.Texels.empty())
+    {
+        return false;
+    }
+
+    // DDS_HEADER and DDS_HEADER_DXT10, for a single DXGI_FORMAT_R32G32B32A32_FLOAT mip
+    uint32_t header[32 + 5] = {};
+    header[0] = 0x20534444; // "DDS "
+    header[1] = 124;
+    header[2] = 0x1 | 0x2 | 0x4 | 0x8 | 0x1000; // Caps, height, width, pitch, pixel format
+    header[3] = lightmap.Height;
+    header[4] = lightmap.Width;
+    header[5] = lightmap.Width * 4 * sizeof(float);
+    header[7] = 1;
+    header[19] = 32;
+    header[20] = 0x4; // Four CC
+    header[21] = 0x30315844; // "DX10"
+    header[27] = 0x1000; // Texture
+    header[32] = 2; // DXGI_FORMAT_R32G32B32A32_FLOAT
+    header[33] = 3; // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+    header[35] = 1; // Array size
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    file.write((const char *)header, sizeof(header));
+    file.write((const char *)lightmap.Texels.data(), lightmap.Texels.size() * sizeof(float));
+    return (bool)file;
+}
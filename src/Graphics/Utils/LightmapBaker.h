@@ -0,0 +1,104 @@
+#pragma once
+
+
+#include "LightingModel.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Bakes direct lighting and ambient occlusion into lightmaps on the CPU. There's no D3D in here.
+/// Meshes are added in world space with their own lightmap UVs, which must not overlap. All meshes occlude each
+/// other: BuildAccelerationStructure() puts their triangles in one bounding volume hierarchy. Bake() rasterizes
+/// a mesh's triangles in UV space, then shades the covered texels in tiles spread across the job system: the
+/// lights of the shader lighting model (LightingModel) with a shadow ray each, and cosine weighted AO rays.
+/// Texels just outside the triangles are filled from their neighbours so bilinear filtering doesn't bleed black
+/// </summary>
+class LightmapBaker
+{
+public:
+    struct Settings
+    {
+        uint32_t Width = 256;
+        uint32_t Height = 256;
+        uint32_t AORayCount = 64;
+        // AO rays only look for occluders this close
+        float AODistance = 2.0f;
+        // Rays start this far off the surface, along its normal
+        float RayOffset = 1e-3f;
+        uint32_t DilationPasses = 2;
+        uint32_t TileSize = 32;
+    };
+
+    struct Vertex
+    {
+        float Position[3];
+        float Normal[3];
+        float TexCoord[2];
+    };
+
+    struct Lightmap
+    {
+        uint32_t Width = 0;
+        uint32_t Height = 0;
+        // RGBA32F: the irradiance of the direct lights in rgb, the fraction of unoccluded AO rays in alpha
+        std::vector<float> Texels;
+        uint32_t CoveredTexels = 0;
+    };
+
+public:
+    /// <summary>
+    /// Returns the index of the mesh, for Bake(). Indices are relative to vertices
+    /// </summary>
+    uint32_t AddMesh(std::vector<Vertex> vertices, std::vector<uint32_t> indices);
+    /// <summary>
+    /// Must be called after adding the meshes and before baking
+    /// </summary>
+    void BuildAccelerationStructure();
+    bool Bake(uint32_t meshIndex, const LightingModel::LightList &lights, const Settings &settings, Lightmap &lightmap) const;
+
+    /// <summary>
+    /// Whether anything is hit between origin and origin + direction * maxDistance
+    /// </summary>
+    bool IsOccluded(const float origin[3], const float direction[3], float maxDistance) const;
+
+public:
+    static bool SaveDDS(const Lightmap &lightmap, const std::string &path);
+
+private:
+    struct Mesh
+    {
+        std::vector<Vertex> Vertices;
+        std::vector<uint32_t> Indices;
+    };
+
+    // One vertex and two edges, ready for Moller-Trumbore
+    struct Triangle
+    {
+        float Vertex0[3];
+        float Edge1[3];
+        float Edge2[3];
+    };
+
+    struct Node
+    {
+        float Min[3];
+        float Max[3];
+        // Leaves: the first of their triangles. Inner nodes, which have no triangles: the first of their two children
+        uint32_t First;
+        uint32_t TriangleCount;
+    };
+
+private:
+    void BuildNode(uint32_t nodeIndex, uint32_t depth, uint32_t first, uint32_t count, const std::vector<Triangle> &triangles,
+                   const std::vector<float> &centroids, std::vector<uint32_t> &order);
+
+private:
+    std::vector<Mesh> mMeshes;
+
+    std::vector<Triangle> mTriangles;
+    std::vector<Node> mNodes;
+    // Levels below the root; IsOccluded() never has more than mDepth + 1 nodes on its stack
+    uint32_t mDepth = 0;
+};
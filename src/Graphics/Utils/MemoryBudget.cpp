@@ -0,0 +1,160 @@
+#include "MemoryBudget.h"
+
+#include <algorithm>
+
+const char *MemoryBudget::GetCategoryName(Category category)
+{
+    switch (category)
+    {
+    case Category::Texture:
+        return "Textures";
+    case Category::RenderTarget:
+        return "Render targets";
+    case Category::AtlasPage:
+        return "Atlas pages";
+    case Category::StreamedTexture:
+        return "Streamed textures";
+    default:
+        return "Unknown";
+    }
+}
+
+void MemoryBudget::SetBudget(uint64_t budget)
+{
+    mBudget = budget;
+}
+
+void MemoryBudget::Track(Category category, uint32_t id, uint64_t bytes)
+{
+    auto categoryIndex = (uint32_t)category;
+    auto [it, inserted] = mAllocations[categoryIndex].try_emplace(id, 0);
+    if (inserted)
+    {
+        mStatistics.Allocations[categoryIndex]++;
+    }
+
+    mStatistics.Bytes[categoryIndex] = mStatistics.Bytes[categoryIndex] - it->second + bytes;
+    mStatistics.TotalBytes = mStatistics.TotalBytes - it->second + bytes;
+    it->second = bytes;
+}
+
+void MemoryBudget::Untrack(Category category, uint32_t id)
+{
+    auto categoryIndex = (uint32_t)category;
+    auto it = mAllocations[categoryIndex].find(id);
+    if (it == mAllocations[categoryIndex].end())
+    {
+        return;
+    }
+
+    mStatistics.Allocations[categoryIndex]--;
+    mStatistics.Bytes[categoryIndex] -= it->second;
+    mStatistics.TotalBytes -= it->second;
+    mAllocations[categoryIndex].erase(it);
+
+    if (category == Category::StreamedTexture)
+    {
+        if (auto evictableIt = mEvictables.find(id); evictableIt != mEvictables.end())
+        {
+            mLeastRecentlyUsed.erase(evictableIt->second.Position);
+            mEvictables.erase(evictableIt);
+        }
+    }
+}
+
+void MemoryBudget::TrackEvictable(uint32_t texture, uint64_t bytes, uint64_t lowBytes)
+{
+    Track(Category::StreamedTexture, texture, bytes);
+
+    auto [it, inserted] = mEvictables.try_emplace(texture);
+    if (inserted)
+    {
+        mLeastRecentlyUsed.push_front(texture);
+        it->second.Position = mLeastRecentlyUsed.begin();
+        it->second.LastUsedFrame = mFrame;
+    }
+    it->second.LowBytes = lowBytes;
+}
+
+void MemoryBudget::BeginFrame()
+{
+    mFrame++;
+}
+
+void MemoryBudget::Touch(uint32_t texture)
+{
+    auto it = mEvictables.find(texture);
+    if (it == mEvictables.end())
+    {
+        return;
+    }
+
+    it->second.LastUsedFrame = mFrame;
+    mLeastRecentlyUsed.splice(mLeastRecentlyUsed.begin(), mLeastRecentlyUsed, it->second.Position);
+}
+
+void MemoryBudget::SelectEvictions(std::vector<uint32_t> &evictions)
+{
+    if (mStatistics.TotalBytes <= mBudget)
+    {
+        return;
+    }
+
+    const auto &streamedAllocations = mAllocations[(uint32_t)Category::StreamedTexture];
+    uint64_t excessBytes = mStatistics.TotalBytes - mBudget;
+    for (auto it = mLeastRecentlyUsed.rbegin(); it != mLeastRecentlyUsed.rend() && excessBytes > 0; ++it)
+    {
+        const auto &evictable = mEvictables[*it];
+        if (mFrame - evictable.LastUsedFrame < kMinIdleFrames)
+        {
+            // Everything after this one was used even more recently
+            break;
+        }
+
+        auto allocationIt = streamedAllocations.find(*it);
+        if (allocationIt == streamedAllocations.end() || allocationIt->second <= evictable.LowBytes)
+        {
+            continue;
+        }
+
+        uint64_t freedBytes = allocationIt->second - evictable.LowBytes;
+        evictions.push_back(*it);
+        excessBytes -= std::min(excessBytes, freedBytes);
+    }
+}
+
+void MemoryBudget::OnEvicted(uint32_t texture, uint64_t bytes)
+{
+    if (mEvictables.find(texture) == mEvictables.end())
+    {
+        return;
+    }
+
+    mStatistics.Evictions++;
+    mStatistics.EvictedBytes += bytes;
+}
+
+uint64_t MemoryBudget::GetBudget() const
+{
+    return mBudget;
+}
+
+uint64_t MemoryBudget::GetTotalBytes() const
+{
+    return mStatistics.TotalBytes;
+}
+
+uint64_t MemoryBudget::GetBytes(Category category) const
+{
+    return mStatistics.Bytes[(uint32_t)category];
+}
+
+uint32_t MemoryBudget::GetEvictableCount() const
+{
+    return (uint32_t)mEvictables.size();
+}
+
+auto MemoryBudget::GetStatistics() const -> const Statistics &
+{
+    return mStatistics;
+}
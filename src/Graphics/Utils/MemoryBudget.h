@@ -0,0 +1,100 @@
+#pragma once
+
+
+#include <array>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// Accounts for the GPU memory of resources and picks which textures to evict when it goes over a budget.
+/// It only does bookkeeping, there's no D3D in here: owners report the allocation size of every resource,
+/// streamable textures are also kept in least recently used order and touched every frame they're drawn.
+/// When the tracked total is over the budget, SelectEvictions() names the least recently used streamable
+/// textures that should drop to their low mips; the owner evicts them and reports their new size
+/// </summary>
+class MemoryBudget
+{
+public:
+    enum class Category
+    {
+        Texture,
+        RenderTarget,
+        AtlasPage,
+        StreamedTexture,
+        Count,
+    };
+
+    static constexpr const uint32_t kCategoryCount = (uint32_t)Category::Count;
+    static constexpr const uint64_t kDefaultBudget = 1024ull * 1024 * 1024;
+    // Textures used within this many frames are never evicted, so what's on screen doesn't thrash
+    static constexpr const uint64_t kMinIdleFrames = 8;
+
+    struct Statistics
+    {
+        std::array<uint64_t, kCategoryCount> Bytes = {};
+        std::array<uint32_t, kCategoryCount> Allocations = {};
+        uint64_t TotalBytes = 0;
+        uint32_t Evictions = 0;
+        uint64_t EvictedBytes = 0;
+    };
+
+public:
+    static const char *GetCategoryName(Category category);
+
+public:
+    void SetBudget(uint64_t budget);
+    /// <summary>
+    /// Records that id of category takes bytes, replacing what was recorded for it before
+    /// </summary>
+    void Track(Category category, uint32_t id, uint64_t bytes);
+    void Untrack(Category category, uint32_t id);
+    /// <summary>
+    /// Records a streamed texture that takes bytes and can be evicted down to lowBytes. New textures count as used this frame
+    /// </summary>
+    void TrackEvictable(uint32_t texture, uint64_t bytes, uint64_t lowBytes);
+
+    void BeginFrame();
+    /// <summary>
+    /// Marks a streamed texture as used this frame
+    /// </summary>
+    void Touch(uint32_t texture);
+    /// <summary>
+    /// Appends to evictions the streamed textures to evict, least recently used first, until the total would fit in
+    /// the budget. Textures used in the last kMinIdleFrames frames are kept, so the total may stay over the budget.
+    /// Nothing is counted until the owner confirms each eviction with OnEvicted()
+    /// </summary>
+    void SelectEvictions(std::vector<uint32_t> &evictions);
+    /// <summary>
+    /// Records that the owner evicted texture, freeing bytes
+    /// </summary>
+    void OnEvicted(uint32_t texture, uint64_t bytes);
+
+public:
+    uint64_t GetBudget() const;
+    uint64_t GetTotalBytes() const;
+    uint64_t GetBytes(Category category) const;
+    uint32_t GetEvictableCount() const;
+    const Statistics &GetStatistics() const;
+
+private:
+    struct Evictable
+    {
+        uint64_t LowBytes;
+        uint64_t LastUsedFrame;
+        // Position in mLeastRecentlyUsed
+        std::list<uint32_t>::iterator Position;
+    };
+
+private:
+    uint64_t mBudget = kDefaultBudget;
+    uint64_t mFrame = 0;
+
+    std::array<std::unordered_map<uint32_t, uint64_t>, kCategoryCount> mAllocations;
+    std::unordered_map<uint32_t, Evictable> mEvictables;
+    // Most recently used first
+    std::list<uint32_t> mLeastRecentlyUsed;
+
+    Statistics mStatistics;
+};
@@ -0,0 +1,438 @@
+#include "MipGenerator.h"
+#include "JobSystem.h"
+#include "CpuFeatures.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+namespace MipGenerator
+{
+
+static constexpr uint32_t kChannels = 4;
+
+// Taps of the Kaiser filter, relative to twice the destination texel: 2x - 5 to 2x + 6
+static constexpr uint32_t kKaiserTaps = 12;
+static constexpr int32_t kKaiserFirstTap = -5;
+static constexpr double kKaiserWidth = 3.0;
+static constexpr double kKaiserAlpha = 4.0;
+
+// Levels smaller than this are filtered on the calling thread
+static constexpr uint32_t kParallelPixels = 128 * 128;
+static constexpr uint32_t kPixelsPerJob = 64 * 1024;
+
+static constexpr uint32_t kLinearToSRGBSize = 4096;
+
+struct Tables
+{
+    float SRGBToLinear[256];
+    float UnormToFloat[256];
+    uint8_t LinearToSRGB[kLinearToSRGBSize];
+    float KaiserWeights[kKaiserTaps];
+    bool HasAVX;
+};
+
+static double BesselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 64; ++k)
+    {
+        double factor = x / (2.0 * k);
+        term *= factor * factor;
+        sum += term;
+        if (term < sum * 1e-12)
+        {
+            break;
+        }
+    }
+    return sum;
+}
+
+static double Kaiser(double x)
+{
+    const double kPi = 3.14159265358979323846;
+
+    double sinc = x == 0.0 ? 1.0 : std::sin(kPi * x) / (kPi * x);
+    double t = x / kKaiserWidth;
+    if (t * t >= 1.0)
+    {
+        return 0.0;
+    }
+    return sinc * BesselI0(kKaiserAlpha * std::sqrt(1.0 - t * t)) / BesselI0(kKaiserAlpha);
+}
+
+static Tables BuildTables()
+{
+    Tables tables;
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+        float value = i / 255.0f;
+        tables.UnormToFloat[i] = value;
+        tables.SRGBToLinear[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    for (uint32_t i = 0; i < kLinearToSRGBSize; ++i)
+    {
+        float value = i / (float)(kLinearToSRGBSize - 1);
+        float srgb = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+        tables.LinearToSRGB[i] = (uint8_t)std::lround(std::clamp(srgb, 0.0f, 1.0f) * 255.0f);
+    }
+
+    // Source texel 2x + k is centered (k - 0.5) texels away from the destination texel,
+    // which is half as much in destination texels
+    double weights[kKaiserTaps];
+    double sum = 0.0;
+    for (uint32_t i = 0; i < kKaiserTaps; ++i)
+    {
+        int32_t k = kKaiserFirstTap + (int32_t)i;
+        weights[i] = Kaiser((k - 0.5) * 0.5);
+        sum += weights[i];
+    }
+    for (uint32_t i = 0; i < kKaiserTaps; ++i)
+    {
+        tables.KaiserWeights[i] = (float)(weights[i] / sum);
+    }
+
+    tables.HasAVX = CpuFeatures::HasAVX();
+    return tables;
+}
+
+static const Tables &GetTables()
+{
+    static const Tables tables = BuildTables();
+    return tables;
+}
+
+static std::atomic<bool> gAVXEnabled = true;
+
+template <typename Function>
+static void ForEachRow(uint32_t rowCount, uint32_t rowWidth, Function &&function)
+{
+    if ((uint64_t)rowCount * rowWidth < kParallelPixels)
+    {
+        function(0u, rowCount);
+        return;
+    }
+    JobSystem::Get()->ParallelFor(rowCount, std::max(kPixelsPerJob / rowWidth, 1u), function);
+}
+
+static void DecodeRow(const uint8_t *source, float *destination, uint32_t width, const float *colorTable, const float *alphaTable)
+{
+    for (uint32_t x = 0; x < width; ++x)
+    {
+        const uint8_t *texel = source + x * kChannels;
+        float *decoded = destination + x * kChannels;
+        decoded[0] = colorTable[texel[0]];
+        decoded[1] = colorTable[texel[1]];
+        decoded[2] = colorTable[texel[2]];
+        decoded[3] = alphaTable[texel[3]];
+    }
+}
+
+static void EncodeRow(const float *source, uint8_t *destination, uint32_t width, bool srgb, const uint8_t *linearToSRGB)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 scale = srgb ? _mm_setr_ps(kLinearToSRGBSize - 1, kLinearToSRGBSize - 1, kLinearToSRGBSize - 1, 255.0f)
+                              : _mm_set1_ps(255.0f);
+
+    for (uint32_t x = 0; x < width; ++x)
+    {
+        // The Kaiser filter rings a little past [0, 1]. max() also turns NaNs into zeros
+        __m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(source + x * kChannels), zero), one);
+        __m128i quantized = _mm_cvtps_epi32(_mm_mul_ps(value, scale));
+        uint8_t *texel = destination + x * kChannels;
+
+        if (srgb)
+        {
+            alignas(16) int32_t lanes[4];
+            _mm_store_si128((__m128i *)lanes, quantized);
+            texel[0] = linearToSRGB[lanes[0]];
+            texel[1] = linearToSRGB[lanes[1]];
+            texel[2] = linearToSRGB[lanes[2]];
+            texel[3] = (uint8_t)lanes[3];
+        }
+        else
+        {
+            __m128i words = _mm_packs_epi32(quantized, quantized);
+            __m128i packed = _mm_packus_epi16(words, words);
+            int32_t bytes = _mm_cvtsi128_si32(packed);
+            std::memcpy(texel, &bytes, sizeof(bytes));
+        }
+    }
+}
+
+static void BoxRowSSE(const float *row0, const float *row1, float *destination, uint32_t sourceWidth,
+                      uint32_t firstX, uint32_t width)
+{
+    const __m128 quarter = _mm_set1_ps(0.25f);
+    for (uint32_t x = firstX; x < width; ++x)
+    {
+        uint32_t x0 = std::min(2 * x, sourceWidth - 1) * kChannels;
+        uint32_t x1 = std::min(2 * x + 1, sourceWidth - 1) * kChannels;
+        __m128 top = _mm_add_ps(_mm_loadu_ps(row0 + x0), _mm_loadu_ps(row0 + x1));
+        __m128 bottom = _mm_add_ps(_mm_loadu_ps(row1 + x0), _mm_loadu_ps(row1 + x1));
+        _mm_storeu_ps(destination + x * kChannels, _mm_mul_ps(_mm_add_ps(top, bottom), quarter));
+    }
+}
+
+static TARGET_AVX void BoxRowAVX(const float *row0, const float *row1, float *destination, uint32_t sourceWidth,
+                                 uint32_t width)
+{
+    const __m256 quarter = _mm256_set1_ps(0.25f);
+
+    // Two destination texels at a time, from four source texels
+    uint32_t x = 0;
+    for (; x + 1 < width && 2 * x + 3 < sourceWidth; x += 2)
+    {
+        const float *top = row0 + 2 * x * kChannels;
+        const float *bottom = row1 + 2 * x * kChannels;
+        __m256 top01 = _mm256_loadu_ps(top);
+        __m256 top23 = _mm256_loadu_ps(top + 8);
+        __m256 bottom01 = _mm256_loadu_ps(bottom);
+        __m256 bottom23 = _mm256_loadu_ps(bottom + 8);
+
+        // [0 1] [2 3] -> [0 2] + [1 3]
+        __m256 topSum = _mm256_add_ps(_mm256_permute2f128_ps(top01, top23, 0x20), _mm256_permute2f128_ps(top01, top23, 0x31));
+        __m256 bottomSum = _mm256_add_ps(_mm256_permute2f128_ps(bottom01, bottom23, 0x20), _mm256_permute2f128_ps(bottom01, bottom23, 0x31));
+        _mm256_storeu_ps(destination + x * kChannels, _mm256_mul_ps(_mm256_add_ps(topSum, bottomSum), quarter));
+    }
+    _mm256_zeroupper();
+
+    BoxRowSSE(row0, row1, destination, sourceWidth, x, width);
+}
+
+static void KaiserRowSSE(const float *source, float *destination, uint32_t sourceWidth, uint32_t firstX, uint32_t lastX,
+                         const float *weights)
+{
+    for (uint32_t x = firstX; x < lastX; ++x)
+    {
+        __m128 sum = _mm_setzero_ps();
+        for (uint32_t i = 0; i < kKaiserTaps; ++i)
+        {
+            int32_t sourceX = std::clamp((int32_t)(2 * x) + kKaiserFirstTap + (int32_t)i, 0, (int32_t)sourceWidth - 1);
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[i]), _mm_loadu_ps(source + sourceX * kChannels)));
+        }
+        _mm_storeu_ps(destination + x * kChannels, sum);
+    }
+}
+
+static TARGET_AVX void KaiserRowAVX(const float *source, float *destination, uint32_t sourceWidth, uint32_t width,
+                                    const float *weights)
+{
+    // Texels whose taps are all inside the row are done two at a time; the edges clamp
+    uint32_t firstInterior = std::min((uint32_t)-kKaiserFirstTap / 2 + 1, width);
+    KaiserRowSSE(source, destination, sourceWidth, 0, firstInterior, weights);
+
+    uint32_t x = firstInterior;
+    for (; x + 1 < width && 2 * (x + 1) + kKaiserTaps + kKaiserFirstTap <= sourceWidth; x += 2)
+    {
+        const float *taps = source + (2 * x + kKaiserFirstTap) * kChannels;
+        __m256 sum = _mm256_setzero_ps();
+        for (uint32_t i = 0; i < kKaiserTaps; ++i)
+        {
+            // The taps of texel x + 1 are two source texels further
+            const float *tap = taps + i * kChannels;
+            __m256 texels = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(tap)), _mm_loadu_ps(tap + 2 * kChannels), 1);
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(weights[i]), texels));
+        }
+        _mm256_storeu_ps(destination + x * kChannels, sum);
+    }
+    _mm256_zeroupper();
+
+    KaiserRowSSE(source, destination, sourceWidth, x, width, weights);
+}
+
+static void KaiserColumnSSE(const float *const *rows, float *destination, uint32_t firstFloat, uint32_t floatCount,
+                            const float *weights)
+{
+    for (uint32_t i = firstFloat; i < floatCount; i += 4)
+    {
+        __m128 sum = _mm_setzero_ps();
+        for (uint32_t tap = 0; tap < kKaiserTaps; ++tap)
+        {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[tap]), _mm_loadu_ps(rows[tap] + i)));
+        }
+        _mm_storeu_ps(destination + i, sum);
+    }
+}
+
+static TARGET_AVX void KaiserColumnAVX(const float *const *rows, float *destination, uint32_t floatCount,
+                                       const float *weights)
+{
+    uint32_t i = 0;
+    for (; i + 8 <= floatCount; i += 8)
+    {
+        __m256 sum = _mm256_setzero_ps();
+        for (uint32_t tap = 0; tap < kKaiserTaps; ++tap)
+        {
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(weights[tap]), _mm256_loadu_ps(rows[tap] + i)));
+        }
+        _mm256_storeu_ps(destination + i, sum);
+    }
+    _mm256_zeroupper();
+
+    KaiserColumnSSE(rows, destination, i, floatCount, weights);
+}
+
+bool UsesAVX()
+{
+    return GetTables().HasAVX && gAVXEnabled.load(std::memory_order_relaxed);
+}
+
+void SetAVXEnabled(bool enabled)
+{
+    gAVXEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+uint32_t GetMipCount(uint32_t width, uint32_t height)
+{
+    uint32_t mipCount = 1;
+    while (width > 1 || height > 1)
+    {
+        width = std::max(width >> 1, 1u);
+        height = std::max(height >> 1, 1u);
+        mipCount++;
+    }
+    return mipCount;
+}
+
+MipChain Generate(const uint8_t *source, uint32_t width, uint32_t height, uint32_t rowPitch, bool srgb,
+                  Filter filter, uint32_t levelCount)
+{
+    MipChain chain;
+    if (!source || width == 0 || height == 0)
+    {
+        return chain;
+    }
+
+    const auto &tables = GetTables();
+    const bool useAVX = UsesAVX();
+    uint32_t maxLevelCount = GetMipCount(width, height);
+    levelCount = levelCount == 0 ? maxLevelCount : std::min(levelCount, maxLevelCount);
+
+    for (uint32_t i = 0; i < levelCount; ++i)
+    {
+        Level level;
+        level.Offset = chain.Size;
+        level.Width = std::max(width >> i, 1u);
+        level.Height = std::max(height >> i, 1u);
+        level.RowPitch = level.Width * kChannels;
+        chain.Levels.push_back(level);
+        chain.Size += (size_t)level.RowPitch * level.Height;
+    }
+    chain.Data.reset(new uint8_t[chain.Size]);
+
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        std::memcpy(chain.Data.get() + (size_t)y * width * kChannels, source + (size_t)y * rowPitch, width * kChannels);
+    }
+    if (levelCount == 1)
+    {
+        return chain;
+    }
+
+    // The current level in linear space, the next one and, for the Kaiser filter, the result of its horizontal pass
+    std::unique_ptr<float[]> current(new float[(size_t)width * height * kChannels]);
+    std::unique_ptr<float[]> next(new float[(size_t)chain.Levels[1].Width * chain.Levels[1].Height * kChannels]);
+    std::unique_ptr<float[]> horizontal;
+    if (filter == Filter::Kaiser)
+    {
+        horizontal.reset(new float[(size_t)chain.Levels[1].Width * height * kChannels]);
+    }
+
+    const float *colorTable = srgb ? tables.SRGBToLinear : tables.UnormToFloat;
+    ForEachRow(height, width, [&](uint32_t begin, uint32_t end)
+               {
+                   for (uint32_t y = begin; y < end; ++y)
+                   {
+                       DecodeRow(source + (size_t)y * rowPitch, current.get() + (size_t)y * width * kChannels, width,
+                                 colorTable, tables.UnormToFloat);
+                   }
+               });
+
+    for (uint32_t i = 1; i < levelCount; ++i)
+    {
+        const auto &sourceLevel = chain.Levels[i - 1];
+        const auto &level = chain.Levels[i];
+        uint32_t sourceWidth = sourceLevel.Width;
+        uint32_t sourceHeight = sourceLevel.Height;
+        uint32_t floatsPerRow = level.Width * kChannels;
+        uint8_t *encoded = chain.Data.get() + level.Offset;
+
+        if (filter == Filter::Kaiser)
+        {
+            ForEachRow(sourceHeight, level.Width, [&](uint32_t begin, uint32_t end)
+                       {
+                           for (uint32_t y = begin; y < end; ++y)
+                           {
+                               const float *sourceRow = current.get() + (size_t)y * sourceWidth * kChannels;
+                               float *destinationRow = horizontal.get() + (size_t)y * floatsPerRow;
+                               if (useAVX)
+                               {
+                                   KaiserRowAVX(sourceRow, destinationRow, sourceWidth, level.Width, tables.KaiserWeights);
+                               }
+                               else
+                               {
+                                   KaiserRowSSE(sourceRow, destinationRow, sourceWidth, 0, level.Width, tables.KaiserWeights);
+                               }
+                           }
+                       });
+
+            ForEachRow(level.Height, level.Width, [&](uint32_t begin, uint32_t end)
+                       {
+                           for (uint32_t y = begin; y < end; ++y)
+                           {
+                               const float *rows[kKaiserTaps];
+                               for (uint32_t tap = 0; tap < kKaiserTaps; ++tap)
+                               {
+                                   int32_t sourceY = std::clamp((int32_t)(2 * y) + kKaiserFirstTap + (int32_t)tap, 0, (int32_t)sourceHeight - 1);
+                                   rows[tap] = horizontal.get() + (size_t)sourceY * floatsPerRow;
+                               }
+
+                               float *destinationRow = next.get() + (size_t)y * floatsPerRow;
+                               if (useAVX)
+                               {
+                                   KaiserColumnAVX(rows, destinationRow, floatsPerRow, tables.KaiserWeights);
+                               }
+                               else
+                               {
+                                   KaiserColumnSSE(rows, destinationRow, 0, floatsPerRow, tables.KaiserWeights);
+                               }
+                               EncodeRow(destinationRow, encoded + (size_t)y * level.RowPitch, level.Width, srgb, tables.LinearToSRGB);
+                           }
+                       });
+        }
+        else
+        {
+            ForEachRow(level.Height, level.Width, [&](uint32_t begin, uint32_t end)
+                       {
+                           for (uint32_t y = begin; y < end; ++y)
+                           {
+                               const float *row0 = current.get() + (size_t)std::min(2 * y, sourceHeight - 1) * sourceWidth * kChannels;
+                               const float *row1 = current.get() + (size_t)std::min(2 * y + 1, sourceHeight - 1) * sourceWidth * kChannels;
+                               float *destinationRow = next.get() + (size_t)y * floatsPerRow;
+                               if (useAVX)
+                               {
+                                   BoxRowAVX(row0, row1, destinationRow, sourceWidth, level.Width);
+                               }
+                               else
+                               {
+                                   BoxRowSSE(row0, row1, destinationRow, sourceWidth, 0, level.Width);
+                               }
+                               EncodeRow(destinationRow, encoded + (size_t)y * level.RowPitch, level.Width, srgb, tables.LinearToSRGB);
+                           }
+                       });
+        }
+
+        // The level just written is the source of the next one. Both buffers fit the second level
+        std::swap(current, next);
+    }
+
+    return chain;
+}
+
+} // namespace MipGenerator
@@ -0,0 +1,65 @@
+#pragma once
+
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/// <summary>
+/// Builds mip chains for 8 bit, 4 channel images on the CPU. There's no D3D in here.
+/// Filtering happens in linear space: the color channels of sRGB images are decoded first, alpha is
+/// always linear. Every level is filtered from the float version of the previous one rather than from
+/// its 8 bit copy. Large levels are split in rows across the job system
+/// </summary>
+namespace MipGenerator
+{
+
+enum class Filter
+{
+    // 2x2 average. Cheap, but lets some aliasing through
+    Box,
+    // Separable Kaiser windowed sinc, 12 taps per axis. Sharper, at the cost of slight ringing
+    Kaiser,
+};
+
+struct Level
+{
+    // Offset of the level in MipChain::Data
+    size_t Offset;
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t RowPitch;
+};
+
+struct MipChain
+{
+    std::unique_ptr<uint8_t[]> Data;
+    size_t Size = 0;
+    // Finest first. Level 0 is a tightly packed copy of the source image
+    std::vector<Level> Levels;
+};
+
+/// <summary>
+/// Number of levels in a full chain, down to 1x1
+/// </summary>
+uint32_t GetMipCount(uint32_t width, uint32_t height);
+
+/// <summary>
+/// Generates levelCount levels from source, or the whole chain if levelCount is 0.
+/// Returns an empty chain if source is empty
+/// </summary>
+MipChain Generate(const uint8_t *source, uint32_t width, uint32_t height, uint32_t rowPitch, bool srgb,
+                  Filter filter = Filter::Kaiser, uint32_t levelCount = 0);
+
+/// <summary>
+/// Whether Generate() filters with AVX. True on CPUs that have it, unless SetAVXEnabled(false) was called
+/// </summary>
+bool UsesAVX();
+
+/// <summary>
+/// Falls back to the SSE loops even when the CPU has AVX, so both can be tested and measured on one machine.
+/// Both give the same results to the bit
+/// </summary>
+void SetAVXEnabled(bool enabled);
+
+} // namespace MipGenerator
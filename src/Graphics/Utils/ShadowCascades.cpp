@@ -0,0 +1,232 @@
+#include "ShadowCascades.h"
+
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+
+static float Dot(const float lhs[3], const float rhs[3])
+{
+    return lhs[0] * rhs[0] + lhs[1] * rhs[1] + lhs[2] * rhs[2];
+}
+
+static void Cross(const float lhs[3], const float rhs[3], float result[3])
+{
+    result[0] = lhs[1] * rhs[2] - lhs[2] * rhs[1];
+    result[1] = lhs[2] * rhs[0] - lhs[0] * rhs[2];
+    result[2] = lhs[0] * rhs[1] - lhs[1] * rhs[0];
+}
+
+static bool Normalize(float vector[3])
+{
+    float length = std::sqrt(Dot(vector, vector));
+    if (length < 1e-6f)
+    {
+        return false;
+    }
+    vector[0] /= length;
+    vector[1] /= length;
+    vector[2] /= length;
+    return true;
+}
+
+static ShadowCascades::Matrix Multiply(const ShadowCascades::Matrix &lhs, const ShadowCascades::Matrix &rhs)
+{
+    ShadowCascades::Matrix result = {};
+    for (uint32_t row = 0; row < 4; ++row)
+    {
+        for (uint32_t column = 0; column < 4; ++column)
+        {
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                result.M[row][column] += lhs.M[row][i] * rhs.M[i][column];
+            }
+        }
+    }
+    return result;
+}
+
+static ShadowCascades::Plane GetColumnPlane(const ShadowCascades::Matrix &matrix, uint32_t column, float sign)
+{
+    // Gribb & Hartmann: the planes of the clip space volume are sums of the matrix's columns
+    float plane[4];
+    for (uint32_t row = 0; row < 4; ++row)
+    {
+        plane[row] = matrix.M[row][3] + sign * matrix.M[row][column];
+    }
+    float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+    return { plane[0] / length, plane[1] / length, plane[2] / length, plane[3] / length };
+}
+
+bool ShadowCascades::Update(const CameraInfo &camera, const float lightDirection[3], const Settings &settings)
+{
+    float direction[3] = { lightDirection[0], lightDirection[1], lightDirection[2] };
+    if (camera.NearZ <= 0.0f || camera.FarZ <= camera.NearZ || settings.Resolution == 0 || !Normalize(direction))
+    {
+        return false;
+    }
+
+    mCascadeCount = std::clamp(settings.CascadeCount, 1u, kMaxCascades);
+    float lambda = std::clamp(settings.SplitLambda, 0.0f, 1.0f);
+
+    // The up vector only depends on the light, so cascades don't rotate with the camera
+    float up[3] = { 0.0f, 1.0f, 0.0f };
+    if (std::abs(direction[1]) > 0.99f)
+    {
+        up[1] = 0.0f;
+        up[2] = 1.0f;
+    }
+    float xAxis[3], yAxis[3];
+    Cross(up, direction, xAxis);
+    Normalize(xAxis);
+    Cross(direction, xAxis, yAxis);
+
+    float splitNear = camera.NearZ;
+    for (uint32_t i = 0; i < mCascadeCount; ++i)
+    {
+        auto &cascade = mCascades[i];
+
+        float fraction = (float)(i + 1) / mCascadeCount;
+        float logarithmicSplit = camera.NearZ * std::pow(camera.FarZ / camera.NearZ, fraction);
+        float uniformSplit = camera.NearZ + (camera.FarZ - camera.NearZ) * fraction;
+        float splitFar = i + 1 == mCascadeCount ? camera.FarZ : lambda * logarithmicSplit + (1.0f - lambda) * uniformSplit;
+        cascade.SplitNear = splitNear;
+        cascade.SplitFar = splitFar;
+
+        float corners[8][3];
+        float center[3] = {};
+        for (uint32_t corner = 0; corner < 8; ++corner)
+        {
+            float depth = corner < 4 ? splitNear : splitFar;
+            float x = (corner & 1 ? 1.0f : -1.0f) * depth * camera.TanHalfFovX;
+            float y = (corner & 2 ? 1.0f : -1.0f) * depth * camera.TanHalfFovY;
+            for (uint32_t axis = 0; axis < 3; ++axis)
+            {
+                corners[corner][axis] = camera.Position[axis] + camera.Forward[axis] * depth + camera.Right[axis] * x + camera.Up[axis] * y;
+                center[axis] += corners[corner][axis] / 8.0f;
+            }
+        }
+
+        float radius = 0.0f;
+        for (const auto &corner : corners)
+        {
+            float offset[3] = { corner[0] - center[0], corner[1] - center[1], corner[2] - center[2] };
+            radius = std::max(radius, std::sqrt(Dot(offset, offset)));
+        }
+        // Rounded, so float noise doesn't change the texel size from one frame to the next
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+        std::copy(std::begin(center), std::end(center), cascade.Center);
+        cascade.Radius = radius;
+
+        // Looking down the light direction from the sphere's edge
+        float eye[3] = { center[0] - direction[0] * radius, center[1] - direction[1] * radius, center[2] - direction[2] * radius };
+        cascade.View = { { { xAxis[0], yAxis[0], direction[0], 0.0f },
+                           { xAxis[1], yAxis[1], direction[1], 0.0f },
+                           { xAxis[2], yAxis[2], direction[2], 0.0f },
+                           { -Dot(xAxis, eye), -Dot(yAxis, eye), -Dot(direction, eye), 1.0f } } };
+
+        float nearZ = -settings.CasterDistance;
+        float farZ = 2.0f * radius;
+        cascade.Projection = { { { 1.0f / radius, 0.0f, 0.0f, 0.0f },
+                                 { 0.0f, 1.0f / radius, 0.0f, 0.0f },
+                                 { 0.0f, 0.0f, 1.0f / (farZ - nearZ), 0.0f },
+                                 { 0.0f, 0.0f, -nearZ / (farZ - nearZ), 1.0f } } };
+        cascade.ViewProjection = Multiply(cascade.View, cascade.Projection);
+
+        // Move the projection so the world origin lands on a texel corner; every world point then does as well
+        float halfResolution = settings.Resolution / 2.0f;
+        float originX = cascade.ViewProjection.M[3][0] * halfResolution;
+        float originY = cascade.ViewProjection.M[3][1] * halfResolution;
+        cascade.Projection.M[3][0] += (std::round(originX) - originX) / halfResolution;
+        cascade.Projection.M[3][1] += (std::round(originY) - originY) / halfResolution;
+        cascade.ViewProjection = Multiply(cascade.View, cascade.Projection);
+
+        Matrix clipToTexture = { { { 0.5f, 0.0f, 0.0f, 0.0f },
+                                   { 0.0f, -0.5f, 0.0f, 0.0f },
+                                   { 0.0f, 0.0f, 1.0f, 0.0f },
+                                   { 0.5f, 0.5f, 0.0f, 1.0f } } };
+        cascade.ShadowTransform = Multiply(cascade.ViewProjection, clipToTexture);
+
+        cascade.CasterPlanes[0] = GetColumnPlane(cascade.ViewProjection, 0, 1.0f);
+        cascade.CasterPlanes[1] = GetColumnPlane(cascade.ViewProjection, 0, -1.0f);
+        cascade.CasterPlanes[2] = GetColumnPlane(cascade.ViewProjection, 1, 1.0f);
+        cascade.CasterPlanes[3] = GetColumnPlane(cascade.ViewProjection, 1, -1.0f);
+        cascade.CasterPlanes[4] = GetColumnPlane(cascade.ViewProjection, 2, -1.0f);
+
+        splitNear = splitFar;
+    }
+    return true;
+}
+
+void ShadowCascades::CullCasters(uint32_t cascade, const float *centerX, const float *centerY, const float *centerZ,
+                                 const float *radius, uint32_t count, std::vector<uint32_t> &visible) const
+{
+    visible.clear();
+    if (cascade >= mCascadeCount)
+    {
+        return;
+    }
+    const auto &planes = mCascades[cascade].CasterPlanes;
+
+    // Four spheres at a time, the rest one by one
+    uint32_t first = 0;
+    for (; first + 4 <= count; first += 4)
+    {
+        __m128 x = _mm_loadu_ps(centerX + first);
+        __m128 y = _mm_loadu_ps(centerY + first);
+        __m128 z = _mm_loadu_ps(centerZ + first);
+        __m128 r = _mm_loadu_ps(radius + first);
+
+        __m128 inside = _mm_cmpeq_ps(x, x);
+        for (const auto &plane : planes)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.NormalX), x), _mm_mul_ps(_mm_set1_ps(plane.NormalY), y)),
+                                         _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.NormalZ), z), _mm_set1_ps(plane.Distance)));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, r), _mm_setzero_ps()));
+        }
+
+        int insideMask = _mm_movemask_ps(inside);
+        for (uint32_t lane = 0; lane < 4; ++lane)
+        {
+            if (insideMask & (1 << lane))
+            {
+                visible.push_back(first + lane);
+            }
+        }
+    }
+
+    for (; first < count; ++first)
+    {
+        bool inside = true;
+        for (const auto &plane : planes)
+        {
+            float distance = plane.NormalX * centerX[first] + plane.NormalY * centerY[first] + plane.NormalZ * centerZ[first] + plane.Distance;
+            inside &= distance + radius[first] >= 0.0f;
+        }
+        if (inside)
+        {
+            visible.push_back(first);
+        }
+    }
+}
+
+uint32_t ShadowCascades::GetCascadeCount() const
+{
+    return mCascadeCount;
+}
+
+auto ShadowCascades::GetCascade(uint32_t cascade) const -> const Cascade &
+{
+    return mCascades[std::min(cascade, kMaxCascades - 1)];
+}
+
+uint32_t ShadowCascades::GetCascadeIndex(float viewDepth) const
+{
+    for (uint32_t i = 0; i < mCascadeCount; ++i)
+    {
+        if (viewDepth < mCascades[i].SplitFar)
+        {
+            return i;
+        }
+    }
+    return mCascadeCount ? mCascadeCount - 1 : 0;
+}
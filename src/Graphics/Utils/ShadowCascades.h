@@ -0,0 +1,101 @@
+#pragma once
+
+
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// Splits the view frustum into cascades for the shadow map of one directional light and fits an orthographic
+/// projection to each. There's no D3D in here. Splits blend logarithmic and uniform distributions (the practical
+/// split scheme). Every cascade is fit around the bounding sphere of its slice of the frustum, so its size doesn't
+/// change as the camera turns, and its origin is snapped to whole shadow map texels, so edges don't shimmer as the
+/// camera moves. Matrices are row major and transform row vectors, like DirectXMath's
+/// </summary>
+class ShadowCascades
+{
+public:
+    static constexpr const uint32_t kMaxCascades = 4;
+
+    struct Matrix
+    {
+        float M[4][4];
+    };
+
+    // Points p with dot(Normal, p) + Distance >= 0 are on the inner side
+    struct Plane
+    {
+        float NormalX;
+        float NormalY;
+        float NormalZ;
+        float Distance;
+    };
+
+    struct Settings
+    {
+        uint32_t CascadeCount = kMaxCascades;
+        // 0 for uniform splits, 1 for logarithmic ones
+        float SplitLambda = 0.75f;
+        uint32_t Resolution = 2048;
+        // How far behind a cascade, towards the light, casters are still rendered
+        float CasterDistance = 100.0f;
+    };
+
+    struct CameraInfo
+    {
+        float Position[3];
+        // Normalized, left handed
+        float Forward[3];
+        float Right[3];
+        float Up[3];
+        // Tangents of half the field of view
+        float TanHalfFovX;
+        float TanHalfFovY;
+        float NearZ;
+        float FarZ;
+    };
+
+    struct Cascade
+    {
+        // View depths the cascade covers
+        float SplitNear;
+        float SplitFar;
+        // Bounding sphere of the cascade's slice of the frustum
+        float Center[3];
+        float Radius;
+
+        Matrix View;
+        Matrix Projection;
+        Matrix ViewProjection;
+        // World position to shadow map texture coordinates and depth
+        Matrix ShadowTransform;
+
+        // Left, right, bottom, top, far. There's no near plane: casters between the light and the cascade cast into it
+        Plane CasterPlanes[5];
+    };
+
+public:
+    /// <summary>
+    /// lightDirection is where the light goes, as in LightCB::Direction; it doesn't need to be normalized.
+    /// Returns false if the camera or the light direction are degenerate
+    /// </summary>
+    bool Update(const CameraInfo &camera, const float lightDirection[3], const Settings &settings);
+
+    /// <summary>
+    /// Writes to visible the indices of the bounding spheres that can cast a shadow in cascade.
+    /// Spheres are structure of arrays, count long
+    /// </summary>
+    void CullCasters(uint32_t cascade, const float *centerX, const float *centerY, const float *centerZ, const float *radius,
+                     uint32_t count, std::vector<uint32_t> &visible) const;
+
+public:
+    uint32_t GetCascadeCount() const;
+    const Cascade &GetCascade(uint32_t cascade) const;
+    /// <summary>
+    /// Index of the cascade that covers view depth z; the last one past the far plane
+    /// </summary>
+    uint32_t GetCascadeIndex(float viewDepth) const;
+
+private:
+    Cascade mCascades[kMaxCascades] = {};
+    uint32_t mCascadeCount = 0;
+};
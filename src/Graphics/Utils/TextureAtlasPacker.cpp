@@ -0,0 +1,85 @@
+#include "TextureAtlasPacker.h"
+
+#include <algorithm>
+
+// imgui_draw.cpp keeps its implementation static too
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imgui/imstb_rectpack.h"
+
+namespace TextureAtlasPacker
+{
+
+std::vector<Page> Pack(std::vector<Rect> &rects, uint32_t pageSize, uint32_t padding, uint32_t alignment)
+{
+    std::vector<Page> pages;
+
+    // Everything is packed in units of alignment texels, which also keeps the coordinates small
+    uint32_t pageCells = pageSize / alignment;
+    auto toCells = [&](uint32_t texels)
+    {
+        return (texels + 2 * padding + alignment - 1) / alignment;
+    };
+
+    std::vector<uint32_t> remaining;
+    for (uint32_t i = 0; i < (uint32_t)rects.size(); ++i)
+    {
+        rects[i].Packed = false;
+        if (toCells(rects[i].Width) <= pageCells && toCells(rects[i].Height) <= pageCells)
+        {
+            remaining.push_back(i);
+        }
+    }
+
+    std::vector<stbrp_node> nodes(pageCells);
+    std::vector<stbrp_rect> stbRects;
+    while (!remaining.empty())
+    {
+        stbrp_context context;
+        stbrp_init_target(&context, (int)pageCells, (int)pageCells, nodes.data(), (int)nodes.size());
+
+        stbRects.clear();
+        for (auto index : remaining)
+        {
+            stbrp_rect stbRect = {};
+            stbRect.id = (int)index;
+            stbRect.w = (stbrp_coord)toCells(rects[index].Width);
+            stbRect.h = (stbrp_coord)toCells(rects[index].Height);
+            stbRects.push_back(stbRect);
+        }
+        stbrp_pack_rects(&context, stbRects.data(), (int)stbRects.size());
+
+        Page page = {};
+        remaining.clear();
+        for (const auto &stbRect : stbRects)
+        {
+            auto &rect = rects[stbRect.id];
+            if (!stbRect.was_packed)
+            {
+                remaining.push_back(stbRect.id);
+                continue;
+            }
+
+            rect.Packed = true;
+            rect.Page = (uint32_t)pages.size();
+            rect.X = stbRect.x * alignment + padding;
+            rect.Y = stbRect.y * alignment + padding;
+
+            page.Width = std::max(page.Width, (uint32_t)(stbRect.x + stbRect.w) * alignment);
+            page.Height = std::max(page.Height, (uint32_t)(stbRect.y + stbRect.h) * alignment);
+            page.RectCount++;
+            page.UsedTexels += (uint64_t)rect.Width * rect.Height;
+        }
+
+        if (page.RectCount == 0)
+        {
+            // Can't happen, every remaining rect fits in an empty page
+            break;
+        }
+        pages.push_back(page);
+    }
+
+    return pages;
+}
+
+} // namespace TextureAtlasPacker
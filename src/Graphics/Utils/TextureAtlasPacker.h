@@ -0,0 +1,44 @@
+#pragma once
+
+
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// Places rectangles in as few atlas pages as possible, with imgui's copy of stb_rect_pack.
+/// There's no D3D in here. Every rectangle gets padding texels on each side, and both its padded
+/// position and size are rounded up to multiples of alignment, so the placement stays exact in
+/// the mips as long as alignment >> mip is at least 1
+/// </summary>
+namespace TextureAtlasPacker
+{
+
+struct Rect
+{
+    uint32_t Width;
+    uint32_t Height;
+
+    // Set by Pack(). X and Y are where the texels start, inside the padding
+    bool Packed = false;
+    uint32_t Page = 0;
+    uint32_t X = 0;
+    uint32_t Y = 0;
+};
+
+struct Page
+{
+    // Rounded up to the alignment, at most the page size given to Pack()
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t RectCount;
+    // Texels covered by the rectangles, padding excluded
+    uint64_t UsedTexels;
+};
+
+/// <summary>
+/// Packs rects in pages of at most pageSize x pageSize texels. Rects that can't fit in an empty page
+/// are left unpacked
+/// </summary>
+std::vector<Page> Pack(std::vector<Rect> &rects, uint32_t pageSize, uint32_t padding, uint32_t alignment);
+
+} // namespace TextureAtlasPacker
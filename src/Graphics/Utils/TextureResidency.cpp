@@ -0,0 +1,290 @@
+#include "TextureResidency.h"
+
+#include <algorithm>
+#include <cmath>
+
+uint32_t TextureResidency::ComputeMip(uint32_t width, uint32_t height, uint32_t mipCount, float screenSize)
+{
+    if (mipCount == 0)
+    {
+        return 0;
+    }
+
+    uint32_t lastMip = mipCount - 1;
+    if (screenSize <= 0.0f)
+    {
+        return lastMip;
+    }
+
+    float texels = (float)std::max(width, height);
+    if (texels <= screenSize)
+    {
+        return 0;
+    }
+
+    // The finest mip that still has at least one texel per pixel
+    auto mip = (uint32_t)std::floor(std::log2(texels / screenSize));
+    return std::min(mip, lastMip);
+}
+
+uint32_t TextureResidency::AddTexture(const TextureDesc &desc)
+{
+    TextureState state;
+    state.Desc = desc;
+    state.Desc.MipCount = std::max(state.Desc.MipCount, 1u);
+    state.Desc.TailMip = std::min(state.Desc.TailMip, state.Desc.MipCount - 1);
+    state.Desc.MipSizes.resize(state.Desc.MipCount, 0);
+
+    state.ResidentMip = state.Desc.TailMip;
+    state.PendingMip = state.Desc.TailMip;
+    state.WantedMip = state.Desc.TailMip;
+    state.HeldMip = state.Desc.TailMip;
+
+    mTextures.push_back(std::move(state));
+    return (uint32_t)mTextures.size() - 1;
+}
+
+void TextureResidency::Clear()
+{
+    mTextures.clear();
+    mUpdate = 0;
+}
+
+void TextureResidency::Request(uint32_t texture, float screenSize)
+{
+    if (texture >= mTextures.size())
+    {
+        return;
+    }
+
+    auto &state = mTextures[texture];
+    state.RequestedScreenSize = std::max(state.RequestedScreenSize, screenSize);
+}
+
+void TextureResidency::Update(uint64_t budget, uint64_t maxStreamInBytes, std::vector<Change> &changes)
+{
+    mUpdate++;
+
+    uint32_t textureCount = (uint32_t)mTextures.size();
+    mSteps.clear();
+    mAllowedMips.resize(textureCount);
+    mBlocked.assign(textureCount, 0);
+
+    // The tails are always resident; everything finer than them is split in one step per mip
+    uint64_t usedBytes = 0;
+    for (uint32_t i = 0; i < textureCount; ++i)
+    {
+        auto &state = mTextures[i];
+        const auto &desc = state.Desc;
+
+        uint32_t requestedMip = std::min(ComputeMip(desc.Width, desc.Height, desc.MipCount, state.RequestedScreenSize), desc.TailMip);
+        if (requestedMip <= state.HeldMip || mUpdate > state.HeldUntil)
+        {
+            state.HeldMip = requestedMip;
+            state.HeldScreenSize = state.RequestedScreenSize;
+            state.HeldUntil = mUpdate + kEvictionDelay;
+        }
+        state.WantedMip = state.HeldMip;
+        state.RequestedScreenSize = 0.0f;
+
+        usedBytes += GetBytes(state, desc.TailMip);
+        mAllowedMips[i] = desc.TailMip;
+
+        for (uint32_t mip = desc.TailMip; mip-- > state.WantedMip;)
+        {
+            float texels = (float)std::max({ desc.Width >> mip, desc.Height >> mip, 1u });
+            mSteps.push_back({ i, mip, state.HeldScreenSize / texels });
+        }
+    }
+
+    // Under-sampled textures first. Within a texture the coarser mip always comes first,
+    // so the accepted steps of every texture form a contiguous chain starting at its tail
+    std::sort(mSteps.begin(), mSteps.end(), [](const Step &lhs, const Step &rhs)
+              {
+                  if (lhs.Priority != rhs.Priority)
+                  {
+                      return lhs.Priority > rhs.Priority;
+                  }
+                  if (lhs.Texture != rhs.Texture)
+                  {
+                      return lhs.Texture < rhs.Texture;
+                  }
+                  return lhs.Mip > rhs.Mip;
+              });
+
+    for (const auto &step : mSteps)
+    {
+        if (mBlocked[step.Texture])
+        {
+            continue;
+        }
+
+        uint64_t cost = mTextures[step.Texture].Desc.MipSizes[step.Mip];
+        if (usedBytes + cost > budget)
+        {
+            mBlocked[step.Texture] = 1;
+            continue;
+        }
+        usedBytes += cost;
+        mAllowedMips[step.Texture] = step.Mip;
+    }
+
+    // Evictions free memory right away. Textures with a stream-in in flight are left alone
+    constexpr uint8_t kStreamingIn = 1;
+    constexpr uint8_t kOutOfStreamBudget = 2;
+    mBlocked.assign(textureCount, 0);
+    for (uint32_t i = 0; i < textureCount; ++i)
+    {
+        auto &state = mTextures[i];
+        if (state.PendingMip != state.ResidentMip)
+        {
+            mBlocked[i] = kStreamingIn;
+            continue;
+        }
+
+        if (mAllowedMips[i] > state.ResidentMip)
+        {
+            changes.push_back({ i, state.ResidentMip, mAllowedMips[i] });
+            state.ResidentMip = mAllowedMips[i];
+            state.PendingMip = mAllowedMips[i];
+        }
+    }
+
+    // Stream-ins follow the same priority order, until maxStreamInBytes is reached.
+    // At least one mip is streamed per update, however large it is
+    uint64_t streamInBytes = 0;
+    for (const auto &step : mSteps)
+    {
+        auto &state = mTextures[step.Texture];
+        if (mBlocked[step.Texture] || step.Mip < mAllowedMips[step.Texture] || step.Mip + 1 != state.PendingMip)
+        {
+            continue;
+        }
+
+        uint64_t cost = state.Desc.MipSizes[step.Mip];
+        if (streamInBytes > 0 && streamInBytes + cost > maxStreamInBytes)
+        {
+            mBlocked[step.Texture] = kOutOfStreamBudget;
+            continue;
+        }
+        streamInBytes += cost;
+        state.PendingMip = step.Mip;
+    }
+
+    for (uint32_t i = 0; i < textureCount; ++i)
+    {
+        auto &state = mTextures[i];
+        if (mBlocked[i] != kStreamingIn && state.PendingMip < state.ResidentMip)
+        {
+            changes.push_back({ i, state.ResidentMip, state.PendingMip });
+        }
+    }
+}
+
+void TextureResidency::OnStreamedIn(uint32_t texture, uint32_t mip)
+{
+    if (texture >= mTextures.size())
+    {
+        return;
+    }
+
+    auto &state = mTextures[texture];
+    state.ResidentMip = mip;
+    state.PendingMip = mip;
+}
+
+void TextureResidency::OnStreamInFailed(uint32_t texture)
+{
+    if (texture >= mTextures.size())
+    {
+        return;
+    }
+
+    auto &state = mTextures[texture];
+    state.PendingMip = state.ResidentMip;
+}
+
+bool TextureResidency::Evict(uint32_t texture, uint32_t mip, Change &change)
+{
+    if (texture >= mTextures.size())
+    {
+        return false;
+    }
+
+    auto &state = mTextures[texture];
+    mip = std::min(mip, state.Desc.TailMip);
+    if (state.PendingMip != state.ResidentMip || mip <= state.ResidentMip)
+    {
+        return false;
+    }
+
+    change = { texture, state.ResidentMip, mip };
+    state.ResidentMip = mip;
+    state.PendingMip = mip;
+    state.WantedMip = mip;
+    // The hold expires, so any request wins again
+    state.HeldMip = mip;
+    state.HeldScreenSize = 0.0f;
+    state.HeldUntil = mUpdate;
+    return true;
+}
+
+uint32_t TextureResidency::GetTextureCount() const
+{
+    return (uint32_t)mTextures.size();
+}
+
+uint32_t TextureResidency::GetResidentMip(uint32_t texture) const
+{
+    return mTextures[texture].ResidentMip;
+}
+
+uint32_t TextureResidency::GetPendingMip(uint32_t texture) const
+{
+    return mTextures[texture].PendingMip;
+}
+
+uint32_t TextureResidency::GetWantedMip(uint32_t texture) const
+{
+    return mTextures[texture].WantedMip;
+}
+
+uint64_t TextureResidency::GetResidentBytes() const
+{
+    uint64_t residentBytes = 0;
+    for (const auto &state : mTextures)
+    {
+        residentBytes += GetBytes(state, state.ResidentMip);
+    }
+    return residentBytes;
+}
+
+uint64_t TextureResidency::GetPendingBytes() const
+{
+    uint64_t pendingBytes = 0;
+    for (const auto &state : mTextures)
+    {
+        pendingBytes += GetBytes(state, state.PendingMip) - GetBytes(state, state.ResidentMip);
+    }
+    return pendingBytes;
+}
+
+uint64_t TextureResidency::GetBytes(uint32_t texture, uint32_t firstMip) const
+{
+    return GetBytes(mTextures[texture], firstMip);
+}
+
+uint32_t TextureResidency::GetTailMip(uint32_t texture) const
+{
+    return mTextures[texture].Desc.TailMip;
+}
+
+uint64_t TextureResidency::GetBytes(const TextureState &state, uint32_t firstMip) const
+{
+    uint64_t bytes = 0;
+    for (uint32_t mip = firstMip; mip < state.Desc.MipCount; ++mip)
+    {
+        bytes += state.Desc.MipSizes[mip];
+    }
+    return bytes;
+}
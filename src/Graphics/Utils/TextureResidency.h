@@ -0,0 +1,121 @@
+#pragma once
+
+
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// Decides which mips of the streamed textures should be resident. It only does bookkeeping, there's
+/// no D3D in here: every frame the renderer reports how large each texture appears on screen, Update()
+/// fits the wanted mips in a memory budget and reports which textures must stream mips in or out.
+/// The owner applies the changes and calls OnStreamedIn() / OnStreamInFailed() when an upload finishes.
+/// </summary>
+class TextureResidency
+{
+public:
+    // Finer mips stay resident for this many updates after they were last needed
+    static constexpr const uint32_t kEvictionDelay = 60;
+
+    struct TextureDesc
+    {
+        uint32_t Width = 0;
+        uint32_t Height = 0;
+        uint32_t MipCount = 0;
+        // Mips from this one to the last are always resident
+        uint32_t TailMip = 0;
+        // Bytes needed to make every mip resident, finest first
+        std::vector<uint64_t> MipSizes;
+    };
+
+    struct Change
+    {
+        uint32_t Texture;
+        // Finest mip resident before the change
+        uint32_t ResidentMip;
+        // Finest mip after the change. Larger than ResidentMip for evictions
+        uint32_t TargetMip;
+    };
+
+public:
+    /// <summary>
+    /// Returns the mip that matches a texture covering screenSize pixels along its largest side
+    /// </summary>
+    static uint32_t ComputeMip(uint32_t width, uint32_t height, uint32_t mipCount, float screenSize);
+
+public:
+    uint32_t AddTexture(const TextureDesc &desc);
+    void Clear();
+
+    /// <summary>
+    /// Reports that texture covers screenSize pixels this frame. Several requests keep the largest one
+    /// </summary>
+    void Request(uint32_t texture, float screenSize);
+
+    /// <summary>
+    /// Fits the requested mips in budget bytes and appends the textures that must change to changes.
+    /// Evictions are final: the mips are no longer counted as soon as they're reported. Stream-ins become
+    /// pending and are capped to maxStreamInBytes per update; no other change is reported for a texture
+    /// until its stream-in finished
+    /// </summary>
+    void Update(uint64_t budget, uint64_t maxStreamInBytes, std::vector<Change> &changes);
+
+    void OnStreamedIn(uint32_t texture, uint32_t mip);
+    void OnStreamInFailed(uint32_t texture);
+
+    /// <summary>
+    /// Drops texture to mip right away, as if it hadn't been requested for a while. Returns false, and leaves
+    /// change alone, if a stream-in is pending or nothing finer than mip is resident. The next request brings it back
+    /// </summary>
+    bool Evict(uint32_t texture, uint32_t mip, Change &change);
+
+public:
+    uint32_t GetTextureCount() const;
+    uint32_t GetResidentMip(uint32_t texture) const;
+    /// <summary>
+    /// Finest mip that is resident or streaming in
+    /// </summary>
+    uint32_t GetPendingMip(uint32_t texture) const;
+    uint32_t GetWantedMip(uint32_t texture) const;
+    uint64_t GetResidentBytes() const;
+    /// <summary>
+    /// Bytes of the mips of texture from firstMip to the last
+    /// </summary>
+    uint64_t GetBytes(uint32_t texture, uint32_t firstMip) const;
+    uint32_t GetTailMip(uint32_t texture) const;
+    uint64_t GetPendingBytes() const;
+
+private:
+    struct TextureState
+    {
+        TextureDesc Desc;
+        uint32_t ResidentMip;
+        uint32_t PendingMip;
+        uint32_t WantedMip;
+
+        float RequestedScreenSize = 0.0f;
+
+        // Finest mip requested lately and the update until which it's kept
+        uint32_t HeldMip;
+        float HeldScreenSize = 0.0f;
+        uint64_t HeldUntil = 0;
+    };
+
+    struct Step
+    {
+        uint32_t Texture;
+        uint32_t Mip;
+        float Priority;
+    };
+
+private:
+    uint64_t GetBytes(const TextureState &state, uint32_t firstMip) const;
+
+private:
+    std::vector<TextureState> mTextures;
+    uint64_t mUpdate = 0;
+
+    // Scratch memory, kept around so Update() doesn't allocate every frame
+    std::vector<Step> mSteps;
+    std::vector<uint32_t> mAllowedMips;
+    std::vector<uint8_t> mBlocked;
+};
@@ -0,0 +1,78 @@
+#include "TextureTable.h"
+
+uint32_t TextureTable::Add()
+{
+    mEntries.emplace_back();
+    return (uint32_t)mEntries.size() - 1;
+}
+
+void TextureTable::Release(uint32_t index)
+{
+    mEntries[index].Generation++;
+}
+
+auto TextureTable::GetEntry(uint32_t index) -> Entry &
+{
+    return mEntries[index];
+}
+
+auto TextureTable::GetEntry(uint32_t index) const -> const Entry &
+{
+    return mEntries[index];
+}
+
+uint32_t TextureTable::GetSize() const
+{
+    return (uint32_t)mEntries.size();
+}
+
+bool TextureTable::IsEmpty() const
+{
+    return mEntries.empty();
+}
+
+auto TextureTable::GetHandle(uint32_t index) const -> Handle
+{
+    return Handle{ index, mEntries[index].Generation };
+}
+
+bool TextureTable::IsValid(Handle handle) const
+{
+    return handle.Index < mEntries.size() && mEntries[handle.Index].Generation == handle.Generation;
+}
+
+uint64_t TextureTable::GetSrvGPU(Handle handle) const
+{
+    const auto &entry = mEntries[handle.Index];
+    return entry.Generation == handle.Generation ? entry.SrvGPU : 0;
+}
+
+uint64_t TextureTable::GetUavGPU(Handle handle) const
+{
+    const auto &entry = mEntries[handle.Index];
+    return entry.Generation == handle.Generation ? entry.UavGPU : 0;
+}
+
+uint64_t TextureTable::GetRtvCPU(Handle handle) const
+{
+    const auto &entry = mEntries[handle.Index];
+    return entry.Generation == handle.Generation ? entry.RtvCPU : 0;
+}
+
+uint64_t TextureTable::GetDsvCPU(Handle handle) const
+{
+    const auto &entry = mEntries[handle.Index];
+    return entry.Generation == handle.Generation ? entry.DsvCPU : 0;
+}
+
+void TextureTable::WriteSrvIndices(int32_t *table) const
+{
+    for (uint32_t i = 0; i < (uint32_t)mEntries.size(); ++i)
+    {
+        table[i] = mEntries[i].HeapIndices[kSrv];
+    }
+    if (mEntries.empty())
+    {
+        table[0] = -1;
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// One entry per texture index: the descriptor heap indices of its views, the descriptor handles computed from them
+/// and a generation. It only does bookkeeping, there's no D3D in here: handles are the ptr values of the D3D12
+/// descriptor handles, which the owner computes again when a heap moves. Binding is a lookup by Handle, checked
+/// against the generation so that handles kept across a removal stop resolving
+/// </summary>
+class TextureTable
+{
+public:
+    // Views, as indices of Entry::HeapIndices
+    static constexpr const uint32_t kSrv = 0;
+    static constexpr const uint32_t kUav = 1;
+    static constexpr const uint32_t kRtv = 2;
+    static constexpr const uint32_t kDsv = 3;
+    static constexpr const uint32_t kViewCount = 4;
+
+    /// <summary>
+    /// Texture index with the generation of its slot
+    /// </summary>
+    struct Handle
+    {
+        uint32_t Index = 0;
+        uint32_t Generation = 0;
+    };
+
+    struct Entry
+    {
+        // What binding reads comes first
+        uint64_t SrvGPU = 0;
+        uint64_t UavGPU = 0;
+        uint64_t SrvCPU = 0;
+        uint64_t UavCPU = 0;
+        uint64_t RtvCPU = 0;
+        uint64_t DsvCPU = 0;
+        // Starts at 1, so a default constructed Handle never resolves
+        uint32_t Generation = 1;
+        // -1 if the texture doesn't have that view
+        std::array<int32_t, kViewCount> HeapIndices = { -1, -1, -1, -1 };
+    };
+
+public:
+    /// <summary>
+    /// Appends an entry without views and returns its index
+    /// </summary>
+    uint32_t Add();
+    /// <summary>
+    /// Bumps the generation of index, so the handles to what was there stop resolving. The slot can be reused
+    /// </summary>
+    void Release(uint32_t index);
+
+    Entry &GetEntry(uint32_t index);
+    const Entry &GetEntry(uint32_t index) const;
+    uint32_t GetSize() const;
+    bool IsEmpty() const;
+
+    Handle GetHandle(uint32_t index) const;
+    bool IsValid(Handle handle) const;
+    /// <summary>
+    /// 0 for a stale handle or a view the texture doesn't have
+    /// </summary>
+    uint64_t GetSrvGPU(Handle handle) const;
+    uint64_t GetUavGPU(Handle handle) const;
+    uint64_t GetRtvCPU(Handle handle) const;
+    uint64_t GetDsvCPU(Handle handle) const;
+
+    /// <summary>
+    /// Writes the shader resource view heap index of every entry to table, -1 where there's none.
+    /// table has room for max(GetSize(), 1) indices; a table without entries gets a single -1
+    /// </summary>
+    void WriteSrvIndices(int32_t *table) const;
+
+private:
+    std::vector<Entry> mEntries;
+};
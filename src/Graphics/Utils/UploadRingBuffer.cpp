@@ -0,0 +1,133 @@
+#include "UploadRingBuffer.h"
+
+UploadRingBuffer::~UploadRingBuffer()
+{
+    for (auto &segment : mSegments)
+    {
+        if (segment.Resource)
+        {
+            segment.Resource->Unmap(0, nullptr);
+        }
+    }
+}
+
+bool UploadRingBuffer::Init(uint64_t frameSize)
+{
+    for (uint32_t i = 0; i < mSegments.size(); ++i)
+    {
+        auto &segment = mSegments[i];
+        auto bufferResult = CreateMappedBuffer(frameSize);
+        CHECK(bufferResult.Valid(), false, "Unable to create upload ring segment {} with size {}", i, frameSize);
+        std::tie(segment.Resource, segment.MappedData) = bufferResult.Get();
+        segment.Size = frameSize;
+        segment.Offset = 0;
+    }
+    mFrameIndex = 0;
+    return true;
+}
+
+void UploadRingBuffer::BeginFrame(uint32_t frameIndex)
+{
+    auto &segment = mSegments[frameIndex];
+
+    if (!segment.OverflowResources.empty())
+    {
+        // The GPU is done with this frame, so it's safe to replace the segment with a bigger one
+        uint64_t newSize = Math::AlignUp(segment.Size + segment.OverflowSize, (uint64_t)_64KiB);
+        SHOWWARNING("Upload ring segment {} overflowed by {} bytes. Growing it from {} to {} bytes",
+                    frameIndex, segment.OverflowSize, segment.Size, newSize);
+
+        segment.OverflowResources.clear();
+        segment.OverflowSize = 0;
+
+        auto bufferResult = CreateMappedBuffer(newSize);
+        if (bufferResult.Valid())
+        {
+            segment.Resource->Unmap(0, nullptr);
+            std::tie(segment.Resource, segment.MappedData) = bufferResult.Get();
+            segment.Size = newSize;
+        }
+        else
+        {
+            SHOWFATAL("Unable to grow upload ring segment {} to {} bytes", frameIndex, newSize);
+        }
+    }
+
+    mLastFrameUsed = GetUsed();
+    segment.Offset = 0;
+    mFrameIndex = frameIndex;
+}
+
+auto UploadRingBuffer::Allocate(uint64_t size, uint64_t alignment) -> Allocation
+{
+    auto &segment = mSegments[mFrameIndex];
+
+    Allocation allocation = {};
+    CHECK(size > 0, allocation, "Unable to allocate 0 bytes from the upload ring");
+    allocation.Size = size;
+
+    uint64_t alignedOffset = Math::AlignUp(segment.Offset, alignment);
+    if (alignedOffset + size <= segment.Size)
+    {
+        segment.Offset = alignedOffset + size;
+        allocation.CPU = segment.MappedData + alignedOffset;
+        allocation.GPU = segment.Resource->GetGPUVirtualAddress() + alignedOffset;
+    }
+    else
+    {
+        uint64_t overflowSize = Math::AlignUp(size, kConstantBufferAlignment);
+        auto bufferResult = CreateMappedBuffer(overflowSize);
+        CHECK(bufferResult.Valid(), allocation, "Unable to allocate {} bytes from the upload ring", size);
+
+        auto [resource, mappedData] = bufferResult.Get();
+        allocation.CPU = mappedData;
+        allocation.GPU = resource->GetGPUVirtualAddress();
+
+        // Upload heaps can stay mapped until they are released
+        segment.OverflowResources.push_back(resource);
+        segment.OverflowSize += overflowSize;
+    }
+
+    mPeak = std::max(mPeak, GetUsed());
+    return allocation;
+}
+
+uint64_t UploadRingBuffer::GetFrameSize() const
+{
+    return mSegments[mFrameIndex].Size;
+}
+
+uint64_t UploadRingBuffer::GetUsed() const
+{
+    const auto &segment = mSegments[mFrameIndex];
+    return segment.Offset + segment.OverflowSize;
+}
+
+uint64_t UploadRingBuffer::GetLastFrameUsed() const
+{
+    return mLastFrameUsed;
+}
+
+uint64_t UploadRingBuffer::GetPeak() const
+{
+    return mPeak;
+}
+
+Result<std::tuple<ComPtr<ID3D12Resource>, uint8_t *>> UploadRingBuffer::CreateMappedBuffer(uint64_t size)
+{
+    auto device = Direct3D::Get()->GetD3D12Device();
+
+    ComPtr<ID3D12Resource> resource;
+    auto uploadHeap = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+    auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+    CHECK_HR(device->CreateCommittedResource(
+        &uploadHeap, D3D12_HEAP_FLAG_NONE,
+        &bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr, IID_PPV_ARGS(&resource)), std::nullopt);
+
+    uint8_t *mappedData = nullptr;
+    CD3DX12_RANGE readRange(0, 0);
+    CHECK_HR(resource->Map(0, &readRange, (void **)&mappedData), std::nullopt);
+
+    return std::make_tuple(resource, mappedData);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+
+#include <Oblivion.h>
+#include <ISingletone.h>
+#include "../Direct3D.h"
+
+/// <summary>
+/// One large persistently mapped upload buffer for every frame in flight. Per-frame data
+/// (constants, instances, dynamic vertices) is sub-allocated linearly from the segment of the
+/// current frame and is valid until the fence of that frame completes.
+/// </summary>
+class UploadRingBuffer : public ISingletone<UploadRingBuffer>
+{
+    MAKE_SINGLETONE_CAPABLE(UploadRingBuffer);
+
+public:
+    static constexpr const uint64_t kDefaultFrameSize = _8MiB;
+    static constexpr const uint64_t kConstantBufferAlignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+
+    struct Allocation
+    {
+        void *CPU = nullptr;
+        D3D12_GPU_VIRTUAL_ADDRESS GPU = 0;
+        uint64_t Size = 0;
+
+        bool Valid() const
+        {
+            return CPU != nullptr;
+        }
+    };
+
+private:
+    struct FrameSegment
+    {
+        ComPtr<ID3D12Resource> Resource;
+        uint8_t *MappedData = nullptr;
+        uint64_t Size = 0;
+        uint64_t Offset = 0;
+
+        // Buffers created when the segment was full; released when the frame comes around again
+        std::vector<ComPtr<ID3D12Resource>> OverflowResources;
+        uint64_t OverflowSize = 0;
+    };
+
+private:
+    UploadRingBuffer() = default;
+    ~UploadRingBuffer();
+
+public:
+    bool Init(uint64_t frameSize = kDefaultFrameSize);
+
+    /// <summary>
+    /// Must be called after waiting for the fence of the frame resource at frameIndex
+    /// </summary>
+    void BeginFrame(uint32_t frameIndex);
+
+    Allocation Allocate(uint64_t size, uint64_t alignment = 16);
+
+    template <typename T>
+    Allocation AllocateConstantBuffer()
+    {
+        return Allocate(sizeof(T), kConstantBufferAlignment);
+    }
+
+    template <typename T>
+    Allocation AllocateArray(uint32_t count)
+    {
+        return Allocate((uint64_t)sizeof(T) * count, std::max<uint64_t>(alignof(T), 16));
+    }
+
+public:
+    uint64_t GetFrameSize() const;
+    uint64_t GetUsed() const;
+    uint64_t GetLastFrameUsed() const;
+    uint64_t GetPeak() const;
+
+private:
+    Result<std::tuple<ComPtr<ID3D12Resource>, uint8_t *>> CreateMappedBuffer(uint64_t size);
+
+private:
+    std::array<FrameSegment, Direct3D::kBufferCount> mSegments;
+    uint32_t mFrameIndex = 0;
+
+    uint64_t mLastFrameUsed = 0;
+    uint64_t mPeak = 0;
+};
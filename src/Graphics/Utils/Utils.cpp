@@ -2,6 +2,32 @@
 
 #include "Conversions.h"
 
+Result<ComPtr<ID3DBlob>> Utils::CompileShader(LPCWSTR filename, LPCSTR profile, const D3D_SHADER_MACRO *defines)
+{
+    uint32_t flags = D3DCOMPILE_ENABLE_STRICTNESS;
+#if DEBUG || _DEBUG
+    flags |= D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#else
+    flags |= D3DCOMPILE_OPTIMIZATION_LEVEL3;
+#endif
+
+    ComPtr<ID3DBlob> shader, errors;
+    HRESULT result = D3DCompileFromFile(filename, defines, D3D_COMPILE_STANDARD_FILE_INCLUDE, "main", profile, flags, 0,
+                                        &shader, &errors);
+    CHECK(SUCCEEDED(result), std::nullopt, "Unable to compile {} for {}: {}", Conversions::ws2s(filename), profile,
+          errors ? (const char *)errors->GetBufferPointer() : "no compiler output");
+    return shader;
+}
+
+std::wstring Utils::GetExecutableDirectory()
+{
+    wchar_t path[MAX_PATH];
+    DWORD length = GetModuleFileNameW(nullptr, path, MAX_PATH);
+    CHECK(length > 0 && length < MAX_PATH, L"", "Unable to get the path of the executable");
+
+    std::wstring directory(path, length);
+    return directory.substr(0, directory.find_last_of(L"\\/") + 1);
+}
 
 std::tuple<ComPtr<ID3D12Resource>, ComPtr<ID3D12Resource>> Utils::CreateDefaultBuffer(ID3D12Device *device,
                                                                                       ID3D12GraphicsCommandList *cmdList,
@@ -38,7 +64,8 @@ std::tuple<ComPtr<ID3D12Resource>, ComPtr<ID3D12Resource>> Utils::CreateDefaultB
 
     UpdateSubresources<1>(cmdList, finalResource.Get(), temporaryResource.Get(), 0, 0, 1, &subresourceData);
 
-    if (state != D3D12_RESOURCE_STATE_COPY_DEST)
+    // On a copy queue the buffer decays to COMMON after the copy and is promoted implicitly on first use
+    if (state != D3D12_RESOURCE_STATE_COPY_DEST && cmdList->GetType() != D3D12_COMMAND_LIST_TYPE_COPY)
     {
         CD3DX12_RESOURCE_BARRIER barrier =
             CD3DX12_RESOURCE_BARRIER::Transition(finalResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, state);
@@ -4,7 +4,11 @@
 
 namespace Utils
 {
-    Result<ComPtr<ID3DBlob>> CompileShader(LPCWSTR filename, LPCSTR profile);
+    // Compiles main() from an HLSL file; defines ends with a { nullptr, nullptr } entry. Safe to call from any thread
+    Result<ComPtr<ID3DBlob>> CompileShader(LPCWSTR filename, LPCSTR profile, const D3D_SHADER_MACRO *defines = nullptr);
+
+    // Directory of the running executable, ending with a separator. Empty if it can't be found
+    std::wstring GetExecutableDirectory();
 
     std::tuple<ComPtr<ID3D12Resource>, ComPtr<ID3D12Resource>> CreateDefaultBuffer(
         ID3D12Device *device, ID3D12GraphicsCommandList *cmdList, D3D12_RESOURCE_STATES state, void *data, uint32_t dataSize);
@@ -11,19 +11,7 @@ cbuffer cbPerFrame : register(b0)
     float3 CameraPosition;
 };
 
-cbuffer cbMaterial : register(b1)
-{
-    float4 DiffuseAlbedo;
-
-    float3 FresnelR0;
-    float Shininess;
-
-    float4x4 MatTransform;
-
-    int HasTexture;
-};
-
-cbuffer SceneLights : register(b2)
+cbuffer SceneLights : register(b1)
 {
     float4 AmbientColor;
 
@@ -34,10 +22,36 @@ cbuffer SceneLights : register(b2)
     unsigned int NumSpotLights;
 };
 
+cbuffer ClusterInfo : register(b2)
+{
+    uint3 ClusterGridSize;
+    uint ClusteredPointLights;
+    float2 InvScreenSize;
+    float ClusterDepthScale;
+    float ClusterDepthBias;
+};
+
 struct InstanceInfo
 {
     row_major float4x4 World;
     float4 Color;
+    uint MaterialIndex;
+    uint3 Padding;
+};
+
+// MaterialConstants, padded to the 256 bytes every material takes in the materials buffer
+struct MaterialData
+{
+    float4 DiffuseAlbedo;
+
+    float3 FresnelR0;
+    float Shininess;
+
+    float4x4 MatTransform;
+
+    int TextureIndex;
+    uint3 Padding0;
+    float4 Padding1[9];
 };
 
 struct VSIn
@@ -51,14 +65,25 @@ struct VSOut
 {
     float4 Position : SV_POSITION;
     float3 PositionW : POSITION;
+    float ViewDepth : DEPTH;
     float3 NormalW : NORMAL;
     float2 TexCoord : TEXCOORD;
     float4 Color : COLOR;
+    nointerpolation uint MaterialIndex : MATERIAL;
 };
 
 StructuredBuffer<InstanceInfo> instanceData : register(t0, space1);
+StructuredBuffer<MaterialData> materials : register(t1, space1);
+// Shader resource view of every texture index, as an index in textures. -1 if it has none
+StructuredBuffer<int> textureTable : register(t2, space1);
+
+// Point lights followed by spotlights, binned by SceneLight::UpdateClusteredLights
+StructuredBuffer<Light> clusteredLights : register(t3, space1);
+StructuredBuffer<LightCluster> lightClusters : register(t4, space1);
+StructuredBuffer<uint> clusterLightIndices : register(t5, space1);
 
-Texture2D diffuseMap : register(t0);
+// The whole shader visible heap of TextureManager
+Texture2D textures[] : register(t0, space2);
 
 SamplerState wrapLinearSampler : register(s0);
 SamplerState wrapPointSampler : register(s1);
@@ -0,0 +1,55 @@
+#include "Common.hlsli"
+
+
+float4 main(VSOut input) : SV_TARGET
+{
+    input.NormalW = normalize(input.NormalW);
+
+    MaterialData material = materials[input.MaterialIndex];
+
+    float4 diffuseColor = material.DiffuseAlbedo;
+    if (material.TextureIndex != -1)
+    {
+        int descriptorIndex = textureTable[material.TextureIndex];
+        if (descriptorIndex != -1)
+        {
+            // Instances of one draw may use different textures
+            diffuseColor = textures[NonUniformResourceIndex(descriptorIndex)].Sample(clampLinearSampler, input.TexCoord);
+        }
+    }
+    diffuseColor *= input.Color;
+
+    float3 toEyeW = CameraPosition - input.PositionW;
+    float distToEye = length(toEyeW);
+    toEyeW /= distToEye;
+
+    float4 finalColor = AmbientColor * diffuseColor;
+
+    Material mat;
+    mat.DiffuseAlbedo = diffuseColor;
+    mat.FresnelR0 = material.FresnelR0;
+    mat.Shininess = material.Shininess;
+    // Only the directional lights come from SceneLights, the others from the pixel's cluster
+    float4 directLight = ComputeLighting(Lights, NumDirectionalLights, 0, 0, mat, input.PositionW.xyz, input.NormalW, toEyeW);
+
+    uint clusterIndex = GetClusterIndex(input.Position.xy, input.ViewDepth, InvScreenSize, ClusterGridSize,
+                                        ClusterDepthScale, ClusterDepthBias);
+    LightCluster cluster = lightClusters[clusterIndex];
+    for (uint i = 0; i < cluster.Count; ++i)
+    {
+        uint lightIndex = clusterLightIndices[cluster.Offset + i];
+        if (lightIndex < ClusteredPointLights)
+        {
+            directLight.rgb += ComputePointLight(clusteredLights[lightIndex], mat, input.PositionW.xyz, input.NormalW, toEyeW);
+        }
+        else
+        {
+            directLight.rgb += ComputeSpotlight(clusteredLights[lightIndex], mat, input.PositionW.xyz, input.NormalW, toEyeW);
+        }
+    }
+
+    finalColor += directLight;
+    finalColor.a = diffuseColor.a;
+
+    return finalColor;
+}
@@ -0,0 +1,24 @@
+#include "Common.hlsli"
+
+
+VSOut main(in VSIn input, uint instanceID : SV_InstanceID)
+{
+    VSOut output;
+
+    float4x4 VP = mul(View, Projection);
+
+    InstanceInfo instance = instanceData[instanceID];
+    output.Color = instance.Color;
+    output.MaterialIndex = instance.MaterialIndex;
+
+    output.PositionW = mul(float4(input.Position, 1.0f), instance.World).xyz;
+    output.Position = mul(float4(output.PositionW, 1.0f), VP);
+    output.ViewDepth = mul(float4(output.PositionW, 1.0f), View).z;
+
+    output.NormalW = mul(input.Normal, (float3x3) instance.World);
+
+    float4 texC = float4(input.TexCoord, 0.0f, 1.0f);
+    output.TexCoord = mul(texC, materials[instance.MaterialIndex].MatTransform).xy;
+
+    return output;
+}
@@ -132,6 +132,21 @@ float4 ComputeLighting(Light lights[MAX_LIGHTS], int numDirectionalLights, int n
     return float4(result, 0.0f);
 }
 
+struct LightCluster
+{
+    uint Offset;
+    uint Count;
+};
+
+// Same order as LightClusterBuilder: slice, then tile row from the top of the screen, then tile column
+uint GetClusterIndex(float2 screenPosition, float viewDepth, float2 invScreenSize, uint3 gridSize,
+                     float depthScale, float depthBias)
+{
+    uint2 tile = min(uint2(screenPosition * invScreenSize * float2(gridSize.xy)), gridSize.xy - 1);
+    uint slice = (uint) clamp(floor(log(viewDepth) * depthScale + depthBias), 0.0f, float(gridSize.z - 1));
+    return (slice * gridSize.y + tile.y) * gridSize.x + tile.x;
+}
+
 #define BILINEAR_INTERPOLATION_IMPLEMENTATION(type) \
 type BilinearInterpolation(type params[4], float2 interpolationParams) \
 { \
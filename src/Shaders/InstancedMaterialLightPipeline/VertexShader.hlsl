@@ -1,20 +1,3 @@
-#include "Common.hlsli"
-
-
-VSOut main(in VSIn input)
-{
-    VSOut output;
-    
-    float4x4 VP = mul(View, Projection);
-    
-    output.PositionW = mul(float4(input.Position, 1.0f), input.World).xyz;
-    output.Position = mul(float4(output.PositionW, 1.0f), VP);
-    
-    output.NormalW = mul(input.Normal, (float3x3) input.World);
-    
-    float4 texC = mul(float4(input.TexCoord, 0.0f, 1.0f), input.TexWorld);
-    output.TexCoord = mul(texC, MatTransform).xy;
-
-    return output;
-}
-
+// The permutation source with its generic defaults, instanced through a per instance vertex stream
+#define INSTANCING_MODE INSTANCING_VERTEX_STREAM
+#include "../MaterialLightPermutations/VertexShader.hlsl"
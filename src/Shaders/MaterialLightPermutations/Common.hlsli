@@ -0,0 +1,121 @@
+#ifndef __COMMON_HLSLI__
+#define __COMMON_HLSLI__
+
+#include "../Common/Utils.hlsli"
+
+// Permutation defines, set by PipelineManager for every variant. The defaults are the most general one
+
+// The material has a diffuse texture. The generic pipelines serve every material, so they check HasTexture per draw
+#define TEXTURE_NONE 0
+#define TEXTURE_ALWAYS 1
+#define TEXTURE_PER_MATERIAL 2
+#ifndef HAS_TEXTURE
+#define HAS_TEXTURE TEXTURE_PER_MATERIAL
+#endif
+
+#define INSTANCING_NONE 0
+#define INSTANCING_VERTEX_STREAM 1
+#define INSTANCING_STRUCTURED_BUFFER 2
+#ifndef INSTANCING_MODE
+#define INSTANCING_MODE INSTANCING_NONE
+#endif
+
+// Most lights evaluated per pixel, directional ones first
+#ifndef LIGHT_COUNT
+#define LIGHT_COUNT MAX_LIGHTS
+#endif
+
+#if INSTANCING_MODE == INSTANCING_STRUCTURED_BUFFER
+// PassMaterialLightsTextureInstance root signature
+#define PASS_REGISTER b0
+#define MATERIAL_REGISTER b1
+#define LIGHTS_REGISTER b2
+#else
+// ObjectFrameMaterialLights root signature
+#define PASS_REGISTER b1
+#define MATERIAL_REGISTER b2
+#define LIGHTS_REGISTER b3
+#endif
+
+#if INSTANCING_MODE == INSTANCING_NONE
+cbuffer cbPerObject : register(b0)
+{
+    float4x4 World;
+    float4x4 TexTransform;
+};
+#endif
+
+cbuffer cbPerFrame : register(PASS_REGISTER)
+{
+    float4x4 View;
+    float4x4 Projection;
+    
+    float3 CameraPosition;
+};
+
+cbuffer cbMaterial : register(MATERIAL_REGISTER)
+{
+    float4 DiffuseAlbedo;
+
+    float3 FresnelR0;
+    float Shininess;
+
+    float4x4 MatTransform;
+    
+    int HasTexture;
+};
+
+cbuffer SceneLights : register(LIGHTS_REGISTER)
+{
+    float4 AmbientColor;
+
+    Light Lights[MAX_LIGHTS];
+    
+    unsigned int NumDirectionalLights;
+    unsigned int NumPointLights;
+    unsigned int NumSpotLights;
+};
+
+#if INSTANCING_MODE == INSTANCING_STRUCTURED_BUFFER
+struct InstanceInfo
+{
+    row_major float4x4 World;
+    float4 Color;
+};
+
+StructuredBuffer<InstanceInfo> instanceData : register(t0, space1);
+#endif
+
+struct VSIn
+{
+    float3 Position : POSITION;
+    float3 Normal : NORMAL;
+    float2 TexCoord : TEXCOORD;
+#if INSTANCING_MODE == INSTANCING_VERTEX_STREAM
+    
+    row_major float4x4 World : WORLDMATRIX;
+    row_major float4x4 TexWorld : TEXWORLDMATRIX;
+#endif
+};
+
+struct VSOut
+{
+    float4 Position : SV_POSITION;
+    float3 PositionW : POSITION;
+    float3 NormalW : NORMAL;
+#if HAS_TEXTURE
+    float2 TexCoord : TEXCOORD;
+#endif
+#if INSTANCING_MODE == INSTANCING_STRUCTURED_BUFFER
+    float4 Color : COLOR;
+#endif
+};
+
+Texture2D diffuseMap : register(t0);
+
+SamplerState wrapLinearSampler : register(s0);
+SamplerState wrapPointSampler : register(s1);
+SamplerState clampLinearSampler : register(s2);
+SamplerState clampPointSampler : register(s3);
+
+#endif // __COMMON_HLSLI__
@@ -0,0 +1,46 @@
+#include "Common.hlsli"
+
+
+float4 main(VSOut input) : SV_TARGET
+{
+    input.NormalW = normalize(input.NormalW);
+    
+#if HAS_TEXTURE == TEXTURE_PER_MATERIAL
+    float4 diffuseColor = DiffuseAlbedo;
+    if (HasTexture != -1)
+    {
+        diffuseColor = diffuseMap.Sample(clampLinearSampler, input.TexCoord);
+    }
+#elif HAS_TEXTURE
+    float4 diffuseColor = diffuseMap.Sample(clampLinearSampler, input.TexCoord);
+#else
+    float4 diffuseColor = DiffuseAlbedo;
+#endif
+#if INSTANCING_MODE == INSTANCING_STRUCTURED_BUFFER
+    diffuseColor *= input.Color;
+#endif
+    
+    float4 finalColor = AmbientColor * diffuseColor;
+    
+#if LIGHT_COUNT > 0
+    float3 toEyeW = CameraPosition - input.PositionW;
+    float distToEye = length(toEyeW);
+    toEyeW /= distToEye;
+
+    Material mat;
+    mat.DiffuseAlbedo = diffuseColor;
+    mat.FresnelR0 = FresnelR0;
+    mat.Shininess = Shininess;
+
+    // The loops can't run past LIGHT_COUNT, which the compiler knows
+    uint numDirectionalLights = min(NumDirectionalLights, LIGHT_COUNT);
+    uint numPointLights = min(NumPointLights, LIGHT_COUNT - numDirectionalLights);
+    uint numSpotLights = min(NumSpotLights, LIGHT_COUNT - numDirectionalLights - numPointLights);
+    float4 directLight = ComputeLighting(Lights, numDirectionalLights, numPointLights, numSpotLights, mat, input.PositionW.xyz, input.NormalW, toEyeW);
+    
+    finalColor += directLight;
+#endif
+    finalColor.a = diffuseColor.a;
+    
+    return finalColor;
+}
@@ -0,0 +1,38 @@
+#include "Common.hlsli"
+
+
+#if INSTANCING_MODE == INSTANCING_STRUCTURED_BUFFER
+VSOut main(in VSIn input, uint instanceID : SV_InstanceID)
+#else
+VSOut main(in VSIn input)
+#endif
+{
+    VSOut output;
+    
+    float4x4 VP = mul(View, Projection);
+
+#if INSTANCING_MODE == INSTANCING_NONE
+    float4x4 world = World;
+    float4x4 texTransform = TexTransform;
+#elif INSTANCING_MODE == INSTANCING_VERTEX_STREAM
+    float4x4 world = input.World;
+    float4x4 texTransform = input.TexWorld;
+#else
+    float4x4 world = instanceData[instanceID].World;
+    output.Color = instanceData[instanceID].Color;
+#endif
+    
+    output.PositionW = mul(float4(input.Position, 1.0f), world).xyz;
+    output.Position = mul(float4(output.PositionW, 1.0f), VP);
+    
+    output.NormalW = mul(input.Normal, (float3x3) world);
+
+#if HAS_TEXTURE && INSTANCING_MODE == INSTANCING_STRUCTURED_BUFFER
+    output.TexCoord = input.TexCoord;
+#elif HAS_TEXTURE
+    float4 texC = mul(float4(input.TexCoord, 0.0f, 1.0f), texTransform);
+    output.TexCoord = mul(texC, MatTransform).xy;
+#endif
+
+    return output;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+
+template <typename Signature>
+class FunctionRef;
+
+/// <summary>
+/// Non-owning reference to a callable. Unlike std::function it never allocates,
+/// so it must not outlive the callable it was constructed from
+/// </summary>
+template <typename Ret, typename... Args>
+class FunctionRef<Ret(Args...)>
+{
+public:
+    template <typename Callable,
+              typename = std::enable_if_t<!std::is_same_v<std::decay_t<Callable>, FunctionRef> &&
+                                          std::is_invocable_r_v<Ret, Callable &, Args...>>>
+    FunctionRef(Callable &&callable) noexcept :
+        mCallable((void *)std::addressof(callable)),
+        mInvoke([](void *callable, Args... args) -> Ret
+                {
+                    return (*(std::remove_reference_t<Callable> *)callable)(std::forward<Args>(args)...);
+                })
+    {
+    }
+
+    Ret operator()(Args... args) const
+    {
+        return mInvoke(mCallable, std::forward<Args>(args)...);
+    }
+
+private:
+    void *mCallable;
+    Ret (*mInvoke)(void *, Args...);
+};
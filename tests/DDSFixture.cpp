@@ -0,0 +1,158 @@
+#include "DDSFixture.h"
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+#pragma pack(push, 1)
+struct DDSPixelFormat
+{
+    uint32_t Size;
+    uint32_t Flags;
+    uint32_t FourCC;
+    uint32_t RGBBitCount;
+    uint32_t RBitMask;
+    uint32_t GBitMask;
+    uint32_t BBitMask;
+    uint32_t ABitMask;
+};
+
+struct DDSHeader
+{
+    uint32_t Size;
+    uint32_t Flags;
+    uint32_t Height;
+    uint32_t Width;
+    uint32_t PitchOrLinearSize;
+    uint32_t Depth;
+    uint32_t MipMapCount;
+    uint32_t Reserved1[11];
+    DDSPixelFormat PixelFormat;
+    uint32_t Caps;
+    uint32_t Caps2;
+    uint32_t Caps3;
+    uint32_t Caps4;
+    uint32_t Reserved2;
+};
+
+struct DDSHeaderDXT10
+{
+    uint32_t Format;
+    uint32_t ResourceDimension;
+    uint32_t MiscFlag;
+    uint32_t ArraySize;
+    uint32_t MiscFlags2;
+};
+#pragma pack(pop)
+
+static constexpr uint32_t kDDSMagic = 0x20534444; // "DDS "
+static constexpr uint32_t kDX10FourCC = 0x30315844; // "DX10"
+
+static constexpr uint32_t kDDSFlagsCaps = 0x1;
+static constexpr uint32_t kDDSFlagsHeight = 0x2;
+static constexpr uint32_t kDDSFlagsWidth = 0x4;
+static constexpr uint32_t kDDSFlagsPitch = 0x8;
+static constexpr uint32_t kDDSFlagsPixelFormat = 0x1000;
+static constexpr uint32_t kDDSFlagsMipMapCount = 0x20000;
+static constexpr uint32_t kDDSPixelFormatAlphaPixels = 0x1;
+static constexpr uint32_t kDDSPixelFormatFourCC = 0x4;
+static constexpr uint32_t kDDSPixelFormatRGB = 0x40;
+static constexpr uint32_t kDDSCapsComplex = 0x8;
+static constexpr uint32_t kDDSCapsTexture = 0x1000;
+static constexpr uint32_t kDDSCapsMipMap = 0x400000;
+static constexpr uint32_t kDDSCaps2CubeMapAllFaces = 0xFE00;
+
+static constexpr uint32_t kFormatR8G8B8A8Unorm = 28; // DXGI_FORMAT_R8G8B8A8_UNORM
+static constexpr uint32_t kResourceDimensionTexture2D = 3; // D3D12_RESOURCE_DIMENSION_TEXTURE2D
+static constexpr uint32_t kMiscFlagTextureCube = 0x4; // D3D11_RESOURCE_MISC_TEXTURECUBE
+
+namespace DDSFixture
+{
+
+uint32_t GetTexel(uint32_t slice, uint32_t mip, uint32_t x, uint32_t y)
+{
+    uint32_t hash = 2166136261u;
+    for (uint32_t value : { slice, mip, x, y })
+    {
+        hash = (hash ^ value) * 16777619u;
+    }
+    return hash;
+}
+
+bool Write(const std::filesystem::path &path, const Description &description)
+{
+    uint32_t mipCount = std::max(description.MipCount, 1u);
+    uint32_t arraySize = std::max(description.ArraySize, 1u);
+    bool dx10Header = description.DX10Header || arraySize > 1;
+
+    DDSHeader header = {};
+    header.Size = sizeof(DDSHeader);
+    header.Flags = kDDSFlagsCaps | kDDSFlagsHeight | kDDSFlagsWidth | kDDSFlagsPixelFormat | kDDSFlagsPitch |
+        (mipCount > 1 ? kDDSFlagsMipMapCount : 0);
+    header.Height = description.Height;
+    header.Width = description.Width;
+    header.PitchOrLinearSize = description.Width * 4;
+    header.MipMapCount = mipCount;
+    header.PixelFormat.Size = sizeof(DDSPixelFormat);
+    if (dx10Header)
+    {
+        header.PixelFormat.Flags = kDDSPixelFormatFourCC;
+        header.PixelFormat.FourCC = kDX10FourCC;
+    }
+    else
+    {
+        header.PixelFormat.Flags = kDDSPixelFormatRGB | kDDSPixelFormatAlphaPixels;
+        header.PixelFormat.RGBBitCount = 32;
+        header.PixelFormat.RBitMask = 0x000000FF;
+        header.PixelFormat.GBitMask = 0x0000FF00;
+        header.PixelFormat.BBitMask = 0x00FF0000;
+        header.PixelFormat.ABitMask = 0xFF000000;
+    }
+    header.Caps = kDDSCapsTexture | (mipCount > 1 ? kDDSCapsComplex | kDDSCapsMipMap : 0) |
+        (description.CubeMap ? kDDSCapsComplex : 0);
+    header.Caps2 = description.CubeMap ? kDDSCaps2CubeMapAllFaces : 0;
+
+    DDSHeaderDXT10 headerDXT10 = {};
+    headerDXT10.Format = kFormatR8G8B8A8Unorm;
+    headerDXT10.ResourceDimension = kResourceDimensionTexture2D;
+    headerDXT10.MiscFlag = description.CubeMap ? kMiscFlagTextureCube : 0;
+    headerDXT10.ArraySize = arraySize;
+
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream)
+    {
+        return false;
+    }
+
+    stream.write((const char *)&kDDSMagic, sizeof(kDDSMagic));
+    stream.write((const char *)&header, sizeof(header));
+    if (dx10Header)
+    {
+        stream.write((const char *)&headerDXT10, sizeof(headerDXT10));
+    }
+
+    // Slices, each with its whole mip chain
+    uint32_t sliceCount = arraySize * (description.CubeMap ? 6 : 1);
+    std::vector<uint32_t> texels;
+    for (uint32_t slice = 0; slice < sliceCount; ++slice)
+    {
+        for (uint32_t mip = 0; mip < mipCount; ++mip)
+        {
+            uint32_t width = std::max(description.Width >> mip, 1u);
+            uint32_t height = std::max(description.Height >> mip, 1u);
+            texels.resize((size_t)width * height);
+            for (uint32_t y = 0; y < height; ++y)
+            {
+                for (uint32_t x = 0; x < width; ++x)
+                {
+                    texels[(size_t)y * width + x] = GetTexel(slice, mip, x, y);
+                }
+            }
+            stream.write((const char *)texels.data(), texels.size() * sizeof(texels[0]));
+        }
+    }
+
+    return (bool)stream;
+}
+
+} // namespace DDSFixture
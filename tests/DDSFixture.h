@@ -0,0 +1,33 @@
+#pragma once
+
+
+#include <cstdint>
+#include <filesystem>
+
+/// <summary>
+/// Writes small uncompressed DDS files to load in tests and benchmarks. Texels are a hash of their
+/// array slice, mip and coordinates, so a subresource that's read from the wrong place doesn't match
+/// </summary>
+namespace DDSFixture
+{
+
+struct Description
+{
+    uint32_t Width = 64;
+    uint32_t Height = 64;
+    uint32_t MipCount = 1;
+    // Whole cubes for cube maps
+    uint32_t ArraySize = 1;
+    bool CubeMap = false;
+    // Arrays always get one, legacy headers can't describe them
+    bool DX10Header = false;
+};
+
+bool Write(const std::filesystem::path &path, const Description &description);
+
+/// <summary>
+/// RGBA8 texel value Write stores at (x, y) of the given slice (array element * 6 + face for cube maps) and mip
+/// </summary>
+uint32_t GetTexel(uint32_t slice, uint32_t mip, uint32_t x, uint32_t y);
+
+} // namespace DDSFixture
@@ -0,0 +1,154 @@
+#include "Test.h"
+#include "DDSFixture.h"
+
+#include "Utils/DDSTextureData.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+// Loads the fixture through the mapped path and through the heap path, and checks both describe the same texture
+// and every subresource holds the texels the fixture wrote
+static void ExpectSameThroughBothPaths(const char *name, const DDSFixture::Description &description)
+{
+    auto path = std::filesystem::temp_directory_path() / name;
+    EXPECT_TRUE(DDSFixture::Write(path, description));
+
+    DirectX::DDSTextureData mapped, heap;
+    EXPECT_TRUE(SUCCEEDED(DirectX::LoadDDSTextureData(path.wstring().c_str(), mapped)));
+    EXPECT_TRUE(SUCCEEDED(DirectX::LoadDDSTextureData(path.wstring().c_str(), heap, 0, false)));
+
+    uint32_t sliceCount = description.ArraySize * (description.CubeMap ? 6 : 1);
+    for (const auto *textureData : { &mapped, &heap })
+    {
+        EXPECT_TRUE(textureData->fileData != nullptr);
+        EXPECT_EQ(textureData->resDim, (uint32_t)D3D12_RESOURCE_DIMENSION_TEXTURE2D);
+        EXPECT_EQ(textureData->width, description.Width);
+        EXPECT_EQ(textureData->height, description.Height);
+        EXPECT_EQ(textureData->depth, 1u);
+        EXPECT_EQ(textureData->mipCount, description.MipCount);
+        EXPECT_EQ(textureData->arraySize, sliceCount);
+        EXPECT_EQ(textureData->format, DXGI_FORMAT_R8G8B8A8_UNORM);
+        EXPECT_EQ(textureData->isCubeMap, description.CubeMap);
+        EXPECT_EQ(textureData->subresources.size(), (size_t)sliceCount * description.MipCount);
+    }
+    if (mapped.subresources.size() != heap.subresources.size() || mapped.subresources.size() != (size_t)sliceCount * description.MipCount)
+    {
+        return;
+    }
+
+    // D3D12 subresource order: every mip of slice 0, then slice 1, ...
+    for (uint32_t slice = 0; slice < sliceCount; ++slice)
+    {
+        for (uint32_t mip = 0; mip < description.MipCount; ++mip)
+        {
+            const auto &mappedSubresource = mapped.subresources[slice * description.MipCount + mip];
+            const auto &heapSubresource = heap.subresources[slice * description.MipCount + mip];
+            uint32_t width = std::max(description.Width >> mip, 1u);
+            uint32_t height = std::max(description.Height >> mip, 1u);
+
+            EXPECT_EQ(mappedSubresource.RowPitch, (LONG_PTR)width * 4);
+            EXPECT_EQ(mappedSubresource.SlicePitch, (LONG_PTR)width * height * 4);
+            EXPECT_EQ(mappedSubresource.RowPitch, heapSubresource.RowPitch);
+            EXPECT_EQ(mappedSubresource.SlicePitch, heapSubresource.SlicePitch);
+            EXPECT_TRUE(std::memcmp(mappedSubresource.pData, heapSubresource.pData, heapSubresource.SlicePitch) == 0);
+
+            auto texels = (const uint32_t *)mappedSubresource.pData;
+            bool matchesFixture = true;
+            for (uint32_t y = 0; y < height; ++y)
+            {
+                for (uint32_t x = 0; x < width; ++x)
+                {
+                    matchesFixture &= texels[y * width + x] == DDSFixture::GetTexel(slice, mip, x, y);
+                }
+            }
+            EXPECT_TRUE(matchesFixture);
+        }
+    }
+
+    // Release the mapping before deleting the file
+    mapped = DirectX::DDSTextureData();
+    std::error_code error;
+    std::filesystem::remove(path, error);
+}
+
+TEST(DDSTextureLoader, LegacyHeader)
+{
+    DDSFixture::Description description;
+    description.Width = 64;
+    description.Height = 32;
+    description.MipCount = 7;
+    ExpectSameThroughBothPaths("OblivionLegacyHeader.dds", description);
+}
+
+TEST(DDSTextureLoader, DX10Header)
+{
+    DDSFixture::Description description;
+    description.Width = 128;
+    description.Height = 128;
+    description.MipCount = 8;
+    description.DX10Header = true;
+    ExpectSameThroughBothPaths("OblivionDX10Header.dds", description);
+}
+
+TEST(DDSTextureLoader, CubeMap)
+{
+    DDSFixture::Description description;
+    description.Width = description.Height = 32;
+    description.MipCount = 6;
+    description.CubeMap = true;
+    ExpectSameThroughBothPaths("OblivionCubeMap.dds", description);
+
+    description.DX10Header = true;
+    ExpectSameThroughBothPaths("OblivionCubeMapDX10.dds", description);
+}
+
+TEST(DDSTextureLoader, CubeMapArray)
+{
+    DDSFixture::Description description;
+    description.Width = description.Height = 16;
+    description.MipCount = 5;
+    description.ArraySize = 2;
+    description.CubeMap = true;
+    ExpectSameThroughBothPaths("OblivionCubeMapArray.dds", description);
+}
+
+TEST(DDSTextureLoader, Array)
+{
+    DDSFixture::Description description;
+    description.Width = 64;
+    description.Height = 64;
+    description.MipCount = 7;
+    description.ArraySize = 4;
+    ExpectSameThroughBothPaths("OblivionArray.dds", description);
+}
+
+TEST(DDSTextureLoader, LargerThanOneReadChunk)
+{
+    // 21 MiB with mips, so the Win32 heap path reads it in two 16 MiB chunks
+    DDSFixture::Description description;
+    description.Width = description.Height = 2048;
+    description.MipCount = 12;
+    description.DX10Header = true;
+    ExpectSameThroughBothPaths("OblivionLarge.dds", description);
+}
+
+TEST(DDSTextureLoader, MissingOrTruncatedFileFails)
+{
+    auto path = std::filesystem::temp_directory_path() / "OblivionMissing.dds";
+    std::error_code error;
+    std::filesystem::remove(path, error);
+
+    DirectX::DDSTextureData textureData;
+    EXPECT_TRUE(FAILED(DirectX::LoadDDSTextureData(path.wstring().c_str(), textureData)));
+    EXPECT_TRUE(FAILED(DirectX::LoadDDSTextureData(path.wstring().c_str(), textureData, 0, false)));
+
+    // Shorter than the magic number and header
+    DDSFixture::Description description;
+    EXPECT_TRUE(DDSFixture::Write(path, description));
+    std::filesystem::resize_file(path, 64, error);
+    EXPECT_TRUE(FAILED(DirectX::LoadDDSTextureData(path.wstring().c_str(), textureData)));
+    EXPECT_TRUE(FAILED(DirectX::LoadDDSTextureData(path.wstring().c_str(), textureData, 0, false)));
+    EXPECT_TRUE(textureData.fileData == nullptr);
+    std::filesystem::remove(path, error);
+}
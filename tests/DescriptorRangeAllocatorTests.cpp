@@ -0,0 +1,148 @@
+#include "Test.h"
+#include "Utils/DescriptorRangeAllocator.h"
+
+static constexpr uint32_t kInvalid = DescriptorRangeAllocator::kInvalidOffset;
+static constexpr uint32_t kPersistent = 64;
+static constexpr uint32_t kTransient = 16;
+static constexpr uint32_t kFrameCount = 3;
+// The transient regions come first
+static constexpr uint32_t kFirstPersistent = kTransient * kFrameCount;
+
+static DescriptorRangeAllocator MakeAllocator()
+{
+    DescriptorRangeAllocator allocator;
+    allocator.Init(kPersistent, kTransient, kFrameCount);
+    return allocator;
+}
+
+// Frees are only reused once their frame comes around again
+static void CycleFrames(DescriptorRangeAllocator &allocator, uint32_t firstFrame)
+{
+    for (uint32_t frame = firstFrame + 1; frame <= firstFrame + kFrameCount; ++frame)
+    {
+        allocator.BeginFrame(frame);
+    }
+}
+
+TEST(DescriptorRangeAllocator, AllocatesFirstFit)
+{
+    auto allocator = MakeAllocator();
+    allocator.BeginFrame(0);
+    EXPECT_EQ(allocator.GetCapacity(), kFirstPersistent + kPersistent);
+
+    uint32_t a = allocator.Allocate(4);
+    uint32_t b = allocator.Allocate(8);
+    uint32_t c = allocator.Allocate(4);
+    EXPECT_EQ(a, kFirstPersistent);
+    EXPECT_EQ(b, kFirstPersistent + 4);
+    EXPECT_EQ(c, kFirstPersistent + 12);
+    EXPECT_EQ(allocator.GetAllocatedCount(), 16u);
+
+    // A hole of 8 before the tail: a range that fits goes in the hole, a larger one past it
+    allocator.Free(b, 8);
+    CycleFrames(allocator, 0);
+    EXPECT_EQ(allocator.Allocate(12), kFirstPersistent + 16);
+    EXPECT_EQ(allocator.Allocate(3), b);
+    EXPECT_EQ(allocator.Allocate(5), b + 3);
+
+    EXPECT_EQ(allocator.Allocate(0), kInvalid);
+    EXPECT_EQ(allocator.Allocate(kPersistent), kInvalid);
+}
+
+TEST(DescriptorRangeAllocator, CoalescesFreedRanges)
+{
+    auto allocator = MakeAllocator();
+    allocator.BeginFrame(0);
+
+    uint32_t a = allocator.Allocate(16);
+    uint32_t b = allocator.Allocate(16);
+    uint32_t c = allocator.Allocate(16);
+    uint32_t d = allocator.Allocate(16);
+    EXPECT_EQ(allocator.GetLargestFreeRange(), 0u);
+
+    // Freed out of order: a and c alone, then b joins both of its neighbours
+    allocator.Free(a, 16);
+    allocator.Free(c, 16);
+    CycleFrames(allocator, 0);
+    EXPECT_EQ(allocator.GetLargestFreeRange(), 16u);
+    EXPECT_EQ(allocator.Allocate(32), kInvalid);
+
+    allocator.Free(b, 16);
+    CycleFrames(allocator, 0);
+    EXPECT_EQ(allocator.GetLargestFreeRange(), 48u);
+    EXPECT_EQ(allocator.Allocate(48), a);
+
+    allocator.Free(a, 48);
+    allocator.Free(d, 16);
+    CycleFrames(allocator, 0);
+    EXPECT_EQ(allocator.GetLargestFreeRange(), kPersistent);
+    EXPECT_EQ(allocator.GetAllocatedCount(), 0u);
+}
+
+TEST(DescriptorRangeAllocator, DefersReuseUntilFrameComesAround)
+{
+    auto allocator = MakeAllocator();
+    allocator.BeginFrame(0);
+    uint32_t a = allocator.Allocate(kPersistent);
+    EXPECT_EQ(a, kFirstPersistent);
+
+    allocator.BeginFrame(1);
+    allocator.Free(a, kPersistent);
+    EXPECT_EQ(allocator.GetPendingFreeCount(), kPersistent);
+
+    // Frames 2 and 0 may still reference the range
+    allocator.BeginFrame(2);
+    EXPECT_EQ(allocator.Allocate(1), kInvalid);
+    allocator.BeginFrame(3);
+    EXPECT_EQ(allocator.Allocate(1), kInvalid);
+    EXPECT_EQ(allocator.GetPendingFreeCount(), kPersistent);
+
+    // Frame 1 is back, its command lists are done
+    allocator.BeginFrame(4);
+    EXPECT_EQ(allocator.GetPendingFreeCount(), 0u);
+    EXPECT_EQ(allocator.Allocate(kPersistent), a);
+}
+
+TEST(DescriptorRangeAllocator, ResetsTransientRegionPerFrame)
+{
+    auto allocator = MakeAllocator();
+    for (uint32_t frame = 0; frame < kFrameCount * 2; ++frame)
+    {
+        allocator.BeginFrame(frame);
+        uint32_t frameIndex = frame % kFrameCount;
+        EXPECT_EQ(allocator.GetTransientUsed(), 0u);
+
+        // Every frame has a region of its own, reused from its start
+        EXPECT_EQ(allocator.AllocateTransient(10), frameIndex * kTransient);
+        EXPECT_EQ(allocator.AllocateTransient(6), frameIndex * kTransient + 10);
+        EXPECT_EQ(allocator.GetTransientUsed(), kTransient);
+        EXPECT_EQ(allocator.AllocateTransient(1), kInvalid);
+    }
+    // Transient indices never come out of the persistent ranges
+    EXPECT_EQ(allocator.GetAllocatedCount(), 0u);
+    EXPECT_EQ(allocator.GetLargestFreeRange(), kPersistent);
+}
+
+TEST(DescriptorRangeAllocator, GrowKeepsIndicesStable)
+{
+    auto allocator = MakeAllocator();
+    allocator.BeginFrame(0);
+    uint32_t a = allocator.Allocate(kPersistent - 8);
+    uint32_t transient = allocator.AllocateTransient(4);
+    EXPECT_EQ(allocator.Allocate(16), kInvalid);
+
+    allocator.Grow(kPersistent * 2);
+    EXPECT_EQ(allocator.GetPersistentCapacity(), kPersistent * 2);
+    EXPECT_EQ(allocator.GetCapacity(), kFirstPersistent + kPersistent * 2);
+    EXPECT_EQ(allocator.GetAllocatedCount(), kPersistent - 8);
+
+    // The free tail of the old capacity merges with the new indices
+    EXPECT_EQ(allocator.GetLargestFreeRange(), kPersistent + 8);
+    EXPECT_EQ(allocator.Allocate(16), a + kPersistent - 8);
+    // The transient region didn't move
+    EXPECT_EQ(allocator.AllocateTransient(4), transient + 4);
+
+    // Shrinking does nothing
+    allocator.Grow(kPersistent);
+    EXPECT_EQ(allocator.GetPersistentCapacity(), kPersistent * 2);
+}
@@ -0,0 +1,102 @@
+#include "Test.h"
+#include "Utils/GaussianKernel.h"
+
+#include <cmath>
+
+static constexpr float kTolerance = 1e-5f;
+// Every sigma from a fraction of a texel to a wide blur, with radii of both parities
+static constexpr float kMinSigma = 0.25f;
+static constexpr float kMaxSigma = 16.0f;
+static constexpr float kSigmaStep = 0.25f;
+
+// Counts the center once and every other weight twice, as the blur does
+static double GetKernelSum(const std::vector<float> &weights)
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < weights.size(); ++i)
+    {
+        sum += i == 0 ? weights[i] : 2.0 * weights[i];
+    }
+    return sum;
+}
+
+TEST(GaussianKernel, RadiusCoversTwoSigma)
+{
+    EXPECT_EQ(GaussianKernel::GetRadius(0.5f), 1u);
+    EXPECT_EQ(GaussianKernel::GetRadius(1.0f), 2u);
+    EXPECT_EQ(GaussianKernel::GetRadius(1.25f), 3u);
+    EXPECT_EQ(GaussianKernel::GetRadius(0.0f), 0u);
+    EXPECT_TRUE(GaussianKernel::GetWeights(0.0f).empty());
+    EXPECT_TRUE(GaussianKernel::GetWeights(-1.0f).empty());
+    EXPECT_TRUE(GaussianKernel::GetWeights(NAN).empty());
+    EXPECT_TRUE(GaussianKernel::GetLinearTaps({}).empty());
+}
+
+TEST(GaussianKernel, WeightsAreNormalizedGaussian)
+{
+    for (float sigma = kMinSigma; sigma <= kMaxSigma; sigma += kSigmaStep)
+    {
+        auto weights = GaussianKernel::GetWeights(sigma);
+        EXPECT_EQ(weights.size(), GaussianKernel::GetRadius(sigma) + 1);
+        EXPECT_NEAR(GetKernelSum(weights), 1.0, kTolerance);
+
+        for (size_t i = 1; i < weights.size(); ++i)
+        {
+            double expected = std::exp(-(double)(i * i) / (2.0 * sigma * sigma));
+            EXPECT_NEAR(weights[i] / weights[0], expected, kTolerance);
+        }
+    }
+}
+
+TEST(GaussianKernel, LinearTapsHalveFetches)
+{
+    for (float sigma = kMinSigma; sigma <= kMaxSigma; sigma += kSigmaStep)
+    {
+        auto weights = GaussianKernel::GetWeights(sigma);
+        auto taps = GaussianKernel::GetLinearTaps(weights);
+        uint32_t radius = GaussianKernel::GetRadius(sigma);
+        EXPECT_EQ(taps.size(), 1 + (radius + 1) / 2);
+
+        EXPECT_EQ(taps[0].Offset, 0.0f);
+        EXPECT_EQ(taps[0].Weight, weights[0]);
+        for (size_t k = 1; k < taps.size(); ++k)
+        {
+            // Each tap lies between the two texels it folds, or on the last one of an odd radius
+            EXPECT_TRUE(taps[k].Offset >= 2 * k - 1 && taps[k].Offset <= 2 * k);
+        }
+        if (radius % 2 == 1)
+        {
+            EXPECT_EQ(taps.back().Offset, (float)radius);
+        }
+
+        std::vector<float> tapWeights;
+        for (const auto &tap : taps)
+        {
+            tapWeights.push_back(tap.Weight);
+        }
+        EXPECT_NEAR(GetKernelSum(tapWeights), 1.0, kTolerance);
+    }
+}
+
+TEST(GaussianKernel, LinearTapsReproduceWeights)
+{
+    for (float sigma = kMinSigma; sigma <= kMaxSigma; sigma += kSigmaStep)
+    {
+        auto weights = GaussianKernel::GetWeights(sigma);
+        auto taps = GaussianKernel::GetLinearTaps(weights);
+        uint32_t radius = GaussianKernel::GetRadius(sigma);
+        auto expanded = GaussianKernel::ExpandLinearTaps(taps, radius);
+        EXPECT_EQ(expanded.size(), weights.size());
+
+        // Splitting a tap moves weight between its two texels, so the filtered kernel still adds up to 1
+        EXPECT_NEAR(GetKernelSum(expanded), 1.0, kTolerance);
+
+        EXPECT_NEAR(expanded[0], weights[0], kTolerance * weights[0]);
+        for (uint32_t i = 1; i <= radius; ++i)
+        {
+            // The 8 bit position of the filter is off by half a step at most, which moves up to 1/512 of the pair's weight
+            float pairWeight = taps[(i + 1) / 2].Weight;
+            EXPECT_NEAR(expanded[i], weights[i], pairWeight / 512.0f + kTolerance * pairWeight);
+        }
+    }
+}
@@ -0,0 +1,194 @@
+#include "Test.h"
+#include "JobSystem.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+// More than kJobPoolSize jobs in flight, so slots must not be handed out again before their jobs ran
+static constexpr uint32_t kManyJobs = JobSystem::kJobPoolSize * 5;
+
+static bool RanOnce(const std::unique_ptr<std::atomic<uint32_t>[]> &hits, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (hits[i].load() != 1)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(JobSystem, ParallelForRunsEveryIndexOnce)
+{
+    auto hits = std::make_unique<std::atomic<uint32_t>[]>(kManyJobs);
+    JobSystem::Get()->ParallelFor(kManyJobs, 1, [&](uint32_t begin, uint32_t end)
+                                  {
+                                      for (uint32_t i = begin; i < end; ++i)
+                                      {
+                                          hits[i].fetch_add(1);
+                                      }
+                                  });
+    EXPECT_TRUE(RanOnce(hits, kManyJobs));
+}
+
+TEST(JobSystem, ParallelForRunsEveryIndexOnceInBatches)
+{
+    auto hits = std::make_unique<std::atomic<uint32_t>[]>(kManyJobs);
+    // A batch size that doesn't divide the count leaves a short last batch
+    JobSystem::Get()->ParallelFor(kManyJobs, 7, [&](uint32_t begin, uint32_t end)
+                                  {
+                                      for (uint32_t i = begin; i < end; ++i)
+                                      {
+                                          hits[i].fetch_add(1);
+                                      }
+                                  });
+    EXPECT_TRUE(RanOnce(hits, kManyJobs));
+}
+
+TEST(JobSystem, NestedParallelForRunsEveryIndexOnce)
+{
+    // Every outer job schedules from whichever thread runs it, so the workers' pools fill up too
+    static constexpr uint32_t kOuter = 16;
+    static constexpr uint32_t kInner = JobSystem::kJobPoolSize / 2;
+    auto hits = std::make_unique<std::atomic<uint32_t>[]>(kOuter * kInner);
+    JobSystem::Get()->ParallelFor(kOuter, 1, [&](uint32_t outerBegin, uint32_t outerEnd)
+                                  {
+                                      for (uint32_t outer = outerBegin; outer < outerEnd; ++outer)
+                                      {
+                                          JobSystem::Get()->ParallelFor(kInner, 1, [&](uint32_t begin, uint32_t end)
+                                                                        {
+                                                                            for (uint32_t i = begin; i < end; ++i)
+                                                                            {
+                                                                                hits[outer * kInner + i].fetch_add(1);
+                                                                            }
+                                                                        });
+                                      }
+                                  });
+    EXPECT_TRUE(RanOnce(hits, kOuter * kInner));
+}
+
+TEST(JobSystem, ScheduleRunsEveryJobOnce)
+{
+    auto hits = std::make_unique<std::atomic<uint32_t>[]>(kManyJobs);
+    JobCounter counter;
+    for (uint32_t i = 0; i < kManyJobs; ++i)
+    {
+        JobSystem::Get()->Schedule(counter, [&hits, i]()
+                                   {
+                                       hits[i].fetch_add(1);
+                                   });
+    }
+    JobSystem::Get()->Wait(counter);
+    EXPECT_TRUE(counter.IsDone());
+    EXPECT_TRUE(RanOnce(hits, kManyJobs));
+}
+
+TEST(JobSystem, ScheduleFromOtherThreadRunsEveryJobOnce)
+{
+    // Threads that are not part of the system allocate from the shared pool and push to the injected queue
+    auto hits = std::make_unique<std::atomic<uint32_t>[]>(kManyJobs);
+    JobCounter counter;
+    std::thread thread([&]()
+                       {
+                           for (uint32_t i = 0; i < kManyJobs; ++i)
+                           {
+                               JobSystem::Get()->Schedule(counter, [&hits, i]()
+                                                          {
+                                                              hits[i].fetch_add(1);
+                                                          });
+                           }
+                       });
+    thread.join();
+    JobSystem::Get()->Wait(counter);
+    EXPECT_TRUE(RanOnce(hits, kManyJobs));
+}
+
+TEST(JobSystem, DependentJobRunsAfterDependency)
+{
+    std::atomic<uint32_t> finished = 0;
+    std::atomic<uint32_t> finishedBeforeDependent = 0;
+
+    JobCounter first, second;
+    for (uint32_t i = 0; i < 64; ++i)
+    {
+        JobSystem::Get()->Schedule(first, [&finished]()
+                                   {
+                                       finished.fetch_add(1);
+                                   });
+    }
+    JobSystem::Get()->Schedule(second, [&]()
+                               {
+                                   finishedBeforeDependent = finished.load();
+                               },
+                               &first);
+    JobSystem::Get()->Wait(second);
+    EXPECT_EQ(finishedBeforeDependent.load(), 64u);
+}
+
+TEST(JobSystem, DependencyChainRunsOnOneWorker)
+{
+    JobSystem::Get()->Shutdown();
+    JobSystem::Get()->Init(1);
+
+    static constexpr uint32_t kChainLength = 256;
+    std::atomic<uint32_t> next = 0;
+    std::atomic<bool> inOrder = true;
+    std::atomic<bool> done = false;
+    auto counters = std::make_unique<JobCounter[]>(kChainLength);
+
+    // The chain is scheduled in order from the worker, so each job lands on top of the one it waits for in the
+    // worker's LIFO deque, and the main thread below doesn't run jobs that could steal the dependencies
+    JobCounter outer;
+    JobSystem::Get()->Schedule(outer, [&]()
+                               {
+                                   for (uint32_t i = 0; i < kChainLength; ++i)
+                                   {
+                                       JobSystem::Get()->Schedule(counters[i], [&next, &inOrder, i]()
+                                                                  {
+                                                                      if (next.fetch_add(1) != i)
+                                                                      {
+                                                                          inOrder = false;
+                                                                      }
+                                                                  },
+                                                                  i > 0 ? &counters[i - 1] : nullptr);
+                                   }
+                                   JobSystem::Get()->Wait(counters[kChainLength - 1]);
+                                   done = true;
+                               });
+    while (!done.load())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    JobSystem::Get()->Wait(outer);
+    EXPECT_EQ(next.load(), kChainLength);
+    EXPECT_TRUE(inOrder.load());
+
+    JobSystem::Get()->Shutdown();
+    JobSystem::Get()->Init();
+}
+
+TEST(JobSystem, ShutdownRunsParkedJobs)
+{
+    JobSystem::Get()->Shutdown();
+    JobSystem::Get()->Init(1);
+
+    std::atomic<uint32_t> finished = 0;
+    JobCounter first, second;
+    JobSystem::Get()->Schedule(second, [&finished]()
+                               {
+                                   finished.fetch_add(1);
+                               },
+                               &first);
+    JobSystem::Get()->Schedule(first, [&finished]()
+                               {
+                                   finished.fetch_add(1);
+                               });
+    JobSystem::Get()->Shutdown();
+    EXPECT_EQ(finished.load(), 2u);
+    EXPECT_TRUE(first.IsDone() && second.IsDone());
+
+    JobSystem::Get()->Init();
+}
@@ -0,0 +1,125 @@
+#include "Test.h"
+#include "Utils/LightClusterBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+
+using Sphere = LightClusterBuilder::Sphere;
+
+static constexpr uint32_t kLightCount = 1000;
+// 60 degrees vertical field of view, 16:9
+static constexpr float kYScale = 1.7320508f;
+static constexpr float kXScale = kYScale * 9.0f / 16.0f;
+static constexpr float kNearZ = 0.1f;
+static constexpr float kFarZ = 100.0f;
+
+// Lights whose centres are inside the frustum, at every depth
+static std::vector<Sphere> MakeLights()
+{
+    std::vector<Sphere> lights;
+    uint32_t state = 0x2545f491;
+    auto random = [&state]()
+    {
+        state = state * 1664525u + 1013904223u;
+        return (float)(state >> 8) / (float)(1 << 24);
+    };
+    for (uint32_t i = 0; i < kLightCount; ++i)
+    {
+        float z = kNearZ * std::pow(kFarZ / kNearZ, random() * 0.999f);
+        float ndcX = random() * 1.98f - 0.99f;
+        float ndcY = random() * 1.98f - 0.99f;
+        lights.push_back({ ndcX * z / kXScale, ndcY * z / kYScale, z, 0.05f + random() * 2.0f });
+    }
+    return lights;
+}
+
+static LightClusterBuilder MakeBuilder()
+{
+    LightClusterBuilder builder;
+    builder.Init();
+    builder.SetProjection(kXScale, kYScale, kNearZ, kFarZ);
+    return builder;
+}
+
+// The cluster the shaders look up for a pixel at the light's centre
+static uint32_t GetCluster(const LightClusterBuilder &builder, const Sphere &light)
+{
+    auto tile = [](float ndc, uint32_t tileCount)
+    {
+        return (uint32_t)std::clamp(std::floor((ndc + 1.0f) * 0.5f * tileCount), 0.0f, (float)(tileCount - 1));
+    };
+    uint32_t column = tile(light.X / light.Z * kXScale, builder.GetGridX());
+    uint32_t row = tile(-light.Y / light.Z * kYScale, builder.GetGridY());
+    float slice = std::floor(std::log(light.Z) * builder.GetDepthScale() + builder.GetDepthBias());
+    uint32_t sliceIndex = (uint32_t)std::clamp(slice, 0.0f, (float)(builder.GetGridZ() - 1));
+    return (sliceIndex * builder.GetGridY() + row) * builder.GetGridX() + column;
+}
+
+TEST(LightClusterBuilder, EveryLightLandsInItsCentreCluster)
+{
+    auto lights = MakeLights();
+    auto builder = MakeBuilder();
+    builder.Build(lights.data(), (uint32_t)lights.size());
+
+    const auto &clusters = builder.GetClusters();
+    const auto &lightIndices = builder.GetLightIndices();
+    uint32_t missing = 0;
+    for (uint32_t i = 0; i < kLightCount; ++i)
+    {
+        const auto &cluster = clusters[GetCluster(builder, lights[i])];
+        auto begin = lightIndices.begin() + cluster.Offset;
+        auto end = begin + cluster.Count;
+        missing += std::find(begin, end, i) == end ? 1 : 0;
+    }
+    EXPECT_EQ(missing, 0u);
+    EXPECT_EQ(builder.GetStatistics().VisibleLights, kLightCount);
+}
+
+TEST(LightClusterBuilder, ListsAreCompactAndSorted)
+{
+    auto lights = MakeLights();
+    auto builder = MakeBuilder();
+    builder.Build(lights.data(), (uint32_t)lights.size());
+
+    const auto &clusters = builder.GetClusters();
+    const auto &lightIndices = builder.GetLightIndices();
+    uint32_t offset = 0;
+    bool sorted = true;
+    for (const auto &cluster : clusters)
+    {
+        EXPECT_EQ(cluster.Offset, offset);
+        offset += cluster.Count;
+        sorted &= std::is_sorted(lightIndices.begin() + cluster.Offset, lightIndices.begin() + cluster.Offset + cluster.Count);
+    }
+    EXPECT_TRUE(sorted);
+    EXPECT_EQ(offset, (uint32_t)lightIndices.size());
+    EXPECT_EQ(builder.GetStatistics().LightIndices, offset);
+}
+
+TEST(LightClusterBuilder, SkipsLightsOutsideTheFrustum)
+{
+    std::vector<Sphere> lights = {
+        // Behind the camera
+        { 0.0f, 0.0f, -5.0f, 1.0f },
+        // Past the far plane
+        { 0.0f, 0.0f, kFarZ + 5.0f, 1.0f },
+        // Far to the side
+        { 500.0f, 0.0f, 10.0f, 1.0f },
+        // No radius
+        { 0.0f, 0.0f, 10.0f, 0.0f },
+    };
+    auto builder = MakeBuilder();
+    builder.Build(lights.data(), (uint32_t)lights.size());
+    EXPECT_EQ(builder.GetStatistics().VisibleLights, 0u);
+    EXPECT_TRUE(builder.GetLightIndices().empty());
+}
+
+TEST(LightClusterBuilder, LargeLightCoversEveryCluster)
+{
+    // A sphere around the whole frustum
+    Sphere light = { 0.0f, 0.0f, 0.0f, kFarZ * 4.0f };
+    auto builder = MakeBuilder();
+    builder.Build(&light, 1);
+    EXPECT_EQ(builder.GetStatistics().OccupiedClusters, builder.GetClusterCount());
+    EXPECT_EQ(builder.GetStatistics().MaxLightsPerCluster, 1u);
+}
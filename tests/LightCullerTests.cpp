@@ -0,0 +1,164 @@
+#include "Test.h"
+#include "Utils/LightCuller.h"
+
+#include <iterator>
+#include <vector>
+
+using namespace LightCuller;
+
+static constexpr float kNearZ = 1.0f;
+static constexpr float kFarZ = 100.0f;
+
+// 90 degrees field of view looking down +z from the origin, square, so |x| <= z and |y| <= z
+static Frustum MakeFrustum()
+{
+    const float kHalfSqrt2 = 0.70710678f;
+
+    Frustum frustum;
+    frustum.Planes[0] = { kHalfSqrt2, 0.0f, kHalfSqrt2, 0.0f };
+    frustum.Planes[1] = { -kHalfSqrt2, 0.0f, kHalfSqrt2, 0.0f };
+    frustum.Planes[2] = { 0.0f, kHalfSqrt2, kHalfSqrt2, 0.0f };
+    frustum.Planes[3] = { 0.0f, -kHalfSqrt2, kHalfSqrt2, 0.0f };
+    frustum.Planes[4] = { 0.0f, 0.0f, 1.0f, -kNearZ };
+    frustum.Planes[5] = { 0.0f, 0.0f, -1.0f, kFarZ };
+    frustum.EyeX = 0.0f;
+    frustum.EyeY = 0.0f;
+    frustum.EyeZ = 0.0f;
+    frustum.YScale = 1.0f;
+    return frustum;
+}
+
+// An orthographic box of half size 10 around the origin, so the all zero padding lights would be inside it
+static Frustum MakeBox()
+{
+    Frustum frustum;
+    frustum.Planes[0] = { 1.0f, 0.0f, 0.0f, 10.0f };
+    frustum.Planes[1] = { -1.0f, 0.0f, 0.0f, 10.0f };
+    frustum.Planes[2] = { 0.0f, 1.0f, 0.0f, 10.0f };
+    frustum.Planes[3] = { 0.0f, -1.0f, 0.0f, 10.0f };
+    frustum.Planes[4] = { 0.0f, 0.0f, 1.0f, 10.0f };
+    frustum.Planes[5] = { 0.0f, 0.0f, -1.0f, 10.0f };
+    frustum.EyeX = 0.0f;
+    frustum.EyeY = 0.0f;
+    frustum.EyeZ = -20.0f;
+    frustum.YScale = 1.0f;
+    return frustum;
+}
+
+TEST(LightCuller, CullsSpheres)
+{
+    struct Sphere
+    {
+        float X, Y, Z, Range;
+        bool Visible;
+    };
+    const Sphere kSpheres[] = {
+        { 0.0f, 0.0f, 10.0f, 1.0f, true },
+        // Behind the eye, and beyond the far plane
+        { 0.0f, 0.0f, -10.0f, 1.0f, false },
+        { 0.0f, 0.0f, 105.0f, 3.0f, false },
+        // Straddling the far, right, top and near planes
+        { 0.0f, 0.0f, 102.0f, 3.0f, true },
+        { 12.0f, 0.0f, 10.0f, 3.0f, true },
+        { 0.0f, 12.0f, 10.0f, 3.0f, true },
+        { 0.0f, 0.0f, -1.0f, 2.5f, true },
+        // Just outside the right and bottom planes
+        { 20.0f, 0.0f, 10.0f, 3.0f, false },
+        { 0.0f, -20.0f, 10.0f, 3.0f, false },
+        { 0.0f, 0.0f, -1.0f, 1.5f, false },
+    };
+    const auto count = (uint32_t)std::size(kSpheres);
+
+    Lights lights;
+    lights.Resize(count);
+    std::vector<uint32_t> expected;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const auto &sphere = kSpheres[i];
+        lights.SetPointLight(i, sphere.X, sphere.Y, sphere.Z, sphere.Range, 1.0f);
+        if (sphere.Visible)
+        {
+            expected.push_back(i);
+        }
+    }
+
+    std::vector<uint32_t> selected;
+    EXPECT_EQ(CullAndRank(MakeFrustum(), lights, count, selected), (uint32_t)expected.size());
+    EXPECT_TRUE(selected == expected);
+}
+
+TEST(LightCuller, CullsSpotlightsPointingAway)
+{
+    // The sphere of each light reaches 3 units past the near plane; only the cone decides
+    Lights lights;
+    lights.Resize(4);
+    lights.SetSpotlight(0, 0.0f, 0.0f, -2.0f, 0.0f, 0.0f, -1.0f, 5.0f, 64.0f, 1.0f);
+    lights.SetSpotlight(1, 0.0f, 0.0f, -2.0f, 0.0f, 0.0f, 1.0f, 5.0f, 64.0f, 1.0f);
+    lights.SetPointLight(2, 0.0f, 0.0f, -2.0f, 5.0f, 1.0f);
+    // Pointing sideways, its cone still reaches past the near plane
+    lights.SetSpotlight(3, 0.0f, 0.0f, -2.0f, 1.0f, 0.0f, 1.0f, 5.0f, 64.0f, 1.0f);
+
+    std::vector<uint32_t> selected;
+    EXPECT_EQ(CullAndRank(MakeFrustum(), lights, 4, selected), 3u);
+    EXPECT_TRUE(selected == std::vector<uint32_t>({ 1, 2, 3 }));
+
+    // A wide spotlight lights the half space in front of it, so it is culled as a point light
+    lights.SetSpotlight(0, 0.0f, 0.0f, -2.0f, 0.0f, 0.0f, -1.0f, 5.0f, 0.5f, 1.0f);
+    EXPECT_EQ(CullAndRank(MakeFrustum(), lights, 4, selected), 4u);
+}
+
+TEST(LightCuller, SkipsPaddingLanes)
+{
+    // Counts that leave 3, 2, 1 and 0 padding lanes; the padding is inside the box but must never be selected
+    for (uint32_t count = 1; count <= 9; ++count)
+    {
+        Lights lights;
+        lights.Resize(count);
+        EXPECT_EQ(lights.X.size() % kLaneCount, 0u);
+        std::vector<uint32_t> expected;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            // Every other light is outside
+            lights.SetPointLight(i, i % 2 == 0 ? 0.0f : 30.0f, 0.0f, 0.0f, 1.0f, 1.0f);
+            if (i % 2 == 0)
+            {
+                expected.push_back(i);
+            }
+        }
+
+        std::vector<uint32_t> selected(16, 99);
+        EXPECT_EQ(CullAndRank(MakeBox(), lights, 16, selected), (uint32_t)expected.size());
+        EXPECT_TRUE(selected == expected);
+    }
+}
+
+TEST(LightCuller, KeepsHighestScores)
+{
+    // Same position and range, so the score only depends on the intensity
+    const float kIntensities[] = { 1.0f, 9.0f, 3.0f, 7.0f, 2.0f, 8.0f, 4.0f, 6.0f, 5.0f, 0.5f, 10.0f };
+    const auto count = (uint32_t)std::size(kIntensities);
+
+    Lights lights;
+    lights.Resize(count + 1);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        lights.SetPointLight(i, 0.0f, 0.0f, 20.0f, 2.0f, kIntensities[i]);
+    }
+    // The brightest light, but culled
+    lights.SetPointLight(count, 0.0f, 0.0f, -20.0f, 2.0f, 100.0f);
+
+    std::vector<uint32_t> selected;
+    EXPECT_EQ(CullAndRank(MakeFrustum(), lights, 3, selected), count);
+    EXPECT_TRUE(selected == std::vector<uint32_t>({ 1, 5, 10 }));
+
+    EXPECT_EQ(CullAndRank(MakeFrustum(), lights, 0, selected), count);
+    EXPECT_TRUE(selected.empty());
+
+    EXPECT_EQ(CullAndRank(MakeFrustum(), lights, count, selected), count);
+    EXPECT_EQ((uint32_t)selected.size(), count);
+
+    // A closer light covers more of the screen and outranks brighter ones that are far away
+    lights.SetPointLight(0, 0.0f, 0.0f, 4.0f, 2.0f, 1.0f);
+    EXPECT_EQ(CullAndRank(MakeFrustum(), lights, 3, selected), count);
+    EXPECT_TRUE(selected == std::vector<uint32_t>({ 0, 1, 10 }));
+}
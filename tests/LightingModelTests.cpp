@@ -0,0 +1,181 @@
+#include "Test.h"
+#include "Utils/LightingModel.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace LightingModel;
+
+static constexpr float kTolerance = 1e-5f;
+// Largest distance between the batched and the scalar results, in units in the last place
+static constexpr uint32_t kMaxUlps = 4;
+
+static const Material kMaterial = { { 0.5f, 0.4f, 0.3f, 1.0f }, { 0.04f, 0.05f, 0.06f }, 0.25f };
+
+static void Normalize(float vector[3])
+{
+    float length = std::sqrt(vector[0] * vector[0] + vector[1] * vector[1] + vector[2] * vector[2]);
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        vector[i] /= length;
+    }
+}
+
+static bool Near(const float result[3], double r, double g, double b)
+{
+    return std::abs(result[0] - r) <= kTolerance && std::abs(result[1] - g) <= kTolerance && std::abs(result[2] - b) <= kTolerance;
+}
+
+static uint32_t GetUlps(float lhs, float rhs)
+{
+    int32_t lhsBits, rhsBits;
+    std::memcpy(&lhsBits, &lhs, sizeof(lhsBits));
+    std::memcpy(&rhsBits, &rhs, sizeof(rhsBits));
+    // Lighting is never negative, so the bit patterns are ordered like the values
+    return (uint32_t)std::abs((int64_t)lhsBits - (int64_t)rhsBits);
+}
+
+static float Shade(const Light &light, uint32_t directional, uint32_t point, uint32_t spot, const float position[3],
+                   const float normal[3], const float toEye[3], float result[3])
+{
+    LightList lights = { &light, directional, point, spot };
+    ComputeLighting(lights, kMaterial, position, normal, toEye, result);
+    return result[0];
+}
+
+// The reference values come from the HLSL formulas evaluated in double precision
+
+TEST(LightingModel, DirectionalMatchesReference)
+{
+    float position[3] = { 0.0f, 0.0f, 0.0f };
+    float up[3] = { 0.0f, 1.0f, 0.0f };
+    float result[3];
+
+    Light light = { { 1.0f, 1.0f, 1.0f }, 0.0f, { 0.0f, -1.0f, 0.0f }, 0.0f, {}, 0.0f };
+    Shade(light, 1, 0, 0, position, up, up, result);
+    EXPECT_TRUE(Near(result, 0.7647058823529411, 0.710344827586207, 0.6506493506493507));
+
+    float side[3] = { 1.0f, 0.0f, 0.0f };
+    Shade(light, 1, 0, 0, position, up, side, result);
+    EXPECT_TRUE(Near(result, 0.7746387752866546, 0.719000316544482, 0.6582484678136765));
+
+    Light tilted = { { 0.8f, 0.9f, 1.0f }, 0.0f, { -1.0f, -2.0f, 0.5f }, 0.0f, {}, 0.0f };
+    Normalize(tilted.Direction);
+    float toEye[3] = { 1.0f, 1.0f, 0.0f };
+    Normalize(toEye);
+    Shade(tilted, 1, 0, 0, position, up, toEye, result);
+    EXPECT_TRUE(Near(result, 0.533992021253391, 0.5580358259620009, 0.567933321487134));
+}
+
+TEST(LightingModel, PunctualMatchesReference)
+{
+    float origin[3] = { 0.0f, 0.0f, 0.0f };
+    float up[3] = { 0.0f, 1.0f, 0.0f };
+    float result[3];
+
+    Light point = { { 2.0f, 2.0f, 2.0f }, 2.0f, {}, 10.0f, { 0.0f, 5.0f, 0.0f }, 0.0f };
+    Shade(point, 0, 1, 0, origin, up, up, result);
+    EXPECT_TRUE(Near(result, 0.9558823529411764, 0.8879310344827587, 0.8133116883116884));
+
+    // Past FalloffEnd
+    point.Position[1] = 12.0f;
+    Shade(point, 0, 1, 0, origin, up, up, result);
+    EXPECT_TRUE(Near(result, 0.0, 0.0, 0.0));
+
+    Light spot = { { 3.0f, 3.0f, 3.0f }, 1.0f, { 0.0f, -1.0f, 0.0f }, 20.0f, { 0.0f, 5.0f, 0.0f }, 8.0f };
+    float position[3] = { 2.0f, 0.0f, 0.0f };
+    float toEye[3] = { 0.0f, 1.0f, 1.0f };
+    Normalize(toEye);
+    Shade(spot, 0, 0, 1, position, up, toEye, result);
+    EXPECT_TRUE(Near(result, 0.9049209456110187, 0.840590452753755, 0.7699483865377612));
+}
+
+TEST(LightingModel, LightsAddUp)
+{
+    Light lights[3] = {
+        { { 1.0f, 1.0f, 1.0f }, 0.0f, { 0.0f, -1.0f, 0.0f }, 0.0f, {}, 0.0f },
+        { { 2.0f, 2.0f, 2.0f }, 2.0f, {}, 10.0f, { 0.0f, 5.0f, 0.0f }, 0.0f },
+        { { 3.0f, 3.0f, 3.0f }, 1.0f, { 0.0f, -1.0f, 0.0f }, 20.0f, { 0.0f, 5.0f, 0.0f }, 8.0f },
+    };
+    float position[3] = { 0.5f, 0.0f, 0.0f };
+    float up[3] = { 0.0f, 1.0f, 0.0f };
+
+    float expected[3] = {};
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        float result[3];
+        Shade(lights[i], i == 0, i == 1, i == 2, position, up, up, result);
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            expected[c] += result[c];
+        }
+    }
+
+    float result[3];
+    ComputeLighting({ lights, 1, 1, 1 }, kMaterial, position, up, up, result);
+    EXPECT_TRUE(Near(result, expected[0], expected[1], expected[2]));
+}
+
+TEST(LightingModel, BatchedMatchesScalar)
+{
+    // Counts of every kind, in LightsBuffer order
+    static constexpr uint32_t kDirectional = 2;
+    static constexpr uint32_t kPoint = 8;
+    static constexpr uint32_t kSpot = 4;
+    // Not a multiple of kLaneCount, so the last batch is padded
+    static constexpr uint32_t kSampleCount = 1003;
+
+    uint32_t state = 0x6b43a9b5;
+    auto random = [&state](float min, float max)
+    {
+        state = state * 1664525u + 1013904223u;
+        return min + (max - min) * (float)(state >> 8) / (float)(1 << 24);
+    };
+
+    std::vector<Light> lights;
+    for (uint32_t i = 0; i < kDirectional + kPoint + kSpot; ++i)
+    {
+        Light light = {};
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            light.Strength[c] = random(0.1f, 2.0f);
+            light.Direction[c] = random(-1.0f, 1.0f);
+            light.Position[c] = random(-8.0f, 8.0f);
+        }
+        light.Direction[1] = -1.0f;
+        Normalize(light.Direction);
+        light.FalloffStart = random(0.5f, 2.0f);
+        light.FalloffEnd = random(4.0f, 12.0f);
+        light.SpotPower = random(1.0f, 64.0f);
+        lights.push_back(light);
+    }
+    LightList lightList = { lights.data(), kDirectional, kPoint, kSpot };
+
+    Samples samples;
+    samples.Resize(kSampleCount);
+    for (uint32_t i = 0; i < kSampleCount; ++i)
+    {
+        float position[3] = { random(-8.0f, 8.0f), random(-2.0f, 2.0f), random(-8.0f, 8.0f) };
+        float normal[3] = { random(-1.0f, 1.0f), random(0.1f, 1.0f), random(-1.0f, 1.0f) };
+        float toEye[3] = { random(-1.0f, 1.0f), random(0.1f, 1.0f), random(-1.0f, 1.0f) };
+        Normalize(normal);
+        Normalize(toEye);
+        samples.Set(i, position, normal, toEye);
+    }
+
+    Colors colors;
+    ComputeLighting(lightList, kMaterial, samples, colors);
+    EXPECT_TRUE(colors.R.size() >= kSampleCount);
+
+    uint32_t maxUlps = 0;
+    for (uint32_t i = 0; i < kSampleCount; ++i)
+    {
+        float position[3] = { samples.PositionX[i], samples.PositionY[i], samples.PositionZ[i] };
+        float normal[3] = { samples.NormalX[i], samples.NormalY[i], samples.NormalZ[i] };
+        float toEye[3] = { samples.ToEyeX[i], samples.ToEyeY[i], samples.ToEyeZ[i] };
+        float result[3];
+        ComputeLighting(lightList, kMaterial, position, normal, toEye, result);
+        maxUlps = std::max({ maxUlps, GetUlps(colors.R[i], result[0]), GetUlps(colors.G[i], result[1]), GetUlps(colors.B[i], result[2]) });
+    }
+    EXPECT_TRUE(maxUlps <= kMaxUlps);
+}
@@ -0,0 +1,175 @@
+#include "Test.h"
+#include "Utils/DDSTextureData.h"
+#include "Utils/LightmapBaker.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+using Vertex = LightmapBaker::Vertex;
+
+static constexpr uint32_t kLightmapSize = 32;
+static constexpr float kGroundSize = 20.0f;
+
+// A horizontal quad facing up, centred on the y axis, whose lightmap UVs span [uvMin, uvMax] on both axes
+static uint32_t AddQuad(LightmapBaker &baker, float y, float halfSize, float uvMin = 0.0f, float uvMax = 1.0f)
+{
+    std::vector<Vertex> vertices;
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        float u = i & 1 ? uvMax : uvMin;
+        float v = i & 2 ? uvMax : uvMin;
+        float x = i & 1 ? halfSize : -halfSize;
+        float z = i & 2 ? halfSize : -halfSize;
+        vertices.push_back({ { x, y, z }, { 0.0f, 1.0f, 0.0f }, { u, v } });
+    }
+    return baker.AddMesh(std::move(vertices), { 0, 2, 1, 1, 2, 3 });
+}
+
+static const float *GetTexel(const LightmapBaker::Lightmap &lightmap, uint32_t x, uint32_t y)
+{
+    return &lightmap.Texels[((size_t)y * lightmap.Width + x) * 4];
+}
+
+// The texel of the ground quad's lightmap above world position x, z
+static const float *GetGroundTexel(const LightmapBaker::Lightmap &lightmap, float x, float z)
+{
+    auto texelX = (uint32_t)((x / kGroundSize + 0.5f) * lightmap.Width);
+    auto texelY = (uint32_t)((z / kGroundSize + 0.5f) * lightmap.Height);
+    return GetTexel(lightmap, texelX, texelY);
+}
+
+static LightmapBaker::Settings GetSettings()
+{
+    LightmapBaker::Settings settings;
+    settings.Width = kLightmapSize;
+    settings.Height = kLightmapSize;
+    settings.TileSize = 8;
+    return settings;
+}
+
+TEST(LightmapBaker, OpenPlaneIsUnoccluded)
+{
+    LightmapBaker baker;
+    uint32_t ground = AddQuad(baker, 0.0f, kGroundSize / 2);
+    baker.BuildAccelerationStructure();
+
+    // No lights: black, and every AO ray escapes, including the ones grazing the plane
+    LightmapBaker::Lightmap lightmap;
+    EXPECT_TRUE(baker.Bake(ground, {}, GetSettings(), lightmap));
+    EXPECT_EQ(lightmap.CoveredTexels, kLightmapSize * kLightmapSize);
+    bool unoccluded = true;
+    for (uint32_t i = 0; i < kLightmapSize * kLightmapSize; ++i)
+    {
+        unoccluded &= lightmap.Texels[i * 4] == 0.0f && lightmap.Texels[i * 4 + 3] == 1.0f;
+    }
+    EXPECT_TRUE(unoccluded);
+}
+
+TEST(LightmapBaker, OccluderCastsShadow)
+{
+    LightmapBaker baker;
+    uint32_t ground = AddQuad(baker, 0.0f, kGroundSize / 2);
+    // A 4x4 roof, 1 above the ground
+    AddQuad(baker, 1.0f, 2.0f);
+    baker.BuildAccelerationStructure();
+
+    LightingModel::Light sun = { { 1.0f, 0.5f, 0.25f }, 0.0f, { 0.0f, -1.0f, 0.0f }, 0.0f, {}, 0.0f };
+    LightingModel::LightList lights = { &sun, 1, 0, 0 };
+    LightmapBaker::Lightmap lightmap;
+    EXPECT_TRUE(baker.Bake(ground, lights, GetSettings(), lightmap));
+
+    // Under the roof: no sun, and most AO rays blocked
+    const float *shadowed = GetGroundTexel(lightmap, 0.3f, -0.3f);
+    EXPECT_EQ(shadowed[0], 0.0f);
+    EXPECT_EQ(shadowed[2], 0.0f);
+    EXPECT_TRUE(shadowed[3] < 0.5f);
+
+    // Away from it: the sun straight down on a white surface, and nothing within AODistance
+    const float *lit = GetGroundTexel(lightmap, -8.0f, 7.0f);
+    EXPECT_NEAR(lit[0], 1.0f, 1e-4f);
+    EXPECT_NEAR(lit[1], 0.5f, 1e-4f);
+    EXPECT_NEAR(lit[2], 0.25f, 1e-4f);
+    EXPECT_EQ(lit[3], 1.0f);
+
+    // Just outside the roof's shadow the sun gets through, but part of the sky is still hidden
+    const float *edge = GetGroundTexel(lightmap, 2.5f, 0.0f);
+    EXPECT_NEAR(edge[0], 1.0f, 1e-4f);
+    EXPECT_TRUE(edge[3] > shadowed[3] && edge[3] < 1.0f);
+}
+
+TEST(LightmapBaker, DilationFillsRings)
+{
+    // The quad covers exactly texels 12 to 19 on both axes
+    static constexpr uint32_t kFirst = 12;
+    static constexpr uint32_t kLast = 19;
+
+    LightmapBaker baker;
+    uint32_t quad = AddQuad(baker, 0.0f, 1.0f, (float)kFirst / kLightmapSize, (float)(kLast + 1) / kLightmapSize);
+    baker.BuildAccelerationStructure();
+
+    for (uint32_t passes = 0; passes <= 3; ++passes)
+    {
+        auto settings = GetSettings();
+        settings.DilationPasses = passes;
+        LightmapBaker::Lightmap lightmap;
+        EXPECT_TRUE(baker.Bake(quad, {}, settings, lightmap));
+        EXPECT_EQ(lightmap.CoveredTexels, (kLast - kFirst + 1) * (kLast - kFirst + 1));
+
+        // Every pass adds one ring, diagonals included, copying the AO of 1 outwards; nothing past the last ring
+        bool filledExactly = true;
+        for (uint32_t y = 0; y < kLightmapSize; ++y)
+        {
+            for (uint32_t x = 0; x < kLightmapSize; ++x)
+            {
+                int32_t distanceX = std::max({ (int32_t)kFirst - (int32_t)x, (int32_t)x - (int32_t)kLast, 0 });
+                int32_t distanceY = std::max({ (int32_t)kFirst - (int32_t)y, (int32_t)y - (int32_t)kLast, 0 });
+                bool filled = std::max(distanceX, distanceY) <= (int32_t)passes;
+                filledExactly &= GetTexel(lightmap, x, y)[3] == (filled ? 1.0f : 0.0f);
+            }
+        }
+        EXPECT_TRUE(filledExactly);
+    }
+}
+
+TEST(LightmapBaker, SaveDDSRoundTrip)
+{
+    LightmapBaker::Lightmap lightmap;
+    lightmap.Width = 5;
+    lightmap.Height = 3;
+    for (uint32_t i = 0; i < lightmap.Width * lightmap.Height * 4; ++i)
+    {
+        lightmap.Texels.push_back(i * 0.25f - 3.0f);
+    }
+
+    auto path = std::filesystem::temp_directory_path() / "LightmapBakerTests.dds";
+    EXPECT_TRUE(LightmapBaker::SaveDDS(lightmap, path.string()));
+
+    // Read back by the engine's own loader
+    DirectX::DDSTextureData textureData;
+    EXPECT_TRUE(SUCCEEDED(DirectX::LoadDDSTextureData(path.wstring().c_str(), textureData)));
+    EXPECT_EQ(textureData.resDim, (uint32_t)D3D12_RESOURCE_DIMENSION_TEXTURE2D);
+    EXPECT_EQ(textureData.width, lightmap.Width);
+    EXPECT_EQ(textureData.height, lightmap.Height);
+    EXPECT_EQ(textureData.depth, 1u);
+    EXPECT_EQ(textureData.mipCount, 1u);
+    EXPECT_EQ(textureData.arraySize, 1u);
+    EXPECT_EQ(textureData.format, DXGI_FORMAT_R32G32B32A32_FLOAT);
+    EXPECT_EQ(textureData.isCubeMap, false);
+    EXPECT_EQ(textureData.subresources.size(), 1u);
+    if (textureData.subresources.size() == 1)
+    {
+        const auto &subresource = textureData.subresources[0];
+        EXPECT_EQ(subresource.RowPitch, (LONG_PTR)(lightmap.Width * 4 * sizeof(float)));
+        EXPECT_EQ(subresource.SlicePitch, (LONG_PTR)(lightmap.Texels.size() * sizeof(float)));
+        EXPECT_TRUE(std::memcmp(subresource.pData, lightmap.Texels.data(), lightmap.Texels.size() * sizeof(float)) == 0);
+    }
+    textureData = {};
+    std::filesystem::remove(path);
+
+    // Texels that don't match the size
+    lightmap.Texels.pop_back();
+    EXPECT_TRUE(!LightmapBaker::SaveDDS(lightmap, path.string()));
+    EXPECT_TRUE(!std::filesystem::exists(path));
+}
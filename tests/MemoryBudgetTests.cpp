@@ -0,0 +1,151 @@
+#include "Test.h"
+#include "Utils/MemoryBudget.h"
+
+using Category = MemoryBudget::Category;
+
+static constexpr uint64_t kTextureBytes = 1000;
+static constexpr uint64_t kLowBytes = 100;
+static constexpr uint64_t kFreedBytes = kTextureBytes - kLowBytes;
+
+// Frames after which every texture tracked or touched before is idle long enough to be evicted
+static void Idle(MemoryBudget &memoryBudget)
+{
+    for (uint64_t i = 0; i < MemoryBudget::kMinIdleFrames; ++i)
+    {
+        memoryBudget.BeginFrame();
+    }
+}
+
+TEST(MemoryBudget, TracksCategories)
+{
+    MemoryBudget memoryBudget;
+    memoryBudget.Track(Category::Texture, 0, 300);
+    memoryBudget.Track(Category::RenderTarget, 1, 200);
+    memoryBudget.TrackEvictable(2, kTextureBytes, kLowBytes);
+    EXPECT_EQ(memoryBudget.GetTotalBytes(), 300u + 200u + kTextureBytes);
+    EXPECT_EQ(memoryBudget.GetBytes(Category::StreamedTexture), kTextureBytes);
+
+    // Tracking again replaces the size
+    memoryBudget.Track(Category::Texture, 0, 500);
+    EXPECT_EQ(memoryBudget.GetBytes(Category::Texture), 500u);
+    EXPECT_EQ(memoryBudget.GetStatistics().Allocations[(uint32_t)Category::Texture], 1u);
+
+    memoryBudget.Untrack(Category::StreamedTexture, 2);
+    memoryBudget.Untrack(Category::RenderTarget, 7);
+    EXPECT_EQ(memoryBudget.GetTotalBytes(), 500u + 200u);
+    EXPECT_EQ(memoryBudget.GetEvictableCount(), 0u);
+}
+
+TEST(MemoryBudget, EvictsLeastRecentlyUsedFirst)
+{
+    MemoryBudget memoryBudget;
+    for (uint32_t texture = 0; texture < 4; ++texture)
+    {
+        memoryBudget.TrackEvictable(texture, kTextureBytes, kLowBytes);
+    }
+    memoryBudget.BeginFrame();
+    memoryBudget.Touch(2);
+    memoryBudget.Touch(0);
+    memoryBudget.BeginFrame();
+    memoryBudget.Touch(3);
+    Idle(memoryBudget);
+
+    // Needs every texture evicted; 1 was never touched, then 2, 0 and 3 in the order they were last used
+    memoryBudget.SetBudget(0);
+    std::vector<uint32_t> evictions;
+    memoryBudget.SelectEvictions(evictions);
+    EXPECT_TRUE(evictions == std::vector<uint32_t>({ 1, 2, 0, 3 }));
+}
+
+TEST(MemoryBudget, KeepsRecentlyUsed)
+{
+    MemoryBudget memoryBudget;
+    memoryBudget.TrackEvictable(0, kTextureBytes, kLowBytes);
+    memoryBudget.TrackEvictable(1, kTextureBytes, kLowBytes);
+    memoryBudget.SetBudget(0);
+
+    // New textures count as used
+    std::vector<uint32_t> evictions;
+    memoryBudget.SelectEvictions(evictions);
+    EXPECT_TRUE(evictions.empty());
+
+    for (uint64_t i = 1; i < MemoryBudget::kMinIdleFrames; ++i)
+    {
+        memoryBudget.BeginFrame();
+        memoryBudget.Touch(1);
+    }
+    memoryBudget.BeginFrame();
+    memoryBudget.SelectEvictions(evictions);
+    EXPECT_TRUE(evictions == std::vector<uint32_t>({ 0 }));
+
+    // Texture 1 was used last frame: it's kept until kMinIdleFrames frames have passed since
+    evictions.clear();
+    for (uint64_t i = 2; i < MemoryBudget::kMinIdleFrames; ++i)
+    {
+        memoryBudget.BeginFrame();
+    }
+    memoryBudget.SelectEvictions(evictions);
+    EXPECT_TRUE(evictions == std::vector<uint32_t>({ 0 }));
+    memoryBudget.BeginFrame();
+    evictions.clear();
+    memoryBudget.SelectEvictions(evictions);
+    EXPECT_TRUE(evictions == std::vector<uint32_t>({ 0, 1 }));
+}
+
+TEST(MemoryBudget, EvictsOnlyTheExcess)
+{
+    MemoryBudget memoryBudget;
+    memoryBudget.Track(Category::Texture, 100, 5000);
+    for (uint32_t texture = 0; texture < 8; ++texture)
+    {
+        memoryBudget.TrackEvictable(texture, kTextureBytes, kLowBytes);
+    }
+    Idle(memoryBudget);
+    uint64_t totalBytes = memoryBudget.GetTotalBytes();
+
+    std::vector<uint32_t> evictions;
+    memoryBudget.SetBudget(totalBytes);
+    memoryBudget.SelectEvictions(evictions);
+    EXPECT_TRUE(evictions.empty());
+
+    // Exactly three textures' worth, then one byte more
+    memoryBudget.SetBudget(totalBytes - 3 * kFreedBytes);
+    memoryBudget.SelectEvictions(evictions);
+    EXPECT_EQ(evictions.size(), 3u);
+
+    evictions.clear();
+    memoryBudget.SetBudget(totalBytes - 3 * kFreedBytes - 1);
+    memoryBudget.SelectEvictions(evictions);
+    EXPECT_EQ(evictions.size(), 4u);
+
+    // Textures already down to their low mips free nothing
+    memoryBudget.TrackEvictable(0, kLowBytes, kLowBytes);
+    evictions.clear();
+    memoryBudget.SetBudget(memoryBudget.GetTotalBytes() - 1);
+    memoryBudget.SelectEvictions(evictions);
+    EXPECT_EQ(evictions.size(), 1u);
+    EXPECT_TRUE(evictions[0] != 0);
+}
+
+TEST(MemoryBudget, CountsConfirmedEvictions)
+{
+    MemoryBudget memoryBudget;
+    memoryBudget.TrackEvictable(0, kTextureBytes, kLowBytes);
+    memoryBudget.TrackEvictable(1, kTextureBytes, kLowBytes);
+    Idle(memoryBudget);
+    memoryBudget.SetBudget(0);
+
+    // Selecting isn't evicting: the owner may fail to evict, or select again next frame
+    std::vector<uint32_t> evictions;
+    memoryBudget.SelectEvictions(evictions);
+    memoryBudget.SelectEvictions(evictions);
+    EXPECT_EQ(evictions.size(), 4u);
+    EXPECT_EQ(memoryBudget.GetStatistics().Evictions, 0u);
+    EXPECT_EQ(memoryBudget.GetStatistics().EvictedBytes, 0u);
+
+    memoryBudget.OnEvicted(1, kFreedBytes);
+    // Not a streamed texture
+    memoryBudget.OnEvicted(5, kFreedBytes);
+    EXPECT_EQ(memoryBudget.GetStatistics().Evictions, 1u);
+    EXPECT_EQ(memoryBudget.GetStatistics().EvictedBytes, kFreedBytes);
+}
@@ -0,0 +1,280 @@
+#include "Test.h"
+#include "Utils/MipGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace MipGenerator;
+
+static constexpr uint32_t kChannels = 4;
+
+static std::vector<uint8_t> MakeNoise(uint32_t width, uint32_t height, uint32_t seed)
+{
+    std::vector<uint8_t> image((size_t)width * height * kChannels);
+    uint32_t state = seed;
+    for (auto &value : image)
+    {
+        state = state * 1664525u + 1013904223u;
+        value = (uint8_t)(state >> 24);
+    }
+    return image;
+}
+
+static double SRGBToLinear(double value)
+{
+    return value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+}
+
+static double LinearToSRGB(double value)
+{
+    return value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+}
+
+static double BesselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 64; ++k)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+// Kaiser windowed sinc of width 3 and alpha 4, sampled at the 12 source texels 2x - 5 to 2x + 6
+static std::vector<double> GetKaiserWeights()
+{
+    const double kPi = 3.14159265358979323846;
+
+    std::vector<double> weights;
+    double sum = 0.0;
+    for (int32_t k = -5; k <= 6; ++k)
+    {
+        double x = (k - 0.5) * 0.5;
+        double sinc = x == 0.0 ? 1.0 : std::sin(kPi * x) / (kPi * x);
+        double t = x / 3.0;
+        weights.push_back(sinc * BesselI0(4.0 * std::sqrt(1.0 - t * t)) / BesselI0(4.0));
+        sum += weights.back();
+    }
+    for (auto &weight : weights)
+    {
+        weight /= sum;
+    }
+    return weights;
+}
+
+// Straightforward double precision version of Generate(), with the same edge handling: the box filter drops the
+// last row and column of odd sizes, the Kaiser filter clamps its taps to the level
+static std::vector<std::vector<double>> GenerateReference(const std::vector<uint8_t> &source, uint32_t width, uint32_t height,
+                                                          bool srgb, Filter filter)
+{
+    std::vector<std::vector<double>> levels(1, std::vector<double>(source.size()));
+    for (size_t i = 0; i < source.size(); ++i)
+    {
+        double value = source[i] / 255.0;
+        levels[0][i] = srgb && i % kChannels != 3 ? SRGBToLinear(value) : value;
+    }
+
+    auto kaiserWeights = GetKaiserWeights();
+    while (width > 1 || height > 1)
+    {
+        uint32_t levelWidth = std::max(width >> 1, 1u);
+        uint32_t levelHeight = std::max(height >> 1, 1u);
+        const auto &previous = levels.back();
+        auto texel = [&](int32_t x, int32_t y, uint32_t c)
+        {
+            x = std::clamp(x, 0, (int32_t)width - 1);
+            y = std::clamp(y, 0, (int32_t)height - 1);
+            return previous[((size_t)y * width + x) * kChannels + c];
+        };
+
+        std::vector<double> level((size_t)levelWidth * levelHeight * kChannels);
+        for (uint32_t y = 0; y < levelHeight; ++y)
+        {
+            for (uint32_t x = 0; x < levelWidth; ++x)
+            {
+                for (uint32_t c = 0; c < kChannels; ++c)
+                {
+                    double sum = 0.0;
+                    if (filter == Filter::Box)
+                    {
+                        sum = 0.25 * (texel(2 * x, 2 * y, c) + texel(2 * x + 1, 2 * y, c) + texel(2 * x, 2 * y + 1, c) +
+                                      texel(2 * x + 1, 2 * y + 1, c));
+                    }
+                    else
+                    {
+                        for (int32_t j = 0; j < 12; ++j)
+                        {
+                            for (int32_t i = 0; i < 12; ++i)
+                            {
+                                sum += kaiserWeights[i] * kaiserWeights[j] * texel(2 * x - 5 + i, 2 * y - 5 + j, c);
+                            }
+                        }
+                    }
+                    level[((size_t)y * levelWidth + x) * kChannels + c] = sum;
+                }
+            }
+        }
+
+        levels.push_back(std::move(level));
+        width = levelWidth;
+        height = levelHeight;
+    }
+    return levels;
+}
+
+// The largest difference between the chain and the reference, in 8 bit steps
+static int32_t GetMaxError(const MipChain &chain, const std::vector<std::vector<double>> &reference, bool srgb)
+{
+    int32_t maxError = 0;
+    for (size_t i = 0; i < chain.Levels.size(); ++i)
+    {
+        const uint8_t *data = chain.Data.get() + chain.Levels[i].Offset;
+        for (size_t j = 0; j < reference[i].size(); ++j)
+        {
+            double value = std::clamp(reference[i][j], 0.0, 1.0);
+            value = srgb && j % kChannels != 3 ? LinearToSRGB(value) : value;
+            maxError = std::max(maxError, std::abs((int32_t)data[j] - (int32_t)std::lround(value * 255.0)));
+        }
+    }
+    return maxError;
+}
+
+static bool ExpectLevelSizes(const MipChain &chain, uint32_t width, uint32_t height)
+{
+    bool matches = chain.Levels.size() == GetMipCount(width, height);
+    size_t size = 0;
+    for (size_t i = 0; i < chain.Levels.size() && matches; ++i)
+    {
+        const auto &level = chain.Levels[i];
+        matches &= level.Offset == size && level.Width == std::max(width >> i, 1u) &&
+                   level.Height == std::max(height >> i, 1u) && level.RowPitch == level.Width * kChannels;
+        size += (size_t)level.RowPitch * level.Height;
+    }
+    return matches && chain.Size == size;
+}
+
+TEST(MipGenerator, MipCount)
+{
+    EXPECT_EQ(GetMipCount(1, 1), 1u);
+    EXPECT_EQ(GetMipCount(256, 256), 9u);
+    EXPECT_EQ(GetMipCount(256, 1), 9u);
+    EXPECT_EQ(GetMipCount(37, 13), 6u);
+
+    auto image = MakeNoise(8, 8, 1);
+    EXPECT_EQ(Generate(image.data(), 8, 8, 8 * kChannels, false, Filter::Box, 2).Levels.size(), 2u);
+    EXPECT_EQ(Generate(image.data(), 8, 8, 8 * kChannels, false, Filter::Box, 100).Levels.size(), 4u);
+    EXPECT_TRUE(Generate(nullptr, 8, 8, 8 * kChannels, false).Levels.empty());
+    EXPECT_TRUE(Generate(image.data(), 0, 8, 0, false).Levels.empty());
+}
+
+TEST(MipGenerator, ConstantImageIsUnchanged)
+{
+    // Every 8 bit value has to survive filtering and the trip through linear space in every channel
+    static constexpr uint32_t kWidth = 19;
+    static constexpr uint32_t kHeight = 6;
+    for (uint32_t value = 0; value < 256; ++value)
+    {
+        std::vector<uint8_t> image((size_t)kWidth * kHeight * kChannels);
+        for (size_t i = 0; i < image.size(); ++i)
+        {
+            image[i] = (uint8_t)(value + i % kChannels * 64);
+        }
+
+        for (bool srgb : { false, true })
+        {
+            for (Filter filter : { Filter::Box, Filter::Kaiser })
+            {
+                auto chain = Generate(image.data(), kWidth, kHeight, kWidth * kChannels, srgb, filter);
+                bool unchanged = true;
+                for (const auto &level : chain.Levels)
+                {
+                    const uint8_t *data = chain.Data.get() + level.Offset;
+                    for (size_t i = 0; i < (size_t)level.RowPitch * level.Height; ++i)
+                    {
+                        unchanged &= data[i] == image[i % kChannels];
+                    }
+                }
+                EXPECT_TRUE(unchanged);
+            }
+        }
+    }
+}
+
+TEST(MipGenerator, MatchesReference)
+{
+    // Through the SSE loops and, where the CPU has it, the AVX ones.
+    // Odd sizes, so both filters handle the edges, and one dimension reaching 1 before the other
+    const uint32_t kSizes[][2] = { { 64, 64 }, { 37, 13 }, { 1, 21 }, { 300, 173 } };
+    for (const auto &size : kSizes)
+    {
+        auto image = MakeNoise(size[0], size[1], size[0] * 31 + size[1]);
+        for (bool srgb : { false, true })
+        {
+            for (Filter filter : { Filter::Box, Filter::Kaiser })
+            {
+                // Only rounding: the float filters against the double ones, and the 4096 entry sRGB table
+                auto reference = GenerateReference(image, size[0], size[1], srgb, filter);
+                for (bool avx : { true, false })
+                {
+                    SetAVXEnabled(avx);
+                    auto chain = Generate(image.data(), size[0], size[1], size[0] * kChannels, srgb, filter);
+                    EXPECT_TRUE(ExpectLevelSizes(chain, size[0], size[1]));
+                    EXPECT_TRUE(std::memcmp(chain.Data.get(), image.data(), image.size()) == 0);
+                    EXPECT_TRUE(GetMaxError(chain, reference, srgb) <= 1);
+                }
+                SetAVXEnabled(true);
+            }
+        }
+    }
+}
+
+TEST(MipGenerator, SourceRowPitch)
+{
+    static constexpr uint32_t kWidth = 23;
+    static constexpr uint32_t kHeight = 17;
+    static constexpr uint32_t kPitch = 128;
+    auto image = MakeNoise(kWidth, kHeight, 7);
+    std::vector<uint8_t> padded((size_t)kPitch * kHeight, 0xcd);
+    for (uint32_t y = 0; y < kHeight; ++y)
+    {
+        std::memcpy(padded.data() + y * kPitch, image.data() + y * kWidth * kChannels, kWidth * kChannels);
+    }
+
+    auto tight = Generate(image.data(), kWidth, kHeight, kWidth * kChannels, true);
+    auto pitched = Generate(padded.data(), kWidth, kHeight, kPitch, true);
+    EXPECT_EQ(tight.Size, pitched.Size);
+    EXPECT_TRUE(std::memcmp(tight.Data.get(), pitched.Data.get(), tight.Size) == 0);
+}
+
+TEST(MipGenerator, AVXMatchesSSE)
+{
+    if (!UsesAVX())
+    {
+        return;
+    }
+
+    // Sizes around the two-texel steps of the AVX loops, and one large enough to be split across jobs
+    const uint32_t kSizes[][2] = { { 64, 64 }, { 37, 13 }, { 18, 18 }, { 13, 1 }, { 1, 21 }, { 515, 261 } };
+    for (const auto &size : kSizes)
+    {
+        auto image = MakeNoise(size[0], size[1], size[0] + size[1]);
+        for (bool srgb : { false, true })
+        {
+            for (Filter filter : { Filter::Box, Filter::Kaiser })
+            {
+                auto avx = Generate(image.data(), size[0], size[1], size[0] * kChannels, srgb, filter);
+                SetAVXEnabled(false);
+                auto sse = Generate(image.data(), size[0], size[1], size[0] * kChannels, srgb, filter);
+                SetAVXEnabled(true);
+
+                EXPECT_EQ(avx.Size, sse.Size);
+                EXPECT_TRUE(std::memcmp(avx.Data.get(), sse.Data.get(), sse.Size) == 0);
+            }
+        }
+    }
+}
@@ -0,0 +1,270 @@
+#include "Test.h"
+#include "Utils/ShadowCascades.h"
+
+#include <algorithm>
+
+using CameraInfo = ShadowCascades::CameraInfo;
+
+static constexpr float kTanHalfFovY = 0.57735027f;
+static constexpr float kNearZ = 0.1f;
+static constexpr float kFarZ = 200.0f;
+static const float kLightDirection[3] = { 0.3f, -1.0f, 0.2f };
+
+static CameraInfo MakeCamera(float yaw = 0.0f)
+{
+    CameraInfo camera = {};
+    camera.Position[1] = 2.0f;
+    camera.Forward[0] = std::sin(yaw);
+    camera.Forward[2] = std::cos(yaw);
+    camera.Right[0] = std::cos(yaw);
+    camera.Right[2] = -std::sin(yaw);
+    camera.Up[1] = 1.0f;
+    camera.TanHalfFovX = kTanHalfFovY * 16.0f / 9.0f;
+    camera.TanHalfFovY = kTanHalfFovY;
+    camera.NearZ = kNearZ;
+    camera.FarZ = kFarZ;
+    return camera;
+}
+
+// Row vector times matrix, then the perspective divide
+static void Transform(const ShadowCascades::Matrix &matrix, const float point[3], float result[3])
+{
+    float w = matrix.M[3][3];
+    for (uint32_t column = 0; column < 3; ++column)
+    {
+        result[column] = matrix.M[3][column];
+    }
+    for (uint32_t row = 0; row < 3; ++row)
+    {
+        for (uint32_t column = 0; column < 3; ++column)
+        {
+            result[column] += point[row] * matrix.M[row][column];
+        }
+        w += point[row] * matrix.M[row][3];
+    }
+    for (uint32_t column = 0; column < 3; ++column)
+    {
+        result[column] /= w;
+    }
+}
+
+static void GetCorner(const CameraInfo &camera, float depth, float signX, float signY, float corner[3])
+{
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        corner[axis] = camera.Position[axis] + camera.Forward[axis] * depth + camera.Right[axis] * signX * depth * camera.TanHalfFovX +
+                       camera.Up[axis] * signY * depth * camera.TanHalfFovY;
+    }
+}
+
+TEST(ShadowCascades, SplitsCoverTheFrustum)
+{
+    ShadowCascades cascades;
+    ShadowCascades::Settings settings;
+    EXPECT_TRUE(cascades.Update(MakeCamera(), kLightDirection, settings));
+    EXPECT_EQ(cascades.GetCascadeCount(), settings.CascadeCount);
+
+    EXPECT_EQ(cascades.GetCascade(0).SplitNear, kNearZ);
+    EXPECT_EQ(cascades.GetCascade(settings.CascadeCount - 1).SplitFar, kFarZ);
+    for (uint32_t i = 0; i < settings.CascadeCount; ++i)
+    {
+        const auto &cascade = cascades.GetCascade(i);
+        EXPECT_TRUE(cascade.SplitNear < cascade.SplitFar);
+        if (i > 0)
+        {
+            EXPECT_EQ(cascade.SplitNear, cascades.GetCascade(i - 1).SplitFar);
+        }
+        EXPECT_EQ(cascades.GetCascadeIndex((cascade.SplitNear + cascade.SplitFar) / 2.0f), i);
+    }
+    EXPECT_EQ(cascades.GetCascadeIndex(kFarZ * 2.0f), settings.CascadeCount - 1);
+}
+
+TEST(ShadowCascades, SplitLambdaBlendsUniformAndLogarithmic)
+{
+    ShadowCascades cascades;
+    ShadowCascades::Settings settings;
+    settings.CascadeCount = 4;
+
+    settings.SplitLambda = 0.0f;
+    cascades.Update(MakeCamera(), kLightDirection, settings);
+    for (uint32_t i = 0; i + 1 < settings.CascadeCount; ++i)
+    {
+        EXPECT_NEAR(cascades.GetCascade(i).SplitFar, kNearZ + (kFarZ - kNearZ) * (i + 1) / 4.0f, 1e-3);
+    }
+
+    settings.SplitLambda = 1.0f;
+    cascades.Update(MakeCamera(), kLightDirection, settings);
+    for (uint32_t i = 0; i + 1 < settings.CascadeCount; ++i)
+    {
+        EXPECT_NEAR(cascades.GetCascade(i).SplitFar, kNearZ * std::pow(kFarZ / kNearZ, (i + 1) / 4.0f), 1e-3);
+    }
+}
+
+TEST(ShadowCascades, EveryCascadeContainsItsSlice)
+{
+    ShadowCascades cascades;
+    ShadowCascades::Settings settings;
+    CameraInfo camera = MakeCamera(0.7f);
+    EXPECT_TRUE(cascades.Update(camera, kLightDirection, settings));
+
+    // Snapping moves the projection by up to half a texel
+    float tolerance = 2.0f / settings.Resolution;
+    bool inside = true;
+    for (uint32_t i = 0; i < cascades.GetCascadeCount(); ++i)
+    {
+        const auto &cascade = cascades.GetCascade(i);
+        for (uint32_t corner = 0; corner < 8; ++corner)
+        {
+            float point[3], clip[3];
+            GetCorner(camera, corner < 4 ? cascade.SplitNear : cascade.SplitFar, corner & 1 ? 1.0f : -1.0f,
+                      corner & 2 ? 1.0f : -1.0f, point);
+            Transform(cascade.ViewProjection, point, clip);
+            inside &= std::abs(clip[0]) <= 1.0f + tolerance && std::abs(clip[1]) <= 1.0f + tolerance;
+            inside &= clip[2] >= 0.0f && clip[2] <= 1.0f + 1e-4f;
+        }
+    }
+    EXPECT_TRUE(inside);
+}
+
+TEST(ShadowCascades, CascadesDontChangeAsTheCameraTurns)
+{
+    ShadowCascades cascades;
+    ShadowCascades::Settings settings;
+    cascades.Update(MakeCamera(0.0f), kLightDirection, settings);
+    float radii[ShadowCascades::kMaxCascades];
+    for (uint32_t i = 0; i < cascades.GetCascadeCount(); ++i)
+    {
+        radii[i] = cascades.GetCascade(i).Radius;
+    }
+
+    for (float yaw : { 0.3f, 1.1f, 2.5f, -1.9f })
+    {
+        cascades.Update(MakeCamera(yaw), kLightDirection, settings);
+        for (uint32_t i = 0; i < cascades.GetCascadeCount(); ++i)
+        {
+            EXPECT_EQ(cascades.GetCascade(i).Radius, radii[i]);
+        }
+    }
+}
+
+TEST(ShadowCascades, SnapsToTexels)
+{
+    ShadowCascades cascades;
+    ShadowCascades::Settings settings;
+    CameraInfo camera = MakeCamera(0.4f);
+    camera.Position[0] = 13.37f;
+    camera.Position[2] = -4.21f;
+    cascades.Update(camera, kLightDirection, settings);
+
+    // The world origin lands on a texel corner
+    float halfResolution = settings.Resolution / 2.0f;
+    for (uint32_t i = 0; i < cascades.GetCascadeCount(); ++i)
+    {
+        const auto &viewProjection = cascades.GetCascade(i).ViewProjection;
+        float originX = viewProjection.M[3][0] * halfResolution;
+        float originY = viewProjection.M[3][1] * halfResolution;
+        EXPECT_NEAR(originX, std::round(originX), 1e-2);
+        EXPECT_NEAR(originY, std::round(originY), 1e-2);
+    }
+}
+
+TEST(ShadowCascades, RejectsDegenerateInput)
+{
+    ShadowCascades cascades;
+    ShadowCascades::Settings settings;
+    float noDirection[3] = { 0.0f, 0.0f, 0.0f };
+    EXPECT_TRUE(!cascades.Update(MakeCamera(), noDirection, settings));
+
+    CameraInfo camera = MakeCamera();
+    camera.FarZ = camera.NearZ;
+    EXPECT_TRUE(!cascades.Update(camera, kLightDirection, settings));
+
+    // Straight down uses another up vector
+    float down[3] = { 0.0f, -1.0f, 0.0f };
+    EXPECT_TRUE(cascades.Update(MakeCamera(), down, settings));
+}
+
+TEST(ShadowCascades, CullsCasters)
+{
+    ShadowCascades cascades;
+    ShadowCascades::Settings settings;
+    cascades.Update(MakeCamera(), kLightDirection, settings);
+    const auto &cascade = cascades.GetCascade(0);
+
+    float length = std::sqrt(kLightDirection[0] * kLightDirection[0] + kLightDirection[1] * kLightDirection[1] +
+                             kLightDirection[2] * kLightDirection[2]);
+    std::vector<float> x, y, z, radius;
+    // Spheres distance along the light direction from the cascade's center, and sideways along world x
+    auto addSphere = [&](float distance, float sideways)
+    {
+        x.push_back(cascade.Center[0] + kLightDirection[0] / length * distance + sideways);
+        y.push_back(cascade.Center[1] + kLightDirection[1] / length * distance);
+        z.push_back(cascade.Center[2] + kLightDirection[2] / length * distance);
+        radius.push_back(0.5f);
+    };
+    addSphere(0.0f, 0.0f);
+    // Between the light and the cascade
+    addSphere(-cascade.Radius * 2.0f, 0.0f);
+    // Beside the cascade
+    addSphere(0.0f, cascade.Radius * 4.0f);
+    // There's no near plane, so casters however far towards the light still cast into the cascade
+    addSphere(-settings.CasterDistance * 3.0f, 0.0f);
+    // Past the far side, where nothing it shadows is seen
+    addSphere(cascade.Radius * 3.0f, 0.0f);
+
+    std::vector<uint32_t> visible;
+    cascades.CullCasters(0, x.data(), y.data(), z.data(), radius.data(), (uint32_t)x.size(), visible);
+    EXPECT_EQ(visible, (std::vector<uint32_t>{ 0, 1, 3 }));
+
+    cascades.CullCasters(ShadowCascades::kMaxCascades, x.data(), y.data(), z.data(), radius.data(), (uint32_t)x.size(), visible);
+    EXPECT_TRUE(visible.empty());
+}
+
+TEST(ShadowCascades, BatchedCullingMatchesPlaneTests)
+{
+    ShadowCascades cascades;
+    ShadowCascades::Settings settings;
+    cascades.Update(MakeCamera(0.2f), kLightDirection, settings);
+
+    // Not a multiple of 4, so the scalar tail runs too
+    static constexpr uint32_t kCount = 4099;
+    uint32_t state = 0x51ed270b;
+    auto random = [&state](float min, float max)
+    {
+        state = state * 1664525u + 1013904223u;
+        return min + (max - min) * (float)(state >> 8) / (float)(1 << 24);
+    };
+    std::vector<float> x(kCount), y(kCount), z(kCount), radius(kCount);
+    for (uint32_t i = 0; i < kCount; ++i)
+    {
+        x[i] = random(-150.0f, 150.0f);
+        y[i] = random(-20.0f, 60.0f);
+        z[i] = random(-50.0f, 250.0f);
+        radius[i] = random(0.1f, 8.0f);
+    }
+
+    uint32_t visibleCount = 0;
+    for (uint32_t i = 0; i < cascades.GetCascadeCount(); ++i)
+    {
+        std::vector<uint32_t> expected;
+        for (uint32_t sphere = 0; sphere < kCount; ++sphere)
+        {
+            bool inside = true;
+            for (const auto &plane : cascades.GetCascade(i).CasterPlanes)
+            {
+                inside &= plane.NormalX * x[sphere] + plane.NormalY * y[sphere] + plane.NormalZ * z[sphere] + plane.Distance + radius[sphere] >= 0.0f;
+            }
+            if (inside)
+            {
+                expected.push_back(sphere);
+            }
+        }
+
+        std::vector<uint32_t> visible;
+        cascades.CullCasters(i, x.data(), y.data(), z.data(), radius.data(), kCount, visible);
+        EXPECT_EQ(visible, expected);
+        visibleCount += (uint32_t)visible.size();
+    }
+    // Both outcomes were tested
+    EXPECT_TRUE(visibleCount > 0 && visibleCount < kCount * cascades.GetCascadeCount());
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// Just enough of a test framework for the engine code that runs without a device.
+/// TEST(Suite, Name) defines a test; EXPECT_* report a failure and let the test carry on
+/// </summary>
+namespace Test
+{
+
+struct Case
+{
+    const char *Suite;
+    const char *Name;
+    void (*Function)();
+};
+
+std::vector<Case> &GetCases();
+void Fail(const char *file, int line, const char *expression);
+
+struct Registrar
+{
+    Registrar(const char *suite, const char *name, void (*function)())
+    {
+        GetCases().push_back({ suite, name, function });
+    }
+};
+
+} // namespace Test
+
+#define TEST(suite, name)                                                                                              \
+    static void Test_##suite##_##name();                                                                               \
+    static Test::Registrar gRegistrar_##suite##_##name(#suite, #name, &Test_##suite##_##name);                         \
+    static void Test_##suite##_##name()
+
+#define EXPECT_TRUE(condition)                                                                                         \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            Test::Fail(__FILE__, __LINE__, #condition);                                                                \
+        }                                                                                                              \
+    } while (false)
+
+#define EXPECT_EQ(lhs, rhs) EXPECT_TRUE((lhs) == (rhs))
+#define EXPECT_NEAR(lhs, rhs, tolerance) EXPECT_TRUE(std::abs((double)(lhs) - (double)(rhs)) <= (double)(tolerance))
@@ -0,0 +1,251 @@
+#include "Test.h"
+#include "Utils/TextureResidency.h"
+
+using Change = TextureResidency::Change;
+
+static constexpr uint32_t kSize = 1024;
+static constexpr uint32_t kMipCount = 11;
+static constexpr uint32_t kTailMip = 6;
+static constexpr uint64_t kNoLimit = ~0ull;
+
+static TextureResidency::TextureDesc MakeDesc()
+{
+    TextureResidency::TextureDesc desc;
+    desc.Width = kSize;
+    desc.Height = kSize;
+    desc.MipCount = kMipCount;
+    desc.TailMip = kTailMip;
+    for (uint32_t mip = 0; mip < kMipCount; ++mip)
+    {
+        uint64_t size = kSize >> mip;
+        desc.MipSizes.push_back(size * size * 4);
+    }
+    return desc;
+}
+
+// Bytes a stream-in adds, or an eviction frees
+static uint64_t GetChangeBytes(const TextureResidency &residency, const Change &change)
+{
+    uint64_t resident = residency.GetBytes(change.Texture, change.ResidentMip);
+    uint64_t target = residency.GetBytes(change.Texture, change.TargetMip);
+    return resident > target ? resident - target : target - resident;
+}
+
+// One update whose stream-ins finish right away, as if the uploads were done by the next frame
+static void Update(TextureResidency &residency, uint64_t budget, uint64_t maxStreamInBytes, std::vector<Change> &changes)
+{
+    changes.clear();
+    residency.Update(budget, maxStreamInBytes, changes);
+    for (const auto &change : changes)
+    {
+        if (change.TargetMip < change.ResidentMip)
+        {
+            residency.OnStreamedIn(change.Texture, change.TargetMip);
+        }
+    }
+}
+
+TEST(TextureResidency, StaysWithinBudget)
+{
+    static constexpr uint32_t kTextureCount = 8;
+    TextureResidency residency;
+    for (uint32_t i = 0; i < kTextureCount; ++i)
+    {
+        residency.AddTexture(MakeDesc());
+    }
+
+    // Room for a bit more than two textures at full resolution
+    uint64_t budget = residency.GetBytes(0, 0) * 2 + residency.GetBytes(0, 2) * kTextureCount;
+    std::vector<Change> changes;
+    for (uint32_t update = 0; update < 64; ++update)
+    {
+        for (uint32_t i = 0; i < kTextureCount; ++i)
+        {
+            residency.Request(i, (float)kSize);
+        }
+        Update(residency, budget, kNoLimit, changes);
+        EXPECT_TRUE(residency.GetResidentBytes() + residency.GetPendingBytes() <= budget);
+    }
+
+    // The budget is used, not just respected: what's left can't pay for another mip 0
+    uint64_t mip0Bytes = residency.GetBytes(0, 0) - residency.GetBytes(0, 1);
+    EXPECT_TRUE(budget - residency.GetResidentBytes() < mip0Bytes);
+    for (uint32_t i = 0; i < kTextureCount; ++i)
+    {
+        EXPECT_TRUE(residency.GetResidentMip(i) < kTailMip);
+    }
+}
+
+TEST(TextureResidency, KeepsTailsOverBudget)
+{
+    TextureResidency residency;
+    uint32_t texture = residency.AddTexture(MakeDesc());
+
+    std::vector<Change> changes;
+    residency.Request(texture, (float)kSize);
+    Update(residency, 0, kNoLimit, changes);
+    EXPECT_TRUE(changes.empty());
+    EXPECT_EQ(residency.GetResidentMip(texture), kTailMip);
+    EXPECT_EQ(residency.GetResidentBytes(), residency.GetBytes(texture, kTailMip));
+}
+
+TEST(TextureResidency, CapsStreamInPerUpdate)
+{
+    static constexpr uint32_t kTextureCount = 4;
+    TextureResidency residency;
+    for (uint32_t i = 0; i < kTextureCount; ++i)
+    {
+        residency.AddTexture(MakeDesc());
+    }
+
+    // Enough for the coarse mips of every texture at once, not for the fine ones
+    uint64_t maxStreamInBytes = residency.GetBytes(0, 4) * kTextureCount;
+    std::vector<Change> changes;
+    uint32_t update = 0;
+    for (; update < 64 && residency.GetResidentBytes() < residency.GetBytes(0, 0) * kTextureCount; ++update)
+    {
+        for (uint32_t i = 0; i < kTextureCount; ++i)
+        {
+            residency.Request(i, (float)kSize);
+        }
+        Update(residency, kNoLimit, maxStreamInBytes, changes);
+
+        uint64_t streamInBytes = 0;
+        uint32_t streamedMips = 0;
+        for (const auto &change : changes)
+        {
+            EXPECT_TRUE(change.TargetMip < change.ResidentMip);
+            streamInBytes += GetChangeBytes(residency, change);
+            streamedMips += change.ResidentMip - change.TargetMip;
+        }
+        // A single mip larger than the cap still goes through, or nothing could ever stream in
+        EXPECT_TRUE(streamInBytes <= maxStreamInBytes || streamedMips == 1);
+        EXPECT_TRUE(streamedMips > 0);
+    }
+
+    for (uint32_t i = 0; i < kTextureCount; ++i)
+    {
+        EXPECT_EQ(residency.GetResidentMip(i), 0u);
+    }
+    // The capped updates spread the last mips over several frames
+    EXPECT_TRUE(update > kTextureCount);
+}
+
+TEST(TextureResidency, StreamsOneMipPerUpdateUnderTightCap)
+{
+    TextureResidency residency;
+    uint32_t texture = residency.AddTexture(MakeDesc());
+
+    std::vector<Change> changes;
+    for (uint32_t mip = kTailMip; mip-- > 0;)
+    {
+        residency.Request(texture, (float)kSize);
+        Update(residency, kNoLimit, 1, changes);
+        EXPECT_EQ(changes.size(), 1u);
+        EXPECT_EQ(residency.GetResidentMip(texture), mip);
+    }
+}
+
+TEST(TextureResidency, SkipsTexturesStreamingIn)
+{
+    TextureResidency residency;
+    uint32_t texture = residency.AddTexture(MakeDesc());
+
+    std::vector<Change> changes;
+    residency.Request(texture, (float)kSize);
+    residency.Update(kNoLimit, kNoLimit, changes);
+    EXPECT_EQ(changes.size(), 1u);
+    EXPECT_EQ(residency.GetPendingMip(texture), 0u);
+    EXPECT_EQ(residency.GetResidentMip(texture), kTailMip);
+
+    // No change until the upload is done, even though the texture isn't wanted anymore
+    changes.clear();
+    residency.Update(0, kNoLimit, changes);
+    EXPECT_TRUE(changes.empty());
+
+    residency.OnStreamInFailed(texture);
+    EXPECT_EQ(residency.GetPendingMip(texture), kTailMip);
+    EXPECT_EQ(residency.GetPendingBytes(), 0u);
+}
+
+TEST(TextureResidency, EvictsLowestPriorityMipsFirst)
+{
+    TextureResidency residency;
+    uint32_t near = residency.AddTexture(MakeDesc());
+    uint32_t far = residency.AddTexture(MakeDesc());
+
+    auto request = [&]()
+    {
+        residency.Request(near, (float)kSize);
+        residency.Request(far, (float)kSize / 4);
+    };
+
+    std::vector<Change> changes;
+    for (uint32_t update = 0; update < 4; ++update)
+    {
+        request();
+        Update(residency, kNoLimit, kNoLimit, changes);
+    }
+    EXPECT_EQ(residency.GetResidentMip(near), 0u);
+    EXPECT_EQ(residency.GetResidentMip(far), 2u);
+
+    // Every step of the far texture samples fewer pixels per texel than the near one's, so its
+    // finest mip goes first even though the near texture's mip 0 is much larger
+    request();
+    Update(residency, residency.GetResidentBytes() - 1, kNoLimit, changes);
+    EXPECT_EQ(changes.size(), 1u);
+    EXPECT_EQ(changes[0].Texture, far);
+    EXPECT_EQ(changes[0].ResidentMip, 2u);
+    EXPECT_EQ(changes[0].TargetMip, 3u);
+    EXPECT_EQ(residency.GetResidentMip(near), 0u);
+
+    // Once the far texture's mips no longer pay for it, the near texture's mip 0 goes too
+    request();
+    Update(residency, residency.GetBytes(near, 1) + residency.GetBytes(far, 3), kNoLimit, changes);
+    EXPECT_EQ(residency.GetResidentMip(near), 1u);
+    EXPECT_EQ(residency.GetResidentMip(far), 3u);
+}
+
+TEST(TextureResidency, KeepsMipsForEvictionDelay)
+{
+    TextureResidency residency;
+    uint32_t texture = residency.AddTexture(MakeDesc());
+
+    std::vector<Change> changes;
+    residency.Request(texture, (float)kSize);
+    Update(residency, kNoLimit, kNoLimit, changes);
+    EXPECT_EQ(residency.GetResidentMip(texture), 0u);
+
+    for (uint32_t update = 0; update < TextureResidency::kEvictionDelay; ++update)
+    {
+        Update(residency, kNoLimit, kNoLimit, changes);
+        EXPECT_TRUE(changes.empty());
+    }
+    EXPECT_EQ(residency.GetResidentMip(texture), 0u);
+
+    Update(residency, kNoLimit, kNoLimit, changes);
+    EXPECT_EQ(changes.size(), 1u);
+    EXPECT_EQ(residency.GetResidentMip(texture), kTailMip);
+}
+
+TEST(TextureResidency, EvictDropsRightAway)
+{
+    TextureResidency residency;
+    uint32_t texture = residency.AddTexture(MakeDesc());
+
+    std::vector<Change> changes;
+    residency.Request(texture, (float)kSize);
+    Update(residency, kNoLimit, kNoLimit, changes);
+
+    Change change;
+    EXPECT_TRUE(residency.Evict(texture, 3, change));
+    EXPECT_EQ(change.ResidentMip, 0u);
+    EXPECT_EQ(change.TargetMip, 3u);
+    EXPECT_EQ(residency.GetResidentMip(texture), 3u);
+    EXPECT_TRUE(!residency.Evict(texture, 2, change));
+
+    // The next request brings the mips back
+    residency.Request(texture, (float)kSize);
+    Update(residency, kNoLimit, kNoLimit, changes);
+    EXPECT_EQ(residency.GetResidentMip(texture), 0u);
+}
@@ -0,0 +1,77 @@
+#include "Test.h"
+#include "Utils/TextureTable.h"
+
+static constexpr uint64_t kHeapStart = 0x100000;
+static constexpr uint64_t kDescriptorSize = 32;
+
+// A texture with a shader resource view at heapIndex, and a render target view when rtvIndex isn't -1
+static uint32_t AddTexture(TextureTable &table, int32_t heapIndex, int32_t rtvIndex = -1)
+{
+    uint32_t index = table.Add();
+    auto &entry = table.GetEntry(index);
+    entry.HeapIndices[TextureTable::kSrv] = heapIndex;
+    entry.HeapIndices[TextureTable::kRtv] = rtvIndex;
+    entry.SrvGPU = kHeapStart + heapIndex * kDescriptorSize;
+    entry.RtvCPU = rtvIndex != -1 ? kHeapStart + rtvIndex * kDescriptorSize : 0;
+    return index;
+}
+
+TEST(TextureTable, LooksUpHandles)
+{
+    TextureTable table;
+    EXPECT_TRUE(table.IsEmpty());
+    uint32_t first = AddTexture(table, 3);
+    uint32_t second = AddTexture(table, 7, 1);
+    EXPECT_EQ(first, 0u);
+    EXPECT_EQ(second, 1u);
+    EXPECT_EQ(table.GetSize(), 2u);
+
+    auto handle = table.GetHandle(second);
+    EXPECT_TRUE(table.IsValid(handle));
+    EXPECT_EQ(table.GetSrvGPU(handle), kHeapStart + 7 * kDescriptorSize);
+    EXPECT_EQ(table.GetRtvCPU(handle), kHeapStart + 1 * kDescriptorSize);
+    // Views the texture doesn't have
+    EXPECT_EQ(table.GetUavGPU(handle), 0u);
+    EXPECT_EQ(table.GetDsvCPU(handle), 0u);
+    EXPECT_EQ(table.GetRtvCPU(table.GetHandle(first)), 0u);
+}
+
+TEST(TextureTable, StaleHandlesDontResolve)
+{
+    TextureTable table;
+    uint32_t index = AddTexture(table, 3);
+
+    // A default constructed handle never resolves
+    EXPECT_TRUE(!table.IsValid(TextureTable::Handle{}));
+    EXPECT_EQ(table.GetSrvGPU(TextureTable::Handle{}), 0u);
+    EXPECT_TRUE(!table.IsValid(TextureTable::Handle{ 5, 1 }));
+
+    auto oldHandle = table.GetHandle(index);
+    table.Release(index);
+    EXPECT_TRUE(!table.IsValid(oldHandle));
+    EXPECT_EQ(table.GetSrvGPU(oldHandle), 0u);
+
+    // The slot is reused by the next texture, which the old handle mustn't reach
+    table.GetEntry(index).SrvGPU = kHeapStart + 9 * kDescriptorSize;
+    auto newHandle = table.GetHandle(index);
+    EXPECT_TRUE(table.IsValid(newHandle));
+    EXPECT_EQ(table.GetSrvGPU(newHandle), kHeapStart + 9 * kDescriptorSize);
+    EXPECT_EQ(table.GetSrvGPU(oldHandle), 0u);
+}
+
+TEST(TextureTable, WritesSrvIndices)
+{
+    TextureTable table;
+    int32_t empty[1] = { 42 };
+    table.WriteSrvIndices(empty);
+    EXPECT_EQ(empty[0], -1);
+
+    AddTexture(table, 4);
+    table.Add();
+    AddTexture(table, 2);
+    int32_t indices[3] = {};
+    table.WriteSrvIndices(indices);
+    EXPECT_EQ(indices[0], 4);
+    EXPECT_EQ(indices[1], -1);
+    EXPECT_EQ(indices[2], 2);
+}
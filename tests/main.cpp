@@ -0,0 +1,52 @@
+#include "Test.h"
+#include "JobSystem.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace Test
+{
+
+static uint32_t gFailures = 0;
+
+std::vector<Case> &GetCases()
+{
+    static std::vector<Case> cases;
+    return cases;
+}
+
+void Fail(const char *file, int line, const char *expression)
+{
+    std::printf("    %s:%d: EXPECT failed: %s\n", file, line, expression);
+    ++gFailures;
+}
+
+} // namespace Test
+
+// Usage: UnitTests [suite]. Without a suite every test runs
+int main(int argc, char **argv)
+{
+    const char *suite = argc > 1 ? argv[1] : nullptr;
+    JobSystem::Get()->Init();
+
+    uint32_t ran = 0, failed = 0;
+    for (const auto &testCase : Test::GetCases())
+    {
+        if (suite && std::strcmp(suite, testCase.Suite) != 0)
+        {
+            continue;
+        }
+
+        uint32_t failuresBefore = Test::gFailures;
+        testCase.Function();
+        bool passed = Test::gFailures == failuresBefore;
+        std::printf("[%s] %s.%s\n", passed ? "  OK  " : " FAIL ", testCase.Suite, testCase.Name);
+
+        ++ran;
+        failed += passed ? 0 : 1;
+    }
+
+    JobSystem::Get()->Shutdown();
+    std::printf("%u tests, %u failed\n", ran, failed);
+    return ran == 0 || failed != 0 ? 1 : 0;
+}
@@ -0,0 +1,689 @@
+#include "BlockCompression.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace BlockCompression
+{
+
+static constexpr uint32_t kChannels = 4;
+// Blocks compressed by one job at most
+static constexpr uint32_t kBlocksPerJob = 1024;
+
+// BC7 4 bit index weights, in 64ths
+static constexpr int32_t kBC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+using BlockTexels = float[kTexelsPerBlock][kChannels];
+
+class BitWriter
+{
+public:
+    explicit BitWriter(uint8_t *block)
+        : mBlock(block)
+    {
+        std::memset(mBlock, 0, 16);
+    }
+
+    void Write(uint32_t value, uint32_t bitCount)
+    {
+        for (uint32_t i = 0; i < bitCount; ++i, ++mPosition)
+        {
+            if (value & (1u << i))
+            {
+                mBlock[mPosition >> 3] |= (uint8_t)(1u << (mPosition & 7));
+            }
+        }
+    }
+
+private:
+    uint8_t *mBlock;
+    uint32_t mPosition = 0;
+};
+
+class BitReader
+{
+public:
+    explicit BitReader(const uint8_t *block)
+        : mBlock(block)
+    {
+    }
+
+    uint32_t Read(uint32_t bitCount)
+    {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < bitCount; ++i, ++mPosition)
+        {
+            value |= (uint32_t)((mBlock[mPosition >> 3] >> (mPosition & 7)) & 1) << i;
+        }
+        return value;
+    }
+
+private:
+    const uint8_t *mBlock;
+    uint32_t mPosition = 0;
+};
+
+static void LoadBlock(const uint8_t *texels, BlockTexels &block)
+{
+    for (uint32_t i = 0; i < kTexelsPerBlock; ++i)
+    {
+        for (uint32_t c = 0; c < kChannels; ++c)
+        {
+            block[i][c] = texels[i * kChannels + c];
+        }
+    }
+}
+
+/// <summary>
+/// Finds the line that fits the first channelCount channels of the texels best, by power iteration
+/// on their covariance. Returns the two ends of the texels' projection on that line
+/// </summary>
+static void FitLine(const BlockTexels &texels, uint32_t channelCount, float *end0, float *end1)
+{
+    float mean[kChannels] = {};
+    for (uint32_t i = 0; i < kTexelsPerBlock; ++i)
+    {
+        for (uint32_t c = 0; c < channelCount; ++c)
+        {
+            mean[c] += texels[i][c] / kTexelsPerBlock;
+        }
+    }
+
+    float covariance[kChannels][kChannels] = {};
+    for (uint32_t i = 0; i < kTexelsPerBlock; ++i)
+    {
+        for (uint32_t row = 0; row < channelCount; ++row)
+        {
+            for (uint32_t column = 0; column < channelCount; ++column)
+            {
+                covariance[row][column] += (texels[i][row] - mean[row]) * (texels[i][column] - mean[column]);
+            }
+        }
+    }
+
+    float axis[kChannels] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    for (uint32_t iteration = 0; iteration < 8; ++iteration)
+    {
+        float next[kChannels] = {};
+        float length = 0.0f;
+        for (uint32_t row = 0; row < channelCount; ++row)
+        {
+            for (uint32_t column = 0; column < channelCount; ++column)
+            {
+                next[row] += covariance[row][column] * axis[column];
+            }
+            length = std::max(length, std::abs(next[row]));
+        }
+        if (length < 1e-6f)
+        {
+            // Flat block, any axis will do
+            break;
+        }
+        for (uint32_t c = 0; c < channelCount; ++c)
+        {
+            axis[c] = next[c] / length;
+        }
+    }
+
+    float axisLength = 0.0f;
+    for (uint32_t c = 0; c < channelCount; ++c)
+    {
+        axisLength += axis[c] * axis[c];
+    }
+    axisLength = std::sqrt(axisLength);
+
+    float minProjection = 0.0f;
+    float maxProjection = 0.0f;
+    for (uint32_t i = 0; i < kTexelsPerBlock; ++i)
+    {
+        float projection = 0.0f;
+        for (uint32_t c = 0; c < channelCount; ++c)
+        {
+            projection += (texels[i][c] - mean[c]) * axis[c] / axisLength;
+        }
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+
+    for (uint32_t c = 0; c < channelCount; ++c)
+    {
+        end0[c] = std::clamp(mean[c] + maxProjection * axis[c] / axisLength, 0.0f, 255.0f);
+        end1[c] = std::clamp(mean[c] + minProjection * axis[c] / axisLength, 0.0f, 255.0f);
+    }
+}
+
+/// <summary>
+/// Least squares endpoints for texels already assigned a weight between end0 (0) and end1 (1).
+/// Returns false if every texel has the same weight
+/// </summary>
+static bool RefineLine(const BlockTexels &texels, const float *weights, uint32_t channelCount, float *end0, float *end1)
+{
+    float a = 0.0f, b = 0.0f, c = 0.0f;
+    float x[kChannels] = {}, y[kChannels] = {};
+    for (uint32_t i = 0; i < kTexelsPerBlock; ++i)
+    {
+        float t = weights[i];
+        float s = 1.0f - t;
+        a += s * s;
+        b += s * t;
+        c += t * t;
+        for (uint32_t channel = 0; channel < channelCount; ++channel)
+        {
+            x[channel] += s * texels[i][channel];
+            y[channel] += t * texels[i][channel];
+        }
+    }
+
+    float determinant = a * c - b * b;
+    if (std::abs(determinant) < 1e-6f)
+    {
+        return false;
+    }
+
+    for (uint32_t channel = 0; channel < channelCount; ++channel)
+    {
+        end0[channel] = std::clamp((c * x[channel] - b * y[channel]) / determinant, 0.0f, 255.0f);
+        end1[channel] = std::clamp((a * y[channel] - b * x[channel]) / determinant, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+static uint16_t To565(const float *color)
+{
+    auto r = (uint16_t)std::lround(color[0] * 31.0f / 255.0f);
+    auto g = (uint16_t)std::lround(color[1] * 63.0f / 255.0f);
+    auto b = (uint16_t)std::lround(color[2] * 31.0f / 255.0f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void From565(uint16_t value, int32_t *color)
+{
+    int32_t r = (value >> 11) & 31;
+    int32_t g = (value >> 5) & 63;
+    int32_t b = value & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+static void GetColorPalette(uint16_t color0, uint16_t color1, bool fourColors, int32_t (&palette)[4][kChannels])
+{
+    From565(color0, palette[0]);
+    From565(color1, palette[1]);
+    palette[0][3] = palette[1][3] = palette[2][3] = 255;
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+        if (fourColors)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    palette[3][3] = fourColors ? 255 : 0;
+}
+
+static void CompressColorBlock(const BlockTexels &texels, uint8_t *block)
+{
+    // Weights of the palette entries between color0 and color1
+    static constexpr float kWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+    float end0[kChannels], end1[kChannels];
+    FitLine(texels, 3, end0, end1);
+
+    float bestError = INFINITY;
+    for (uint32_t iteration = 0; iteration < 2; ++iteration)
+    {
+        uint16_t color0 = To565(end0);
+        uint16_t color1 = To565(end1);
+        // color0 > color1 selects the four color mode
+        if (color0 < color1)
+        {
+            std::swap(color0, color1);
+        }
+
+        int32_t palette[4][kChannels];
+        GetColorPalette(color0, color1, true, palette);
+
+        uint32_t indices = 0;
+        float error = 0.0f;
+        float weights[kTexelsPerBlock];
+        for (uint32_t i = 0; i < kTexelsPerBlock; ++i)
+        {
+            uint32_t bestIndex = 0;
+            float bestTexelError = INFINITY;
+            // Equal endpoints use the three color mode, where only index 0 is safe
+            for (uint32_t index = 0; index < (color0 == color1 ? 1u : 4u); ++index)
+            {
+                float texelError = 0.0f;
+                for (uint32_t c = 0; c < 3; ++c)
+                {
+                    float difference = texels[i][c] - palette[index][c];
+                    texelError += difference * difference;
+                }
+                if (texelError < bestTexelError)
+                {
+                    bestTexelError = texelError;
+                    bestIndex = index;
+                }
+            }
+            indices |= bestIndex << (2 * i);
+            error += bestTexelError;
+            weights[i] = kWeights[bestIndex];
+        }
+
+        if (error < bestError)
+        {
+            bestError = error;
+            std::memcpy(block, &color0, 2);
+            std::memcpy(block + 2, &color1, 2);
+            std::memcpy(block + 4, &indices, 4);
+        }
+
+        if (color0 == color1 || !RefineLine(texels, weights, 3, end0, end1))
+        {
+            break;
+        }
+        if (To565(end0) < To565(end1))
+        {
+            // The refined endpoints must keep the order the indices were picked for
+            std::swap(end0, end1);
+        }
+    }
+}
+
+static void DecompressColorBlock(const uint8_t *block, bool forceFourColors, uint8_t *texels)
+{
+    uint16_t color0, color1;
+    uint32_t indices;
+    std::memcpy(&color0, block, 2);
+    std::memcpy(&color1, block + 2, 2);
+    std::memcpy(&indices, block + 4, 4);
+
+    int32_t palette[4][kChannels];
+    GetColorPalette(color0, color1, forceFourColors || color0 > color1, palette);
+    for (uint32_t i = 0; i < kTexelsPerBlock; ++i)
+    {
+        uint32_t index = (indices >> (2 * i)) & 3;
+        for (uint32_t c = 0; c < kChannels; ++c)
+        {
+            texels[i * kChannels + c] = (uint8_t)palette[index][c];
+        }
+    }
+}
+
+static void GetSingleChannelPalette(int32_t value0, int32_t value1, int32_t (&palette)[8])
+{
+    palette[0] = value0;
+    palette[1] = value1;
+    if (value0 > value1)
+    {
+        for (int32_t i = 1; i < 7; ++i)
+        {
+            palette[i + 1] = ((7 - i) * value0 + i * value1 + 3) / 7;
+        }
+    }
+    else
+    {
+        for (int32_t i = 1; i < 5; ++i)
+        {
+            palette[i + 1] = ((5 - i) * value0 + i * value1 + 2) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+static void CompressSingleChannelBlock(const BlockTexels &texels, uint32_t channel, uint8_t *block)
+{
+    float minValue = 255.0f;
+    float maxValue = 0.0f;
+    for (uint32_t i = 0; i < kTexelsPerBlock; ++i)
+    {
+        minValue = std::min(minValue, texels[i][channel]);
+        maxValue = std::max(maxValue, texels[i][channel]);
+    }
+
+    auto value0 = (int32_t)maxValue;
+    auto value1 = (int32_t)minValue;
+    int32_t palette[8];
+    GetSingleChannelPalette(value0, value1, palette);
+
+    uint64_t indices = 0;
+    if (value0 != value1)
+    {
+        for (uint32_t i = 0; i < kTexelsPerBlock; ++i)
+        {
+            uint64_t bestIndex = 0;
+            float bestError = INFINITY;
+            for (uint32_t index = 0; index < 8; ++index)
+            {
+                float error = std::abs(texels[i][channel] - palette[index]);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    bestIndex = index;
+                }
+            }
+            indices |= bestIndex << (3 * i);
+        }
+    }
+
+    block[0] = (uint8_t)value0;
+    block[1] = (uint8_t)value1;
+    for (uint32_t i = 0; i < 6; ++i)
+    {
+        block[2 + i] = (uint8_t)(indices >> (8 * i));
+    }
+}
+
+static void DecompressSingleChannelBlock(const uint8_t *block, uint32_t channel, uint8_t *texels)
+{
+    int32_t palette[8];
+    GetSingleChannelPalette(block[0], block[1], palette);
+
+    uint64_t indices = 0;
+    for (uint32_t i = 0; i < 6; ++i)
+    {
+        indices |= (uint64_t)block[2 + i] << (8 * i);
+    }
+    for (uint32_t i = 0; i < kTexelsPerBlock; ++i)
+    {
+        texels[i * kChannels + channel] = (uint8_t)palette[(indices >> (3 * i)) & 7];
+    }
+}
+
+static uint32_t QuantizeBC7Endpoint(const float *end, uint32_t (&quantized)[kChannels])
+{
+    // Endpoints have 7 bits per channel plus one bit shared by the 4 channels
+    uint32_t bestParity = 0;
+    float bestError = INFINITY;
+    for (uint32_t parity = 0; parity < 2; ++parity)
+    {
+        float error = 0.0f;
+        uint32_t candidate[kChannels];
+        for (uint32_t c = 0; c < kChannels; ++c)
+        {
+            candidate[c] = (uint32_t)std::clamp(std::lround((end[c] - parity) / 2.0f), 0l, 127l);
+            float difference = end[c] - (float)((candidate[c] << 1) | parity);
+            error += difference * difference;
+        }
+        if (error < bestError)
+        {
+            bestError = error;
+            bestParity = parity;
+            std::copy(std::begin(candidate), std::end(candidate), std::begin(quantized));
+        }
+    }
+    return bestParity;
+}
+
+static void GetBC7Palette(const uint32_t (&quantized0)[kChannels], uint32_t parity0, const uint32_t (&quantized1)[kChannels],
+                          uint32_t parity1, int32_t (&palette)[16][kChannels])
+{
+    for (uint32_t c = 0; c < kChannels; ++c)
+    {
+        auto value0 = (int32_t)((quantized0[c] << 1) | parity0);
+        auto value1 = (int32_t)((quantized1[c] << 1) | parity1);
+        for (uint32_t index = 0; index < 16; ++index)
+        {
+            palette[index][c] = ((64 - kBC7Weights[index]) * value0 + kBC7Weights[index] * value1 + 32) >> 6;
+        }
+    }
+}
+
+static void CompressBC7Block(const BlockTexels &texels, uint8_t *block)
+{
+    float end0[kChannels], end1[kChannels];
+    FitLine(texels, kChannels, end0, end1);
+
+    float bestError = INFINITY;
+    uint32_t bestQuantized[2][kChannels];
+    uint32_t bestParity[2];
+    uint32_t bestIndices[kTexelsPerBlock];
+    for (uint32_t iteration = 0; iteration < 2; ++iteration)
+    {
+        uint32_t quantized[2][kChannels];
+        uint32_t parity[2];
+        parity[0] = QuantizeBC7Endpoint(end0, quantized[0]);
+        parity[1] = QuantizeBC7Endpoint(end1, quantized[1]);
+
+        int32_t palette[16][kChannels];
+        GetBC7Palette(quantized[0], parity[0], quantized[1], parity[1], palette);
+
+        float error = 0.0f;
+        uint32_t indices[kTexelsPerBlock];
+        float weights[kTexelsPerBlock];
+        for (uint32_t i = 0; i < kTexelsPerBlock; ++i)
+        {
+            float bestTexelError = INFINITY;
+            for (uint32_t index = 0; index < 16; ++index)
+            {
+                float texelError = 0.0f;
+                for (uint32_t c = 0; c < kChannels; ++c)
+                {
+                    float difference = texels[i][c] - palette[index][c];
+                    texelError += difference * difference;
+                }
+                if (texelError < bestTexelError)
+                {
+                    bestTexelError = texelError;
+                    indices[i] = index;
+                }
+            }
+            error += bestTexelError;
+            weights[i] = kBC7Weights[indices[i]] / 64.0f;
+        }
+
+        if (error < bestError)
+        {
+            bestError = error;
+            std::memcpy(bestQuantized, quantized, sizeof(quantized));
+            std::memcpy(bestParity, parity, sizeof(parity));
+            std::memcpy(bestIndices, indices, sizeof(indices));
+        }
+
+        if (!RefineLine(texels, weights, kChannels, end0, end1))
+        {
+            break;
+        }
+    }
+
+    // The first index is stored with 3 bits, its top bit must be 0
+    if (bestIndices[0] & 8)
+    {
+        std::swap(bestQuantized[0], bestQuantized[1]);
+        std::swap(bestParity[0], bestParity[1]);
+        for (auto &index : bestIndices)
+        {
+            index = 15 - index;
+        }
+    }
+
+    BitWriter writer(block);
+    writer.Write(1 << 6, 7);
+    for (uint32_t c = 0; c < kChannels; ++c)
+    {
+        writer.Write(bestQuantized[0][c], 7);
+        writer.Write(bestQuantized[1][c], 7);
+    }
+    writer.Write(bestParity[0], 1);
+    writer.Write(bestParity[1], 1);
+    writer.Write(bestIndices[0], 3);
+    for (uint32_t i = 1; i < kTexelsPerBlock; ++i)
+    {
+        writer.Write(bestIndices[i], 4);
+    }
+}
+
+static void DecompressBC7Block(const uint8_t *block, uint8_t *texels)
+{
+    BitReader reader(block);
+    if (reader.Read(7) != (1 << 6))
+    {
+        // Only mode 6 is ever written by the cooker
+        std::memset(texels, 0, kTexelsPerBlock * kChannels);
+        return;
+    }
+
+    uint32_t quantized[2][kChannels];
+    for (uint32_t c = 0; c < kChannels; ++c)
+    {
+        quantized[0][c] = reader.Read(7);
+        quantized[1][c] = reader.Read(7);
+    }
+    uint32_t parity0 = reader.Read(1);
+    uint32_t parity1 = reader.Read(1);
+
+    int32_t palette[16][kChannels];
+    GetBC7Palette(quantized[0], parity0, quantized[1], parity1, palette);
+    for (uint32_t i = 0; i < kTexelsPerBlock; ++i)
+    {
+        uint32_t index = reader.Read(i == 0 ? 3 : 4);
+        for (uint32_t c = 0; c < kChannels; ++c)
+        {
+            texels[i * kChannels + c] = (uint8_t)palette[index][c];
+        }
+    }
+}
+
+const char *GetFormatName(Format format)
+{
+    switch (format)
+    {
+    case Format::BC1:
+        return "BC1";
+    case Format::BC3:
+        return "BC3";
+    case Format::BC5:
+        return "BC5";
+    case Format::BC7:
+        return "BC7";
+    default:
+        return "Unknown";
+    }
+}
+
+uint32_t GetBlockSize(Format format)
+{
+    return format == Format::BC1 ? 8 : 16;
+}
+
+size_t GetImageSize(Format format, uint32_t width, uint32_t height)
+{
+    size_t blocksX = (width + kBlockDimension - 1) / kBlockDimension;
+    size_t blocksY = (height + kBlockDimension - 1) / kBlockDimension;
+    return blocksX * blocksY * GetBlockSize(format);
+}
+
+void CompressBlock(Format format, const uint8_t *texels, uint8_t *block)
+{
+    BlockTexels blockTexels;
+    LoadBlock(texels, blockTexels);
+
+    switch (format)
+    {
+    case Format::BC1:
+        CompressColorBlock(blockTexels, block);
+        break;
+    case Format::BC3:
+        CompressSingleChannelBlock(blockTexels, 3, block);
+        CompressColorBlock(blockTexels, block + 8);
+        break;
+    case Format::BC5:
+        CompressSingleChannelBlock(blockTexels, 0, block);
+        CompressSingleChannelBlock(blockTexels, 1, block + 8);
+        break;
+    case Format::BC7:
+        CompressBC7Block(blockTexels, block);
+        break;
+    }
+}
+
+void DecompressBlock(Format format, const uint8_t *block, uint8_t *texels)
+{
+    switch (format)
+    {
+    case Format::BC1:
+        DecompressColorBlock(block, false, texels);
+        break;
+    case Format::BC3:
+        DecompressColorBlock(block + 8, true, texels);
+        DecompressSingleChannelBlock(block, 3, texels);
+        break;
+    case Format::BC5:
+        for (uint32_t i = 0; i < kTexelsPerBlock; ++i)
+        {
+            texels[i * kChannels + 2] = 0;
+            texels[i * kChannels + 3] = 255;
+        }
+        DecompressSingleChannelBlock(block, 0, texels);
+        DecompressSingleChannelBlock(block + 8, 1, texels);
+        break;
+    case Format::BC7:
+        DecompressBC7Block(block, texels);
+        break;
+    }
+}
+
+std::vector<uint8_t> CompressImage(Format format, const uint8_t *texels, uint32_t width, uint32_t height, uint32_t rowPitch)
+{
+    uint32_t blocksX = (width + kBlockDimension - 1) / kBlockDimension;
+    uint32_t blocksY = (height + kBlockDimension - 1) / kBlockDimension;
+    uint32_t blockSize = GetBlockSize(format);
+    std::vector<uint8_t> blocks(GetImageSize(format, width, height));
+
+    JobSystem::Get()->ParallelFor(blocksY, std::max(kBlocksPerJob / blocksX, 1u), [&](uint32_t begin, uint32_t end)
+                                  {
+                                      uint8_t blockTexels[kTexelsPerBlock * kChannels];
+                                      for (uint32_t blockY = begin; blockY < end; ++blockY)
+                                      {
+                                          for (uint32_t blockX = 0; blockX < blocksX; ++blockX)
+                                          {
+                                              for (uint32_t i = 0; i < kTexelsPerBlock; ++i)
+                                              {
+                                                  uint32_t x = std::min(blockX * kBlockDimension + i % kBlockDimension, width - 1);
+                                                  uint32_t y = std::min(blockY * kBlockDimension + i / kBlockDimension, height - 1);
+                                                  std::memcpy(blockTexels + i * kChannels, texels + (size_t)y * rowPitch + x * kChannels, kChannels);
+                                              }
+                                              CompressBlock(format, blockTexels, blocks.data() + ((size_t)blockY * blocksX + blockX) * blockSize);
+                                          }
+                                      }
+                                  });
+    return blocks;
+}
+
+std::vector<uint8_t> DecompressImage(Format format, const uint8_t *blocks, uint32_t width, uint32_t height)
+{
+    uint32_t blocksX = (width + kBlockDimension - 1) / kBlockDimension;
+    uint32_t blocksY = (height + kBlockDimension - 1) / kBlockDimension;
+    uint32_t blockSize = GetBlockSize(format);
+    std::vector<uint8_t> texels((size_t)width * height * kChannels);
+
+    uint8_t blockTexels[kTexelsPerBlock * kChannels];
+    for (uint32_t blockY = 0; blockY < blocksY; ++blockY)
+    {
+        for (uint32_t blockX = 0; blockX < blocksX; ++blockX)
+        {
+            DecompressBlock(format, blocks + ((size_t)blockY * blocksX + blockX) * blockSize, blockTexels);
+            for (uint32_t i = 0; i < kTexelsPerBlock; ++i)
+            {
+                uint32_t x = blockX * kBlockDimension + i % kBlockDimension;
+                uint32_t y = blockY * kBlockDimension + i / kBlockDimension;
+                if (x < width && y < height)
+                {
+                    std::memcpy(texels.data() + ((size_t)y * width + x) * kChannels, blockTexels + i * kChannels, kChannels);
+                }
+            }
+        }
+    }
+    return texels;
+}
+
+} // namespace BlockCompression
@@ -0,0 +1,54 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// CPU encoders and decoders for the block compressed formats the cooker writes.
+/// Every block covers 4x4 texels; the input texels are always 8 bit RGBA, row by row.
+/// BC1 ignores alpha, BC5 only keeps red and green. BC7 blocks are always encoded in mode 6
+/// (one subset, RGBA endpoints, 4 bit indices), which suits smooth blocks and is fast to search
+/// </summary>
+namespace BlockCompression
+{
+
+enum class Format
+{
+    BC1,
+    BC3,
+    BC5,
+    BC7,
+};
+
+static constexpr uint32_t kBlockDimension = 4;
+static constexpr uint32_t kTexelsPerBlock = kBlockDimension * kBlockDimension;
+
+const char *GetFormatName(Format format);
+/// <summary>
+/// Bytes taken by one 4x4 block
+/// </summary>
+uint32_t GetBlockSize(Format format);
+/// <summary>
+/// Bytes taken by a compressed image of width x height texels
+/// </summary>
+size_t GetImageSize(Format format, uint32_t width, uint32_t height);
+
+void CompressBlock(Format format, const uint8_t *texels, uint8_t *block);
+/// <summary>
+/// Decodes one block in 16 RGBA texels. Channels the format doesn't store are 0, alpha is 255
+/// </summary>
+void DecompressBlock(Format format, const uint8_t *block, uint8_t *texels);
+
+/// <summary>
+/// Compresses a whole image. Rows of blocks are spread across the job system.
+/// Texels past the right and bottom edges repeat the last column and row
+/// </summary>
+std::vector<uint8_t> CompressImage(Format format, const uint8_t *texels, uint32_t width, uint32_t height, uint32_t rowPitch);
+/// <summary>
+/// Decodes a whole image in tightly packed RGBA texels
+/// </summary>
+std::vector<uint8_t> DecompressImage(Format format, const uint8_t *blocks, uint32_t width, uint32_t height);
+
+} // namespace BlockCompression
@@ -0,0 +1,367 @@
+#include "TextureCooker.h"
+#include "Utils/DDSTextureLoader.h"
+#include "Utils/MipGenerator.h"
+
+#pragma pack(push, 1)
+struct DDSPixelFormat
+{
+    uint32_t Size;
+    uint32_t Flags;
+    uint32_t FourCC;
+    uint32_t RGBBitCount;
+    uint32_t RBitMask;
+    uint32_t GBitMask;
+    uint32_t BBitMask;
+    uint32_t ABitMask;
+};
+
+struct DDSHeader
+{
+    uint32_t Size;
+    uint32_t Flags;
+    uint32_t Height;
+    uint32_t Width;
+    uint32_t PitchOrLinearSize;
+    uint32_t Depth;
+    uint32_t MipMapCount;
+    uint32_t Reserved1[11];
+    DDSPixelFormat PixelFormat;
+    uint32_t Caps;
+    uint32_t Caps2;
+    uint32_t Caps3;
+    uint32_t Caps4;
+    uint32_t Reserved2;
+};
+
+struct DDSHeaderDXT10
+{
+    DXGI_FORMAT Format;
+    uint32_t ResourceDimension;
+    uint32_t MiscFlag;
+    uint32_t ArraySize;
+    uint32_t MiscFlags2;
+};
+#pragma pack(pop)
+
+static constexpr uint32_t kDDSMagic = 0x20534444; // "DDS "
+static constexpr uint32_t kDX10FourCC = 0x30315844; // "DX10"
+
+static constexpr uint32_t kDDSFlagsCaps = 0x1;
+static constexpr uint32_t kDDSFlagsHeight = 0x2;
+static constexpr uint32_t kDDSFlagsWidth = 0x4;
+static constexpr uint32_t kDDSFlagsPixelFormat = 0x1000;
+static constexpr uint32_t kDDSFlagsMipMapCount = 0x20000;
+static constexpr uint32_t kDDSFlagsLinearSize = 0x80000;
+static constexpr uint32_t kDDSPixelFormatFourCC = 0x4;
+static constexpr uint32_t kDDSCapsComplex = 0x8;
+static constexpr uint32_t kDDSCapsTexture = 0x1000;
+static constexpr uint32_t kDDSCapsMipMap = 0x400000;
+
+static bool ReadFileContents(const std::filesystem::path &path, std::vector<uint8_t> &contents)
+{
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream)
+    {
+        return false;
+    }
+
+    contents.resize((size_t)stream.tellg());
+    stream.seekg(0);
+    stream.read((char *)contents.data(), contents.size());
+    return (bool)stream;
+}
+
+static DXGI_FORMAT GetDXGIFormat(BlockCompression::Format format, bool srgb)
+{
+    switch (format)
+    {
+    case BlockCompression::Format::BC1:
+        return srgb ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+    case BlockCompression::Format::BC3:
+        return srgb ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
+    case BlockCompression::Format::BC5:
+        // Two channel data is never color
+        return DXGI_FORMAT_BC5_UNORM;
+    case BlockCompression::Format::BC7:
+        return srgb ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
+    default:
+        return DXGI_FORMAT_UNKNOWN;
+    }
+}
+
+static double ComputePSNR(BlockCompression::Format format, const uint8_t *original, const uint8_t *decoded, size_t texelCount)
+{
+    // Only the channels the format stores are compared
+    uint32_t channelCount = 4;
+    if (format == BlockCompression::Format::BC1)
+    {
+        channelCount = 3;
+    }
+    else if (format == BlockCompression::Format::BC5)
+    {
+        channelCount = 2;
+    }
+
+    double squaredError = 0.0;
+    for (size_t i = 0; i < texelCount; ++i)
+    {
+        for (uint32_t c = 0; c < channelCount; ++c)
+        {
+            double difference = (double)original[i * 4 + c] - decoded[i * 4 + c];
+            squaredError += difference * difference;
+        }
+    }
+
+    double meanSquaredError = squaredError / ((double)texelCount * channelCount);
+    if (meanSquaredError == 0.0)
+    {
+        return INFINITY;
+    }
+    return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+}
+
+TextureCooker::TextureCooker(const Options &options)
+    : mOptions(options)
+{
+}
+
+bool TextureCooker::Cook(const std::filesystem::path &source, const std::filesystem::path &destination)
+{
+    std::vector<uint8_t> contents;
+    CHECK(ReadFileContents(source, contents), false, "Unable to read {}", source.string());
+
+    std::error_code error;
+    std::filesystem::create_directories(mOptions.CacheDirectory, error);
+    CHECK(!error, false, "Unable to create cache directory {}: {}", mOptions.CacheDirectory.string(), error.message());
+    if (destination.has_parent_path())
+    {
+        std::filesystem::create_directories(destination.parent_path(), error);
+        CHECK(!error, false, "Unable to create directory {}: {}", destination.parent_path().string(), error.message());
+    }
+
+    auto cachePath = mOptions.CacheDirectory / fmt::format("{:016x}.dds", ComputeCacheKey(contents));
+    if (!std::filesystem::exists(cachePath, error))
+    {
+        CookedTexture cooked;
+        CHECK(Encode(source, cooked), false, "Unable to cook {}", source.string());
+        CHECK(WriteDDS(cachePath, cooked), false, "Unable to write {}", cachePath.string());
+
+        uint64_t cookedBytes = std::filesystem::file_size(cachePath, error);
+        fmt::print("{:<40} {:>5}x{:<5} {} {:>2} mips {:>8.2f} MTexels/s  PSNR {:>6.2f} dB  {:>8} KiB -> {:>7} KiB\n",
+                   source.filename().string(), cooked.Width, cooked.Height, BlockCompression::GetFormatName(cooked.BlockFormat),
+                   cooked.Mips.size(), cooked.EncodedTexels / 1e6 / std::max(cooked.EncodeSeconds, 1e-9), cooked.PSNR,
+                   contents.size() / 1024, cookedBytes / 1024);
+
+        mStatistics.Cooked++;
+        mStatistics.EncodedTexels += cooked.EncodedTexels;
+        mStatistics.EncodeSeconds += cooked.EncodeSeconds;
+    }
+    else
+    {
+        fmt::print("{:<40} cached as {}\n", source.filename().string(), cachePath.filename().string());
+        mStatistics.CacheHits++;
+    }
+
+    std::filesystem::copy_file(cachePath, destination, std::filesystem::copy_options::overwrite_existing, error);
+    CHECK(!error, false, "Unable to copy {} to {}: {}", cachePath.string(), destination.string(), error.message());
+
+    mStatistics.SourceBytes += contents.size();
+    mStatistics.CookedBytes += std::filesystem::file_size(destination, error);
+    return true;
+}
+
+auto TextureCooker::GetStatistics() const -> const Statistics &
+{
+    return mStatistics;
+}
+
+bool TextureCooker::Encode(const std::filesystem::path &source, CookedTexture &cooked)
+{
+    DirectX::DDSTextureData textureData;
+    CHECK_HR(DirectX::LoadDDSTextureData(source.c_str(), textureData), false);
+    CHECK(textureData.resDim == D3D12_RESOURCE_DIMENSION_TEXTURE2D && textureData.arraySize == 1 && !textureData.isCubeMap, false,
+          "{} is not a 2D texture", source.string());
+
+    bool srgb = false;
+    bool bgra = false;
+    bool opaque = false;
+    switch (textureData.format)
+    {
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+        break;
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        srgb = true;
+        break;
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+        bgra = true;
+        break;
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        bgra = true;
+        srgb = true;
+        break;
+    case DXGI_FORMAT_B8G8R8X8_UNORM:
+        bgra = true;
+        opaque = true;
+        break;
+    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+        bgra = true;
+        opaque = true;
+        srgb = true;
+        break;
+    default:
+        CHECK(false, false, "{} has format {}; only uncompressed RGBA8 and BGRA8 textures can be cooked",
+              source.string(), (uint32_t)textureData.format);
+    }
+
+    cooked.Width = (uint32_t)textureData.width;
+    cooked.Height = (uint32_t)textureData.height;
+    CHECK(cooked.Width % BlockCompression::kBlockDimension == 0 && cooked.Height % BlockCompression::kBlockDimension == 0, false,
+          "{} is {}x{}; block compressed textures must be a multiple of 4 texels wide and high",
+          source.string(), cooked.Width, cooked.Height);
+
+    // Every mip, tightly packed in RGBA order
+    std::vector<std::vector<uint8_t>> mips;
+    auto addMip = [&](const uint8_t *data, uint32_t width, uint32_t height, size_t rowPitch)
+    {
+        std::vector<uint8_t> mip((size_t)width * height * 4);
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            const uint8_t *sourceRow = data + y * rowPitch;
+            uint8_t *row = mip.data() + (size_t)y * width * 4;
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                row[x * 4 + 0] = sourceRow[x * 4 + (bgra ? 2 : 0)];
+                row[x * 4 + 1] = sourceRow[x * 4 + 1];
+                row[x * 4 + 2] = sourceRow[x * 4 + (bgra ? 0 : 2)];
+                row[x * 4 + 3] = opaque ? 255 : sourceRow[x * 4 + 3];
+            }
+        }
+        mips.push_back(std::move(mip));
+    };
+
+    for (uint32_t i = 0; i < (uint32_t)textureData.mipCount; ++i)
+    {
+        const auto &subresource = textureData.subresources[i];
+        addMip((const uint8_t *)subresource.pData, std::max(cooked.Width >> i, 1u), std::max(cooked.Height >> i, 1u), subresource.RowPitch);
+    }
+
+    if (textureData.mipCount == 1 && mOptions.GenerateMips)
+    {
+        auto mipChain = MipGenerator::Generate(mips[0].data(), cooked.Width, cooked.Height, cooked.Width * 4, srgb);
+        // Generated from the swizzled top mip, so they're in RGBA order already
+        bgra = false;
+        opaque = false;
+        for (uint32_t i = 1; i < (uint32_t)mipChain.Levels.size(); ++i)
+        {
+            const auto &level = mipChain.Levels[i];
+            addMip(mipChain.Data.get() + level.Offset, level.Width, level.Height, level.RowPitch);
+        }
+    }
+
+    switch (mOptions.Format)
+    {
+    case FormatSelection::Auto:
+    {
+        bool hasAlpha = false;
+        for (size_t i = 3; i < mips[0].size() && !hasAlpha; i += 4)
+        {
+            hasAlpha = mips[0][i] != 255;
+        }
+        cooked.BlockFormat = hasAlpha ? BlockCompression::Format::BC3 : BlockCompression::Format::BC1;
+        break;
+    }
+    case FormatSelection::BC1:
+        cooked.BlockFormat = BlockCompression::Format::BC1;
+        break;
+    case FormatSelection::BC3:
+        cooked.BlockFormat = BlockCompression::Format::BC3;
+        break;
+    case FormatSelection::BC5:
+        cooked.BlockFormat = BlockCompression::Format::BC5;
+        break;
+    case FormatSelection::BC7:
+        cooked.BlockFormat = BlockCompression::Format::BC7;
+        break;
+    }
+    cooked.Format = GetDXGIFormat(cooked.BlockFormat, srgb);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    cooked.EncodedTexels = 0;
+    for (uint32_t i = 0; i < (uint32_t)mips.size(); ++i)
+    {
+        uint32_t width = std::max(cooked.Width >> i, 1u);
+        uint32_t height = std::max(cooked.Height >> i, 1u);
+        cooked.Mips.push_back(BlockCompression::CompressImage(cooked.BlockFormat, mips[i].data(), width, height, width * 4));
+        cooked.EncodedTexels += (uint64_t)width * height;
+    }
+    cooked.EncodeSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    auto decoded = BlockCompression::DecompressImage(cooked.BlockFormat, cooked.Mips[0].data(), cooked.Width, cooked.Height);
+    cooked.PSNR = ComputePSNR(cooked.BlockFormat, mips[0].data(), decoded.data(), (size_t)cooked.Width * cooked.Height);
+
+    return true;
+}
+
+bool TextureCooker::WriteDDS(const std::filesystem::path &path, const CookedTexture &cooked) const
+{
+    DDSHeader header = {};
+    header.Size = sizeof(DDSHeader);
+    header.Flags = kDDSFlagsCaps | kDDSFlagsHeight | kDDSFlagsWidth | kDDSFlagsPixelFormat | kDDSFlagsMipMapCount | kDDSFlagsLinearSize;
+    header.Height = cooked.Height;
+    header.Width = cooked.Width;
+    header.PitchOrLinearSize = (uint32_t)cooked.Mips[0].size();
+    header.MipMapCount = (uint32_t)cooked.Mips.size();
+    header.PixelFormat.Size = sizeof(DDSPixelFormat);
+    header.PixelFormat.Flags = kDDSPixelFormatFourCC;
+    header.PixelFormat.FourCC = kDX10FourCC;
+    header.Caps = kDDSCapsTexture | (cooked.Mips.size() > 1 ? kDDSCapsComplex | kDDSCapsMipMap : 0);
+
+    DDSHeaderDXT10 headerDXT10 = {};
+    headerDXT10.Format = cooked.Format;
+    headerDXT10.ResourceDimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    headerDXT10.ArraySize = 1;
+    bool hasAlpha = cooked.BlockFormat == BlockCompression::Format::BC3 || cooked.BlockFormat == BlockCompression::Format::BC7;
+    headerDXT10.MiscFlags2 = hasAlpha ? DirectX::DDS_ALPHA_MODE_STRAIGHT : DirectX::DDS_ALPHA_MODE_OPAQUE;
+
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    CHECK(stream, false, "Unable to open {}", path.string());
+
+    stream.write((const char *)&kDDSMagic, sizeof(kDDSMagic));
+    stream.write((const char *)&header, sizeof(header));
+    stream.write((const char *)&headerDXT10, sizeof(headerDXT10));
+    for (const auto &mip : cooked.Mips)
+    {
+        stream.write((const char *)mip.data(), mip.size());
+    }
+    stream.close();
+    if (!stream)
+    {
+        // Don't leave a truncated file in the cache
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        return false;
+    }
+
+    return true;
+}
+
+uint64_t TextureCooker::ComputeCacheKey(const std::vector<uint8_t> &fileContents) const
+{
+    // FNV-1a over the file, followed by everything that changes the output
+    constexpr uint64_t kOffsetBasis = 0xcbf29ce484222325ull;
+    constexpr uint64_t kPrime = 0x100000001b3ull;
+
+    uint64_t hash = kOffsetBasis;
+    auto add = [&](const uint8_t *data, size_t size)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ data[i]) * kPrime;
+        }
+    };
+
+    add(fileContents.data(), fileContents.size());
+    uint32_t settings[] = { kVersion, (uint32_t)mOptions.Format, mOptions.GenerateMips ? 1u : 0u };
+    add((const uint8_t *)settings, sizeof(settings));
+    return hash;
+}
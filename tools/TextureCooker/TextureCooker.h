@@ -0,0 +1,78 @@
+#pragma once
+
+
+#include <Oblivion.h>
+
+#include "BlockCompression.h"
+
+/// <summary>
+/// Converts uncompressed RGBA8 / BGRA8 DDS files into block compressed DDS files with a full mip chain,
+/// loadable by DirectX::LoadDDSTextureData. Results are cached by a hash of the source file and the
+/// options, so cooking an unchanged texture again only copies the cached file
+/// </summary>
+class TextureCooker
+{
+public:
+    // Bump when the encoders change, so stale cache entries are not reused
+    static constexpr const uint32_t kVersion = 1;
+
+    enum class FormatSelection
+    {
+        // BC1 for opaque textures, BC3 for the others
+        Auto,
+        BC1,
+        BC3,
+        BC5,
+        BC7,
+    };
+
+    struct Options
+    {
+        FormatSelection Format = FormatSelection::Auto;
+        std::filesystem::path CacheDirectory = "TextureCache";
+        // Mips present in the source are kept; this only controls generating them for mipless sources
+        bool GenerateMips = true;
+    };
+
+    struct Statistics
+    {
+        uint32_t Cooked = 0;
+        uint32_t CacheHits = 0;
+        uint64_t SourceBytes = 0;
+        uint64_t CookedBytes = 0;
+        uint64_t EncodedTexels = 0;
+        double EncodeSeconds = 0.0;
+    };
+
+public:
+    explicit TextureCooker(const Options &options);
+
+    /// <summary>
+    /// Cooks source into destination and prints a line with the encode throughput and the PSNR of the top mip
+    /// </summary>
+    bool Cook(const std::filesystem::path &source, const std::filesystem::path &destination);
+
+    const Statistics &GetStatistics() const;
+
+private:
+    struct CookedTexture
+    {
+        DXGI_FORMAT Format;
+        uint32_t Width;
+        uint32_t Height;
+        std::vector<std::vector<uint8_t>> Mips;
+        BlockCompression::Format BlockFormat;
+        double EncodeSeconds;
+        uint64_t EncodedTexels;
+        double PSNR;
+    };
+
+private:
+    bool Encode(const std::filesystem::path &source, CookedTexture &cooked);
+    bool WriteDDS(const std::filesystem::path &path, const CookedTexture &cooked) const;
+    uint64_t ComputeCacheKey(const std::vector<uint8_t> &fileContents) const;
+
+private:
+    Options mOptions;
+    Statistics mStatistics;
+};
@@ -0,0 +1,147 @@
+#include "TextureCooker.h"
+#include "JobSystem.h"
+
+static void PrintUsage()
+{
+    fmt::print("Usage: TextureCooker [options] <file.dds | directory>...\n"
+               "Options:\n"
+               "    -o <directory>       Where cooked textures are written. Default: Cooked\n"
+               "    -f <format>          auto, bc1, bc3, bc5 or bc7. Default: auto (bc1 if opaque, bc3 otherwise)\n"
+               "    --cache <directory>  Where cooked textures are cached. Default: TextureCache\n"
+               "    --no-mips            Don't generate mips for textures that have none\n"
+               "    -j <count>           Number of worker threads. Default: one per core\n");
+}
+
+static bool ParseFormat(std::string_view name, TextureCooker::FormatSelection &format)
+{
+    static const std::pair<std::string_view, TextureCooker::FormatSelection> kFormats[] =
+    {
+        { "auto", TextureCooker::FormatSelection::Auto },
+        { "bc1", TextureCooker::FormatSelection::BC1 },
+        { "bc3", TextureCooker::FormatSelection::BC3 },
+        { "bc5", TextureCooker::FormatSelection::BC5 },
+        { "bc7", TextureCooker::FormatSelection::BC7 },
+    };
+
+    for (const auto &[formatName, selection] : kFormats)
+    {
+        if (name == formatName)
+        {
+            format = selection;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool IsDDSFile(const std::filesystem::path &path)
+{
+    auto extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)std::tolower(c); });
+    return extension == ".dds";
+}
+
+int main(int argc, char **argv)
+{
+    TextureCooker::Options options;
+    std::filesystem::path outputDirectory = "Cooked";
+    uint32_t workerCount = 0;
+    std::vector<std::filesystem::path> inputs;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view argument = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (argument == "-o" && hasValue)
+        {
+            outputDirectory = argv[++i];
+        }
+        else if (argument == "-f" && hasValue)
+        {
+            if (!ParseFormat(argv[++i], options.Format))
+            {
+                fmt::print("Unknown format {}\n", argv[i]);
+                PrintUsage();
+                return 1;
+            }
+        }
+        else if (argument == "--cache" && hasValue)
+        {
+            options.CacheDirectory = argv[++i];
+        }
+        else if (argument == "--no-mips")
+        {
+            options.GenerateMips = false;
+        }
+        else if (argument == "-j" && hasValue)
+        {
+            workerCount = (uint32_t)std::max(std::atoi(argv[++i]) - 1, 1);
+        }
+        else if (argument.starts_with("-"))
+        {
+            PrintUsage();
+            return 1;
+        }
+        else
+        {
+            inputs.push_back(argument);
+        }
+    }
+
+    if (inputs.empty())
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    // Pairs of source and destination. Directories keep their layout under the output directory
+    std::vector<std::pair<std::filesystem::path, std::filesystem::path>> textures;
+    for (const auto &input : inputs)
+    {
+        if (std::filesystem::is_directory(input))
+        {
+            for (const auto &entry : std::filesystem::recursive_directory_iterator(input))
+            {
+                if (entry.is_regular_file() && IsDDSFile(entry.path()))
+                {
+                    textures.emplace_back(entry.path(), outputDirectory / std::filesystem::relative(entry.path(), input));
+                }
+            }
+        }
+        else
+        {
+            textures.emplace_back(input, outputDirectory / input.filename());
+        }
+    }
+
+    JobSystem::Get()->Init(workerCount);
+
+    TextureCooker cooker(options);
+    uint32_t failed = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const auto &[source, destination] : textures)
+    {
+        if (!cooker.Cook(source, destination))
+        {
+            failed++;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    const auto &statistics = cooker.GetStatistics();
+    fmt::print("\n{} textures cooked, {} taken from the cache, {} failed in {:.2f}s\n",
+               statistics.Cooked, statistics.CacheHits, failed, seconds);
+    if (statistics.EncodeSeconds > 0.0)
+    {
+        fmt::print("Encoded {:.2f} MTexels at {:.2f} MTexels/s\n", statistics.EncodedTexels / 1e6,
+                   statistics.EncodedTexels / 1e6 / statistics.EncodeSeconds);
+    }
+    if (statistics.SourceBytes > 0)
+    {
+        fmt::print("{} KiB -> {} KiB ({:.1f}%)\n", statistics.SourceBytes / 1024, statistics.CookedBytes / 1024,
+                   100.0 * statistics.CookedBytes / statistics.SourceBytes);
+    }
+
+    JobSystem::Destroy();
+    return failed == 0 ? 0 : 1;
+}